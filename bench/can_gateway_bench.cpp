@@ -0,0 +1,380 @@
+// ============================================================================
+// CAN GATEWAY BENCHMARK - slcan / cannelloni over loopback (env:native_gateway)
+// ============================================================================
+// CanGateway behind a model of ComfoAir::loop() on a LoopbackBus, with
+// MvhrSimulator as node 1 and a probe port for what reaches the bus:
+//   1. self test (default): in-process slcan (TCP) and cannelloni (UDP)
+//      clients on 127.0.0.1. Every bus frame must arrive once on both,
+//      identical and in order; frames per TCP write / UDP packet at 10 and
+//      100 % bus load; PC -> bus frames over both protocols, the rate limit
+//      and refused slcan commands
+//   2. serve: the gateway and the simulator until killed, for the real
+//      tools over loopback, e.g.
+//        python3 -c 'import can; print(can.Bus(interface="slcan", bitrate=50000,
+//                    channel="socket://127.0.0.1:3333").recv())'
+//        socat pty,link=/tmp/ttyCAN,raw tcp:127.0.0.1:3333 &
+//        sudo slcand -o -c -s2 /tmp/ttyCAN slcan0 && candump slcan0
+//        cannelloni -I vcan0 -R 127.0.0.1 -r 20000 -l 20001   (serve 127.0.0.1 20001)
+//
+//   pio run -e native_gateway && .pio/build/native_gateway/program [serve [peer_ip] [peer_port]]
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "comfoair/can_gateway.h"
+#include "comfoair/can_tx_queue.h"
+#include "comfoair/frame_fanout.h"
+#include "comfoair/loopback_port.h"
+#include "comfoair/mvhr_simulator.h"
+
+using namespace comfoair;
+
+#ifndef CAN_RX_BUDGET
+  #define CAN_RX_BUDGET 16
+#endif
+
+static const uint32_t PC_FRAME_ID = 0x123;    // nothing on ComfoNet uses standard IDs
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %s %s\n", ok ? "✅" : "❌", what);
+    if (!ok) failures++;
+}
+
+// Same clock as the loopback bus stamps
+static uint32_t nowUs() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t nowMs() { return nowUs() / 1000; }
+
+static bool sameFrame(const CAN_FRAME &a, const CAN_FRAME &b) {
+    return a.id == b.id && a.extended == b.extended && a.rtr == b.rtr && a.length == b.length &&
+           (a.rtr || memcmp(a.data.uint8, b.data.uint8, a.length) == 0);
+}
+
+struct Rig {
+    LoopbackBus bus;
+    LoopbackPort bridge;
+    LoopbackPort mvhr;
+    LoopbackPort probe;
+    MvhrSimulator sim;
+    CanTxQueue txQueue;
+    FrameFanout fanout;
+    CanGateway gateway;
+    bool simOn;
+    uint32_t published;
+    uint32_t fromPc;              // PC_FRAME_ID frames seen by the probe
+
+    Rig() :
+        bridge(bus, "bridge"), mvhr(bus, "mvhr"), probe(bus, "probe"), sim(mvhr),
+        txQueue(canTxDriver(bridge)),
+        gateway(GatewayTx{ [](void *ctx, const CAN_FRAME &frame) {
+            return static_cast<CanTxQueue*>(ctx)->enqueue(TxPriority::COMMAND, &frame, 1) != 0;
+        }, &txQueue }),
+        simOn(false), published(0), fromPc(0) {
+        bridge.begin(MVHR_SIM_BITRATE);
+        probe.begin(MVHR_SIM_BITRATE);
+        sim.begin();
+        fanout.addSink("gw", [](void *ctx, const CAN_FRAME &frame) {
+            return static_cast<CanGateway*>(ctx)->forward(frame, nowMs());
+        }, &gateway, CAN_RX_BUDGET);
+    }
+
+    // One ComfoAir::loop() iteration
+    void step() {
+        uint32_t us = nowUs();
+        if (simOn) sim.poll(us);
+        txQueue.poll(us / 1000);
+        CAN_FRAME frame;
+        uint8_t budget = CAN_RX_BUDGET;
+        while (budget > 0 && bridge.read(frame)) {
+            budget--;
+            fanout.publish(frame);
+            published++;
+        }
+        fanout.poll();
+        gateway.poll(us / 1000);
+        while (probe.read(frame)) {
+            if (frame.id == PC_FRAME_ID) fromPc++;
+        }
+    }
+};
+
+// slcan over TCP, as python-can / slcand see it
+struct SlcanClient {
+    int fd;
+    std::string pending;
+    std::string replies;          // '.' ok, '!' error, 'z' transmitted, else the first char
+    std::vector<CAN_FRAME> frames;
+
+    SlcanClient() : fd(-1) {}
+    ~SlcanClient() { if (fd >= 0) close(fd); }
+
+    bool connect(uint16_t port) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (::connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) return false;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return true;
+    }
+
+    void send(const char *text) { ::send(fd, text, strlen(text), MSG_NOSIGNAL); }
+
+    void read() {
+        char chunk[4096];
+        ssize_t n;
+        while ((n = recv(fd, chunk, sizeof(chunk), 0)) > 0) {
+            for (ssize_t i = 0; i < n; i++) {
+                char c = chunk[i];
+                if (c == '\a') {
+                    replies += '!';
+                } else if (c != '\r') {
+                    pending += c;
+                } else {
+                    CAN_FRAME frame;
+                    if (pending.empty()) replies += '.';
+                    else if (slcanParseFrame(pending.data(), pending.size(), frame)) frames.push_back(frame);
+                    else replies += (pending[0] == 'Z' ? 'z' : pending[0]);
+                    pending.clear();
+                }
+            }
+        }
+    }
+};
+
+// cannelloni over UDP
+struct CannelloniClient {
+    int fd;
+    uint16_t gatewayPort;
+    uint32_t packets;
+    std::vector<CAN_FRAME> frames;
+
+    CannelloniClient() : fd(-1), gatewayPort(0), packets(0) {}
+    ~CannelloniClient() { if (fd >= 0) close(fd); }
+
+    bool open(uint16_t port) {
+        gatewayPort = port;
+        fd = socket(AF_INET, SOCK_DGRAM, 0);
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) return false;
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        return true;
+    }
+
+    // An empty data packet announces us as the peer
+    void send(const CAN_FRAME *frames, uint16_t count) {
+        uint8_t packet[CAN_GATEWAY_BATCH_BYTES];
+        size_t len = cannelloniEncodeHeader(0, count, packet);
+        for (uint16_t i = 0; i < count; i++) len += cannelloniEncodeFrame(frames[i], packet + len, sizeof(packet) - len);
+        struct sockaddr_in to = {};
+        to.sin_family = AF_INET;
+        to.sin_port = htons(gatewayPort);
+        to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        sendto(fd, packet, len, 0, (struct sockaddr *)&to, sizeof(to));
+    }
+
+    void read() {
+        uint8_t packet[2048];
+        ssize_t n;
+        while ((n = recv(fd, packet, sizeof(packet), 0)) > 0) {
+            packets++;
+            cannelloniDecode(packet, n, [](void *ctx, const CAN_FRAME &frame) {
+                static_cast<CannelloniClient*>(ctx)->frames.push_back(frame);
+            }, this);
+        }
+    }
+};
+
+static void run(Rig &rig, SlcanClient &tcp, CannelloniClient &udp, uint32_t ms) {
+    for (uint32_t end = nowMs() + ms; (int32_t)(nowMs() - end) < 0; ) {
+        rig.step();
+        tcp.read();
+        udp.read();
+        usleep(200);
+    }
+}
+
+static CAN_FRAME pcFrame(uint8_t i) {
+    CAN_FRAME frame = {};
+    frame.id = PC_FRAME_ID;
+    frame.length = 2;
+    frame.data.uint8[0] = 0xA5;
+    frame.data.uint8[1] = i;
+    return frame;
+}
+
+static void testForwarding(uint16_t load, uint32_t seconds) {
+    printf("\n[Bus -> PC, %u %% of %u kbit/s for %u s]\n", load, MVHR_SIM_BITRATE / 1000, seconds);
+    Rig rig;
+    SlcanClient tcp;
+    CannelloniClient udp;
+    if (!rig.gateway.begin(CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT) ||
+        !tcp.connect(CAN_GATEWAY_SLCAN_PORT) || !udp.open(CAN_GATEWAY_CANNELLONI_PORT)) {
+        check(false, "gateway sockets on 127.0.0.1");
+        return;
+    }
+    tcp.send("C\rS2\rO\r");
+    udp.send(nullptr, 0);
+    run(rig, tcp, udp, 100);
+    check(tcp.replies == "..." && rig.gateway.slcanOpen(), "slcan C / S2 / O accepted");
+    check(rig.gateway.hasPeer(), "cannelloni peer learned");
+
+    rig.sim.setLoad(load);
+    rig.simOn = true;
+    run(rig, tcp, udp, seconds * 1000);
+    rig.simOn = false;
+    run(rig, tcp, udp, 4 * CAN_GATEWAY_BATCH_MS + 50);
+
+    const CanGateway::Stats &s = rig.gateway.stats();
+    bool same = tcp.frames.size() == udp.frames.size();
+    for (size_t i = 0; same && i < tcp.frames.size(); i++) same = sameFrame(tcp.frames[i], udp.frames[i]);
+    printf("  %u frames/s; slcan %.1f writes/s, %.1f frames/write; cannelloni %.1f packets/s, %.1f frames/packet\n",
+           rig.published / seconds, (double)s.slcanWrites / seconds,
+           s.slcanWrites ? (double)s.slcanFrames / s.slcanWrites : 0.0,
+           (double)udp.packets / seconds, udp.packets ? (double)udp.frames.size() / udp.packets : 0.0);
+    check(rig.published > 0 && tcp.frames.size() == rig.published, "every frame on slcan");
+    check(udp.frames.size() == rig.published, "every frame on cannelloni");
+    check(same, "identical frames, same order");
+    check(udp.packets <= seconds * (1000 / CAN_GATEWAY_BATCH_MS) + 2, "cannelloni packets within the batch budget");
+    check(s.blocked == 0 && s.sendErrors == 0, "no blocked frames, no socket errors");
+}
+
+static void testFromPc() {
+    printf("\n[PC -> bus, %u frames/s, burst %u]\n", CAN_GATEWAY_TX_RATE, CAN_GATEWAY_TX_BURST);
+    Rig rig;
+    SlcanClient tcp;
+    CannelloniClient udp;
+    if (!rig.gateway.begin(CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT) ||
+        !tcp.connect(CAN_GATEWAY_SLCAN_PORT) || !udp.open(CAN_GATEWAY_CANNELLONI_PORT)) {
+        check(false, "gateway sockets on 127.0.0.1");
+        return;
+    }
+    tcp.send("t1232A501\r");
+    run(rig, tcp, udp, 50);
+    check(tcp.replies == "!" && rig.fromPc == 0, "refused before O");
+
+    tcp.replies.clear();
+    tcp.send("O\rS4\rV\rt1232A501\r");
+    run(rig, tcp, udp, 100);
+    check(tcp.replies == ".!Vz" && rig.fromPc == 1, "O, S4 refused, V, one frame sent");
+
+    // 20 frames at once: the burst passes, the rest is refused
+    tcp.replies.clear();
+    std::string flood;
+    char line[SLCAN_MAX_LINE];
+    for (uint8_t i = 0; i < 20; i++) {
+        CAN_FRAME frame = pcFrame(i);
+        line[slcanEncode(frame, -1, line, sizeof(line))] = '\0';
+        flood += line;
+    }
+    tcp.send(flood.c_str());
+    run(rig, tcp, udp, 200);
+    uint32_t accepted = 0;
+    for (char c : tcp.replies) accepted += c == 'z';
+    printf("  flood of 20: %u sent, %u rate limited\n", accepted, rig.gateway.stats().txRateLimited);
+    check(accepted >= CAN_GATEWAY_TX_BURST - 1 && accepted <= CAN_GATEWAY_TX_BURST + 1, "slcan flood limited to the burst");
+    check(rig.fromPc == 1 + accepted, "accepted frames reach the bus");
+
+    // Bucket refilled: a cannelloni packet of 5
+    run(rig, tcp, udp, 1000 * CAN_GATEWAY_TX_BURST / CAN_GATEWAY_TX_RATE + 100);
+    uint32_t before = rig.fromPc;
+    CAN_FRAME frames[5];
+    for (uint8_t i = 0; i < 5; i++) frames[i] = pcFrame(i);
+    udp.send(frames, 5);
+    run(rig, tcp, udp, 100);
+    check(rig.fromPc - before == 5, "cannelloni packet of 5 reaches the bus");
+
+    tcp.replies.clear();
+    tcp.send("L\rt1232A501\r");
+    run(rig, tcp, udp, 100);
+    check(tcp.replies == ".!" && rig.fromPc - before == 5, "listen only (L) refuses frames");
+}
+
+static void testCodecs() {
+    printf("\n[Codecs]\n");
+    CAN_FRAME frame = {};
+    frame.id = 0x00450041;
+    frame.extended = 1;
+    frame.length = 2;
+    frame.data.uint8[0] = 0xD2;
+    frame.data.uint8[1] = 0x00;
+    char line[SLCAN_MAX_LINE];
+    size_t n = slcanEncode(frame, 0x1234, line, sizeof(line));
+    check(n == 19 && memcmp(line, "T004500412D2001234\r", n) == 0, "slcan T line with timestamp");
+    CAN_FRAME back;
+    check(slcanParseFrame(line, n - 1, back) && sameFrame(frame, back), "slcan round trip");
+    check(!slcanParseFrame("t12", 3, back) && !slcanParseFrame("t1239", 5, back) &&
+          !slcanParseFrame("T2000000000", 10, back), "slcan malformed lines refused");
+
+    CAN_FRAME rtr = {};
+    rtr.id = 0x00300041;
+    rtr.extended = 1;
+    rtr.rtr = 1;
+    uint8_t packet[64];
+    size_t len = cannelloniEncodeHeader(7, 2, packet);
+    len += cannelloniEncodeFrame(frame, packet + len, sizeof(packet) - len);
+    len += cannelloniEncodeFrame(rtr, packet + len, sizeof(packet) - len);
+    static const uint8_t EXPECTED[] = { 2, 0, 7, 0, 2,  0x80, 0x45, 0x00, 0x41, 2, 0xD2, 0x00,
+                                        0xC0, 0x30, 0x00, 0x41, 0 };
+    check(len == sizeof(EXPECTED) && memcmp(packet, EXPECTED, len) == 0, "cannelloni v2 packet layout");
+    std::vector<CAN_FRAME> decoded;
+    int count = cannelloniDecode(packet, len, [](void *ctx, const CAN_FRAME &f) {
+        static_cast<std::vector<CAN_FRAME>*>(ctx)->push_back(f);
+    }, &decoded);
+    check(count == 2 && sameFrame(decoded[0], frame) && sameFrame(decoded[1], rtr), "cannelloni round trip");
+    check(cannelloniDecode(packet, len - 3, [](void *, const CAN_FRAME &) {}, nullptr) < 0, "truncated packet refused");
+}
+
+static void serve(const char *peer, uint16_t peerPort) {
+    Rig rig;
+    if (!rig.gateway.begin(CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT, peer, peerPort)) {
+        fprintf(stderr, "gateway: cannot open tcp/%u or udp/%u\n", CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT);
+        exit(EXIT_FAILURE);
+    }
+    printf("slcan on tcp/%u, cannelloni on udp/%u%s%s, simulated MVHR at a realistic rate\n",
+           CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT, peer ? " -> " : "", peer ? peer : "");
+    rig.simOn = true;
+    uint32_t lastReport = nowMs();
+    for (;;) {
+        rig.step();
+        usleep(200);
+        if (nowMs() - lastReport >= 10000) {
+            char json[512];
+            rig.gateway.toJson(json, sizeof(json));
+            printf("%u frames on the bus, %u from the PC: %s\n", rig.published, rig.fromPc, json);
+            lastReport = nowMs();
+        }
+    }
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1 && strcmp(argv[1], "serve") == 0) {
+        serve(argc > 2 ? argv[2] : nullptr, argc > 3 ? strtoul(argv[3], nullptr, 10) : 0);
+        return EXIT_SUCCESS;
+    }
+
+    printf("\n========== CAN GATEWAY BENCHMARK ==========\n");
+    testCodecs();
+    testForwarding(10, 2);
+    testForwarding(100, 2);
+    testFromPc();
+    printf("\n========== %s (%d failed) ==========\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+// ============================================================================
+// CAN PORT BENCHMARK - host build (env:native_bench)
+// ============================================================================
+// Runs the device's receive path (PdoCache -> pdoDecode -> PdoRouter) and
+// CanTxQueue against a CanPort on Linux and reports ns per frame:
+//   - decode only: the pipeline without a port
+//   - loopback, one thread: transmit + read + pipeline
+//   - loopback, producer thread -> consumer: throughput and RX -> decode
+//     latency (LatencyHistogram)
+//   - CanTxQueue draining jobs through the port
+// With an interface name the last three also run over SocketCAN, e.g.
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//   pio run -e native_bench && .pio/build/native_bench/program vcan0
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "comfoair/can_tx_queue.h"
+#include "comfoair/loopback_port.h"
+#include "comfoair/socketcan_port.h"
+#include "rx_pipeline.h"
+
+using namespace comfoair;
+
+static const uint32_t FRAMES = 1000000;
+static const uint32_t TX_JOBS = 200000;
+
+// PDOIDs seen on the bus in one broadcast cycle (routed and unrouted)
+static const uint16_t FRAME_MIX[] = {
+    65, 117, 118, 119, 120, 121, 122, 128, 129, 130, 209, 213, 216, 220, 221,
+    274, 275, 276, 277, 278, 290, 291, 292, 293, 294, 321, 325, 328, 329, 67
+};
+static const uint8_t FRAME_MIX_COUNT = sizeof(FRAME_MIX) / sizeof(FRAME_MIX[0]);
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Same clock as the loopback bus and SocketCanPort stamps
+static uint32_t nowUs() {
+    return SocketCanPort::monotonicUs();
+}
+
+// Frame i of the mix; the payload changes every cycle so the cache passes it
+static CAN_FRAME mixFrame(uint32_t i) {
+    CAN_FRAME frame = {};
+    uint16_t pdoid = FRAME_MIX[i % FRAME_MIX_COUNT];
+    uint32_t cycle = i / FRAME_MIX_COUNT;
+    frame.id = pdoCanId(pdoid, 1);
+    frame.extended = 1;
+    frame.length = 4;
+    frame.data.uint32[0] = cycle * 37;
+    return frame;
+}
+
+static void report(const char *label, uint32_t frames, uint64_t ns) {
+    printf("  %-28s %9u frames  %7.1f ns/frame  %6.2f Mframes/s\n", label, frames,
+           frames ? (double)ns / frames : 0.0, ns ? frames * 1000.0 / ns : 0.0);
+}
+
+static void reportLatency(const LatencyHistogram &h) {
+    printf("  %-28s avg %u us  p50 %u us  p99 %u us  max %u us\n", "RX -> decode",
+           h.averageUs(), h.percentileUs(500), h.percentileUs(990), h.maxUs);
+}
+
+static void benchDecode() {
+    RxPipeline pipe(nowUs);
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        pipe.process(mixFrame(i), i / 1000);
+    }
+    report("decode only", FRAMES, nowNs() - start);
+}
+
+static void benchInline(const char *label, CanPort &tx, CanPort &rx) {
+    RxPipeline pipe(nowUs);
+    CAN_FRAME frame;
+    uint32_t received = 0;
+    uint64_t start = nowNs();
+    for (uint32_t i = 0; i < FRAMES; i++) {
+        while (!tx.transmit(mixFrame(i))) {}
+        while (rx.read(frame)) {
+            pipe.process(frame, i / 1000);
+            received++;
+        }
+    }
+    report(label, received, nowNs() - start);
+    if (received != FRAMES) printf("  lost %u frames\n", FRAMES - received);
+}
+
+// Producer paced by the receiver's backlog, so nothing is lost on the
+// loopback ring; over SocketCAN the kernel queues push back instead
+static void benchThreaded(const char *label, CanPort &tx, CanPort &rx, uint32_t maxBacklog) {
+    RxPipeline pipe(nowUs);
+    std::atomic<bool> done(false);
+
+    uint64_t start = nowNs();
+    std::thread producer([&]() {
+        for (uint32_t i = 0; i < FRAMES; i++) {
+            while (maxBacklog && rx.rxPending() >= maxBacklog) std::this_thread::yield();
+            while (!tx.transmit(mixFrame(i))) std::this_thread::yield();
+        }
+        done = true;
+    });
+
+    CAN_FRAME frame;
+    uint32_t received = 0;
+    uint32_t idleSince = 0;
+    while (received < FRAMES) {
+        if (rx.read(frame)) {
+            pipe.process(frame, received / 1000);
+            received++;
+            idleSince = 0;
+        } else if (done) {
+            // Whatever is still missing was dropped
+            if (!idleSince) idleSince = nowUs();
+            else if (nowUs() - idleSince > 200000) break;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    uint64_t ns = nowNs() - start;
+    producer.join();
+
+    report(label, received, ns);
+    reportLatency(pipe.rxToDecode);
+    if (received != FRAMES) printf("  lost %u frames\n", FRAMES - received);
+}
+
+static void benchTxQueue(const char *label, CanPort &tx, CanPort &rx) {
+    CanTxQueue queue(canTxDriver(tx));
+    CAN_FRAME frame;
+    uint32_t enqueued = 0;
+    uint32_t received = 0;
+
+    uint64_t start = nowNs();
+    while (queue.stats().completed + queue.stats().failed < TX_JOBS) {
+        while (enqueued < TX_JOBS && queue.depth() < CanTxQueue::MAX_JOBS) {
+            CAN_FRAME job = mixFrame(enqueued++);
+            queue.enqueue(TxPriority::COMMAND, &job, 1);
+        }
+        queue.poll(nowUs() / 1000);
+        while (rx.read(frame)) received++;
+    }
+    uint64_t ns = nowNs() - start;
+    while (rx.read(frame)) received++;
+
+    report(label, TX_JOBS, ns);
+    printf("  %-28s completed %u  failed %u  retries %u  received %u\n", "",
+           queue.stats().completed, queue.stats().failed, queue.stats().retries, received);
+}
+
+int main(int argc, char **argv) {
+    printf("\n========== CAN PORT BENCHMARK ==========\n");
+    benchDecode();
+
+    LoopbackBus bus;
+    LoopbackPort bridge(bus, "loopback-tx");
+    LoopbackPort display(bus, "loopback-rx");
+    bridge.begin(50000);
+    display.begin(50000);
+
+    printf("\n[loopback]\n");
+    benchInline("transmit + read + decode", bridge, display);
+    benchThreaded("producer -> consumer", bridge, display, LOOPBACK_RX_RING_SIZE);
+    benchTxQueue("CanTxQueue jobs", bridge, display);
+
+    if (argc > 1) {
+        SocketCanPort sender(argv[1]);
+        SocketCanPort receiver(argv[1]);
+        if (!sender.begin(50000) || !receiver.begin(50000)) {
+            return EXIT_FAILURE;
+        }
+        printf("\n[socketcan %s]\n", argv[1]);
+        benchInline("transmit + read + decode", sender, receiver);
+        benchThreaded("producer -> consumer", sender, receiver, 0);
+        benchTxQueue("CanTxQueue jobs", sender, receiver);
+    }
+
+    printf("\n========== DONE ==========\n");
+    return EXIT_SUCCESS;
+}
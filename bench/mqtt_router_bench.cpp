@@ -0,0 +1,255 @@
+// ============================================================================
+// MQTT TOPIC ROUTER BENCHMARK - TopicRouter vs. std::map (env:native_mqtt)
+// ============================================================================
+// Every topic the firmware subscribes to (command table, ventilation_level,
+// set_mode, /can/raw and the state topic of every PDO a remote panel reads
+// back) into both:
+//   - map: the old MQTT::callbackMap, std::map<std::string, std::function>
+//     looked up with operator[] (a std::string built per message)
+//   - router: TopicRouter::dispatch()
+//   1. checks: every topic reaches its own handler, re-adding replaces,
+//      unknown topics miss cleanly, hit counters, full table / pool
+//   2. ns per inbound message, all hits and a 50 % miss mix (the map is
+//      measured with find() there: operator[] calls an empty std::function
+//      for an unknown topic and throws)
+//   3. heap: allocations to build the table and per 1000 messages
+//
+//   pio run -e native_mqtt && .pio/build/native_mqtt/program
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <functional>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+#include "comfoair/commands.h"
+#include "mqtt/topic_router.h"
+
+#ifndef MQTT_PREFIX
+  #define MQTT_PREFIX "comfoair"
+#endif
+#include "comfoair/pdo_topics_gen.h"
+
+using namespace comfoair;
+
+static const uint32_t ITERATIONS = 200;
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %s %s\n", ok ? "✅" : "❌", what);
+    if (!ok) failures++;
+}
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Global operator new counter, for the heap comparison
+static uint32_t allocations = 0;
+
+void *operator new(size_t size) {
+    allocations++;
+    void *p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+// Handler context: which topic index it belongs to, calls seen
+struct Target {
+    uint16_t index;
+    uint32_t calls;
+    uint32_t bytes;
+};
+
+static void onMessage(void *context, const char *topic, const uint8_t *payload, unsigned int length) {
+    Target *target = static_cast<Target*>(context);
+    target->calls++;
+    target->bytes += length;
+}
+
+static std::vector<std::string> firmwareTopics() {
+    std::vector<std::string> topics;
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+        topics.push_back(std::string(MQTT_PREFIX "/commands/") + COMMANDS[i].name);
+    }
+    topics.push_back(MQTT_PREFIX "/commands/ventilation_level");
+    topics.push_back(MQTT_PREFIX "/commands/set_mode");
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+        if (PDO_DESCRIPTORS[i].route != PdoRoute::NONE) topics.push_back(PDO_TOPICS[i]);
+    }
+    topics.push_back(MQTT_PREFIX "/can/raw");
+    return topics;
+}
+
+typedef std::map<std::string, std::function<void(char*, uint8_t*, unsigned int)>> CallbackMap;
+
+static void runChecks(const std::vector<std::string> &topics, std::vector<Target> &targets) {
+    printf("\n[Checks, %zu topics]\n", topics.size());
+    static TopicRouter router;
+
+    bool added = true;
+    char topic[64];
+    for (size_t i = 0; i < topics.size(); i++) {
+        snprintf(topic, sizeof(topic), "%s", topics[i].c_str());   // stack buffer, as ComfoAir::setup()
+        added = router.add(topic, onMessage, &targets[i]) && added;
+        memset(topic, 'x', sizeof(topic) - 1);
+    }
+    check(added && router.routeCount() == topics.size(), "every firmware topic fits (MQTT_MAX_ROUTES, MQTT_TOPIC_POOL_SIZE)");
+
+    bool sorted = true;
+    for (uint8_t i = 1; i < router.routeCount(); i++) sorted = sorted && router.route(i - 1).hash <= router.route(i).hash;
+    check(sorted, "routes sorted by topic hash");
+
+    const uint8_t payload[] = "2";
+    bool own = true;
+    for (size_t i = 0; i < topics.size(); i++) {
+        uint32_t before = targets[i].calls;
+        own = router.dispatch(topics[i].c_str(), payload, 1) && own;
+        own = own && targets[i].calls == before + 1;
+    }
+    check(own, "each topic reaches its own handler once");
+
+    Target replaced = { 0, 0, 0 };
+    router.add(topics[0].c_str(), onMessage, &replaced);
+    router.dispatch(topics[0].c_str(), payload, 1);
+    check(router.routeCount() == topics.size() && replaced.calls == 1 && targets[0].calls == 1,
+          "adding a topic again replaces its handler");
+
+    uint32_t calls = 0;
+    for (const Target &t : targets) calls += t.calls;
+    bool missed = !router.dispatch(MQTT_PREFIX "/commands/unknown", payload, 1) &&
+                  !router.dispatch(MQTT_PREFIX "/commands", payload, 1) &&
+                  !router.dispatch("", payload, 0);
+    uint32_t after = 0;
+    for (const Target &t : targets) after += t.calls;
+    check(missed && router.misses() == 3 && after == calls, "unknown topics miss without calling anything");
+
+    uint32_t hits = 0;
+    for (uint8_t i = 0; i < router.routeCount(); i++) hits += router.route(i).hits;
+    check(hits == topics.size() + 1, "per route hit counters");
+
+    char json[4096];
+    size_t len = router.toJson(json, sizeof(json));
+    check(len > 0 && strncmp(json, "{\"routes\":", 10) == 0 && json[len - 1] == '}', "toJson()");
+    char small[48];
+    len = router.toJson(small, sizeof(small));
+    check(len < sizeof(small) && small[len] == '\0' && small[len - 1] == '}', "toJson() truncated to a closed document");
+
+    static TopicRouter full;
+    bool refused = false;
+    for (uint16_t i = 0; i < 1000 && !refused; i++) {
+        snprintf(topic, sizeof(topic), MQTT_PREFIX "/full/%u", i);
+        refused = !full.add(topic, onMessage, nullptr);
+    }
+    check(refused && full.routeCount() <= TopicRouter::MAX_ROUTES, "full table refuses new topics");
+    check(!full.add("x", nullptr, nullptr), "null handler refused");
+
+    // Hash collisions: same bucket, told apart by strcmp()
+    static TopicRouter colliding;
+    Target a = { 0, 0, 0 }, b = { 1, 0, 0 };
+    colliding.add("costarring", onMessage, &a);     // FNV-1a 32 collision pair
+    colliding.add("liquid", onMessage, &b);
+    bool collide = TopicRouter::hash("costarring") == TopicRouter::hash("liquid");
+    colliding.dispatch("liquid", payload, 1);
+    colliding.dispatch("costarring", payload, 1);
+    colliding.dispatch("costarring", payload, 1);
+    check(collide && a.calls == 2 && b.calls == 1, "colliding hashes reach their own handler");
+}
+
+static void runBench(const std::vector<std::string> &topics) {
+    printf("\n[Lookup, %zu topics, %u rounds]\n", topics.size(), ITERATIONS);
+    std::vector<Target> targets(topics.size());
+
+    uint32_t before = allocations;
+    CallbackMap map;
+    for (size_t i = 0; i < topics.size(); i++) {
+        Target *target = &targets[i];
+        map[topics[i].c_str()] = [target](char *topic, uint8_t *payload, unsigned int length) {
+            onMessage(target, topic, payload, length);
+        };
+    }
+    uint32_t mapBuild = allocations - before;
+
+    before = allocations;
+    static TopicRouter router;
+    for (size_t i = 0; i < topics.size(); i++) router.add(topics[i].c_str(), onMessage, &targets[i]);
+    uint32_t routerBuild = allocations - before;
+
+    // PubSubClient hands the callback a char* into its buffer
+    std::vector<std::vector<char>> inbound;
+    for (const std::string &t : topics) inbound.emplace_back(t.c_str(), t.c_str() + t.size() + 1);
+    std::vector<std::vector<char>> unknown;
+    for (const std::string &t : topics) {
+        std::string u = t + "/x";
+        unknown.emplace_back(u.c_str(), u.c_str() + u.size() + 1);
+    }
+    uint8_t payload[] = "21.5";
+    uint32_t messages = ITERATIONS * topics.size();
+
+    before = allocations;
+    uint64_t t0 = nowNs();
+    for (uint32_t n = 0; n < ITERATIONS; n++) {
+        for (std::vector<char> &topic : inbound) map[topic.data()](topic.data(), payload, 4);
+    }
+    double mapHit = (double)(nowNs() - t0) / messages;
+    uint32_t mapAllocs = allocations - before;
+
+    before = allocations;
+    t0 = nowNs();
+    for (uint32_t n = 0; n < ITERATIONS; n++) {
+        for (std::vector<char> &topic : inbound) router.dispatch(topic.data(), payload, 4);
+    }
+    double routerHit = (double)(nowNs() - t0) / messages;
+    uint32_t routerAllocs = allocations - before;
+
+    t0 = nowNs();
+    for (uint32_t n = 0; n < ITERATIONS; n++) {
+        for (size_t i = 0; i < inbound.size(); i++) {
+            char *topic = (i & 1) ? unknown[i].data() : inbound[i].data();
+            CallbackMap::iterator it = map.find(topic);
+            if (it != map.end()) it->second(topic, payload, 4);
+        }
+    }
+    double mapMix = (double)(nowNs() - t0) / messages;
+
+    t0 = nowNs();
+    for (uint32_t n = 0; n < ITERATIONS; n++) {
+        for (size_t i = 0; i < inbound.size(); i++) {
+            char *topic = (i & 1) ? unknown[i].data() : inbound[i].data();
+            router.dispatch(topic, payload, 4);
+        }
+    }
+    double routerMix = (double)(nowNs() - t0) / messages;
+
+    uint32_t calls = 0;
+    for (const Target &t : targets) calls += t.calls;
+    uint32_t evens = (topics.size() + 1) / 2;
+    check(calls == 2 * messages + 2 * ITERATIONS * evens, "map and router called the same handlers");
+
+    printf("  %-8s %10s %10s %14s %16s\n", "", "hit ns", "50% miss", "build allocs", "allocs/1000 msg");
+    printf("  %-8s %10.1f %10.1f %14u %16.1f\n", "map", mapHit, mapMix, mapBuild, mapAllocs * 1000.0 / messages);
+    printf("  %-8s %10.1f %10.1f %14u %16.1f\n", "router", routerHit, routerMix, routerBuild, routerAllocs * 1000.0 / messages);
+    printf("  router %.1fx faster on hits, %.1fx on the miss mix, %zu bytes static\n",
+           routerHit > 0 ? mapHit / routerHit : 0.0, routerMix > 0 ? mapMix / routerMix : 0.0, sizeof(TopicRouter));
+    check(routerAllocs == 0 && routerBuild == 0, "router: no heap to build or dispatch");
+}
+
+int main() {
+    printf("\n========== MQTT TOPIC ROUTER ==========\n");
+    std::vector<std::string> topics = firmwareTopics();
+    std::vector<Target> targets(topics.size());
+    runChecks(topics, targets);
+    runBench(topics);
+    printf("\n==========================================\n");
+    printf("%s\n", failures ? "❌ FAILURES" : "✅ ALL CHECKS PASSED");
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,230 @@
+// ============================================================================
+// MVHR LOAD BENCHMARK - simulator against the receive path (env:native_sim)
+// ============================================================================
+// MvhrSimulator on one LoopbackPort, the display side on another, both on
+// simulated time:
+//   1. regression: RTRs for 49 / 66 / 192 / 212, the time request and a few
+//      commands, checked against what comes back
+//   2. load ramp: the simulator fills 10..100 % of 50 kbit/s while a model
+//      of ComfoAir::loop() drains CAN_RX_BUDGET frames per iteration and
+//      stalls for the display refresh; reports offered / consumed frames/s,
+//      ring high water and overflows, i.e. the stall that loses frames
+//   3. host ceiling: the simulator beyond the wire (setLoad > 100) and the
+//      host CPU time per frame of the receive pipeline
+//
+//   pio run -e native_sim && .pio/build/native_sim/program [loop_us] [stall_ms]
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include "comfoair/commands.h"
+#include "comfoair/loopback_port.h"
+#include "comfoair/mvhr_simulator.h"
+#include "comfoair/rmi_reassembler.h"
+#include "rx_pipeline.h"
+
+using namespace comfoair;
+
+#ifndef CAN_RX_BUDGET
+  #define CAN_RX_BUDGET 16
+#endif
+
+static const uint8_t DISPLAY_NODE = 0x11;
+
+static uint32_t sim_us = 0;
+static uint32_t simClock() { return sim_us; }
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static int failures = 0;
+
+static void check(bool ok, const char *what) {
+    printf("  %s %s\n", ok ? "✅" : "❌", what);
+    if (!ok) failures++;
+}
+
+struct Rig {
+    LoopbackBus bus;
+    LoopbackPort display;
+    LoopbackPort mvhr;
+    MvhrSimulator sim;
+    RxPipeline pipe;
+
+    Rig() : bus(simClock), display(bus, "display"), mvhr(bus, "mvhr"), sim(mvhr), pipe(simClock) {
+        display.begin(MVHR_SIM_BITRATE);
+        sim.begin();
+    }
+
+    // Advance simulated time, the simulator polled every 100 us
+    void run(uint32_t us, bool drain = true) {
+        for (uint32_t end = sim_us + us; (int32_t)(sim_us - end) < 0; sim_us += 100) {
+            sim.poll(sim_us);
+            CAN_FRAME frame;
+            while (drain && display.read(frame)) pipe.process(frame, sim_us / 1000);
+        }
+    }
+
+    void rtr(uint32_t canId) {
+        CAN_FRAME frame = {};
+        frame.id = canId;
+        frame.extended = 1;
+        frame.rtr = 1;
+        display.transmit(frame);
+    }
+
+    // Same segmentation as ComfoMessage::sendRmi()
+    void command(CommandId id, uint8_t seq) {
+        const CommandDescriptor &cmd = commandDescriptor(id);
+        uint32_t canId = (0x1FUL << 24) | ((uint32_t)(seq & 0x3) << 17) | (1UL << 16) |
+                         ((uint32_t)MvhrSimulator::NODE << 6) | DISPLAY_NODE;
+        CAN_FRAME frame = {};
+        frame.extended = 1;
+        if (cmd.length <= 8) {
+            frame.id = canId;
+            frame.length = cmd.length;
+            memcpy(frame.data.uint8, cmd.payload, cmd.length);
+            display.transmit(frame);
+            return;
+        }
+        frame.id = canId | (1UL << 14);
+        uint8_t last = (cmd.length - 1) / 7;
+        for (uint8_t i = 0; i <= last; i++) {
+            uint8_t n = (i == last) ? cmd.length - i * 7 : 7;
+            frame.data.uint8[0] = (i == last) ? (i | 0x80) : i;
+            memcpy(&frame.data.uint8[1], &cmd.payload[i * 7], n);
+            frame.length = n + 1;
+            display.transmit(frame);
+        }
+    }
+};
+
+static void testRegression() {
+    printf("\n[Regression]\n");
+    Rig rig;
+    rig.run(1000);
+
+    rig.rtr(pdoCanId(PDO_OPERATING_MODE, 1));
+    rig.rtr(pdoCanId(PDO_BYPASS_ACTIVATION_MODE, 1));
+    rig.rtr(pdoCanId(PDO_FILTER_DAYS, 1));
+    rig.rtr(pdoCanId(PDO_TARGET_TEMP, 1));
+    rig.rtr(0x10080028);
+    rig.run(50000);
+    check(rig.sim.stats().rtrAnswered == 4, "4 PDO RTRs answered");
+    check(rig.pipe.lastRaw(PDO_OPERATING_MODE) == 0xFF, "operating_mode = auto");
+    check(rig.pipe.lastRaw(PDO_FILTER_DAYS) == 143, "filter days received");
+    check(rig.pipe.lastRaw(PDO_TARGET_TEMP) == 210, "target temp 21.0");
+    check(rig.sim.stats().timeRequests == 1 &&
+          rig.pipe.lastRaw(PDO_DEVICE_TIME) == (int32_t)rig.sim.deviceTime(), "time request answered");
+
+    rig.command(CommandId::VENTILATION_LEVEL_3, 1);
+    rig.command(CommandId::TEMP_PROFILE_WARM, 2);
+    rig.command(CommandId::MANUAL, 3);
+    rig.run(50000);
+    check(rig.sim.stats().commands == 3, "3 multi-frame commands recognised");
+    check(rig.sim.fanSpeed() == 3 && rig.pipe.lastRaw(PDO_FAN_SPEED) == 3, "fan_speed 3 broadcast");
+    check(rig.sim.tempProfile() == 2 && rig.pipe.lastRaw(PDO_TEMP_PROFILE) == 2, "temp_profile warm broadcast");
+    check(rig.pipe.lastRaw(PDO_TARGET_TEMP) == 235, "target temp follows the profile");
+    check(rig.pipe.lastRaw(PDO_OPERATING_MODE) == 1, "operating_mode = limited_manual");
+
+    rig.command(CommandId::BOOST_10_MIN, 0);
+    rig.run(50000);
+    check(rig.pipe.lastRaw(81) > 590, "boost: next_fan_change ~600 s");
+    rig.command(CommandId::VENTILATION_LEVEL_1, 1);
+    rig.command(CommandId::BOOST_END, 2);
+    rig.run(50000);
+    check(rig.pipe.lastRaw(PDO_FAN_SPEED) == 1, "fan_speed 1 after boost end");
+
+    rig.sim.setAlarm(328, true);
+    rig.run(50000);
+    check(rig.pipe.lastRaw(328) == 1, "filter alarm broadcast");
+    rig.rtr(pdoCanId(200, 1));
+    rig.run(50000);
+    check(rig.sim.stats().rtrUnknown == 1, "RTR for an unknown PDOID ignored");
+}
+
+// One ComfoAir::loop() model run: iteration every loopUs, a stall of
+// stallMs every second
+static void loadStep(uint16_t load, uint32_t loopUs, uint32_t stallMs) {
+    Rig rig;
+    rig.sim.setLoad(load);
+    const uint32_t seconds = 10;
+    uint32_t nextLoopUs = sim_us;
+    uint32_t nextStallUs = sim_us + 1000000;
+    uint32_t start = sim_us;
+    uint64_t cpuNs = 0;
+
+    while (sim_us - start < seconds * 1000000) {
+        rig.sim.poll(sim_us);
+        if ((int32_t)(sim_us - nextLoopUs) >= 0) {
+            uint64_t t0 = nowNs();
+            CAN_FRAME frame;
+            for (uint8_t budget = CAN_RX_BUDGET; budget && rig.display.read(frame); budget--) {
+                rig.pipe.process(frame, sim_us / 1000);
+            }
+            cpuNs += nowNs() - t0;
+            nextLoopUs += loopUs;
+            if (stallMs && (int32_t)(sim_us - nextStallUs) >= 0) {
+                nextLoopUs += stallMs * 1000;
+                nextStallUs += 1000000;
+            }
+        }
+        sim_us += 50;
+    }
+
+    CAN_RX_STATS rx = rig.display.getRxStats();
+    uint32_t offered = rig.sim.stats().broadcasts;
+    printf("  %4u%%  %6.0f fr/s offered  %6.0f fr/s consumed  ring %3u/%u  overflows %6u  %5.0f ns/frame\n",
+           load, offered / (double)seconds, rig.pipe.frames / (double)seconds,
+           rx.ringHighWater, rx.ringSize, rx.ringOverflows,
+           rig.pipe.frames ? (double)cpuNs / rig.pipe.frames : 0.0);
+}
+
+static void benchCeiling() {
+    printf("\n[Host ceiling, simulator beyond the wire]\n");
+    Rig rig;
+    rig.sim.setLoad(10000);         // 100 x 50 kbit/s
+    uint64_t cpuNs = 0;
+    for (uint32_t i = 0; i < 200000; i++) {
+        rig.sim.poll(sim_us);
+        uint64_t t0 = nowNs();
+        CAN_FRAME frame;
+        while (rig.display.read(frame)) rig.pipe.process(frame, sim_us / 1000);
+        cpuNs += nowNs() - t0;
+        sim_us += 10;
+    }
+    double ns = rig.pipe.frames ? (double)cpuNs / rig.pipe.frames : 0.0;
+    printf("  %u frames, %.0f ns/frame in the receive path -> ceiling ~%.0f frames/s\n",
+           rig.pipe.frames, ns, ns > 0 ? 1e9 / ns : 0.0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t loopUs = argc > 1 ? strtoul(argv[1], nullptr, 10) : 5000;
+    uint32_t stallMs = argc > 2 ? strtoul(argv[2], nullptr, 10) : 0;
+
+    printf("\n========== MVHR LOAD BENCHMARK ==========\n");
+    testRegression();
+
+    printf("\n[Load ramp, %u kbit/s, loop every %u us, %u ms stall per second]\n",
+           MVHR_SIM_BITRATE / 1000, loopUs, stallMs);
+    static const uint16_t LOADS[] = { 10, 25, 50, 75, 100 };
+    for (uint16_t load : LOADS) loadStep(load, loopUs, stallMs);
+
+    if (!stallMs) {
+        printf("\n[Display stall at 100 %% load]\n");
+        static const uint16_t STALLS[] = { 50, 100, 150, 200, 400 };
+        for (uint16_t stall : STALLS) {
+            printf("  stall %3u ms:", stall);
+            loadStep(100, loopUs, stall);
+        }
+    }
+
+    benchCeiling();
+
+    printf("\n========== %s (%d failed) ==========\n", failures ? "FAILED" : "PASSED", failures);
+    return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
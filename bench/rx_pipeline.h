@@ -0,0 +1,60 @@
+#ifndef RX_PIPELINE_H
+#define RX_PIPELINE_H
+
+// ============================================================================
+// RX PIPELINE - the device's route sink for host benchmarks
+// ============================================================================
+// PdoCache -> pdoDecode -> PdoRouter, with the subscriptions the managers
+// make on the device (handlers only count) and RX -> decode latency.
+// ============================================================================
+
+#include "comfoair/latency_stats.h"
+#include "comfoair/pdo_cache.h"
+#include "comfoair/pdo_router.h"
+
+struct RxPipeline {
+    typedef uint32_t (*Clock)();    // microseconds, same clock as the frame stamps
+
+    comfoair::PdoCache cache;
+    comfoair::PdoRouter router;
+    comfoair::LatencyHistogram rxToDecode;
+    Clock clock;
+    uint32_t frames;
+    uint32_t decoded;
+    uint32_t handled;
+    comfoair::PdoValue last[comfoair::PDO_TABLE_SIZE];
+
+    explicit RxPipeline(Clock clock) :
+        cache(1000), rxToDecode(), clock(clock), frames(0), decoded(0), handled(0), last() {
+        static const uint16_t ROUTED[] = { 65, 117, 118, 121, 122, 209, 213, 221, 274, 275, 276, 290, 291 };
+        for (uint16_t pdoid : ROUTED) {
+            router.subscribe(pdoid, [](void *ctx, const comfoair::PdoValue &) {
+                static_cast<RxPipeline*>(ctx)->handled++;
+            }, this);
+        }
+    }
+
+    void process(const CAN_FRAME &frame, uint32_t nowMs) {
+        frames++;
+        if (!comfoair::isPdoValueFrame(frame.id, frame.rtr)) return;
+        uint16_t pdoid = comfoair::pdoidFromCanId(frame.id);
+        if (frame.id == comfoair::CAN_ID_TIME_RESPONSE) pdoid = comfoair::PDO_DEVICE_TIME;
+        if (!cache.accept(pdoid, frame.data.uint8, frame.length, nowMs)) return;
+        comfoair::PdoValue value;
+        if (comfoair::pdoDecode(pdoid, frame.data.uint8, frame.length, value)) {
+            value.rxUs = frame.timestamp_us;
+            value.decodeUs = clock();
+            if (frame.timestamp_us) rxToDecode.record(value.decodeUs - value.rxUs);
+            decoded++;
+            last[pdoid] = value;
+            router.dispatch(value);
+        }
+    }
+
+    // Last decoded raw value, -1 if never seen
+    int32_t lastRaw(uint16_t pdoid) const {
+        return last[pdoid].desc ? last[pdoid].raw : -1;
+    }
+};
+
+#endif
@@ -0,0 +1,274 @@
+// ============================================================================
+// TRACE REPLAY BENCHMARK - recorded bus logs through decode (env:native_replay)
+// ============================================================================
+// Replays a candump / ASC log (see comfoair/trace_replay.h):
+//   1. values: every frame through the MQTT path of ComfoAir (change cache,
+//      decode, format) at the given speed; the published values go to
+//      out_file as "<trace time> <name> <payload>". The cache runs on trace
+//      time, so the stream is the same at any speed - diff it between
+//      builds to check that a decode change publishes identical values.
+//   2. routing: the same trace as fast as possible through a LoopbackPort
+//      and a model of ComfoAir::loop() (CAN_RX_BUDGET frames per
+//      iteration into the route pipeline), frames/s and ns per frame
+//   3. raw: the bridge's CAN_MQTT_RAW_MS mode, every frame into a
+//      RawFrameBatch flushed per 100 ms of trace time; messages and ns per
+//      frame against step 1, each batch decoded back and compared, damaged
+//      copies rejected whole
+//
+//   pio run -e native_replay && .pio/build/native_replay/program trace.log [speed] [out_file|-]
+//   speed: 1 = real time, N = N x, 0 = as fast as possible (default)
+// ============================================================================
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+#include "comfoair/loopback_port.h"
+#include "comfoair/pdo_cache.h"
+#include "comfoair/raw_frame_batch.h"
+#include "comfoair/trace_replay.h"
+#include "rx_pipeline.h"
+
+using namespace comfoair;
+
+#ifndef CAN_RX_BUDGET
+  #define CAN_RX_BUDGET 16
+#endif
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t hostClock() { return (uint32_t)(nowNs() / 1000); }
+
+static bool loadFile(const char *path, std::vector<char> &data) {
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    char chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(file);
+    return true;
+}
+
+static void printReplayStats(const TraceReplay::Stats &stats) {
+    printf("  %u lines, %u frames (%u skipped), trace %.3f s, replayed in %.3f s\n",
+           stats.lines, stats.frames, stats.skipped, stats.traceUs / 1e6, stats.elapsedUs / 1e6);
+    if (stats.retries || stats.maxLateUs) {
+        printf("  %u sink retries, max %u us behind schedule\n", stats.retries, stats.maxLateUs);
+    }
+}
+
+// ComfoAir::publishFrame() without the broker
+struct ValueStream {
+    PdoCache cache;
+    FILE *out;
+    const TraceReplay *replay;
+    uint32_t published;
+    uint64_t cpuNs;
+
+    explicit ValueStream(FILE *out) : out(out), replay(nullptr), published(0), cpuNs(0) {}
+
+    static bool sink(void *context, const CAN_FRAME &frame) {
+        ValueStream *self = static_cast<ValueStream*>(context);
+        uint64_t traceUs = self->replay->stats().traceUs;    // of this frame
+        if (!isPdoValueFrame(frame.id, frame.rtr)) return true;
+        uint64_t t0 = nowNs();
+        bool isTime = frame.id == CAN_ID_TIME_RESPONSE;
+        uint16_t pdoid = isTime ? PDO_DEVICE_TIME : pdoidFromCanId(frame.id);
+        PdoValue value;
+        if ((isTime || self->cache.accept(pdoid, frame.data.uint8, frame.length, traceUs / 1000)) &&
+            pdoDecode(pdoid, frame.data.uint8, frame.length, value)) {
+            char text[PDO_TEXT_SIZE];
+            pdoFormat(value, text, sizeof(text));
+            self->cpuNs += nowNs() - t0;
+            if (self->out) {
+                fprintf(self->out, "%llu.%06llu %s %s\n", (unsigned long long)(traceUs / 1000000),
+                        (unsigned long long)(traceUs % 1000000), value.name(), text);
+            }
+            self->published++;
+            return true;
+        }
+        self->cpuNs += nowNs() - t0;
+        return true;
+    }
+};
+
+static uint32_t replayValues(const std::vector<char> &trace, uint16_t speed, FILE *out) {
+    if (speed) printf("\n[Values, speed %ux]\n", speed);
+    else printf("\n[Values, speed max]\n");
+    TraceText text = { trace.data(), trace.size(), 0 };
+    ValueStream stream(out);
+    TraceReplay replay(TraceText::readLine, &text, ValueStream::sink, &stream);
+    stream.replay = &replay;
+
+    uint64_t t0 = nowNs();
+    replay.start(hostClock(), speed);
+    while (!replay.done()) replay.poll(hostClock(), 256);
+    uint64_t wallNs = nowNs() - t0;
+
+    const TraceReplay::Stats &stats = replay.stats();
+    printReplayStats(stats);
+    printf("  %u values published, %.0f frames/s end to end, %.0f ns/frame in cache + decode + format\n",
+           stream.published, wallNs ? stats.delivered * 1e9 / wallNs : 0.0,
+           stats.delivered ? (double)stream.cpuNs / stats.delivered : 0.0);
+    return stream.published;
+}
+
+// ComfoAir::publishRawFrame() / flushRawFrames() without the broker
+struct RawStream {
+    RawFrameBatch batch;
+    const TraceReplay *replay;
+    std::vector<CAN_FRAME> sent;    // frames of the open batch, to check decode
+    size_t checked;
+    uint64_t flushUs;
+    uint32_t messages, bytes, mismatches;
+    uint64_t cpuNs;
+
+    RawStream() : replay(nullptr), checked(0), flushUs(0), messages(0), bytes(0), mismatches(0), cpuNs(0) {}
+
+    // Decoded frame against the appended one, timestamp to the millisecond
+    static void check(void *context, const CAN_FRAME &frame) {
+        RawStream *self = static_cast<RawStream*>(context);
+        const CAN_FRAME &want = self->sent[self->checked++];
+        uint32_t base = self->sent[0].timestamp_us;
+        uint32_t stamp = base + (want.timestamp_us - base) / 1000 * 1000;
+        if (frame.id != want.id || frame.length != want.length || frame.rtr != want.rtr ||
+            (!frame.rtr && memcmp(frame.data.uint8, want.data.uint8, frame.length)) ||
+            frame.timestamp_us != stamp) {
+            self->mismatches++;
+        }
+    }
+
+    void flush() {
+        if (batch.empty()) return;
+        uint64_t t0 = nowNs();
+        size_t length;
+        const uint8_t *payload = batch.finish(length);
+        cpuNs += nowNs() - t0;
+        messages++;
+        bytes += length;
+        checked = 0;
+        if (RawFrameBatch::decode(payload, length, check, this) != (int)sent.size()) mismatches++;
+
+        // Cut short, or claiming a record more than it holds: rejected
+        // before a single frame is dispatched
+        std::vector<uint8_t> bad(payload, payload + length);
+        uint16_t frames = bad[2] | (bad[3] << 8);
+        bad[2] = (uint8_t)(frames + 1);
+        bad[3] = (uint8_t)((frames + 1) >> 8);
+        checked = 0;
+        if (RawFrameBatch::decode(payload, length - 1, check, this) != -1 ||
+            RawFrameBatch::decode(bad.data(), bad.size(), check, this) != -1 || checked != 0) {
+            mismatches++;
+        }
+        batch.reset();
+        sent.clear();
+    }
+
+    static bool sink(void *context, const CAN_FRAME &frame) {
+        RawStream *self = static_cast<RawStream*>(context);
+        uint64_t traceUs = self->replay->stats().traceUs;
+        if (traceUs - self->flushUs >= 100000) {
+            self->flush();
+            self->flushUs = traceUs;
+        }
+        CAN_FRAME stamped = frame;
+        stamped.timestamp_us = (uint32_t)traceUs;
+        uint64_t t0 = nowNs();
+        bool fits = self->batch.append(stamped);
+        self->cpuNs += nowNs() - t0;
+        if (!fits) {
+            self->flush();
+            self->batch.append(stamped);
+        }
+        self->sent.push_back(stamped);
+        return true;
+    }
+};
+
+static void replayRaw(const std::vector<char> &trace, uint32_t valueMessages) {
+    printf("\n[Raw frame batches, 100 ms, speed max]\n");
+    TraceText text = { trace.data(), trace.size(), 0 };
+    RawStream stream;
+    TraceReplay replay(TraceText::readLine, &text, RawStream::sink, &stream);
+    stream.replay = &replay;
+    replay.start(hostClock(), 0);
+    while (!replay.done()) replay.poll(hostClock(), 256);
+    stream.flush();
+
+    uint32_t delivered = replay.stats().delivered;
+    printf("  %u frames in %u messages (%.1f per message, %.1f bytes per frame), %u decode mismatches\n",
+           delivered, stream.messages, stream.messages ? (double)delivered / stream.messages : 0.0,
+           delivered ? (double)stream.bytes / delivered : 0.0, stream.mismatches);
+    printf("  %.0f ns/frame in append + finish, %.1fx fewer messages than the value stream\n",
+           delivered ? (double)stream.cpuNs / delivered : 0.0,
+           stream.messages ? (double)valueMessages / stream.messages : 0.0);
+}
+
+static uint32_t routeClockUs = 0;
+static uint32_t routeClock() { return routeClockUs; }
+
+static void replayRouting(const std::vector<char> &trace) {
+    printf("\n[Routing, LoopbackPort -> CAN_RX_BUDGET %u per loop, speed max]\n", CAN_RX_BUDGET);
+    TraceText text = { trace.data(), trace.size(), 0 };
+    LoopbackBus bus(routeClock);
+    LoopbackPort port(bus, "replay");
+    port.begin(50000);
+    RxPipeline pipe(routeClock);
+    TraceReplay replay(TraceText::readLine, &text, traceToLoopback, &port);
+
+    uint64_t cpuNs = 0;
+    uint32_t loops = 0;
+    replay.start(routeClockUs, 0);
+    while (!replay.done() || port.rxPending()) {
+        replay.poll(routeClockUs);
+        uint64_t t0 = nowNs();
+        CAN_FRAME frame;
+        for (uint8_t budget = CAN_RX_BUDGET; budget && port.read(frame); budget--) {
+            pipe.process(frame, routeClockUs / 1000);
+        }
+        cpuNs += nowNs() - t0;
+        routeClockUs += 100;
+        loops++;
+    }
+
+    printReplayStats(replay.stats());
+    CAN_RX_STATS rx = port.getRxStats();
+    double ns = pipe.frames ? (double)cpuNs / pipe.frames : 0.0;
+    printf("  %u frames routed, %u decoded, %u handled in %u loops, ring %u/%u\n",
+           pipe.frames, pipe.decoded, pipe.handled, loops, rx.ringHighWater, rx.ringSize);
+    printf("  %.0f ns/frame in the receive path -> ceiling ~%.0f frames/s\n", ns, ns > 0 ? 1e9 / ns : 0.0);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s trace.log [speed] [out_file|-]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    uint16_t speed = argc > 2 ? strtoul(argv[2], nullptr, 10) : 0;
+    FILE *out = nullptr;
+    if (argc > 3) {
+        out = strcmp(argv[3], "-") == 0 ? stdout : fopen(argv[3], "w");
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", argv[3]);
+            return EXIT_FAILURE;
+        }
+    }
+
+    std::vector<char> trace;
+    if (!loadFile(argv[1], trace)) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return EXIT_FAILURE;
+    }
+
+    printf("\n========== TRACE REPLAY: %s (%zu bytes) ==========\n", argv[1], trace.size());
+    uint32_t values = replayValues(trace, speed, out);
+    if (out && out != stdout) fclose(out);
+    replayRouting(trace);
+    replayRaw(trace, values);
+    printf("\n==========================================\n");
+    return EXIT_SUCCESS;
+}
@@ -2,18 +2,99 @@
 #define CANADDRESS_H
 
 #include <inttypes.h>
-#include <map>
+
+// ============================================================================
+// CAN ADDRESS - ComfoNet extended ID layout, encode and decode
+// ============================================================================
+// Every ComfoNet frame has a 29-bit ID with the sending node in bits [5:0]:
+//   PDO    [24:14] PDOID  [13:6] 0x01  [5:0] source node
+//   RMI    [28:24] 0x1F   [18:17] sequence  [16] request  [15] error
+//          [14] multi-message  [13:12] counter  [11:6] destination node
+//   NODE   [28:24] 0x10   heartbeats (0x10000000 | node), time request and
+//          response
+// The helpers are constexpr so fixed IDs and filter masks fold at compile
+// time; decoding a received ID is a few shifts.
+// ============================================================================
 
 namespace comfoair {
+
+  enum class CanIdKind : uint8_t {
+    PDO,
+    RMI,
+    NODE,
+    OTHER
+  };
+
+  constexpr uint8_t CAN_NODE_MASK = 0x3F;
+  constexpr uint32_t CAN_ID_NODE_BASE = 0x10000000;
+
+  constexpr uint8_t canIdSourceNode(uint32_t canId) { return canId & CAN_NODE_MASK; }
+
+  // ComfoNet PDO ID: (pdoid << 14) | 0x40 | node
+  constexpr uint32_t pdoCanId(uint16_t pdoid, uint8_t node) {
+    return ((uint32_t)pdoid << 14) | 0x40 | (node & CAN_NODE_MASK);
+  }
+  constexpr bool isPdoCanId(uint32_t canId) {
+    return (canId >> 25) == 0 && (canId & 0x3FC0) == 0x40;
+  }
+  constexpr uint16_t pdoidFromCanId(uint32_t canId) {
+    return (canId >> 14) & 0x7FF;
+  }
+
+  constexpr uint32_t nodeHeartbeatId(uint8_t node) { return CAN_ID_NODE_BASE | (node & CAN_NODE_MASK); }
+  constexpr bool isNodeHeartbeatId(uint32_t canId) { return (canId & ~(uint32_t)CAN_NODE_MASK) == CAN_ID_NODE_BASE; }
+
+  constexpr CanIdKind canIdKind(uint32_t canId) {
+    return ((canId >> 24) & 0x1F) == 0x1F ? CanIdKind::RMI
+         : ((canId >> 24) & 0x1F) == 0x10 ? CanIdKind::NODE
+         : isPdoCanId(canId)              ? CanIdKind::PDO
+         : CanIdKind::OTHER;
+  }
+
+  // RMI address fields
   class CanAddress {
     public:
-      CanAddress(uint8_t srcAddr, uint8_t dstAddr, uint8_t unknownCounter, bool multimsg, bool errorOccurred, bool isRequest, uint8_t seqNr);
-      uint32_t canID();
-      void canIDBuf(char *buf);
+      constexpr CanAddress(uint8_t srcAddr, uint8_t dstAddr, uint8_t unknownCounter, bool multimsg,
+                           bool errorOccurred, bool isRequest, uint8_t seqNr) :
+        srcAddr(srcAddr & CAN_NODE_MASK), dstAddr(dstAddr & CAN_NODE_MASK), unknownCounter(unknownCounter & 0x3),
+        seqNr(seqNr & 0x3), multimsg(multimsg), errorOccurred(errorOccurred), isRequest(isRequest) {}
+
+      static constexpr CanAddress fromCanId(uint32_t canId) {
+        return CanAddress(canId & CAN_NODE_MASK, (canId >> 6) & CAN_NODE_MASK, (canId >> 12) & 0x3,
+                          (canId >> 14) & 1, (canId >> 15) & 1, (canId >> 16) & 1, (canId >> 17) & 0x3);
+      }
+
+      constexpr uint32_t canID() const {
+        return (uint32_t)srcAddr
+             | ((uint32_t)dstAddr << 6)
+             | ((uint32_t)unknownCounter << 12)
+             | ((uint32_t)(multimsg ? 1 : 0) << 14)
+             | ((uint32_t)(errorOccurred ? 1 : 0) << 15)
+             | ((uint32_t)(isRequest ? 1 : 0) << 16)
+             | ((uint32_t)seqNr << 17)
+             | (0x1FUL << 24);
+      }
+      void canIDBuf(char *buf) const;
+
+      constexpr uint8_t srcNode() const { return srcAddr; }
+      constexpr uint8_t dstNode() const { return dstAddr; }
+      constexpr uint8_t counter() const { return unknownCounter; }
+      constexpr bool multiMsg() const { return multimsg; }
+      constexpr bool error() const { return errorOccurred; }
+      constexpr bool request() const { return isRequest; }
+      constexpr uint8_t seq() const { return seqNr; }
+
     private:
       uint8_t srcAddr, dstAddr, unknownCounter, seqNr;
       bool multimsg, errorOccurred, isRequest;
   };
+
+  static_assert(CanAddress::fromCanId(CanAddress(0x11, 0x01, 2, true, false, true, 3).canID()).canID() ==
+                CanAddress(0x11, 0x01, 2, true, false, true, 3).canID(), "CanAddress round trip");
+  static_assert(pdoidFromCanId(pdoCanId(276, 0x01)) == 276 && canIdSourceNode(pdoCanId(276, 0x01)) == 0x01,
+                "PDO ID round trip");
+  static_assert(canIdKind(0x10040001) == CanIdKind::NODE && canIdKind(0x00450041) == CanIdKind::PDO,
+                "ID kinds");
 }
 
-#endif
\ No newline at end of file
+#endif
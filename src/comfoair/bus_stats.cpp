@@ -0,0 +1,141 @@
+#include <stdio.h>
+#include <string.h>
+#include "bus_stats.h"
+#include "can_filter.h"
+
+namespace comfoair {
+
+  const char *canBusStateName(CanBusState state) {
+    switch (state) {
+      case CanBusState::STOPPED: return "stopped";
+      case CanBusState::RUNNING: return "running";
+      case CanBusState::BUS_OFF: return "bus_off";
+      case CanBusState::RECOVERING: return "recovering";
+    }
+    return "unknown";
+  }
+
+  BusStats::BusStats(uint32_t bitrate) : bitrate(bitrate) {
+    reset();
+  }
+
+  void BusStats::reset() {
+    memset(slotOf, 0xFF, sizeof(slotOf));
+    memset(pdos, 0, sizeof(pdos));
+    trackedCount = 0;
+    totalFrames = 0;
+    untracked = 0;
+    decodeFailures = 0;
+    windowStartUs = 0;
+    windowBits = 0;
+    load = 0;
+    peakLoad = 0;
+    memset(&bus, 0, sizeof(bus));
+  }
+
+  // 0: < 1 ms, n: [2^(n-1), 2^n) ms, last bucket open ended
+  uint8_t BusStats::jitterBucket(uint32_t deviationUs) {
+    uint32_t ms = deviationUs / 1000;
+    if (ms == 0) return 0;
+    uint8_t bucket = 32 - __builtin_clz(ms);
+    return bucket < JITTER_BUCKETS ? bucket : JITTER_BUCKETS - 1;
+  }
+
+  void BusStats::record(const CAN_FRAME &frame) {
+    totalFrames++;
+    // Extended frame without stuff bits: 67 + 8 per data byte (incl. IFS)
+    windowBits += 67 + (frame.rtr ? 0 : 8 * frame.length);
+
+    if (!frame.extended || frame.rtr || !isPdoCanId(frame.id)) return;
+    uint16_t pdoid = pdoidFromCanId(frame.id);
+    if (pdoid >= PDO_TABLE_SIZE) return;
+
+    uint8_t slot = slotOf[pdoid];
+    if (slot == 0xFF) {
+      if (trackedCount >= MAX_PDOS) {
+        untracked++;
+        return;
+      }
+      slot = trackedCount++;
+      slotOf[pdoid] = slot;
+      pdos[slot].pdoid = pdoid;
+    }
+
+    PdoStats &s = pdos[slot];
+    if (s.frames > 0) {
+      uint32_t interval = frame.timestamp_us - s.lastUs;
+      if (s.avgIntervalUs == 0) {
+        s.avgIntervalUs = interval;
+      } else {
+        int32_t diff = (int32_t)(interval - s.avgIntervalUs);
+        uint8_t bucket = jitterBucket(diff < 0 ? -diff : diff);
+        if (s.jitter[bucket] != 0xFFFF) s.jitter[bucket]++;
+        s.avgIntervalUs += diff / 8;
+      }
+    }
+    s.frames++;
+    s.lastUs = frame.timestamp_us;
+  }
+
+  void BusStats::tick(uint32_t nowUs) {
+    if (windowStartUs == 0) {
+      windowStartUs = nowUs;
+      return;
+    }
+    uint32_t elapsed = nowUs - windowStartUs;
+    if (elapsed < 1000000) return;
+
+    // bits / (bitrate * seconds), in permille
+    load = (uint16_t)((uint64_t)windowBits * 1000000000ULL / ((uint64_t)bitrate * elapsed));
+    if (load > peakLoad) peakLoad = load;
+    windowBits = 0;
+    windowStartUs = nowUs;
+  }
+
+  size_t BusStats::toJson(char *buf, size_t len, uint32_t nowUs, bool histograms) const {
+    if (len == 0) return 0;
+    size_t pos = 0;
+
+    // Appends only if the whole piece fits
+    auto append = [&](const char *piece, int n) {
+      if (n < 0 || pos + n + 3 >= len) return false;  // keep room for "]}"
+      memcpy(buf + pos, piece, n);
+      pos += n;
+      return true;
+    };
+
+    char piece[192];
+    int n = snprintf(piece, sizeof(piece),
+                     "{\"frames\":%u,\"load\":%u.%u,\"peak\":%u.%u,\"decode_fail\":%u,\"untracked\":%u,"
+                     "\"twai\":{\"state\":\"%s\",\"tec\":%u,\"rec\":%u,\"tx_failed\":%u,\"missed\":%u,"
+                     "\"overrun\":%u,\"arb_lost\":%u,\"bus_err\":%u},\"pdo\":[",
+                     totalFrames, load / 10, load % 10, peakLoad / 10, peakLoad % 10,
+                     decodeFailures, untracked, canBusStateName(bus.state),
+                     bus.txErrorCounter, bus.rxErrorCounter, bus.txFailed, bus.rxMissed,
+                     bus.rxOverrun, bus.arbLost, bus.busErrors);
+    if (!append(piece, n)) {
+      buf[0] = '\0';
+      return 0;
+    }
+
+    for (uint8_t i = 0; i < trackedCount; i++) {
+      const PdoStats &s = pdos[i];
+      // Rate in mHz: 1e9 / interval in us
+      uint32_t mhz = s.avgIntervalUs ? (uint32_t)(1000000000ULL / s.avgIntervalUs) : 0;
+      n = snprintf(piece, sizeof(piece), "%s[%u,%u,%u,%u",
+                   i ? "," : "", s.pdoid, s.frames, mhz, (nowUs - s.lastUs) / 1000);
+      if (n > 0 && histograms) {
+        for (uint8_t b = 0; b < JITTER_BUCKETS && n < (int)sizeof(piece); b++) {
+          n += snprintf(piece + n, sizeof(piece) - n, ",%u", s.jitter[b]);
+        }
+      }
+      if (n > 0 && n < (int)sizeof(piece) - 1) piece[n++] = ']';
+      if (!append(piece, n)) break;
+    }
+
+    buf[pos++] = ']';
+    buf[pos++] = '}';
+    buf[pos] = '\0';
+    return pos;
+  }
+}
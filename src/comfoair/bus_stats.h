@@ -0,0 +1,104 @@
+#ifndef BUS_STATS_H
+#define BUS_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+#include "pdo_table.h"
+
+// ============================================================================
+// BUS STATISTICS - per-PDOID rate / jitter, bus load, controller status
+// ============================================================================
+// record() runs for every received frame in loop(): a table lookup and a
+// few integer operations, fixed arrays only.
+//   - per PDOID (first MAX_PDOS seen): frame count, mean inter-arrival time
+//     (EWMA, 1/8), last-seen time and a log2 histogram of the deviation of
+//     each interval from the mean (jitter)
+//   - bus load from the bits of every received frame, per 1 s window
+//   - decode failures and the TWAI controller status (passed in, so this
+//     class has no driver dependency)
+// toJson() renders a compact snapshot for HTTP / MQTT. Per PDO an array
+//   [pdoid, frames, rate in mHz, age in ms, jitter bucket counts...]
+// ============================================================================
+
+namespace comfoair {
+
+  enum class CanBusState : uint8_t {
+    STOPPED,
+    RUNNING,
+    BUS_OFF,
+    RECOVERING
+  };
+
+  // Controller snapshot, see TWAIWrapper::getBusStatus()
+  struct CanBusStatus {
+    CanBusState state;
+    uint32_t txErrorCounter;    // TEC
+    uint32_t rxErrorCounter;    // REC
+    uint32_t txFailed;
+    uint32_t rxMissed;          // driver RX queue full
+    uint32_t rxOverrun;         // hardware RX FIFO overrun
+    uint32_t arbLost;
+    uint32_t busErrors;
+  };
+
+  const char *canBusStateName(CanBusState state);
+
+  class BusStats {
+    public:
+      static const uint8_t MAX_PDOS = 64;
+      static const uint8_t JITTER_BUCKETS = 10;  // <1 ms, <2, <4 ... <256, >=256 ms
+
+      struct PdoStats {
+        uint16_t pdoid;
+        uint32_t frames;
+        uint32_t lastUs;
+        uint32_t avgIntervalUs;
+        uint16_t jitter[JITTER_BUCKETS];  // saturating counts
+      };
+
+      explicit BusStats(uint32_t bitrate);
+
+      void record(const CAN_FRAME &frame);
+      void recordDecodeFailure() { decodeFailures++; }
+      void setBusStatus(const CanBusStatus &status) { bus = status; }
+
+      // Closes the bus load window once per second
+      void tick(uint32_t nowUs);
+
+      uint32_t frames() const { return totalFrames; }
+      uint16_t loadPermille() const { return load; }
+      uint16_t peakLoadPermille() const { return peakLoad; }
+      uint32_t decodeFailureCount() const { return decodeFailures; }
+      uint8_t pdoCount() const { return trackedCount; }
+      const PdoStats &pdo(uint8_t index) const { return pdos[index]; }
+      const CanBusStatus &busStatus() const { return bus; }
+
+      // Snapshot as JSON, histograms only when asked (they triple the size).
+      // Never truncates mid-entry; returns the length written.
+      size_t toJson(char *buf, size_t len, uint32_t nowUs, bool histograms) const;
+
+      void reset();
+
+      static uint8_t jitterBucket(uint32_t deviationUs);
+
+    private:
+      uint32_t bitrate;
+      uint8_t slotOf[PDO_TABLE_SIZE];   // PDOID -> index into pdos, 0xFF = none
+      PdoStats pdos[MAX_PDOS];
+      uint8_t trackedCount;
+
+      uint32_t totalFrames;
+      uint32_t untracked;               // PDOs beyond MAX_PDOS
+      uint32_t decodeFailures;
+
+      uint32_t windowStartUs;
+      uint32_t windowBits;
+      uint16_t load;                    // permille of bitrate, last window
+      uint16_t peakLoad;
+
+      CanBusStatus bus;
+  };
+}
+
+#endif
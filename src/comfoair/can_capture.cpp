@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <string.h>
+#include "can_capture.h"
+
+namespace comfoair {
+
+  static const uint8_t FLAG_EXTENDED = 0x10;
+  static const uint8_t FLAG_RTR = 0x20;
+
+  static uint8_t deltaBytes(uint32_t delta) {
+    if (delta < 0x100) return 1;
+    if (delta < 0x10000) return 2;
+    if (delta < 0x1000000) return 3;
+    return 4;
+  }
+
+  CanCapture::CanCapture() : buffer(nullptr), mask(0), paused(false), checkpointEvery(1) {
+    clear();
+  }
+
+  void CanCapture::begin(uint8_t *buffer, uint32_t size) {
+    this->buffer = buffer;
+    mask = 0;
+    if (buffer && size >= 2 * MAX_RECORD) {
+      uint32_t pow2 = 1;
+      while (pow2 <= size / 2) pow2 <<= 1;
+      mask = pow2 - 1;
+    }
+    // A full ring of the smallest records still fits MAX_CHECKPOINTS
+    checkpointEvery = 1;
+    while ((mask + 1) / MIN_RECORD / checkpointEvery > MAX_CHECKPOINTS) checkpointEvery <<= 1;
+    clear();
+  }
+
+  void CanCapture::clear() {
+    head = 0;
+    tail = 0;
+    headSeq = 0;
+    tailSeq = 0;
+    tailUs = 0;
+    lastUs = 0;
+    lastStamp = 0;
+    dropped = 0;
+    cpFirst = 0;
+    cpCount = 0;
+  }
+
+  uint32_t CanCapture::readLe(uint32_t pos, uint8_t bytes) const {
+    uint32_t value = 0;
+    for (uint8_t i = 0; i < bytes; i++) value |= (uint32_t)at(pos + i) << (8 * i);
+    return value;
+  }
+
+  uint8_t CanCapture::recordSize(uint32_t pos) const {
+    uint8_t flags = at(pos);
+    uint8_t dlc = flags & 0x0F;
+    return 1 + ((flags >> 6) + 1) + ((flags & FLAG_EXTENDED) ? 4 : 2) + ((flags & FLAG_RTR) ? 0 : dlc);
+  }
+
+  uint32_t CanCapture::recordDelta(uint32_t pos) const {
+    return readLe(pos + 1, (at(pos) >> 6) + 1);
+  }
+
+  void CanCapture::dropOldest() {
+    tail += recordSize(tail);
+    tailSeq++;
+    dropped++;
+    if (tail != head) tailUs += recordDelta(tail);
+    while (cpCount && (int32_t)(checkpoints[cpFirst].seq - tailSeq) < 0) {
+      cpFirst = (cpFirst + 1) % MAX_CHECKPOINTS;
+      cpCount--;
+    }
+  }
+
+  void CanCapture::addCheckpoint(const Cursor &c) {
+    if (cpCount == MAX_CHECKPOINTS) {
+      cpFirst = (cpFirst + 1) % MAX_CHECKPOINTS;
+      cpCount--;
+    }
+    checkpoints[(cpFirst + cpCount) % MAX_CHECKPOINTS] = c;
+    cpCount++;
+  }
+
+  void CanCapture::record(const CAN_FRAME &frame) {
+    if (!mask || paused) return;
+
+    bool first = headSeq == 0;
+    uint32_t delta = first ? 0 : frame.timestamp_us - lastStamp;
+    uint8_t dlc = frame.length > 8 ? 8 : frame.length;
+    uint8_t dataBytes = frame.rtr ? 0 : dlc;
+    uint8_t db = deltaBytes(delta);
+    uint8_t idBytes = frame.extended ? 4 : 2;
+    uint8_t size = 1 + db + idBytes + dataBytes;
+
+    while (head + size - tail > mask + 1) dropOldest();
+    bool empty = head == tail;
+
+    uint32_t pos = head;
+    buffer[pos++ & mask] = dlc | (frame.extended ? FLAG_EXTENDED : 0) | (frame.rtr ? FLAG_RTR : 0) |
+                           ((db - 1) << 6);
+    for (uint8_t i = 0; i < db; i++) buffer[pos++ & mask] = delta >> (8 * i);
+    for (uint8_t i = 0; i < idBytes; i++) buffer[pos++ & mask] = frame.id >> (8 * i);
+    for (uint8_t i = 0; i < dataBytes; i++) buffer[pos++ & mask] = frame.data.uint8[i];
+    head = pos;
+
+    lastUs = first ? frame.timestamp_us : lastUs + delta;
+    lastStamp = frame.timestamp_us;
+    if (empty) tailUs = lastUs;
+    if ((headSeq & (checkpointEvery - 1)) == 0) {
+      Cursor c = { head - size, headSeq, lastUs - delta };
+      addCheckpoint(c);
+    }
+    headSeq++;
+  }
+
+  CanCapture::Stats CanCapture::stats() const {
+    Stats s;
+    s.recorded = headSeq;
+    s.frames = headSeq - tailSeq;
+    s.dropped = dropped;
+    s.bytesUsed = head - tail;
+    s.capacity = mask ? mask + 1 : 0;
+    s.spanUs = head != tail ? lastUs - tailUs : 0;
+    s.paused = paused;
+    return s;
+  }
+
+  CanCapture::Cursor CanCapture::seek(uint32_t seq) const {
+    Cursor c = { tail, tailSeq, head != tail ? tailUs - recordDelta(tail) : 0 };
+    // Newest checkpoint at or before seq (all of them are past the tail)
+    uint16_t lo = 0, hi = cpCount;
+    while (lo < hi) {
+      uint16_t mid = (lo + hi) / 2;
+      if ((int32_t)(checkpoints[(cpFirst + mid) % MAX_CHECKPOINTS].seq - seq) <= 0) lo = mid + 1;
+      else hi = mid;
+    }
+    if (lo > 0) c = checkpoints[(cpFirst + lo - 1) % MAX_CHECKPOINTS];
+    CAN_FRAME frame;
+    uint64_t timeUs;
+    while ((int32_t)(c.seq - seq) < 0 && c.pos != head) next(c, frame, timeUs);
+    return c;
+  }
+
+  bool CanCapture::next(Cursor &c, CAN_FRAME &frame, uint64_t &timeUs) const {
+    if (c.pos == head) return false;
+
+    uint8_t flags = at(c.pos);
+    uint8_t db = (flags >> 6) + 1;
+    uint32_t pos = c.pos + 1;
+    timeUs = c.prevUs + readLe(pos, db);
+    pos += db;
+
+    memset(&frame, 0, sizeof(frame));
+    frame.extended = (flags & FLAG_EXTENDED) != 0;
+    frame.rtr = (flags & FLAG_RTR) != 0;
+    frame.length = flags & 0x0F;
+    uint8_t idBytes = frame.extended ? 4 : 2;
+    frame.id = readLe(pos, idBytes);
+    pos += idBytes;
+    if (!frame.rtr) {
+      for (uint8_t i = 0; i < frame.length; i++) frame.data.uint8[i] = at(pos++);
+    }
+    frame.timestamp_us = (uint32_t)timeUs;
+
+    c.pos = pos;
+    c.seq++;
+    c.prevUs = timeUs;
+    return true;
+  }
+
+  size_t CanCapture::copy(uint32_t from, uint32_t to, uint8_t *out, size_t len) const {
+    size_t n = to - from;
+    if (n > len) n = len;
+    for (size_t i = 0; i < n; i++) out[i] = at(from + i);
+    return n;
+  }
+
+  size_t CanCapture::formatCandump(const CAN_FRAME &frame, uint64_t timeUs, char *buf, size_t len) {
+    static const char HEX_DIGITS[] = "0123456789ABCDEF";
+    if (len < MAX_CANDUMP_LINE) return 0;
+
+    int n = snprintf(buf, len, frame.extended ? "(%u.%06u) can0 %08X#" : "(%u.%06u) can0 %03X#",
+                     (unsigned)(timeUs / 1000000), (unsigned)(timeUs % 1000000), (unsigned)frame.id);
+    if (n < 0) return 0;
+    size_t pos = n;
+    if (frame.rtr) {
+      buf[pos++] = 'R';
+      if (frame.length) buf[pos++] = '0' + (frame.length > 8 ? 8 : frame.length);
+    } else {
+      for (uint8_t i = 0; i < frame.length && i < 8; i++) {
+        buf[pos++] = HEX_DIGITS[frame.data.uint8[i] >> 4];
+        buf[pos++] = HEX_DIGITS[frame.data.uint8[i] & 0x0F];
+      }
+    }
+    buf[pos++] = '\n';
+    buf[pos] = '\0';
+    return pos;
+  }
+
+  size_t CanCapture::formatHeader(uint32_t firstSeq, uint32_t count, uint64_t baseUs, uint8_t *buf, size_t len) {
+    if (len < HEADER_SIZE) return 0;
+    memset(buf, 0, HEADER_SIZE);
+    memcpy(buf, "CCAP", 4);
+    buf[4] = 1;
+    for (uint8_t i = 0; i < 4; i++) buf[8 + i] = firstSeq >> (8 * i);
+    for (uint8_t i = 0; i < 4; i++) buf[12 + i] = count >> (8 * i);
+    for (uint8_t i = 0; i < 8; i++) buf[16 + i] = baseUs >> (8 * i);
+    return HEADER_SIZE;
+  }
+
+  void CanCaptureExport::begin(Format format, uint32_t fromSeq, uint32_t maxFrames, int64_t offsetUs) {
+    this->format = format;
+    this->offsetUs = offsetUs;
+    cursor = capture.seek(fromSeq);
+    first = cursor.seq;
+
+    end = cursor;
+    CAN_FRAME frame;
+    uint64_t timeUs;
+    for (uint32_t n = 0; n < maxFrames && capture.next(end, frame, timeUs); n++) {}
+
+    remaining = format == Format::BINARY ? end.pos - cursor.pos : end.seq - cursor.seq;
+    headerPending = format == Format::BINARY;
+  }
+
+  size_t CanCaptureExport::next(char *buf, size_t len) {
+    size_t pos = 0;
+
+    if (format == Format::BINARY) {
+      if (headerPending) {
+        pos = CanCapture::formatHeader(first, end.seq - first, cursor.prevUs + offsetUs, (uint8_t *)buf, len);
+        if (!pos) return 0;
+        headerPending = false;
+      }
+      size_t n = capture.copy(cursor.pos, cursor.pos + remaining, (uint8_t *)buf + pos, len - pos);
+      cursor.pos += n;
+      remaining -= n;
+      return pos + n;
+    }
+
+    CAN_FRAME frame;
+    uint64_t timeUs;
+    while (remaining && len - pos >= CanCapture::MAX_CANDUMP_LINE && capture.next(cursor, frame, timeUs)) {
+      pos += CanCapture::formatCandump(frame, timeUs + offsetUs, buf + pos, len - pos);
+      remaining--;
+    }
+    return pos;
+  }
+}
@@ -0,0 +1,146 @@
+#ifndef CAN_CAPTURE_H
+#define CAN_CAPTURE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+
+// ============================================================================
+// CAN CAPTURE - continuous raw frame recorder in a (PSRAM) byte ring
+// ============================================================================
+// A FrameFanout sink: every received frame is appended as a compact binary
+// record, no formatting. When the ring is full the oldest records are
+// dropped. At ~10 bytes per PDO frame 4 MB hold about 400k frames.
+//
+// Record layout (little endian):
+//   u8   flags: bits 0-3 dlc, bit 4 extended, bit 5 rtr,
+//               bits 6-7 size of the delta field - 1
+//   u8.. delta: microseconds since the previous record (1..4 bytes)
+//   u16 / u32  CAN id (standard / extended)
+//   u8[] data: dlc bytes, none for RTR frames
+//
+// Records are numbered from 0 in recording order (seq). Readers walk them
+// with a Cursor; times are reconstructed as 64-bit microseconds on the
+// frame stamp clock (timestamp_us, wraps handled). A Cursor is kept every
+// checkpointEvery records, so seek() walks at most that many instead of
+// the whole ring. record() and the readers must run in the same task.
+//
+// Binary export (format "binary"): a 24 byte header
+//   "CCAP", u8 version (1), u8[3] 0, u32 first seq, u32 record count,
+//   u64 base time (us) - the first record's time is base + its delta
+// followed by the records as stored.
+// ============================================================================
+
+namespace comfoair {
+
+  class CanCapture {
+    public:
+      static const uint8_t MAX_RECORD = 1 + 4 + 4 + 8;
+      static const uint8_t MAX_CANDUMP_LINE = 64;
+      static const uint8_t MIN_RECORD = 1 + 1 + 2;
+      static const uint16_t MAX_CHECKPOINTS = 256;
+
+      struct Cursor {
+        uint32_t pos;           // byte position of the record
+        uint32_t seq;
+        uint64_t prevUs;        // time of the record before it
+      };
+
+      struct Stats {
+        uint32_t recorded;      // since clear(), also the next seq
+        uint32_t frames;        // in the ring now
+        uint32_t dropped;       // overwritten by newer frames
+        uint32_t bytesUsed;
+        uint32_t capacity;
+        uint64_t spanUs;        // oldest -> newest
+        bool paused;
+      };
+
+      CanCapture();
+
+      // size is rounded down to a power of two; nullptr / 0 = disabled
+      void begin(uint8_t *buffer, uint32_t size);
+      bool enabled() const { return mask != 0; }
+
+      void record(const CAN_FRAME &frame);
+
+      void pause(bool paused) { this->paused = paused; }
+      bool isPaused() const { return paused; }
+      void clear();
+
+      Stats stats() const;
+      uint32_t firstSeq() const { return tailSeq; }
+      uint32_t endSeq() const { return headSeq; }
+      // Stamp clock of the newest record (32-bit timestamp_us and 64-bit)
+      uint32_t newestStamp() const { return lastStamp; }
+      uint64_t newestUs() const { return lastUs; }
+
+      // First record with seq >= seq (the oldest if it was dropped)
+      Cursor seek(uint32_t seq) const;
+      // Decode the record at c and advance; false at the end
+      bool next(Cursor &c, CAN_FRAME &frame, uint64_t &timeUs) const;
+      // Raw record bytes between two cursors, for the binary export
+      size_t copy(uint32_t from, uint32_t to, uint8_t *out, size_t len) const;
+
+      // One candump -L line: "(sec.usec) can0 ID#DATA\n"
+      static size_t formatCandump(const CAN_FRAME &frame, uint64_t timeUs, char *buf, size_t len);
+      // Binary export header
+      static size_t formatHeader(uint32_t firstSeq, uint32_t count, uint64_t baseUs, uint8_t *buf, size_t len);
+      static const uint8_t HEADER_SIZE = 24;
+
+    private:
+      uint8_t at(uint32_t pos) const { return buffer[pos & mask]; }
+      uint32_t readLe(uint32_t pos, uint8_t bytes) const;
+      uint8_t recordSize(uint32_t pos) const;
+      uint32_t recordDelta(uint32_t pos) const;
+      void dropOldest();
+      void addCheckpoint(const Cursor &c);
+
+      uint8_t *buffer;
+      uint32_t mask;            // size - 1, 0 = disabled
+      uint32_t head;            // byte positions, free running
+      uint32_t tail;
+      uint32_t headSeq;
+      uint32_t tailSeq;
+      uint64_t tailUs;          // time of the oldest record
+      uint64_t lastUs;          // time of the newest record
+      uint32_t lastStamp;
+      uint32_t dropped;
+      bool paused;
+      Cursor checkpoints[MAX_CHECKPOINTS];  // ring, oldest at cpFirst
+      uint16_t cpFirst;
+      uint16_t cpCount;
+      uint32_t checkpointEvery;   // records, power of two
+  };
+
+  // Chunked export of a range of records, candump text or binary. The
+  // capture must not record between begin() and the last next() (pause it,
+  // or export from the task that records).
+  class CanCaptureExport {
+    public:
+      enum class Format : uint8_t { CANDUMP, BINARY };
+
+      explicit CanCaptureExport(const CanCapture &capture) : capture(capture), remaining(0) {}
+
+      // Up to maxFrames records from fromSeq on; offsetUs is added to every
+      // time (stamp clock -> wall clock)
+      void begin(Format format, uint32_t fromSeq, uint32_t maxFrames, int64_t offsetUs);
+      // Next chunk, 0 when done
+      size_t next(char *buf, size_t len);
+
+      uint32_t firstSeq() const { return first; }
+      uint32_t endSeq() const { return end.seq; }   // from= of the following page
+
+    private:
+      const CanCapture &capture;
+      Format format;
+      CanCapture::Cursor cursor;
+      CanCapture::Cursor end;
+      uint32_t first;
+      uint32_t remaining;       // records (candump) or bytes (binary) left
+      int64_t offsetUs;
+      bool headerPending;
+  };
+}
+
+#endif
@@ -0,0 +1,221 @@
+#include <string.h>
+#include <algorithm>
+#include "can_filter.h"
+
+namespace comfoair {
+
+  // The part of the ID both filter modes can see: ID[28:13]
+  static inline uint16_t project(uint32_t canId) {
+    return (canId >> 13) & 0xFFFF;
+  }
+
+  static inline uint8_t popcount16(uint16_t v) {
+    uint8_t n = 0;
+    for (; v; v &= v - 1) n++;
+    return n;
+  }
+
+  struct DualSplit {
+    uint16_t code[2];
+    uint16_t mask[2];
+    uint32_t accepted;
+  };
+
+  // Evaluate one partition (side[i] = filter 0 or 1) and keep it if better
+  static void tryPartition(const uint16_t *patterns, uint16_t count, const uint8_t *side, DualSplit &best) {
+    bool used[2] = { false, false };
+    uint16_t first[2] = { 0, 0 };
+    uint16_t mask[2] = { 0, 0 };
+    for (uint16_t i = 0; i < count; i++) {
+      uint8_t s = side[i];
+      if (!used[s]) {
+        used[s] = true;
+        first[s] = patterns[i];
+      } else {
+        mask[s] |= patterns[i] ^ first[s];
+      }
+    }
+    // An empty side just repeats the other filter
+    for (uint8_t s = 0; s < 2; s++) {
+      if (!used[s]) {
+        first[s] = first[1 - s];
+        mask[s] = mask[1 - s];
+      }
+    }
+
+    uint32_t accepted = (1UL << popcount16(mask[0])) +
+                        ((used[0] && used[1]) ? (1UL << popcount16(mask[1])) : 0);
+    if (accepted < best.accepted) {
+      for (uint8_t s = 0; s < 2; s++) {
+        best.mask[s] = mask[s];
+        best.code[s] = first[s] & ~mask[s];
+      }
+      best.accepted = accepted;
+    }
+  }
+
+  void CanIdFilter::clear() {
+    memset(pdoBits, 0, sizeof(pdoBits));
+    pdoCount = 0;
+    idCount = 0;
+    maskedCount = 0;
+  }
+
+  bool CanIdFilter::addPdo(uint16_t pdoid) {
+    if (pdoid >= PDO_TABLE_SIZE) return false;
+    uint8_t bit = 1 << (pdoid & 7);
+    if (!(pdoBits[pdoid >> 3] & bit)) {
+      if (pdoCount >= MAX_PDOS) return false;
+      pdoBits[pdoid >> 3] |= bit;
+      pdoCount++;
+    }
+    return true;
+  }
+
+  bool CanIdFilter::addId(uint32_t canId) {
+    canId &= 0x1FFFFFFF;
+    for (uint8_t i = 0; i < idCount; i++) {
+      if (ids[i] == canId) return true;
+    }
+    if (idCount >= MAX_EXACT_IDS) return false;
+    ids[idCount++] = canId;
+    return true;
+  }
+
+  // The dual filter sees ID[28:13] only, so each masked entry expands to
+  // 2^n patterns there - keep n small
+  bool CanIdFilter::addMasked(uint32_t canId, uint32_t dontCare) {
+    dontCare &= 0x1FFFFFFF;
+    canId &= 0x1FFFFFFF & ~dontCare;
+    if (maskedCount >= MAX_MASKED_IDS || popcount16(project(dontCare)) > MAX_MASKED_DONT_CARE) {
+      return false;
+    }
+    maskedIds[maskedCount] = canId;
+    maskedDontCare[maskedCount] = dontCare;
+    maskedCount++;
+    return true;
+  }
+
+  bool CanIdFilter::matches(uint32_t canId, bool extended) const {
+    if (!extended) return false;  // ComfoNet only uses extended frames
+
+    for (uint8_t i = 0; i < idCount; i++) {
+      if (ids[i] == canId) return true;
+    }
+    for (uint8_t i = 0; i < maskedCount; i++) {
+      if (((canId ^ maskedIds[i]) & ~maskedDontCare[i] & 0x1FFFFFFF) == 0) return true;
+    }
+    if (!isPdoCanId(canId)) return false;
+
+    uint16_t pdoid = pdoidFromCanId(canId);
+    return pdoid < PDO_TABLE_SIZE && (pdoBits[pdoid >> 3] & (1 << (pdoid & 7)));
+  }
+
+  CanHwFilter CanIdFilter::computeHardware() const {
+    CanHwFilter result = { 0, 0xFFFFFFFF, true, 0x10000 };
+    if (isEmpty()) return result;
+
+    // ------------------------------------------------------------------------
+    // Single filter over the full 29-bit ID (node bits of PDOs are don't care)
+    // ------------------------------------------------------------------------
+    uint32_t code29 = 0;
+    uint32_t mask29 = 0;
+    bool first = true;
+    auto merge = [&](uint32_t code, uint32_t mask) {
+      if (first) {
+        code29 = code;
+        mask29 = mask;
+        first = false;
+      } else {
+        mask29 |= mask | (code ^ code29);
+      }
+    };
+    for (uint16_t p = 0; p < PDO_TABLE_SIZE; p++) {
+      if (pdoBits[p >> 3] & (1 << (p & 7))) merge(pdoCanId(p, 0), 0x3F);
+    }
+    for (uint8_t i = 0; i < idCount; i++) {
+      merge(ids[i], 0);
+    }
+    for (uint8_t i = 0; i < maskedCount; i++) {
+      merge(maskedIds[i], maskedDontCare[i]);
+    }
+    code29 &= ~mask29;
+
+    result.acceptanceCode = code29 << 3;
+    result.acceptanceMask = (mask29 << 3) | 0x7;  // RTR + unused bits: don't care
+    result.singleFilter = true;
+    result.acceptedPatterns = 1UL << popcount16(project(mask29));
+
+    // ------------------------------------------------------------------------
+    // Dual filter: two code/mask pairs, each over ID[28:13] only
+    // ------------------------------------------------------------------------
+    const uint16_t MAX_PATTERNS = MAX_PDOS + MAX_EXACT_IDS + MAX_MASKED_IDS * (1 << MAX_MASKED_DONT_CARE);
+    uint16_t patterns[MAX_PATTERNS];
+    uint16_t count = 0;
+    for (uint16_t p = 0; p < PDO_TABLE_SIZE; p++) {
+      if (pdoBits[p >> 3] & (1 << (p & 7))) patterns[count++] = project(pdoCanId(p, 0));
+    }
+    for (uint8_t i = 0; i < idCount; i++) {
+      patterns[count++] = project(ids[i]);
+    }
+    for (uint8_t i = 0; i < maskedCount; i++) {
+      // Enumerate every subset of the don't-care bits
+      uint16_t code = project(maskedIds[i]), wild = project(maskedDontCare[i]);
+      uint16_t sub = 0;
+      do {
+        patterns[count++] = code | sub;
+        sub = (sub - wild) & wild;
+      } while (sub != 0);
+    }
+    std::sort(patterns, patterns + count);
+    count = std::unique(patterns, patterns + count) - patterns;
+
+    DualSplit best;
+    best.accepted = 0xFFFFFFFF;
+    uint8_t side[MAX_PATTERNS];
+
+    if (count <= 12) {
+      // Small sets: try every partition (pattern 0 fixed on filter 0)
+      for (uint32_t combo = 0; combo < (1UL << (count - 1)); combo++) {
+        side[0] = 0;
+        for (uint16_t i = 1; i < count; i++) side[i] = (combo >> (i - 1)) & 1;
+        tryPartition(patterns, count, side, best);
+      }
+    } else {
+      // Split on a single ID bit...
+      for (uint8_t bit = 0; bit < 16; bit++) {
+        for (uint16_t i = 0; i < count; i++) side[i] = (patterns[i] >> bit) & 1;
+        tryPartition(patterns, count, side, best);
+      }
+      // ...or into two contiguous ranges of the sorted patterns
+      for (uint16_t k = 1; k < count; k++) {
+        for (uint16_t i = 0; i < count; i++) side[i] = i >= k;
+        tryPartition(patterns, count, side, best);
+      }
+    }
+
+    // Prefer single filter on a tie, it also checks ID[12:0]
+    if (best.accepted < result.acceptedPatterns) {
+      result.acceptanceCode = ((uint32_t)best.code[0] << 16) | best.code[1];
+      result.acceptanceMask = ((uint32_t)best.mask[0] << 16) | best.mask[1];
+      result.singleFilter = false;
+      result.acceptedPatterns = best.accepted;
+    }
+    return result;
+  }
+
+  bool CanIdFilter::hardwareAccepts(const CanHwFilter &filter, uint32_t canId, bool extended) {
+    if (!extended) return filter.acceptanceMask == 0xFFFFFFFF;
+
+    if (filter.singleFilter) {
+      uint32_t bits = canId << 3;
+      return ((bits ^ filter.acceptanceCode) & ~filter.acceptanceMask & 0xFFFFFFF8) == 0;
+    }
+
+    uint16_t id = project(canId);
+    uint16_t code1 = filter.acceptanceCode >> 16, mask1 = filter.acceptanceMask >> 16;
+    uint16_t code2 = filter.acceptanceCode & 0xFFFF, mask2 = filter.acceptanceMask & 0xFFFF;
+    return ((id ^ code1) & ~mask1 & 0xFFFF) == 0 ||
+           ((id ^ code2) & ~mask2 & 0xFFFF) == 0;
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef CAN_FILTER_H
+#define CAN_FILTER_H
+
+#include <cstdint>
+#include "pdo_table.h"
+
+// ============================================================================
+// CAN ID FILTER - wanted-frame set + TWAI acceptance filter builder
+// ============================================================================
+// Collects the PDOIDs (any source node), exact extended IDs and masked ID
+// ranges (e.g. RMI responses to our node) we consume and
+//   - matches()          : exact software check, applied in the RX task
+//   - computeHardware()  : best SJA1000-style code/mask, single or dual
+//                          filter mode, for twai_driver_install()
+//   - hardwareAccepts()  : emulates that filter, so a recorded trace can be
+//                          replayed offline to measure accept/reject rates
+//
+// TWAI layout for extended frames (ESP-IDF):
+//   single filter: bits [31:3] = ID[28:0], bit 2 = RTR
+//   dual filter:   filter 1 bits [31:16] = ID[28:13]
+//                  filter 2 bits [15:0]  = ID[28:13]
+// Mask bits set to 1 are "don't care".
+// ============================================================================
+
+namespace comfoair {
+
+  struct CanHwFilter {
+    uint32_t acceptanceCode;
+    uint32_t acceptanceMask;
+    bool singleFilter;
+    uint32_t acceptedPatterns;  // ID[28:13] values let through, lower is stricter
+  };
+
+  class CanIdFilter {
+    public:
+      static const uint8_t MAX_EXACT_IDS = 8;
+      static const uint8_t MAX_MASKED_IDS = 2;
+      static const uint8_t MAX_MASKED_DONT_CARE = 5;  // don't-care bits within ID[28:13]
+      // Bounds the dual filter search scratch on the stack, not PDO_TABLE_SIZE
+      static const uint16_t MAX_PDOS = 255;
+
+      CanIdFilter() { clear(); }
+
+      void clear();
+      bool addPdo(uint16_t pdoid);        // PDO from any node, false beyond MAX_PDOS
+      bool addId(uint32_t canId);         // exact 29-bit extended ID
+      bool addMasked(uint32_t canId, uint32_t dontCare);  // ID with wildcard bits
+
+      bool isEmpty() const { return pdoCount == 0 && idCount == 0 && maskedCount == 0; }
+      uint16_t pdoCountTotal() const { return pdoCount; }
+
+      // Software check: is this a frame we consume?
+      bool matches(uint32_t canId, bool extended) const;
+
+      // Tightest code/mask covering every wanted frame.
+      // An empty filter yields accept-all.
+      CanHwFilter computeHardware() const;
+
+      static bool hardwareAccepts(const CanHwFilter &filter, uint32_t canId, bool extended);
+
+    private:
+      uint8_t pdoBits[PDO_TABLE_SIZE / 8];
+      uint16_t pdoCount;
+      uint32_t ids[MAX_EXACT_IDS];
+      uint8_t idCount;
+      uint32_t maskedIds[MAX_MASKED_IDS];
+      uint32_t maskedDontCare[MAX_MASKED_IDS];
+      uint8_t maskedCount;
+  };
+}
+
+#endif
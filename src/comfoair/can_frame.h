@@ -0,0 +1,20 @@
+#ifndef CAN_FRAME_H
+#define CAN_FRAME_H
+
+#include <cstdint>
+
+// CAN_FRAME structure compatible with old esp32_can library
+typedef struct {
+    uint32_t id;          // CAN ID
+    uint8_t extended;     // Extended frame (1) or standard (0)
+    uint8_t rtr;          // RTR frame
+    uint8_t length;       // Data length
+    union {
+        uint8_t byte[8];
+        uint8_t uint8[8];
+        uint32_t uint32[2];
+    } data;
+    uint32_t timestamp_us;  // esp_timer_get_time() when the RX task received it (0 for TX frames)
+} CAN_FRAME;
+
+#endif
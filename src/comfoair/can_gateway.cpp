@@ -0,0 +1,576 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include "can_gateway.h"
+
+#ifndef MSG_NOSIGNAL
+  #define MSG_NOSIGNAL 0
+#endif
+
+namespace comfoair {
+
+  static const char HEX_DIGITS[] = "0123456789ABCDEF";
+
+  // Linux can_id flags, as cannelloni puts them on the wire
+  static const uint32_t CAN_EFF_FLAG_BIT = 0x80000000;
+  static const uint32_t CAN_RTR_FLAG_BIT = 0x40000000;
+  static const uint32_t CAN_ERR_FLAG_BIT = 0x20000000;
+  static const uint8_t CANNELLONI_VERSION = 2;
+  static const uint8_t CANNELLONI_OP_DATA = 0;
+  static const uint8_t CANNELLONI_FD_FLAG = 0x80;
+
+  // Socket reads per poll(), so a flood from the PC cannot hold the loop
+  static const uint8_t MAX_READS_PER_POLL = 4;
+
+  static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+  }
+
+  static bool parseHex(const char *p, uint8_t digits, uint32_t &value) {
+    value = 0;
+    for (uint8_t i = 0; i < digits; i++) {
+      int digit = hexDigit(p[i]);
+      if (digit < 0) return false;
+      value = (value << 4) | digit;
+    }
+    return true;
+  }
+
+  static void setNonBlocking(int fd) {
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+  }
+
+  static bool wouldBlock() {
+    return errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOMEM || errno == ENOBUFS;
+  }
+
+  // ==========================================================================
+  // SLCAN
+  // ==========================================================================
+  size_t slcanEncode(const CAN_FRAME &frame, int32_t timestampMs, char *buf, size_t len) {
+    if (len < SLCAN_MAX_FRAME) return 0;
+    size_t pos = 0;
+    uint8_t length = frame.length > 8 ? 8 : frame.length;
+    buf[pos++] = frame.rtr ? (frame.extended ? 'R' : 'r') : (frame.extended ? 'T' : 't');
+    for (int8_t shift = frame.extended ? 28 : 8; shift >= 0; shift -= 4) {
+      buf[pos++] = HEX_DIGITS[(frame.id >> shift) & 0x0F];
+    }
+    buf[pos++] = '0' + length;
+    if (!frame.rtr) {
+      for (uint8_t i = 0; i < length; i++) {
+        buf[pos++] = HEX_DIGITS[frame.data.uint8[i] >> 4];
+        buf[pos++] = HEX_DIGITS[frame.data.uint8[i] & 0x0F];
+      }
+    }
+    if (timestampMs >= 0) {
+      for (int8_t shift = 12; shift >= 0; shift -= 4) {
+        buf[pos++] = HEX_DIGITS[(timestampMs >> shift) & 0x0F];
+      }
+    }
+    buf[pos++] = '\r';
+    return pos;
+  }
+
+  bool slcanParseFrame(const char *line, size_t len, CAN_FRAME &frame) {
+    if (len < 1) return false;
+    char type = line[0];
+    bool extended = type == 'T' || type == 'R';
+    bool rtr = type == 'r' || type == 'R';
+    if (!extended && type != 't' && !rtr) return false;
+
+    uint8_t idDigits = extended ? 8 : 3;
+    if (len < 1u + idDigits + 1) return false;
+    uint32_t id;
+    if (!parseHex(line + 1, idDigits, id)) return false;
+    if (id > (extended ? 0x1FFFFFFFu : 0x7FFu)) return false;
+    int dlc = hexDigit(line[1 + idDigits]);
+    if (dlc < 0 || dlc > 8) return false;
+
+    size_t dataDigits = rtr ? 0 : 2 * dlc;
+    size_t expected = 1 + idDigits + 1 + dataDigits;
+    if (len != expected && len != expected + 4) return false;   // optional timestamp
+
+    memset(&frame, 0, sizeof(frame));
+    frame.id = id;
+    frame.extended = extended;
+    frame.rtr = rtr;
+    frame.length = dlc;
+    for (uint8_t i = 0; i < dataDigits / 2; i++) {
+      uint32_t byte;
+      if (!parseHex(line + 2 + idDigits + 2 * i, 2, byte)) return false;
+      frame.data.uint8[i] = byte;
+    }
+    return true;
+  }
+
+  // ==========================================================================
+  // CANNELLONI
+  // ==========================================================================
+  size_t cannelloniEncodeHeader(uint8_t seq, uint16_t count, uint8_t *buf) {
+    buf[0] = CANNELLONI_VERSION;
+    buf[1] = CANNELLONI_OP_DATA;
+    buf[2] = seq;
+    buf[3] = count >> 8;
+    buf[4] = count & 0xFF;
+    return CANNELLONI_HEADER_SIZE;
+  }
+
+  size_t cannelloniEncodeFrame(const CAN_FRAME &frame, uint8_t *buf, size_t len) {
+    if (len < CANNELLONI_MAX_FRAME) return 0;
+    uint8_t length = frame.length > 8 ? 8 : frame.length;
+    uint32_t id = frame.extended ? (frame.id & 0x1FFFFFFF) | CAN_EFF_FLAG_BIT : frame.id & 0x7FF;
+    if (frame.rtr) id |= CAN_RTR_FLAG_BIT;
+    buf[0] = id >> 24;
+    buf[1] = id >> 16;
+    buf[2] = id >> 8;
+    buf[3] = id;
+    buf[4] = length;
+    if (frame.rtr) return 5;          // RTR frames carry no data section
+    memcpy(buf + 5, frame.data.uint8, length);
+    return 5 + length;
+  }
+
+  int cannelloniDecode(const uint8_t *packet, size_t len,
+                       void (*fn)(void *context, const CAN_FRAME &frame), void *context) {
+    if (len < CANNELLONI_HEADER_SIZE || packet[0] != CANNELLONI_VERSION) return -1;
+    if (packet[1] != CANNELLONI_OP_DATA) return 0;    // ACK / NACK
+    uint16_t count = (packet[3] << 8) | packet[4];
+
+    size_t pos = CANNELLONI_HEADER_SIZE;
+    int delivered = 0;
+    for (uint16_t i = 0; i < count; i++) {
+      if (pos + 5 > len) return -1;
+      uint32_t id = ((uint32_t)packet[pos] << 24) | ((uint32_t)packet[pos + 1] << 16) |
+                    ((uint32_t)packet[pos + 2] << 8) | packet[pos + 3];
+      uint8_t length = packet[pos + 4];
+      pos += 5;
+      bool fd = length & CANNELLONI_FD_FLAG;
+      length &= ~CANNELLONI_FD_FLAG;
+      if (fd) pos++;                  // FD flags byte
+      if (length > (fd ? 64 : 8)) return -1;
+      size_t dataLength = (id & CAN_RTR_FLAG_BIT) ? 0 : length;
+      if (pos + dataLength > len) return -1;
+
+      if (!fd && !(id & CAN_ERR_FLAG_BIT)) {
+        CAN_FRAME frame;
+        memset(&frame, 0, sizeof(frame));
+        frame.extended = (id & CAN_EFF_FLAG_BIT) != 0;
+        frame.rtr = (id & CAN_RTR_FLAG_BIT) != 0;
+        frame.id = id & (frame.extended ? 0x1FFFFFFF : 0x7FF);
+        frame.length = length;
+        memcpy(frame.data.uint8, packet + pos, dataLength);
+        fn(context, frame);
+        delivered++;
+      }
+      pos += dataLength;
+    }
+    return delivered;
+  }
+
+  // ==========================================================================
+  // RATE LIMIT / BATCH
+  // ==========================================================================
+  TxRateLimiter::TxRateLimiter(uint16_t perSecond, uint16_t burst) :
+    milliTokens((uint32_t)burst * 1000), maxMilliTokens((uint32_t)burst * 1000),
+    perSecond(perSecond), lastMs(0) {
+  }
+
+  bool TxRateLimiter::allow(uint32_t nowMs) {
+    uint32_t elapsed = nowMs - lastMs;
+    lastMs = nowMs;
+    if (elapsed > 60000) elapsed = 60000;
+    milliTokens += elapsed * perSecond;
+    if (milliTokens > maxMilliTokens) milliTokens = maxMilliTokens;
+    if (perSecond == 0 || milliTokens < 1000) return false;
+    milliTokens -= 1000;
+    return true;
+  }
+
+  GatewayBatch::GatewayBatch(uint8_t reserve) : reserve(reserve) {
+    clear();
+  }
+
+  void GatewayBatch::commit(size_t bytes, uint32_t nowMs, bool frame) {
+    if (empty()) firstMs = nowMs;
+    used += bytes;
+    if (frame) frames++;
+  }
+
+  bool GatewayBatch::due(uint32_t nowMs, uint32_t maxAgeMs) const {
+    if (empty()) return false;
+    // Answers and the rest of a partial write go out at once
+    if (frames == 0 || sent > 0) return true;
+    return nowMs - firstMs >= maxAgeMs;
+  }
+
+  void GatewayBatch::consume(size_t bytes) {
+    sent += bytes;
+    if (sent >= used) clear();
+  }
+
+  void GatewayBatch::clear() {
+    used = reserve;
+    sent = 0;
+    frames = 0;
+    firstMs = 0;
+  }
+
+  // ==========================================================================
+  // GATEWAY
+  // ==========================================================================
+  CanGateway::CanGateway(const GatewayTx &tx, uint16_t txRate, uint16_t txBurst) :
+    tx(tx),
+    limiter(txRate, txBurst),
+    listener(-1),
+    client(-1),
+    udp(-1),
+    slcanPort(0),
+    udpPort(0),
+    peerIp(0),
+    peerPort(0),
+    peerKnown(false),
+    peerFixed(false),
+    channelOpen(false),
+    listenOnly(false),
+    timestamps(false),
+    udpSeq(0),
+    rxNowMs(0),
+    lineLength(0),
+    slcanOut(0),
+    udpOut(CANNELLONI_HEADER_SIZE) {
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  CanGateway::~CanGateway() {
+    end();
+  }
+
+  bool CanGateway::begin(uint16_t slcanPort, uint16_t cannelloniPort, const char *peer, uint16_t peerPort) {
+    end();
+    this->slcanPort = slcanPort;
+    this->udpPort = cannelloniPort;
+    bool ok = true;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+
+    if (slcanPort) {
+      listener = socket(AF_INET, SOCK_STREAM, 0);
+      int on = 1;
+      addr.sin_port = htons(slcanPort);
+      if (listener < 0 ||
+          setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on)) < 0 ||
+          bind(listener, (struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+          listen(listener, 1) < 0) {
+        if (listener >= 0) close(listener);
+        listener = -1;
+        ok = false;
+      } else {
+        setNonBlocking(listener);
+      }
+    }
+
+    if (cannelloniPort) {
+      udp = socket(AF_INET, SOCK_DGRAM, 0);
+      addr.sin_port = htons(cannelloniPort);
+      if (udp < 0 || bind(udp, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        if (udp >= 0) close(udp);
+        udp = -1;
+        ok = false;
+      } else {
+        setNonBlocking(udp);
+      }
+    }
+
+    if (peer && *peer) {
+      struct in_addr ip;
+      if (inet_pton(AF_INET, peer, &ip) == 1) {
+        peerIp = ip.s_addr;
+        this->peerPort = htons(peerPort ? peerPort : cannelloniPort);
+        peerKnown = true;
+        peerFixed = true;
+      } else {
+        ok = false;
+      }
+    }
+    return ok;
+  }
+
+  void CanGateway::end() {
+    closeClient();
+    if (listener >= 0) close(listener);
+    if (udp >= 0) close(udp);
+    listener = -1;
+    udp = -1;
+    peerKnown = false;
+    peerFixed = false;
+    udpOut.clear();
+  }
+
+  bool CanGateway::forward(const CAN_FRAME &frame, uint32_t nowMs) {
+    bool toSlcan = slcanOpen();
+    bool toUdp = udp >= 0 && peerKnown;
+
+    // Room in every endpoint first, so a refused frame is never sent twice
+    if (toSlcan && !slcanOut.fits(SLCAN_MAX_FRAME) && (!flushSlcan() || !slcanOut.fits(SLCAN_MAX_FRAME))) {
+      totals.blocked++;
+      return false;
+    }
+    if (toUdp && !udpOut.fits(CANNELLONI_MAX_FRAME) && !flushUdp()) {
+      totals.blocked++;
+      return false;
+    }
+
+    if (toSlcan && slcanOpen()) {
+      int32_t timestampMs = timestamps ? (int32_t)((frame.timestamp_us / 1000) % 60000) : -1;
+      slcanOut.commit(slcanEncode(frame, timestampMs, (char *)slcanOut.tail(), SLCAN_MAX_FRAME), nowMs, true);
+      totals.slcanFrames++;
+    }
+    if (toUdp) {
+      udpOut.commit(cannelloniEncodeFrame(frame, udpOut.tail(), CANNELLONI_MAX_FRAME), nowMs, true);
+      totals.udpFrames++;
+    }
+    return true;
+  }
+
+  void CanGateway::poll(uint32_t nowMs) {
+    acceptClient();
+    if (client >= 0) readSlcan(nowMs);
+    if (udp >= 0) readUdp(nowMs);
+
+    if (client >= 0 && slcanOut.due(nowMs, CAN_GATEWAY_BATCH_MS)) flushSlcan();
+    if (udp >= 0 && peerKnown && udpOut.due(nowMs, CAN_GATEWAY_BATCH_MS)) flushUdp();
+  }
+
+  // --------------------------------------------------------------------------
+  // slcan
+  // --------------------------------------------------------------------------
+  void CanGateway::acceptClient() {
+    if (listener < 0) return;
+    int fd = accept(listener, nullptr, nullptr);
+    if (fd < 0) return;
+    closeClient();                    // the newest tool wins
+    setNonBlocking(fd);
+    int on = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));   // batching is ours
+    client = fd;
+    totals.slcanClients++;
+  }
+
+  void CanGateway::closeClient() {
+    if (client >= 0) close(client);
+    client = -1;
+    channelOpen = false;
+    listenOnly = false;
+    timestamps = false;
+    lineLength = 0;
+    slcanOut.clear();
+  }
+
+  void CanGateway::readSlcan(uint32_t nowMs) {
+    char chunk[64];
+    for (uint8_t reads = 0; reads < MAX_READS_PER_POLL && client >= 0; reads++) {
+      ssize_t n = recv(client, chunk, sizeof(chunk), 0);
+      if (n == 0 || (n < 0 && !wouldBlock())) {
+        closeClient();                // closed by the PC
+        return;
+      }
+      if (n < 0) return;
+      for (ssize_t i = 0; i < n; i++) {
+        char c = chunk[i];
+        if (c == '\r' || c == '\n') {
+          if (lineLength > sizeof(line)) {
+            totals.badInput++;
+            reply("\a", nowMs);
+          } else if (lineLength > 0) {
+            onSlcanLine(line, lineLength, nowMs);
+          }
+          lineLength = 0;
+        } else if (lineLength < sizeof(line)) {
+          line[lineLength++] = c;
+        } else {
+          lineLength = sizeof(line) + 1;   // too long, answered at its end
+        }
+      }
+    }
+  }
+
+  // Lawicel commands; answers are "\r" (ok) or "\a" (error)
+  void CanGateway::onSlcanLine(const char *line, size_t len, uint32_t nowMs) {
+    bool ok = true;
+    switch (line[0]) {
+      case 'O':
+      case 'L':
+        channelOpen = true;
+        listenOnly = line[0] == 'L';
+        break;
+      case 'C':
+        channelOpen = false;
+        break;
+      case 'S':
+        ok = len == 2 && line[1] == '2';   // ComfoNet runs at 50 kbit/s only
+        break;
+      case 'V':
+        reply("V1013\r", nowMs);
+        return;
+      case 'N':
+        reply("NCFNT\r", nowMs);
+        return;
+      case 'F':
+        reply("F00\r", nowMs);
+        return;
+      case 'Z':
+        timestamps = len >= 2 && line[1] == '1';
+        break;
+      case 'M':
+      case 'm':
+      case 'X':
+      case 'W':
+      case 'Q':
+        break;                        // accepted, filtering is the PC's job
+      case 't':
+      case 'T':
+      case 'r':
+      case 'R': {
+        CAN_FRAME frame;
+        if (!channelOpen || listenOnly || !slcanParseFrame(line, len, frame)) {
+          ok = false;
+        } else if (submit(frame, nowMs)) {
+          reply(frame.extended ? "Z\r" : "z\r", nowMs);
+          return;
+        } else {
+          reply("\a", nowMs);
+          return;
+        }
+        break;
+      }
+      default:
+        ok = false;
+        break;
+    }
+    if (!ok) totals.badInput++;
+    reply(ok ? "\r" : "\a", nowMs);
+  }
+
+  void CanGateway::reply(const char *text, uint32_t nowMs) {
+    size_t n = strlen(text);
+    if (client < 0 || !slcanOut.fits(n)) return;
+    memcpy(slcanOut.tail(), text, n);
+    slcanOut.commit(n, nowMs, false);
+  }
+
+  bool CanGateway::flushSlcan() {
+    while (client >= 0 && slcanOut.pendingBytes() > 0) {
+      ssize_t n = send(client, slcanOut.pending(), slcanOut.pendingBytes(), MSG_NOSIGNAL);
+      if (n > 0) {
+        totals.slcanWrites++;
+        slcanOut.consume(n);
+      } else if (n < 0 && wouldBlock()) {
+        return false;                 // TCP window full, rest on the next poll()
+      } else {
+        totals.sendErrors++;
+        closeClient();
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // --------------------------------------------------------------------------
+  // cannelloni
+  // --------------------------------------------------------------------------
+  void CanGateway::readUdp(uint32_t nowMs) {
+    static uint8_t packet[1500];      // forward() / poll() run on one task
+    for (uint8_t reads = 0; reads < MAX_READS_PER_POLL; reads++) {
+      struct sockaddr_in from;
+      socklen_t fromLength = sizeof(from);
+      ssize_t n = recvfrom(udp, packet, sizeof(packet), 0, (struct sockaddr *)&from, &fromLength);
+      if (n < 0) return;
+
+      rxNowMs = nowMs;
+      int frames = cannelloniDecode(packet, n, [](void *ctx, const CAN_FRAME &frame) {
+        CanGateway *self = static_cast<CanGateway*>(ctx);
+        self->submit(frame, self->rxNowMs);
+      }, this);
+      if (frames < 0) {
+        totals.badInput++;
+        continue;
+      }
+      // Answer whoever talks to us, unless begin() fixed the peer
+      if (!peerFixed && (!peerKnown || peerIp != from.sin_addr.s_addr || peerPort != from.sin_port)) {
+        peerIp = from.sin_addr.s_addr;
+        peerPort = from.sin_port;
+        peerKnown = true;
+        udpOut.clear();
+      }
+    }
+  }
+
+  bool CanGateway::flushUdp() {
+    if (udpOut.empty()) return true;
+    cannelloniEncodeHeader(udpSeq, udpOut.frameCount(), udpOut.data());
+
+    struct sockaddr_in to;
+    memset(&to, 0, sizeof(to));
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = peerIp;
+    to.sin_port = peerPort;
+    ssize_t n = sendto(udp, udpOut.pending(), udpOut.pendingBytes(), 0, (struct sockaddr *)&to, sizeof(to));
+    if (n < 0 && wouldBlock()) return false;     // no lwIP buffers, retry
+    if (n < 0) {
+      totals.sendErrors++;                        // e.g. no route: the packet is lost
+    } else {
+      totals.udpPackets++;
+      udpSeq++;
+    }
+    udpOut.clear();
+    return true;
+  }
+
+  // --------------------------------------------------------------------------
+  // PC -> bus
+  // --------------------------------------------------------------------------
+  bool CanGateway::submit(const CAN_FRAME &frame, uint32_t nowMs) {
+    if (!limiter.allow(nowMs)) {
+      totals.txRateLimited++;
+      return false;
+    }
+    if (!tx.submit(tx.context, frame)) {
+      totals.txRejected++;
+      return false;
+    }
+    totals.txFrames++;
+    return true;
+  }
+
+  size_t CanGateway::toJson(char *buf, size_t len) const {
+    if (len == 0) return 0;
+    const uint8_t *ip = (const uint8_t *)&peerIp;
+    char peer[24] = "";
+    if (peerKnown) {
+      snprintf(peer, sizeof(peer), "%u.%u.%u.%u:%u", ip[0], ip[1], ip[2], ip[3], ntohs(peerPort));
+    }
+    int n = snprintf(buf, len,
+                     "{\"slcan\":{\"port\":%u,\"connected\":%s,\"open\":%s,\"clients\":%u,\"frames\":%u,\"writes\":%u},"
+                     "\"cannelloni\":{\"port\":%u,\"peer\":\"%s\",\"frames\":%u,\"packets\":%u},"
+                     "\"tx\":{\"frames\":%u,\"rate_limited\":%u,\"rejected\":%u},"
+                     "\"bad_input\":%u,\"blocked\":%u,\"send_errors\":%u}",
+                     slcanPort, slcanConnected() ? "true" : "false", slcanOpen() ? "true" : "false",
+                     totals.slcanClients, totals.slcanFrames, totals.slcanWrites,
+                     udpPort, peer, totals.udpFrames, totals.udpPackets,
+                     totals.txFrames, totals.txRateLimited, totals.txRejected,
+                     totals.badInput, totals.blocked, totals.sendErrors);
+    return n < 0 ? 0 : ((size_t)n < len ? n : len - 1);
+  }
+}
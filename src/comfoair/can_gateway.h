@@ -0,0 +1,200 @@
+#ifndef CAN_GATEWAY_H
+#define CAN_GATEWAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+
+// ============================================================================
+// CAN GATEWAY - the live bus on the network for PC tools (CAN over IP)
+// ============================================================================
+// A FrameFanout sink that forwards received frames to two endpoints:
+//   slcan       TCP server, Lawicel ASCII (one client; a new connection
+//               replaces the old one). python-can:
+//                 can.Bus(interface="slcan", channel="socket://<ip>:3333")
+//               SocketCAN / SavvyCAN through a pty:
+//                 socat pty,link=/tmp/ttyCAN,raw tcp:<ip>:3333 &
+//                 slcand -o -c -s2 /tmp/ttyCAN slcan0
+//   cannelloni  UDP, cannelloni v2 data packets. The peer is fixed by
+//               begin() or learned from the last packet received:
+//                 cannelloni -I vcan0 -R <ip> -r 20000 -l 20000
+//
+// Frames are batched per endpoint: one TCP write / UDP datagram carries
+// everything received within CAN_GATEWAY_BATCH_MS, up to
+// CAN_GATEWAY_BATCH_BYTES. At the 50 kbit/s ComfoNet rate that keeps the
+// WiFi stack at <= 1000 / CAN_GATEWAY_BATCH_MS packets/s per endpoint
+// whatever the bus load. slcan command answers go out on the next poll().
+//
+// Frames from the PC (slcan t/T/r/R, cannelloni data) pass a token bucket
+// of CAN_GATEWAY_TX_RATE frames/s (burst CAN_GATEWAY_TX_BURST) and are
+// handed to GatewayTx (CanTxQueue on the device); the rest are dropped and
+// counted. CAN_GATEWAY_TX_RATE 0 = listen only.
+//
+// Sockets are non-blocking BSD sockets (lwIP on the ESP32, the host stack
+// on Linux). A sink that cannot flush (TCP window full, no lwIP buffers)
+// refuses the frame and FrameFanout offers it again. forward() and poll()
+// must run on the same task.
+// ============================================================================
+
+#ifndef CAN_GATEWAY_SLCAN_PORT
+  #define CAN_GATEWAY_SLCAN_PORT 3333        // 0 = no slcan server
+#endif
+#ifndef CAN_GATEWAY_CANNELLONI_PORT
+  #define CAN_GATEWAY_CANNELLONI_PORT 20000  // cannelloni default, 0 = off
+#endif
+#ifndef CAN_GATEWAY_BATCH_MS
+  #define CAN_GATEWAY_BATCH_MS 20
+#endif
+#ifndef CAN_GATEWAY_BATCH_BYTES
+  #define CAN_GATEWAY_BATCH_BYTES 1200       // below the WiFi MTU
+#endif
+#ifndef CAN_GATEWAY_TX_RATE
+  #define CAN_GATEWAY_TX_RATE 20
+#endif
+#ifndef CAN_GATEWAY_TX_BURST
+  #define CAN_GATEWAY_TX_BURST 8
+#endif
+
+namespace comfoair {
+
+  // --- slcan (Lawicel ASCII): "T1F074051" "2" "0102" "\r" ---
+  static const uint8_t SLCAN_MAX_FRAME = 1 + 8 + 1 + 16 + 4 + 1;   // with timestamp
+  static const uint8_t SLCAN_MAX_LINE = 32;
+
+  // timestampMs < 0 = none (Z0), else 0..59999 appended as 4 hex digits
+  size_t slcanEncode(const CAN_FRAME &frame, int32_t timestampMs, char *buf, size_t len);
+  // One t / T / r / R command without the '\r'
+  bool slcanParseFrame(const char *line, size_t len, CAN_FRAME &frame);
+
+  // --- cannelloni v2: header, then per frame u32 id (BE, Linux flags), u8 len, data ---
+  static const uint8_t CANNELLONI_HEADER_SIZE = 5;
+  static const uint8_t CANNELLONI_MAX_FRAME = 4 + 1 + 8;
+
+  size_t cannelloniEncodeHeader(uint8_t seq, uint16_t count, uint8_t *buf);
+  size_t cannelloniEncodeFrame(const CAN_FRAME &frame, uint8_t *buf, size_t len);
+  // Classic frames of a data packet to fn; the frame count, -1 if malformed.
+  // CAN FD and error frames are skipped.
+  int cannelloniDecode(const uint8_t *packet, size_t len,
+                       void (*fn)(void *context, const CAN_FRAME &frame), void *context);
+
+  // Token bucket, whole frames
+  class TxRateLimiter {
+    public:
+      TxRateLimiter(uint16_t perSecond, uint16_t burst);
+      bool allow(uint32_t nowMs);
+
+    private:
+      uint32_t milliTokens;
+      uint32_t maxMilliTokens;
+      uint16_t perSecond;
+      uint32_t lastMs;
+  };
+
+  // Bytes waiting for one TCP write / UDP datagram; reserve = header room
+  class GatewayBatch {
+    public:
+      explicit GatewayBatch(uint8_t reserve = 0);
+
+      bool fits(size_t bytes) const { return used + bytes <= sizeof(buf); }
+      uint8_t *tail() { return buf + used; }
+      void commit(size_t bytes, uint32_t nowMs, bool frame);
+
+      bool empty() const { return frames == 0 && used == reserve; }
+      bool due(uint32_t nowMs, uint32_t maxAgeMs) const;
+      uint16_t frameCount() const { return frames; }
+
+      uint8_t *data() { return buf; }
+      const uint8_t *pending() const { return buf + sent; }
+      size_t pendingBytes() const { return used - sent; }
+      // bytes went out; a fully sent batch starts over
+      void consume(size_t bytes);
+      void clear();
+
+    private:
+      uint8_t buf[CAN_GATEWAY_BATCH_BYTES];
+      uint16_t used;
+      uint16_t sent;
+      uint16_t frames;
+      uint8_t reserve;
+      uint32_t firstMs;
+  };
+
+  struct GatewayTx {
+    bool (*submit)(void *context, const CAN_FRAME &frame);   // false = queue full
+    void *context;
+  };
+
+  class CanGateway {
+    public:
+      struct Stats {
+        uint32_t slcanClients;      // connections accepted
+        uint32_t slcanFrames;       // frames forwarded
+        uint32_t slcanWrites;       // send() calls
+        uint32_t udpFrames;
+        uint32_t udpPackets;
+        uint32_t txFrames;          // frames from the PC handed to GatewayTx
+        uint32_t txRateLimited;
+        uint32_t txRejected;        // GatewayTx queue full
+        uint32_t badInput;          // unknown slcan commands, malformed packets
+        uint32_t blocked;           // frames refused while a batch could not go out
+        uint32_t sendErrors;        // socket errors (the slcan client is dropped)
+      };
+
+      explicit CanGateway(const GatewayTx &tx, uint16_t txRate = CAN_GATEWAY_TX_RATE,
+                          uint16_t txBurst = CAN_GATEWAY_TX_BURST);
+      ~CanGateway();
+
+      // Ports 0 = endpoint off; peer nullptr = learn from incoming packets
+      bool begin(uint16_t slcanPort, uint16_t cannelloniPort,
+                 const char *peer = nullptr, uint16_t peerPort = 0);
+      void end();
+
+      // FrameFanout sink; false = an endpoint is still flushing, offer again
+      bool forward(const CAN_FRAME &frame, uint32_t nowMs);
+      // Accept / read / flush due batches; call every loop()
+      void poll(uint32_t nowMs);
+
+      bool slcanConnected() const { return client >= 0; }
+      bool slcanOpen() const { return client >= 0 && channelOpen; }
+      bool hasPeer() const { return peerKnown; }
+      const Stats &stats() const { return totals; }
+
+      // {"slcan":{...},"cannelloni":{...},"tx":{...}}
+      size_t toJson(char *buf, size_t len) const;
+
+    private:
+      void acceptClient();
+      void closeClient();
+      void readSlcan(uint32_t nowMs);
+      void onSlcanLine(const char *line, size_t len, uint32_t nowMs);
+      void reply(const char *text, uint32_t nowMs);
+      void readUdp(uint32_t nowMs);
+      bool submit(const CAN_FRAME &frame, uint32_t nowMs);
+      bool flushSlcan();
+      bool flushUdp();
+
+      GatewayTx tx;
+      TxRateLimiter limiter;
+      int listener;
+      int client;
+      int udp;
+      uint16_t slcanPort;
+      uint16_t udpPort;
+      uint32_t peerIp;              // network byte order
+      uint16_t peerPort;
+      bool peerKnown;
+      bool peerFixed;
+      bool channelOpen;
+      bool listenOnly;
+      bool timestamps;
+      uint8_t udpSeq;
+      uint32_t rxNowMs;             // clock for frames decoded from a packet
+      char line[SLCAN_MAX_LINE];
+      uint8_t lineLength;
+      GatewayBatch slcanOut;
+      GatewayBatch udpOut;
+      Stats totals;
+  };
+}
+
+#endif
@@ -0,0 +1,160 @@
+#include <string.h>
+#include "can_health.h"
+
+namespace comfoair {
+
+  const char *canHealthStateName(CanHealthState state) {
+    switch (state) {
+      case CanHealthState::ERROR_ACTIVE: return "error_active";
+      case CanHealthState::ERROR_PASSIVE: return "error_passive";
+      case CanHealthState::BUS_OFF: return "bus_off";
+      case CanHealthState::RECOVERING: return "recovering";
+      case CanHealthState::RESTARTED: return "restarted";
+      case CanHealthState::COUNT: break;
+    }
+    return "unknown";
+  }
+
+  CanHealth::CanHealth(const CanHealthDriver &driver)
+    : driver(driver), listener(nullptr), listenerContext(nullptr),
+      current(CanHealthState::ERROR_ACTIVE), enteredMs(0), busOffMs(0), retryAtMs(0),
+      restartedMs(0), backoff(CAN_RECOVERY_BACKOFF_MS), restartedOnce(false), warning(false) {
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  void CanHealth::setListener(CanHealthListener listener, void *context) {
+    this->listener = listener;
+    listenerContext = context;
+  }
+
+  void CanHealth::enter(CanHealthState next, uint32_t nowMs) {
+    if (next == current) return;
+    CanHealthState from = current;
+    totals.timeMs[(uint8_t)current] += nowMs - enteredMs;
+    current = next;
+    enteredMs = nowMs;
+    if (listener) listener(listenerContext, from, next, nowMs);
+  }
+
+  void CanHealth::busOff(uint32_t nowMs) {
+    if (!txAllowed()) return;  // already handling one
+
+    totals.busOffs++;
+    busOffMs = nowMs;
+    // Back again soon after the last restart: wait longer this time
+    if (restartedOnce && nowMs - restartedMs < CAN_RESTART_STABLE_MS) {
+      backoff = backoff * 2 < CAN_RECOVERY_BACKOFF_MAX_MS ? backoff * 2 : CAN_RECOVERY_BACKOFF_MAX_MS;
+    }
+    retryAtMs = nowMs + backoff;
+    enter(CanHealthState::BUS_OFF, nowMs);
+  }
+
+  void CanHealth::recoveryFailed(uint32_t nowMs) {
+    totals.recoveryFailures++;
+    backoff = backoff * 2 < CAN_RECOVERY_BACKOFF_MAX_MS ? backoff * 2 : CAN_RECOVERY_BACKOFF_MAX_MS;
+    retryAtMs = nowMs + backoff;
+    enter(CanHealthState::BUS_OFF, nowMs);
+  }
+
+  void CanHealth::onEvents(uint16_t events, uint32_t nowMs) {
+    if (events & CAN_EVENT_BUS_ERROR) totals.busErrors++;
+    if (events & CAN_EVENT_TX_FAILED) totals.txFailed++;
+    if (events & CAN_EVENT_BELOW_ERR_WARN) warning = false;
+    if (events & CAN_EVENT_ABOVE_ERR_WARN) {
+      totals.errorWarnings++;
+      warning = true;
+    }
+
+    // Recovery completes with the controller stopped; a late completion
+    // after our timeout still counts
+    if ((events & CAN_EVENT_BUS_RECOVERED) &&
+        (current == CanHealthState::RECOVERING || current == CanHealthState::BUS_OFF)) {
+      if (driver.start(driver.context)) {
+        totals.recoveries++;
+        totals.lastRecoveryMs = nowMs - busOffMs;
+        if (totals.lastRecoveryMs > totals.maxRecoveryMs) totals.maxRecoveryMs = totals.lastRecoveryMs;
+        restartedMs = nowMs;
+        restartedOnce = true;
+        enter(CanHealthState::RESTARTED, nowMs);
+      } else {
+        recoveryFailed(nowMs);
+      }
+    }
+
+    // Both in one batch: stay on the safe side, sync() corrects it
+    if (events & CAN_EVENT_ERR_PASSIVE) {
+      if (current == CanHealthState::ERROR_ACTIVE || current == CanHealthState::RESTARTED) {
+        totals.errorPassive++;
+        enter(CanHealthState::ERROR_PASSIVE, nowMs);
+      }
+    } else if (events & CAN_EVENT_ERR_ACTIVE) {
+      if (current == CanHealthState::ERROR_PASSIVE) enter(CanHealthState::ERROR_ACTIVE, nowMs);
+    }
+
+    // Most severe last
+    if (events & CAN_EVENT_BUS_OFF) busOff(nowMs);
+  }
+
+  void CanHealth::sync(const CanBusStatus &status, uint32_t nowMs) {
+    switch (status.state) {
+      case CanBusState::BUS_OFF:
+        busOff(nowMs);
+        break;
+      case CanBusState::STOPPED:
+        if (current == CanHealthState::RECOVERING) onEvents(CAN_EVENT_BUS_RECOVERED, nowMs);
+        break;
+      case CanBusState::RUNNING: {
+        // Controller thresholds: passive above 127, warning from 96
+        bool passive = status.txErrorCounter > 127 || status.rxErrorCounter > 127;
+        warning = status.txErrorCounter >= 96 || status.rxErrorCounter >= 96;
+        if (passive && (current == CanHealthState::ERROR_ACTIVE || current == CanHealthState::RESTARTED)) {
+          totals.errorPassive++;
+          enter(CanHealthState::ERROR_PASSIVE, nowMs);
+        } else if (!passive && current == CanHealthState::ERROR_PASSIVE) {
+          enter(CanHealthState::ERROR_ACTIVE, nowMs);
+        }
+        break;
+      }
+      case CanBusState::RECOVERING:
+        break;
+    }
+  }
+
+  void CanHealth::poll(uint32_t nowMs) {
+    switch (current) {
+      case CanHealthState::BUS_OFF:
+        if ((int32_t)(nowMs - retryAtMs) >= 0) {
+          if (driver.initiateRecovery(driver.context)) {
+            enter(CanHealthState::RECOVERING, nowMs);
+          } else {
+            recoveryFailed(nowMs);
+          }
+        }
+        break;
+      case CanHealthState::RECOVERING:
+        if (nowMs - enteredMs >= CAN_RECOVERY_TIMEOUT_MS) recoveryFailed(nowMs);
+        break;
+      case CanHealthState::RESTARTED:
+        if (nowMs - restartedMs >= CAN_RESTART_STABLE_MS) enter(CanHealthState::ERROR_ACTIVE, nowMs);
+        break;
+      default:
+        break;
+    }
+
+    // Running long enough since the last restart: forget the backoff
+    if (restartedOnce && txAllowed() && nowMs - restartedMs >= CAN_RESTART_STABLE_MS) {
+      backoff = CAN_RECOVERY_BACKOFF_MS;
+    }
+  }
+
+  uint32_t CanHealth::timeInState(CanHealthState state, uint32_t nowMs) const {
+    uint32_t ms = totals.timeMs[(uint8_t)state];
+    if (state == current) ms += nowMs - enteredMs;
+    return ms;
+  }
+
+  void CanHealth::resetStats(uint32_t nowMs) {
+    memset(&totals, 0, sizeof(totals));
+    enteredMs = nowMs;
+  }
+}
@@ -0,0 +1,147 @@
+#ifndef CAN_HEALTH_H
+#define CAN_HEALTH_H
+
+#include <cstdint>
+#include "bus_stats.h"
+
+// ============================================================================
+// CAN HEALTH - error-passive / bus-off recovery state machine
+// ============================================================================
+//   ERROR_ACTIVE  <->  ERROR_PASSIVE        (TEC/REC crossing 128)
+//        |                  |
+//        +----> BUS_OFF <---+               (TEC > 255, TX paused)
+//                 |   ^
+//   backoff over  |   | recovery timeout / start failed
+//                 v   |
+//              RECOVERING                   (128 x 11 recessive bits)
+//                 |
+//   BUS_RECOVERED | start()
+//                 v
+//              RESTARTED  --stable-->  ERROR_ACTIVE
+//
+// Recovery is initiated only after a backoff, doubled for every bus-off
+// that follows a restart within CAN_RESTART_STABLE_MS (up to
+// CAN_RECOVERY_BACKOFF_MAX_MS), so a shorted or misconfigured bus does not
+// keep the controller flipping in and out of bus-off. txAllowed() is false
+// in BUS_OFF and RECOVERING; the caller pauses its TX queue with it.
+//
+// Events are the controller alerts as portable bits (see
+// TWAIWrapper::takeHealthEvents()). sync() reconciles with a controller
+// status snapshot in case an alert was lost. The driver is reached through
+// function pointers, so the state machine runs against a simulated
+// controller as well; everything runs on the loop() task.
+// ============================================================================
+
+#ifndef CAN_RECOVERY_BACKOFF_MS
+  #define CAN_RECOVERY_BACKOFF_MS 100
+#endif
+#ifndef CAN_RECOVERY_BACKOFF_MAX_MS
+  #define CAN_RECOVERY_BACKOFF_MAX_MS 30000
+#endif
+// 128 x 11 bits take 28 ms at 50 kbit/s; longer means the bus is stuck
+#ifndef CAN_RECOVERY_TIMEOUT_MS
+  #define CAN_RECOVERY_TIMEOUT_MS 1000
+#endif
+#ifndef CAN_RESTART_STABLE_MS
+  #define CAN_RESTART_STABLE_MS 10000
+#endif
+
+namespace comfoair {
+
+  enum class CanHealthState : uint8_t {
+    ERROR_ACTIVE,
+    ERROR_PASSIVE,
+    BUS_OFF,
+    RECOVERING,
+    RESTARTED,
+    COUNT
+  };
+
+  const char *canHealthStateName(CanHealthState state);
+
+  // Controller alerts, one bit each
+  enum CanHealthEvent : uint16_t {
+    CAN_EVENT_ERR_ACTIVE = 1 << 0,
+    CAN_EVENT_ERR_PASSIVE = 1 << 1,
+    CAN_EVENT_BUS_OFF = 1 << 2,
+    CAN_EVENT_BUS_RECOVERED = 1 << 3,
+    CAN_EVENT_ABOVE_ERR_WARN = 1 << 4,
+    CAN_EVENT_BELOW_ERR_WARN = 1 << 5,
+    CAN_EVENT_BUS_ERROR = 1 << 6,
+    CAN_EVENT_TX_FAILED = 1 << 7
+  };
+
+  struct CanHealthDriver {
+    bool (*initiateRecovery)(void *context);  // false = controller not bus-off
+    bool (*start)(void *context);             // false = controller not stopped
+    void *context;
+  };
+
+  typedef void (*CanHealthListener)(void *context, CanHealthState from, CanHealthState to,
+                                    uint32_t nowMs);
+
+  class CanHealth {
+    public:
+      static const uint8_t STATE_COUNT = (uint8_t)CanHealthState::COUNT;
+
+      struct Stats {
+        uint32_t timeMs[STATE_COUNT];   // closed intervals, see timeInState()
+        uint32_t errorPassive;          // entries into ERROR_PASSIVE
+        uint32_t busOffs;
+        uint32_t recoveries;            // successful restarts
+        uint32_t recoveryFailures;      // timeouts and rejected driver calls
+        uint32_t errorWarnings;         // TEC/REC crossed the warning limit
+        uint32_t busErrors;
+        uint32_t txFailed;
+        uint32_t lastRecoveryMs;        // bus-off to restart
+        uint32_t maxRecoveryMs;
+      };
+
+      explicit CanHealth(const CanHealthDriver &driver);
+
+      void setListener(CanHealthListener listener, void *context);
+
+      // Feed alert bits collected since the last call
+      void onEvents(uint16_t events, uint32_t nowMs);
+
+      // Reconcile with the controller state (lost alerts)
+      void sync(const CanBusStatus &status, uint32_t nowMs);
+
+      // Backoff, recovery timeout, restart settling
+      void poll(uint32_t nowMs);
+
+      CanHealthState state() const { return current; }
+      bool txAllowed() const {
+        return current != CanHealthState::BUS_OFF && current != CanHealthState::RECOVERING;
+      }
+      bool errorWarning() const { return warning; }
+      uint32_t backoffMs() const { return backoff; }
+
+      // Including the time spent in the current state so far
+      uint32_t timeInState(CanHealthState state, uint32_t nowMs) const;
+
+      const Stats &stats() const { return totals; }
+      void resetStats(uint32_t nowMs);
+
+    private:
+      void enter(CanHealthState next, uint32_t nowMs);
+      void busOff(uint32_t nowMs);
+      void recoveryFailed(uint32_t nowMs);
+
+      CanHealthDriver driver;
+      CanHealthListener listener;
+      void *listenerContext;
+
+      CanHealthState current;
+      uint32_t enteredMs;
+      uint32_t busOffMs;          // start of the current outage
+      uint32_t retryAtMs;         // BUS_OFF: when to initiate recovery
+      uint32_t restartedMs;
+      uint32_t backoff;
+      bool restartedOnce;         // restartedMs is valid
+      bool warning;
+      Stats totals;
+  };
+}
+
+#endif
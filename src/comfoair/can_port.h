@@ -0,0 +1,88 @@
+#ifndef CAN_PORT_H
+#define CAN_PORT_H
+
+#include <cstdint>
+#include "can_frame.h"
+#include "can_filter.h"
+#include "can_tx_queue.h"
+#include "can_health.h"
+#include "bus_stats.h"
+
+// ============================================================================
+// CAN PORT - the bus as seen by ComfoAir, independent of the controller
+// ============================================================================
+// Implementations:
+//   TWAIWrapper     ESP32 TWAI driver (CAN0, twai_wrapper.h)
+//   SocketCanPort   Linux SocketCAN, e.g. vcan0 (socketcan_port.h)
+//   LoopbackPort    in-process bus, no hardware (loopback_port.h)
+//
+// read() and transmit() never block. Only one frame is in flight at a time
+// (CanTxQueue waits for txResult() before submitting the next). The
+// remaining calls have defaults for backends without error states.
+// canTxDriver() / canHealthDriver() plug a port into CanTxQueue / CanHealth.
+// ============================================================================
+
+// Receive path counters, see CanPort::getRxStats()
+typedef struct {
+    uint32_t received;        // frames pushed into the ring by the RX task
+    uint32_t ringOverflows;   // frames dropped because the ring was full
+    uint32_t ringHighWater;   // max frames waiting in the ring
+    uint32_t ringSize;
+    uint32_t driverPending;   // frames waiting in the TWAI driver queue
+    uint32_t driverMissed;    // TWAI rx queue full (raise CAN_RX_QUEUE_LEN)
+    uint32_t driverOverrun;   // hardware RX FIFO overrun
+    uint32_t swRejected;      // passed the hardware filter, dropped in software
+    uint32_t hwWouldReject;   // CAN_HW_FILTER_ENABLED=false: emulated filter rejects
+} CAN_RX_STATS;
+
+namespace comfoair {
+
+  class CanPort {
+    public:
+      virtual ~CanPort() {}
+
+      virtual const char *name() const = 0;
+
+      // Open the bus; wanted = frames we consume (nullptr = everything)
+      virtual bool begin(uint32_t bitrate, const CanIdFilter *wanted = nullptr) = 0;
+
+      // Next received frame, stamped with timestamp_us; false if none waiting
+      virtual bool read(CAN_FRAME &frame) = 0;
+      virtual uint32_t rxPending() const = 0;
+
+      // Queue one frame without waiting; txResult() reports its outcome
+      virtual bool transmit(const CAN_FRAME &frame) = 0;
+      virtual TxResult txResult() = 0;
+      // The frame in flight timed out: drop it if still queued. transmit()
+      // stays busy while it may still reach the bus.
+      virtual void abortTransmit() {}
+
+      virtual CanBusStatus getBusStatus() const = 0;
+      virtual CAN_RX_STATS getRxStats() const { return CAN_RX_STATS(); }
+
+      // Error state alerts since the last call, as CanHealthEvent bits
+      virtual uint16_t takeHealthEvents() { return 0; }
+      // Bus-off recovery, then start again
+      virtual bool initiateRecovery() { return false; }
+      virtual bool restart() { return true; }
+  };
+
+  inline CanTxDriver canTxDriver(CanPort &port) {
+    return CanTxDriver{
+      [](void *ctx, const CAN_FRAME &frame) { return static_cast<CanPort*>(ctx)->transmit(frame); },
+      [](void *ctx) { return static_cast<CanPort*>(ctx)->txResult(); },
+      [](void *ctx) { static_cast<CanPort*>(ctx)->abortTransmit(); },
+      &port
+    };
+  }
+
+  inline CanHealthDriver canHealthDriver(CanPort &port) {
+    return CanHealthDriver{
+      [](void *ctx) { return static_cast<CanPort*>(ctx)->initiateRecovery(); },
+      [](void *ctx) { return static_cast<CanPort*>(ctx)->restart(); },
+      &port
+    };
+  }
+}
+
+#endif
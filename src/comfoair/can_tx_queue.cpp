@@ -0,0 +1,137 @@
+#include <string.h>
+#include "can_tx_queue.h"
+
+namespace comfoair {
+
+  CanTxQueue::CanTxQueue(const CanTxDriver &driver)
+    : driver(driver), active(nullptr), inFlight(false), paused(false), submittedMs(0), nextSeq(0), nextId(1) {
+    memset(jobs, 0, sizeof(jobs));
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  TxJobId CanTxQueue::enqueue(TxPriority priority, const CAN_FRAME *frames, uint8_t count,
+                              TxCallback callback, void *context) {
+    if (count == 0 || count > MAX_FRAMES_PER_JOB) {
+      totals.rejected++;
+      return 0;
+    }
+
+    // An identical poll frame that has not started yet already covers this one
+    if (priority == TxPriority::POLL && count == 1 && callback == nullptr) {
+      for (Job &job : jobs) {
+        if (job.id != 0 && &job != active && job.priority == TxPriority::POLL &&
+            job.frameCount == 1 && job.frames[0].id == frames[0].id &&
+            job.frames[0].rtr == frames[0].rtr && job.frames[0].length == frames[0].length &&
+            memcmp(job.frames[0].data.uint8, frames[0].data.uint8, frames[0].length) == 0) {
+          totals.coalesced++;
+          return job.id;
+        }
+      }
+    }
+
+    for (Job &job : jobs) {
+      if (job.id != 0) continue;
+
+      job.id = nextId++;
+      if (nextId == 0) nextId = 1;
+      job.priority = priority;
+      job.frameCount = count;
+      job.nextFrame = 0;
+      job.retries = 0;
+      job.seq = nextSeq++;
+      job.notBeforeMs = 0;
+      job.callback = callback;
+      job.context = context;
+      memcpy(job.frames, frames, count * sizeof(CAN_FRAME));
+
+      totals.enqueued++;
+      uint8_t d = depth();
+      if (d > totals.maxDepth) totals.maxDepth = d;
+      return job.id;
+    }
+
+    totals.rejected++;
+    return 0;
+  }
+
+  uint8_t CanTxQueue::depth() const {
+    uint8_t n = 0;
+    for (const Job &job : jobs) {
+      if (job.id != 0) n++;
+    }
+    return n;
+  }
+
+  // Highest priority class first, oldest first within a class
+  CanTxQueue::Job *CanTxQueue::pickNext() {
+    Job *best = nullptr;
+    for (Job &job : jobs) {
+      if (job.id == 0) continue;
+      if (!best || job.priority < best->priority ||
+          (job.priority == best->priority && (int32_t)(job.seq - best->seq) < 0)) {
+        best = &job;
+      }
+    }
+    return best;
+  }
+
+  void CanTxQueue::finish(Job &job, bool success) {
+    if (success) {
+      totals.completed++;
+    } else {
+      totals.failed++;
+    }
+    TxCallback callback = job.callback;
+    void *context = job.context;
+    TxJobId id = job.id;
+
+    job.id = 0;
+    active = nullptr;
+    inFlight = false;
+
+    // Last, the callback may enqueue a follow-up job
+    if (callback) callback(context, id, success);
+  }
+
+  void CanTxQueue::poll(uint32_t nowMs) {
+    if (inFlight) {
+      TxResult result = driver.result(driver.context);
+      if (result == TxResult::PENDING && nowMs - submittedMs >= TX_RESULT_TIMEOUT_MS) {
+        // Still queued in the driver: take it back before the retry
+        if (driver.abort) driver.abort(driver.context);
+        result = TxResult::FAILED;
+      }
+      if (result == TxResult::PENDING) return;
+
+      inFlight = false;
+      Job &job = *active;
+      if (result == TxResult::SUCCESS) {
+        job.nextFrame++;
+        job.retries = 0;
+        if (job.nextFrame == job.frameCount) {
+          finish(job, true);
+        }
+      } else if (job.retries >= MAX_RETRIES) {
+        finish(job, false);
+      } else {
+        totals.retries++;
+        job.notBeforeMs = nowMs + (RETRY_BACKOFF_MS << job.retries);
+        job.retries++;
+      }
+    }
+
+    if (paused) return;
+
+    // Multi-frame jobs are atomic: keep sending the active job
+    if (!active) {
+      active = pickNext();
+      if (!active) return;
+    }
+    if (active->notBeforeMs != 0 && (int32_t)(nowMs - active->notBeforeMs) < 0) return;
+
+    if (driver.submit(driver.context, active->frames[active->nextFrame])) {
+      inFlight = true;
+      submittedMs = nowMs;
+    }
+  }
+}
@@ -0,0 +1,116 @@
+#ifndef CAN_TX_QUEUE_H
+#define CAN_TX_QUEUE_H
+
+#include <cstdint>
+#include "can_frame.h"
+
+// ============================================================================
+// CAN TX QUEUE - non-blocking, prioritized transmit scheduler
+// ============================================================================
+// Callers (UI, MQTT handlers, time sync, RTR polling) enqueue a job of one
+// or more frames and return immediately. poll() hands one frame at a time
+// to the driver and waits for its TX result before sending the next, so:
+//   - jobs go out by priority class (COMMAND > TIME_SYNC > POLL), FIFO
+//     within a class
+//   - a multi-frame job is atomic: once started, no other job's frames are
+//     interleaved with it
+//   - a failed frame is retried with exponential backoff, and the job
+//     fails after MAX_RETRIES; a frame without a result after
+//     TX_RESULT_TIMEOUT_MS is aborted in the driver first, so the retry
+//     cannot put it on the bus twice
+//   - the optional callback reports the job outcome
+//   - pause() holds new submissions (bus-off recovery, see CanHealth); the
+//     frame already in flight still completes, queued jobs wait
+//
+// The driver is reached through two function pointers (see canTxDriver()
+// for a CanPort) so this class has no TWAI dependency. enqueue() and poll()
+// must run on the same task.
+// ============================================================================
+
+namespace comfoair {
+
+  enum class TxPriority : uint8_t {
+    COMMAND = 0,     // user commands (UI, MQTT)
+    TIME_SYNC = 1,   // device clock set / request
+    POLL = 2,        // RTR polling, coalesced per CAN ID
+    COUNT
+  };
+
+  enum class TxResult : int8_t {
+    PENDING = 0,
+    SUCCESS = 1,
+    FAILED = -1
+  };
+
+  typedef uint16_t TxJobId;  // 0 = not queued
+  typedef void (*TxCallback)(void *context, TxJobId job, bool success);
+
+  struct CanTxDriver {
+    bool (*submit)(void *context, const CAN_FRAME &frame);  // non-blocking, false = driver busy
+    TxResult (*result)(void *context);                      // outcome of the last submitted frame
+    void (*abort)(void *context);                           // drop a frame that timed out, nullptr = no-op
+    void *context;
+  };
+
+  class CanTxQueue {
+    public:
+      static const uint8_t MAX_JOBS = 8;
+      static const uint8_t MAX_FRAMES_PER_JOB = 8;
+      static const uint8_t MAX_RETRIES = 4;
+      static const uint16_t RETRY_BACKOFF_MS = 5;      // doubled on every retry
+      static const uint16_t TX_RESULT_TIMEOUT_MS = 100; // no result -> treated as failed
+
+      struct Stats {
+        uint32_t enqueued;
+        uint32_t completed;
+        uint32_t failed;      // jobs that ran out of retries
+        uint32_t retries;     // frame retransmissions
+        uint32_t rejected;    // enqueue() on a full queue
+        uint32_t coalesced;   // POLL jobs merged into an already queued one
+        uint8_t maxDepth;
+      };
+
+      explicit CanTxQueue(const CanTxDriver &driver);
+
+      TxJobId enqueue(TxPriority priority, const CAN_FRAME *frames, uint8_t count,
+                      TxCallback callback = nullptr, void *context = nullptr);
+
+      void poll(uint32_t nowMs);
+
+      void pause(bool paused) { this->paused = paused; }
+      bool isPaused() const { return paused; }
+
+      uint8_t depth() const;
+      bool idle() const { return depth() == 0; }
+      const Stats &stats() const { return totals; }
+
+    private:
+      struct Job {
+        TxJobId id;                 // 0 = free slot
+        TxPriority priority;
+        uint8_t frameCount;
+        uint8_t nextFrame;          // frames [0, nextFrame) are on the bus
+        uint8_t retries;            // for the current frame
+        uint32_t seq;               // enqueue order, FIFO within a class
+        uint32_t notBeforeMs;       // backoff
+        TxCallback callback;
+        void *context;
+        CAN_FRAME frames[MAX_FRAMES_PER_JOB];
+      };
+
+      Job *pickNext();
+      void finish(Job &job, bool success);
+
+      CanTxDriver driver;
+      Job jobs[MAX_JOBS];
+      Job *active;                  // job whose frames are being sent
+      bool inFlight;                // a frame was submitted, waiting for result
+      bool paused;
+      uint32_t submittedMs;
+      uint32_t nextSeq;
+      TxJobId nextId;
+      Stats totals;
+  };
+}
+
+#endif
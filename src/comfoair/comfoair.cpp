@@ -7,74 +7,151 @@
 #include "../time/time_manager.h"
 #include "../mqtt/mqtt.h"
 #include "../secrets.h"
+#include "pdo_topics_gen.h"
+#include "../ota/ota.h"
+#include "../board_config.h"  // For hasDisplay()
+#include <esp_timer.h>
+#include <sys/time.h>
 
 #include "../serial_logger.h"
 #define Serial LogSerial 
 
-// Only include TWAI wrapper in non-remote client mode
-#if !defined(REMOTE_CLIENT_MODE) || !REMOTE_CLIENT_MODE
-  #include "twai_wrapper.h"
-#endif
 
 
-void printFrame2(CAN_FRAME *message)
-{ /*
-  Serial.print(message->id, HEX);
-  if (message->extended) Serial.print(" X ");
-  else Serial.print(" S ");   
-  Serial.print(message->length, DEC);
-  for (int i = 0; i < message->length; i++) {
-    Serial.print(" ");
-    if (message->data.byte[i] < 0x10) Serial.print("0");
-    Serial.print(message->data.byte[i], HEX); 
+// Frame log sink - prints every received frame to Serial / the OTA web log.
+// Very chatty, enable with -DCAN_LOG_FRAMES=1 for debugging only.
+#if defined(CAN_LOG_FRAMES) && CAN_LOG_FRAMES
+static bool logFrameSink(void *context, const CAN_FRAME &frame) {
+  Serial.printf("%08X %c %d", frame.id, frame.extended ? 'X' : 'S', frame.length);
+  for (int i = 0; i < frame.length; i++) {
+    Serial.printf(" %02X", frame.data.byte[i]);
   }
-  Serial.println(); */
+  Serial.println();
+  return true;
 }
+#endif
+
+// Max frames handled per loop() call; the rest wait in the RX ring so a
+// burst cannot starve LVGL / touch handling
+#ifndef CAN_RX_BUDGET
+  #define CAN_RX_BUDGET 16
+#endif
+
+// Slow-changing PDOs are re-requested when no value arrived for this long
+#ifndef PDO_POLL_REFRESH_MS
+  #define PDO_POLL_REFRESH_MS 600000
+#endif
+#define PDO_POLL_START_DELAY_MS 8000
+
+// Bus statistics snapshot to MQTT (<prefix>/can/stats), 0 = off
+#ifndef CAN_STATS_PUBLISH_MS
+  #define CAN_STATS_PUBLISH_MS 60000
+#endif
+
+// Controller state re-read in case an alert was lost
+#define CAN_HEALTH_SYNC_MS 1000
+
+// Frames from these ComfoNet nodes are dropped before the fan-out
+// (bit n = node n), e.g. a second display's traffic we never use
+#ifndef CAN_IGNORED_NODES
+  #define CAN_IGNORED_NODES 0ULL
+#endif
+
+// Raw frame capture ring in PSRAM (HTTP /can/capture), 0 = off.
+// About 10 bytes per frame: 4 MB hold ~400k frames.
+#ifndef CAN_CAPTURE_SIZE
+  #define CAN_CAPTURE_SIZE (4 * 1024 * 1024)
+#endif
+// Most frames per /can/capture response (?max= may ask for fewer). A page
+// is streamed from loop() in one go while the RX task keeps filling the
+// CAN_RX_RING_SIZE (64) frame ring, ~190 ms of a saturated 50 kbit/s bus;
+// 256 frames are ~12 KB of candump text and go out well within that.
+// Larger captures are fetched page by page (X-Capture-Next).
+#ifndef CAN_CAPTURE_PAGE_FRAMES
+  #define CAN_CAPTURE_PAGE_FRAMES 256
+#endif
+
+// CAN over IP for SavvyCAN / python-can / cannelloni (see can_gateway.h),
+// diagnostics only: anyone on the network can read the bus and send to it
+// (rate limited). CAN_GATEWAY_CANNELLONI_PEER "a.b.c.d" fixes the UDP peer,
+// empty = the last one that sent us a packet.
+#ifndef CAN_GATEWAY_ENABLED
+  #define CAN_GATEWAY_ENABLED 0
+#endif
+#ifndef CAN_GATEWAY_CANNELLONI_PEER
+  #define CAN_GATEWAY_CANNELLONI_PEER ""
+#endif
+
+// Headless bridge only: publish raw frames as binary batches on
+// <prefix>/can/raw every CAN_MQTT_RAW_MS (see raw_frame_batch.h) instead of
+// one decoded text message per value; 0 = off. The panel or host decodes.
+#ifndef CAN_MQTT_RAW_MS
+  #define CAN_MQTT_RAW_MS 0
+#endif
+
+// ComfoNet bit rate
+static const uint32_t CAN_BITRATE = 50000;
 
-// ============================================================================
-// âœ… PROPER: Deduplication based on LAST SENT COMMAND (not CAN state)
-// This prevents echo loops while allowing legitimate commands
-// ============================================================================
-#define subscribe(command) if (mqtt) { mqtt->subscribeTo(MQTT_PREFIX "/commands/" command, [this](char const * _1,uint8_t const * _2, int _3) { \
-    Serial.print("Received: "); \
-    Serial.println(command); \
-    \
-    /* Extract requested speed from command */ \
-    uint8_t requested_speed = 255; /* 255 = not a speed command */ \
-    if (strcmp(command, "ventilation_level_0") == 0) requested_speed = 0; \
-    else if (strcmp(command, "ventilation_level_1") == 0) requested_speed = 1; \
-    else if (strcmp(command, "ventilation_level_2") == 0) requested_speed = 2; \
-    else if (strcmp(command, "ventilation_level_3") == 0) requested_speed = 3; \
-    \
-    /* Check if this is a duplicate of the last command we sent */ \
-    unsigned long now = millis(); \
-    bool is_duplicate = (requested_speed != 255 && \
-                        requested_speed == this->last_sent_fan_speed && \
-                        now - this->last_fan_speed_command_time < 2000); /* 2 second window */ \
-    \
-    if (is_duplicate) { \
-      Serial.printf("    Duplicate ignored - just sent speed %d %lu ms ago\n", \
-                    requested_speed, now - this->last_fan_speed_command_time); \
-    } else { \
-      Serial.printf("  Sending command to MVHR\n"); \
-      this->comfoMessage.sendCommand(command); \
-      \
-      /* Track this command */ \
-      if (requested_speed != 255) { \
-        this->last_sent_fan_speed = requested_speed; \
-        this->last_fan_speed_command_time = now; \
-      } \
-    } \
-  }); }
+// Our ComfoNet node ID, as used by ComfoMessage::send(), and the MVHR's
+static const uint8_t LOCAL_NODE_ID = 0x11;
+static const uint8_t MVHR_NODE_ID = 0x01;
 
 extern comfoair::MQTT *mqtt;
-char mqttTopicMsgBuf[30];
-char mqttTopicValBuf[30];
-char otherBuf[30];
+
+static void logHealthChange(void *context, comfoair::CanHealthState from,
+                            comfoair::CanHealthState to, uint32_t nowMs) {
+  Serial.printf("[CAN] Bus %s -> %s\n", comfoair::canHealthStateName(from),
+                comfoair::canHealthStateName(to));
+}
+
+static const char *nodeName(uint8_t node) {
+  if (node == MVHR_NODE_ID) return " (MVHR)";
+  if (node == LOCAL_NODE_ID) return " (our ID)";
+  return "";
+}
+
+static void logNodeChange(void *context, uint8_t node, comfoair::NodeState from,
+                          comfoair::NodeState to, uint32_t nowMs) {
+  Serial.printf("[CAN] Node 0x%02X%s %s -> %s\n", node, nodeName(node),
+                comfoair::nodeStateName(from), comfoair::nodeStateName(to));
+}
+
+static void onCommandSent(void *context, comfoair::TxJobId job, bool success) {
+  if (!success) {
+    Serial.printf("ComfoAir: command (TX job %u) FAILED - no ACK after retries\n", job);
+  }
+}
 
 
 namespace comfoair {
-  ComfoAir::ComfoAir() : 
+  ComfoAir::ComfoAir(CanPort &port) : 
+    port(port),
+    txQueue(canTxDriver(port)),
+    pdoPoller([](void *ctx, uint16_t pdoid) {
+      return static_cast<ComfoAir*>(ctx)->pollPdo(pdoid);
+    }, this),
+    rmiReassembler([](void *ctx, const RmiMessage &message) {
+      static_cast<ComfoAir*>(ctx)->onRmiMessage(message);
+    }, this),
+    rmiClient(RmiTransport{
+      [](void *ctx, uint8_t node, const uint8_t *payload, uint8_t length) -> int8_t {
+        return static_cast<ComfoAir*>(ctx)->comfoMessage.sendRmi(node, length, payload, TxPriority::POLL, true);
+      },
+      [](void *ctx, uint8_t sequence) {
+        static_cast<ComfoAir*>(ctx)->comfoMessage.releaseSequence(sequence);
+      },
+      this
+    }, LOCAL_NODE_ID),
+    busStats(CAN_BITRATE),
+    canHealth(canHealthDriver(port)),
+    nodeTable(LOCAL_NODE_ID),
+    captureExport(canCapture),
+    canGateway(GatewayTx{
+      [](void *ctx, const CAN_FRAME &frame) {
+        return static_cast<ComfoAir*>(ctx)->txQueue.enqueue(TxPriority::COMMAND, &frame, 1) != 0;
+      },
+      this
+    }),
     sensorManager(nullptr), 
     filterManager(nullptr), 
     controlManager(nullptr),
@@ -82,25 +159,50 @@ namespace comfoair {
     errorManager(nullptr),
     last_sent_fan_speed(255),
     last_fan_speed_command_time(0),
-    current_fan_speed(255) {}  // â† Time-based deduplication
+    current_fan_speed(255),  // â† Time-based deduplication
+    rawMqtt(false),
+    rawMessages(0),
+    rawFrames(0),
+    rawBytes(0) {
+    comfoMessage.setTxQueue(&txQueue);
+    canHealth.setListener(logHealthChange, nullptr);
+    nodeTable.setListener(logNodeChange, nullptr);
+    nodeTable.setIgnored(CAN_IGNORED_NODES);
+    
+    // Track current fan speed for deduplication, independent of the display
+    pdoRouter.subscribe(PDO_FAN_SPEED, [](void *ctx, const PdoValue &value) {
+      static_cast<ComfoAir*>(ctx)->current_fan_speed = value.raw;
+    }, this);
+    
+    // Not broadcast often enough to rely on - polled when missing or stale
+    // (rtr in pdo_spec.json)
+    static_assert(PDO_POLLED_COUNT <= PdoPoller::MAX_ENTRIES, "raise PdoPoller::MAX_ENTRIES");
+    for (uint16_t pdoid : PDO_POLLED) {
+      pdoPoller.add(pdoid, PDO_POLL_REFRESH_MS);
+    }
+  }
 
   void ComfoAir::setSensorDataManager(SensorDataManager* manager) {
     sensorManager = manager;
+    if (manager) manager->subscribePdos(pdoRouter);
     Serial.println("ComfoAir: SensorDataManager linked ");
   }
 
   void ComfoAir::setFilterDataManager(FilterDataManager* manager) {
     filterManager = manager;
+    if (manager) manager->subscribePdos(pdoRouter);
     Serial.println("ComfoAir: FilterDataManager linked ");
   }
 
   void ComfoAir::setControlManager(ControlManager* manager) {
     controlManager = manager;
+    if (manager) manager->subscribePdos(pdoRouter);
     Serial.println("ComfoAir: ControlManager linked ");
   }
 
   void ComfoAir::setTimeManager(TimeManager* manager) {
     timeManager = manager;
+    if (manager) manager->subscribePdos(pdoRouter);
     Serial.println("ComfoAir: TimeManager linked ");
   }
 
@@ -109,19 +211,59 @@ namespace comfoair {
   // ============================================================================
   void ComfoAir::setErrorDataManager(ErrorDataManager* manager) {
     errorManager = manager;
+    if (manager) manager->subscribePdos(pdoRouter);
     Serial.println("ComfoAir: ErrorDataManager linked ");
   }
   // ============================================================================
 
-  bool ComfoAir::sendCommand(const char* command) {
+  bool ComfoAir::sendCommand(CommandId command) {
     #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
       Serial.println("ComfoAir: sendCommand() called in Remote Client Mode - command ignored");
       return false;
     #else
-      return comfoMessage.sendCommand(command);
+      // Queued - UI / MQTT handlers never wait for the bus
+      return comfoMessage.sendCommand(command, onCommandSent, nullptr);
     #endif
   }
 
+  bool ComfoAir::sendCommand(const char* command) {
+    CommandId id = findCommand(command);
+    if (id == CommandId::NONE) {
+      Serial.printf("ComfoAir: unknown command '%s'\n", command);
+      return false;
+    }
+    return sendCommand(id);
+  }
+
+  // ============================================================================
+  // Deduplication based on LAST SENT COMMAND (not CAN state)
+  // This prevents echo loops while allowing legitimate commands
+  // ============================================================================
+  void ComfoAir::onMqttCommand(CommandId command) {
+    uint8_t requested_speed = commandFanSpeed(command);  // 255 = not a speed command
+    
+    // Check if this is a duplicate of the last command we sent
+    unsigned long now = millis();
+    bool is_duplicate = (requested_speed != 255 &&
+                        requested_speed == this->last_sent_fan_speed &&
+                        now - this->last_fan_speed_command_time < 2000);  // 2 second window
+    
+    if (is_duplicate) {
+      Serial.printf("    Duplicate ignored - just sent speed %d %lu ms ago\n",
+                    requested_speed, now - this->last_fan_speed_command_time);
+      return;
+    }
+    
+    Serial.printf("  Sending command to MVHR: %s\n", commandName(command));
+    this->sendCommand(command);
+    
+    // Track this command
+    if (requested_speed != 255) {
+      this->last_sent_fan_speed = requested_speed;
+      this->last_fan_speed_command_time = now;
+    }
+  }
+
   void ComfoAir::requestDeviceTime() {
     #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
       Serial.println("ComfoAir: requestDeviceTime() not supported in Remote Client Mode");
@@ -141,18 +283,6 @@ namespace comfoair {
     #endif
   }
 
-  void ComfoAir::handleDeviceTimeResponse(uint32_t device_seconds) {
-    #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
-      Serial.println("ComfoAir: handleDeviceTimeResponse() not used in Remote Client Mode");
-    #else
-      if (timeManager) {
-        timeManager->onDeviceTimeReceived(device_seconds);
-      } else {
-        Serial.println("ComfoAir: Received device time but TimeManager not linked!");
-      }
-    #endif
-  }
-
   // ============================================================================
   // ✅ NEW: Request filter days remaining
   // ============================================================================
@@ -161,6 +291,7 @@ namespace comfoair {
       Serial.println("ComfoAir: requestFilterDays() not supported in Remote Client Mode");
     #else
       Serial.println("ComfoAir: Requesting filter days via CAN...");
+      invalidatePdo(PDO_FILTER_DAYS);  // always deliver the answer
       // Send RTR - uses local variable, won't pollute global message state
       // MVHR will respond when ready, we don't wait for response here
       comfoMessage.requestFilterDays();
@@ -175,6 +306,7 @@ namespace comfoair {
       Serial.println("ComfoAir: requestTargetTemp() not supported in Remote Client Mode");
     #else
       Serial.println("ComfoAir: Requesting target temp via CAN...");
+      invalidatePdo(PDO_TARGET_TEMP);
       comfoMessage.requestTargetTemp();
     #endif
   }
@@ -187,6 +319,7 @@ namespace comfoair {
       Serial.println("ComfoAir: requestBypassStatus() not supported in Remote Client Mode");
     #else
       Serial.println("ComfoAir: Requesting bypass status via CAN...");
+      invalidatePdo(PDO_BYPASS_ACTIVATION_MODE);
       comfoMessage.requestBypassStatus();
     #endif
   }
@@ -199,10 +332,56 @@ namespace comfoair {
       Serial.println("ComfoAir: requestOperatingMode() not supported in Remote Client Mode");
     #else
       Serial.println("ComfoAir: Requesting operating mode via CAN...");
+      invalidatePdo(PDO_OPERATING_MODE);
       comfoMessage.requestOperatingMode();
     #endif
   }
 
+  // ============================================================================
+  // RMI property access
+  // ============================================================================
+  RmiRequestId ComfoAir::getProperty(uint8_t unit, uint8_t subunit, uint8_t property,
+                                     RmiCallback callback, void *context) {
+    #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
+      return 0;
+    #else
+      return rmiClient.get(MVHR_NODE_ID, unit, subunit, property, callback, context);
+    #endif
+  }
+
+  RmiRequestId ComfoAir::setProperty(uint8_t unit, uint8_t subunit, uint8_t property,
+                                     const uint8_t *value, uint8_t length,
+                                     RmiCallback callback, void *context) {
+    #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
+      return 0;
+    #else
+      return rmiClient.set(MVHR_NODE_ID, unit, subunit, property, value, length, callback, context);
+    #endif
+  }
+
+  static void logDeviceInfo(void *context, const RmiResult &result) {
+    if (result.status != RmiStatus::OK) {
+      Serial.printf("[RMI] property 0x%02X: %s\n", result.property,
+                    result.status == RmiStatus::TIMEOUT ? "no answer" : "error");
+      return;
+    }
+    if (result.property == RMI_NODE_FIRMWARE_VERSION && result.length >= 4) {
+      uint32_t v = result.data[0] | (result.data[1] << 8) | (result.data[2] << 16) | ((uint32_t)result.data[3] << 24);
+      Serial.printf("[RMI] firmware version %u.%u.%u (%u ms)\n",
+                    (v >> 30) & 0x3, (v >> 20) & 0x3FF, (v >> 10) & 0x3FF, result.latencyMs);
+    } else {
+      Serial.printf("[RMI] %s: %.*s (%u ms)\n",
+                    result.property == RMI_NODE_SERIAL_NUMBER ? "serial number" : "model",
+                    (int)result.length, (const char *)result.data, result.latencyMs);
+    }
+  }
+
+  void ComfoAir::requestDeviceInfo() {
+    getProperty(RMI_UNIT_NODE, 1, RMI_NODE_SERIAL_NUMBER, logDeviceInfo, nullptr);
+    getProperty(RMI_UNIT_NODE, 1, RMI_NODE_FIRMWARE_VERSION, logDeviceInfo, nullptr);
+    getProperty(RMI_UNIT_NODE, 1, RMI_NODE_MODEL, logDeviceInfo, nullptr);
+  }
+
   void ComfoAir::setup() {
 
     
@@ -221,97 +400,103 @@ namespace comfoair {
       // ========================================================================
       Serial.println("\n=== CAN Bus Initialization ===");
       Serial.println("Board: Waveshare ESP32-S3-Touch-LCD-4");
-      Serial.println("Using native TWAI driver");
+      Serial.printf("CAN port: %s\n", port.name());
+      
+      rawMqtt = CAN_MQTT_RAW_MS > 0 && mqtt && !hasDisplay();
+      
+      // Only frames a sink consumes pass the TWAI acceptance filter
+      CanIdFilter wanted;
+      buildRxFilter(wanted);
       
-      // CAN pins set in twai_wrapper.h (GPIO6 TX, GPIO0 RX)
-      if (!CAN0.begin(50000)) {
-        Serial.println("CAN init FAILED!");
+      // TWAI pins set in twai_wrapper.h (GPIO6 TX, GPIO0 RX)
+      if (!port.begin(CAN_BITRATE, &wanted)) {
+        Serial.printf("CAN init FAILED! (%s)\n", port.name());
         return;
       }
-      CAN0.watchFor();
+      canHealth.resetStats(millis());
       
       Serial.println("CAN initialized at 50 kbps");
+      
+      // Frame consumers, each with its own cursor into canFanout
+      canFanout.addSink("route", [](void *ctx, const CAN_FRAME &frame) {
+        return static_cast<ComfoAir*>(ctx)->routeFrame(frame);
+      }, this, CAN_RX_BUDGET);
+      if (rawMqtt) {
+        static_assert(RAW_FRAME_BATCH_SIZE + 64 <= MQTT_BUFFER_SIZE, "raise MQTT_BUFFER_SIZE");
+        canFanout.addSink("raw", [](void *ctx, const CAN_FRAME &frame) {
+          return static_cast<ComfoAir*>(ctx)->publishRawFrame(frame);
+        }, this, CAN_RX_BUDGET);
+        Serial.printf("MQTT raw mode: frame batches on " MQTT_PREFIX "/can/raw every %u ms\n", CAN_MQTT_RAW_MS);
+      } else if (mqtt) {
+        canFanout.addSink("mqtt", [](void *ctx, const CAN_FRAME &frame) {
+          return static_cast<ComfoAir*>(ctx)->publishFrame(frame);
+        }, this, 8);
+      }
+      setupCapture();
+      setupGateway();
+      #if defined(CAN_LOG_FRAMES) && CAN_LOG_FRAMES
+        canFanout.addSink("log", logFrameSink, nullptr, CAN_RX_BUDGET);
+      #endif
       Serial.println("=== CAN Bus Ready ===\n");
       
+      OTA::addEndpoint("/can/stats", [](void *ctx, char *buf, size_t len) -> size_t {
+        ComfoAir *self = static_cast<ComfoAir*>(ctx);
+        self->busStats.setBusStatus(self->port.getBusStatus());
+        return self->busStats.toJson(buf, len, micros(), true);
+      }, this);
+      OTA::addEndpoint("/can/nodes", [](void *ctx, char *buf, size_t len) -> size_t {
+        return static_cast<ComfoAir*>(ctx)->nodeTable.toJson(buf, len, millis());
+      }, this);
+      OTA::addEndpoint("/can/latency", [](void *ctx, char *buf, size_t len) -> size_t {
+        return canLatency.toJson(buf, len, true);
+      }, nullptr);
+      
       // Subscribe to MQTT commands (only if MQTT is enabled)
       if (mqtt) {
-          // Subscribe to MQTT commands
-          subscribe("ventilation_level_0");
-          subscribe("ventilation_level_1");
-          subscribe("ventilation_level_2");
-          subscribe("ventilation_level_3");
-          subscribe("boost_10_min");
-          subscribe("boost_20_min");
-          subscribe("boost_30_min");
-          subscribe("boost_60_min");
-          subscribe("boost_end");
-          subscribe("auto");
-          subscribe("manual");
-          subscribe("bypass_activate_1h");
-          subscribe("bypass_deactivate_1h");
-          subscribe("bypass_auto");
-          subscribe("ventilation_supply_only");
-          subscribe("ventilation_supply_only_reset");
-          subscribe("ventilation_extract_only");
-          subscribe("ventilation_extract_only_reset");
-          subscribe("temp_profile_normal");
-          subscribe("temp_profile_cool");
-          subscribe("temp_profile_warm");
-
-          mqtt->subscribeTo(MQTT_PREFIX "/commands/" "ventilation_level", [this](char const * _1,uint8_t const * _2, int _3) {
-            sprintf(otherBuf, "ventilation_level_%d", _2[0] - 48);
+          // <prefix>/commands/<name> for every entry of the command table
+          char topic[64];
+          for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+            snprintf(topic, sizeof(topic), MQTT_PREFIX "/commands/%s", COMMANDS[i].name);
+            mqtt->subscribeTo(topic, [](void *ctx, const char *_1, const uint8_t *_2, unsigned int _3) {
+              const char *name = strrchr(_1, '/');
+              CommandId command = findCommand(name ? name + 1 : _1);
+              Serial.print("Received: ");
+              Serial.println(_1);
+              if (command != CommandId::NONE) static_cast<ComfoAir*>(ctx)->onMqttCommand(command);
+            }, this);
+          }
+
+          mqtt->subscribeTo(MQTT_PREFIX "/commands/" "ventilation_level", [](void *ctx, const char *_1, const uint8_t *_2, unsigned int _3) {
             Serial.print("Received: ");
             Serial.println(_1);
-            Serial.println(otherBuf);
-
-            
-            // Check for duplicate
-            uint8_t requested_speed = _2[0] - 48;
-            unsigned long now = millis();
-            bool is_duplicate = (requested_speed <= 3 && 
-                                requested_speed == this->last_sent_fan_speed && 
-                                now - this->last_fan_speed_command_time < 2000);
-            
-            if (is_duplicate) {
-              Serial.printf(" Duplicate ignored - just sent speed %d %lu ms ago\n", 
-                            requested_speed, now - this->last_fan_speed_command_time);
-
-            } else {
-              Serial.printf("  Sending command to MVHR\n");
-
-              this->last_sent_fan_speed = requested_speed;
-              this->last_fan_speed_command_time = now;
-              return this->comfoMessage.sendCommand(otherBuf);
+            uint8_t level = _3 > 0 ? _2[0] - '0' : 255;
+            if (level <= 3) {
+              static_cast<ComfoAir*>(ctx)->onMqttCommand((CommandId)((uint8_t)CommandId::VENTILATION_LEVEL_0 + level));
             }
-          });
+          }, this);
           
-          mqtt->subscribeTo(MQTT_PREFIX "/commands/" "set_mode", [this](char const * _1,uint8_t const * _2, int _3) {
-            if (memcmp("auto", _2, 4) == 0) {
-              Serial.print("Received: ");
-              Serial.println(_1);
-              return this->comfoMessage.sendCommand("auto");
-            } else {
-              return this->comfoMessage.sendCommand("manual");
-            }
-          });
+          mqtt->subscribeTo(MQTT_PREFIX "/commands/" "set_mode", [](void *ctx, const char *_1, const uint8_t *_2, unsigned int _3) {
+            Serial.print("Received: ");
+            Serial.println(_1);
+            bool isAuto = _3 >= 4 && memcmp("auto", _2, 4) == 0;
+            static_cast<ComfoAir*>(ctx)->onMqttCommand(isAuto ? CommandId::AUTO : CommandId::MANUAL);
+          }, this);
+
+          OTA::addEndpoint("/mqtt/routes", [](void *ctx, char *buf, size_t len) -> size_t {
+            return mqtt->routes().toJson(buf, len);
+          }, nullptr);
              Serial.println("MQTT subscriptions complete");
 
       } else {
         Serial.println(" MQTT disabled - skipping subscriptions");
       }
       
-      // ✅ Request slow-changing data at startup (after 8 seconds)
-      // Filter days, target temp, bypass status, and operating mode change very slowly
-      Serial.println("ComfoAir: Waiting 8s before requesting slow-changing data...");
-      delay(8000);
-      requestFilterDays();
-      delay(2000);
-      requestTargetTemp();
-      delay(2000);
-      requestBypassStatus();
-      delay(2000);
-      requestOperatingMode();
-      delay(2000);
+      // Slow-changing data is requested by pdoPoller from loop(), starting
+      // 8s from now and one RTR every PDO_POLL_SPACING_MS
+      pdoPoller.start(millis(), PDO_POLL_START_DELAY_MS);
+      
+      // Pipelined, answers are logged as they arrive
+      requestDeviceInfo();
 
     #endif
   }
@@ -329,196 +514,433 @@ namespace comfoair {
       static unsigned long last_can_rx_report = 0;
       static int can_rx_count = 0;
       
-      // ✅ Request slow-changing data periodically (every 4 hours)
-      // Filter days, target temp, bypass status, and operating mode change very slowly
-      static unsigned long last_slow_data_request = 0;
-      static bool slow_data_request_initialized = false;
+      // Due RTR polls go into the TX queue, unanswered ones time out here
+      pdoPoller.poll(millis());
+      rmiReassembler.poll(millis());
+      rmiClient.poll(millis());
       
-      // Initialize on first loop to prevent immediate request after startup
-      if (!slow_data_request_initialized) {
-        last_slow_data_request = millis();
-        slow_data_request_initialized = true;
+      // Controller alerts -> recovery state machine; TX waits while bus-off
+      canHealth.onEvents(port.takeHealthEvents(), millis());
+      static unsigned long last_health_sync = 0;
+      if (millis() - last_health_sync >= CAN_HEALTH_SYNC_MS) {
+        canHealth.sync(port.getBusStatus(), millis());
+        nodeTable.poll(millis());
+        last_health_sync = millis();
       }
+      canHealth.poll(millis());
+      txQueue.pause(!canHealth.txAllowed());
       
-      if (millis() - last_slow_data_request >= 600000) {  // 14400000ms = 4 hours - 3600000 =1 hr
-        Serial.println("ComfoAir: 30min slow-changing data request...");
-        requestFilterDays();
-           delay(2000);
-        requestTargetTemp();
-           delay(2000);
-        requestBypassStatus();
-           delay(2000);
-        requestOperatingMode();
-           delay(2000);
-        last_slow_data_request = millis();
-      }
+      // Hand the next queued frame to the driver / collect the TX result
+      txQueue.poll(millis());
       
       CAN_FRAME incoming;
-      while (CAN0.read(incoming)) {
+      uint8_t budget = CAN_RX_BUDGET;
+      while (budget > 0 && port.read(incoming)) {
+        budget--;
         can_rx_count++;
         
-        // Report CAN RX rate every 10 seconds
-        if (millis() - last_can_rx_report >= 10000) {
-          Serial.printf("[CAN] Received %d frames in last 10s (%.1f/sec)\n", 
-                        can_rx_count, can_rx_count / 10.0);
-          can_rx_count = 0;
-          last_can_rx_report = millis();
-        }
-        
-        this->canMessage = incoming;
-        
         if (first_message) {
           Serial.println("\nFIRST CAN FRAME RECEIVED! ");
           first_message = false;
         }
         
-        printFrame2(&this->canMessage);
-        
-        // âœ… CRITICAL: Zero out the decoded message structure before decoding
-        memset(&this->decodedMessage, 0, sizeof(DecodedMessage));
-        
-        if (this->comfoMessage.decode(&this->canMessage, &this->decodedMessage)) {
-          // âœ… Make local copies IMMEDIATELY after decode to prevent corruption
-          char decoded_name[40];
-          char decoded_val[15];
-          strncpy(decoded_name, this->decodedMessage.name, 39);
-          decoded_name[39] = '\0';
-          strncpy(decoded_val, this->decodedMessage.val, 14);
-          decoded_val[14] = '\0';
-          
-          /*
-          Serial.print("  â†’ ");
-          Serial.print(decoded_name);
-          Serial.print(" = ");
-          Serial.println(decoded_val);
-          */
-          /* DEBUG: Print manager status and message details
-          Serial.printf("  â†’ Manager status: sensorManager=%s, filterManager=%s, controlManager=%s\n",
-                        sensorManager ? "LINKED" : "NULL",
-                        filterManager ? "LINKED" : "NULL",
-                        controlManager ? "LINKED" : "NULL");
-          Serial.printf("  â†’ Message name: '%s' (length=%d)\n", 
-                        this->decodedMessage.name, 
-                        strlen(this->decodedMessage.name));
-          */
-          // **Check for device time response**
-          if (strcmp(decoded_name, "device_time") == 0) {
-            uint32_t device_seconds = strtoul(decoded_val, NULL, 10);
-            Serial.printf(" Device time: %u seconds since 2000\n", device_seconds);
-            handleDeviceTimeResponse(device_seconds);
-          }
-          
-          /*DEBUG: Print manager status and message details 
-          Serial.printf("  â†’ Manager status: sensorManager=%s, filterManager=%s, controlManager=%s\n",
-                        sensorManager ? "LINKED" : "NULL",
-                        filterManager ? "LINKED" : "NULL",
-                        controlManager ? "LINKED" : "NULL");
-          Serial.printf("  â†’ Message name: '%s' (length=%d)\n", 
-                        decoded_name, 
-                        strlen(decoded_name));
-                        */
-          
-          // Publish to MQTT - use local copies
-          if (mqtt) {
-            sprintf(mqttTopicMsgBuf, "%s/%s", MQTT_PREFIX, decoded_name);
-            sprintf(mqttTopicValBuf, "%s", decoded_val);
-            mqtt->writeToTopic(mqttTopicMsgBuf, mqttTopicValBuf);
-          }
-          // âœ… DEBUG: Check routing logic
-         // Serial.println("  â†’ Checking sensor data routing...");
-          
-          // Route sensor data
-          if (sensorManager) {
-            if (strcmp(decoded_name, "extract_air_temp") == 0) {
-              Serial.println(" MATCH: extract_air_temp - calling updateInsideTemp()");
-              sensorManager->updateInsideTemp(atof(decoded_val));
-            }
-            else if (strcmp(decoded_name, "outdoor_air_temp") == 0) {
-              Serial.println("  MATCH: outdoor_air_temp - calling updateOutsideTemp()");
-              sensorManager->updateOutsideTemp(atof(decoded_val));
-            }
-            else if (strcmp(decoded_name, "extract_air_humidity") == 0) {
-              Serial.println("  MATCH: extract_air_humidity - calling updateInsideHumidity()");
-              sensorManager->updateInsideHumidity(atof(decoded_val));
-            }
-            else if (strcmp(decoded_name, "outdoor_air_humidity") == 0) {
-              Serial.println("  MATCH: outdoor_air_humidity - calling updateOutsideHumidity()");
-              sensorManager->updateOutsideHumidity(atof(decoded_val));
-            }
-            else {
-              //Serial.printf("  âœ— NO MATCH: '%s' is not a sensor data message\n", decoded_name);
-            }
-          } else {
-            // Serial.println("  sensorManager is NULL!"); // Note: sensorManager is NULL in bridge mode (headless) - this is expected
-          }
-          
-          // Route filter data
-          if (filterManager) {
-            if (strcmp(decoded_name, "remaining_days_filter_replacement") == 0) {
-              Serial.println("  MATCH: remaining_days_filter_replacement - calling updateFilterDays()");
-              filterManager->updateFilterDays(atoi(decoded_val));
-            }
-          }
-          
-          // Route control feedback
-          if (controlManager) {
-            if (strcmp(decoded_name, "fan_speed") == 0) {
-              Serial.println("  MATCH: fan_speed - calling updateFanSpeedFromCAN()");
-              
-              // âœ… FIXED: Track current fan speed for deduplication
-              current_fan_speed = atoi(decoded_val);
-              
-              controlManager->updateFanSpeedFromCAN(current_fan_speed);
-            }
-            else if (strcmp(decoded_name, "temp_profile") == 0) {
-              Serial.println(" MATCH: temp_profile - calling updateTempProfileFromCAN()");
-              uint8_t profile = 0;
-              if (strcmp(decoded_val, "cold") == 0) profile = 1;
-              else if (strcmp(decoded_val, "warm") == 0) profile = 2;
-              controlManager->updateTempProfileFromCAN(profile);
-            }
-          }
-          
-          // ============================================================================
-          // â† NEW: Route error/alarm messages
-          // ============================================================================
-          if (errorManager) {
-            // Determine if error is active based on value string
-            bool error_value = (strcmp(decoded_val, "ACTIVE") == 0 || 
-                              strcmp(decoded_val, "REPLACE") == 0 ||
-                              strcmp(decoded_val, "WARNING") == 0);
-            
-            if (strcmp(decoded_name, "error_overheating") == 0) {
-              errorManager->updateErrorOverheating(error_value);
-            }
-            else if (strcmp(decoded_name, "error_temp_sensor_p_oda") == 0) {
-              errorManager->updateErrorTempSensorPODA(error_value);
-            }
-            else if (strcmp(decoded_name, "error_preheat_location") == 0) {
-              errorManager->updateErrorPreheatLocation(error_value);
-            }
-            else if (strcmp(decoded_name, "error_ext_pressure_eha") == 0) {
-              errorManager->updateErrorExtPressureEHA(error_value);
-            }
-            else if (strcmp(decoded_name, "error_ext_pressure_sup") == 0) {
-              errorManager->updateErrorExtPressureSUP(error_value);
-            }
-            else if (strcmp(decoded_name, "error_tempcontrol_p_oda") == 0) {
-              errorManager->updateErrorTempControlPODA(error_value);
-            }
-            else if (strcmp(decoded_name, "error_tempcontrol_sup") == 0) {
-              errorManager->updateErrorTempControlSUP(error_value);
-            }
-            else if (strcmp(decoded_name, "alarm_filter") == 0) {
-              errorManager->updateAlarmFilter(error_value);
-            }
-            else if (strcmp(decoded_name, "warning_system") == 0) {
-              errorManager->updateWarningSystem(error_value);
-            }
-          }
-          // ============================================================================
-        }
+        busStats.record(incoming);
+        // Source node bookkeeping; ignored nodes stop here
+        if (!nodeTable.record(incoming, millis())) continue;
+        canFanout.publish(incoming);
+      }
+      busStats.tick(micros());
+      
+      // Each sink catches up within its own budget
+      canFanout.poll();
+      if (CAN_GATEWAY_ENABLED) canGateway.poll(millis());
+      
+      static unsigned long last_raw_flush = 0;
+      if (rawMqtt && millis() - last_raw_flush >= CAN_MQTT_RAW_MS) {
+        flushRawFrames();
+        last_raw_flush = millis();
+      }
+      
+      // Report CAN RX rate every 10 seconds
+      if (millis() - last_can_rx_report >= 10000) {
+        Serial.printf("[CAN] Received %d frames in last 10s (%.1f/sec)\n", 
+                      can_rx_count, can_rx_count / 10.0);
+        reportCanStats();
+        can_rx_count = 0;
+        last_can_rx_report = millis();
+      }
+      
+      static unsigned long last_stats_publish = 0;
+      if (CAN_STATS_PUBLISH_MS > 0 && millis() - last_stats_publish >= CAN_STATS_PUBLISH_MS) {
+        publishBusStats();
+        last_stats_publish = millis();
+      }
+    #endif
+  }
+
+  // ==========================================================================
+  // FAN-OUT SINKS
+  // ==========================================================================
+  bool ComfoAir::routeFrame(const CAN_FRAME &frame) {
+    // RMI responses are collected until complete, then go to onRmiMessage()
+    if (rmiReassembler.accept(frame, millis())) return true;
+    // Heartbeats only feed nodeTable
+    if (isNodeHeartbeatId(frame.id)) return true;
+    // RTRs and foreign IDs (accept-all filter) must not reach the cache
+    if (!isPdoValueFrame(frame.id, frame.rtr)) return true;
+    
+    // The time response is not a PDO and is never cached.
+    if (frame.id != CAN_ID_TIME_RESPONSE) {
+      uint16_t pdoid = pdoidFromCanId(frame.id);
+      // Any value keeps a polled PDO fresh, changed or not
+      pdoPoller.onPdoReceived(pdoid, millis());
+      
+      // Drop rebroadcasts with an unchanged payload before decoding
+      if (!pdoCache.accept(pdoid, frame.data.uint8, frame.length, millis())) {
+        return true;
+      }
+    }
+    
+    PdoValue value;
+    if (this->comfoMessage.decode(&frame, &value)) {
+      value.decodeUs = micros();
+      canLatency.record(LatencyStage::RX_TO_DECODE, value.rxUs, value.decodeUs);
+      // Route to the subscribed managers (one table lookup, no string compares)
+      pdoRouter.dispatch(value);
+    } else {
+      busStats.recordDecodeFailure();
+    }
+    return true;
+  }
+  
+  bool ComfoAir::publishFrame(const CAN_FRAME &frame) {
+    // Keep the backlog while the broker is away; if it grows past the
+    // fan-out ring only this sink loses frames
+    if (!mqtt->isConnected()) return false;
+    if (isNodeHeartbeatId(frame.id)) return true;
+    if (!isPdoValueFrame(frame.id, frame.rtr)) return true;
+    
+    if (frame.id != CAN_ID_TIME_RESPONSE &&
+        !mqttCache.accept(pdoidFromCanId(frame.id), frame.data.uint8, frame.length, millis())) {
+      return true;
+    }
+    
+    PdoValue value;
+    if (this->comfoMessage.decode(&frame, &value)) {
+      value.decodeUs = micros();
+      // Text is only rendered here, at the edge
+      char decoded_val[PDO_TEXT_SIZE];
+      ComfoMessage::format(value, decoded_val, sizeof(decoded_val));
+      mqtt->writeToTopic(pdoTopic(value.desc), decoded_val);
+      uint32_t publishedUs = micros();
+      canLatency.record(LatencyStage::DECODE_TO_PUBLISH, value.decodeUs, publishedUs);
+      canLatency.record(LatencyStage::RX_TO_PUBLISH, value.rxUs, publishedUs);
+    }
+    return true;
+  }
+  
+  // Raw mode: every frame goes out undecoded, the batch is published when
+  // full or by loop() every CAN_MQTT_RAW_MS
+  bool ComfoAir::publishRawFrame(const CAN_FRAME &frame) {
+    if (!mqtt->isConnected()) return false;
+    if (!rawBatch.append(frame)) {
+      flushRawFrames();
+      rawBatch.append(frame);
+    }
+    return true;
+  }
+  
+  void ComfoAir::flushRawFrames() {
+    if (rawBatch.empty() || !mqtt->isConnected()) return;
+    size_t length;
+    const uint8_t *payload = rawBatch.finish(length);
+    mqtt->writeToTopic(MQTT_PREFIX "/can/raw", payload, length);
+    rawMessages++;
+    rawFrames += rawBatch.frameCount();
+    rawBytes += length;
+    rawBatch.reset();
+  }
+  
+  // Frames we consume: the time response, every PDO a manager subscribed
+  // to and, with MQTT, every PDO we can decode. Sinks that want raw traffic
+  // (frame log, gateway, MQTT raw mode) leave the filter empty = accept all.
+  void ComfoAir::buildRxFilter(CanIdFilter &filter) {
+    filter.clear();
+    if (rawMqtt) return;  // consumers decode with their own tables
+    #if defined(CAN_LOG_FRAMES) && CAN_LOG_FRAMES
+      return;
+    #endif
+    #if CAN_GATEWAY_ENABLED
+      return;  // PC tools see the whole bus
+    #endif
+    filter.addId(CAN_ID_TIME_RESPONSE);
+    filter.addMasked(rmiResponseId(LOCAL_NODE_ID), RMI_RESPONSE_DONT_CARE);
+    filter.addMasked(nodeHeartbeatId(0), CAN_NODE_MASK);   // liveness of every node
+    for (uint16_t pdoid = 0; pdoid < PDO_TABLE_SIZE; pdoid++) {
+      if ((pdoRouter.isHandled(pdoid) || pdoPoller.isPolled(pdoid) || (mqtt && findPdo(pdoid))) &&
+          !filter.addPdo(pdoid)) {
+        filter.clear();  // more than CanIdFilter::MAX_PDOS: accept all
+        return;
+      }
+    }
+  }
+  
+  void ComfoAir::invalidatePdo(uint16_t pdoid) {
+    pdoCache.invalidate(pdoid);
+    mqttCache.invalidate(pdoid);
+  }
+  
+  void ComfoAir::onRmiMessage(const RmiMessage &message) {
+    if (rmiClient.onMessage(message, millis())) return;
+    if (message.isRequest || message.dstNode != LOCAL_NODE_ID) return;
+    Serial.printf("[RMI] %u byte %s from node %u (seq %u)\n", message.length,
+                  message.error ? "error response" : "response", message.srcNode, message.seq);
+  }
+  
+  bool ComfoAir::pollPdo(uint16_t pdoid) {
+    #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
+      return false;
+    #else
+      invalidatePdo(pdoid);  // always deliver the answer
+      return comfoMessage.requestPdo(pdoid);
+    #endif
+  }
+  
+  // Compact snapshot (no jitter histograms) - the full one is on HTTP /can/stats
+  void ComfoAir::publishBusStats() {
+    if (!mqtt || !mqtt->isConnected()) return;
+    static char json[MQTT_BUFFER_SIZE - 64];
+    busStats.setBusStatus(port.getBusStatus());
+    busStats.toJson(json, sizeof(json), micros(), false);
+    mqtt->writeToTopic(MQTT_PREFIX "/can/stats", json);
+  }
+  
+  // ==========================================================================
+  // FRAME CAPTURE
+  // ==========================================================================
+  void ComfoAir::setupCapture() {
+    if (CAN_CAPTURE_SIZE == 0) return;
+    uint8_t *buffer = (uint8_t *)heap_caps_malloc(CAN_CAPTURE_SIZE, MALLOC_CAP_SPIRAM);
+    if (!buffer) {
+      Serial.printf("CAN capture: %u bytes of PSRAM not available - capture off\n", (unsigned)CAN_CAPTURE_SIZE);
+      return;
+    }
+    canCapture.begin(buffer, CAN_CAPTURE_SIZE);
+    canFanout.addSink("capture", [](void *ctx, const CAN_FRAME &frame) {
+      static_cast<ComfoAir*>(ctx)->canCapture.record(frame);
+      return true;
+    }, this, CAN_RX_BUDGET);
+    
+    // Exports run in this task (OTA and ComfoAir share loop()), so nothing
+    // is recorded while a page is streamed
+    OTA::addStreamEndpoint("/can/capture", [](void *ctx) -> const char * {
+      return static_cast<ComfoAir*>(ctx)->beginCaptureExport();
+    }, [](void *ctx, char *buf, size_t len) -> size_t {
+      return static_cast<ComfoAir*>(ctx)->captureExport.next(buf, len);
+    }, this);
+    OTA::addEndpoint("/can/capture/status", [](void *ctx, char *buf, size_t len) -> size_t {
+      return static_cast<ComfoAir*>(ctx)->captureStatus(buf, len);
+    }, this);
+    OTA::addAction("/can/capture/control", [](void *ctx, char *buf, size_t len) -> size_t {
+      return static_cast<ComfoAir*>(ctx)->captureControl(buf, len);
+    }, this);
+    Serial.printf("CAN capture: %u KB ring in PSRAM\n", (unsigned)(canCapture.stats().capacity / 1024));
+  }
+  
+  // GET /can/capture?format=candump|binary&from=<seq>&max=<frames>
+  // Pages are chained with the X-Capture-Next header (from= of the next page).
+  const char *ComfoAir::beginCaptureExport() {
+    char arg[16];
+    CanCaptureExport::Format format = CanCaptureExport::Format::CANDUMP;
+    if (OTA::arg("format", arg, sizeof(arg))) {
+      if (strcmp(arg, "binary") == 0) format = CanCaptureExport::Format::BINARY;
+      else if (strcmp(arg, "candump") != 0) return nullptr;
+    }
+    uint32_t from = canCapture.firstSeq();
+    if (OTA::arg("from", arg, sizeof(arg))) from = strtoul(arg, nullptr, 10);
+    uint32_t maxFrames = CAN_CAPTURE_PAGE_FRAMES;
+    if (OTA::arg("max", arg, sizeof(arg))) {
+      uint32_t wanted = strtoul(arg, nullptr, 10);
+      if (wanted < maxFrames) maxFrames = wanted;
+    }
+    
+    // Record times are the 32-bit frame stamps unwrapped from the first
+    // frame on; map them to esp_timer time, then to wall clock once NTP
+    // has set it (before that candump shows seconds since boot)
+    int64_t nowUs = esp_timer_get_time();
+    int64_t newestUs = nowUs - (uint32_t)((uint32_t)nowUs - canCapture.newestStamp());
+    int64_t offsetUs = newestUs - (int64_t)canCapture.newestUs();
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (tv.tv_sec > 1577836800) {  // 2020-01-01, clock synced
+      offsetUs += (int64_t)tv.tv_sec * 1000000 + tv.tv_usec - nowUs;
+    }
+    
+    captureExport.begin(format, from, maxFrames, offsetUs);
+    char seq[12];
+    snprintf(seq, sizeof(seq), "%u", (unsigned)captureExport.firstSeq());
+    OTA::sendHeader("X-Capture-First", seq);
+    snprintf(seq, sizeof(seq), "%u", (unsigned)captureExport.endSeq());
+    OTA::sendHeader("X-Capture-Next", seq);
+    if (format == CanCaptureExport::Format::BINARY) {
+      OTA::sendHeader("Content-Disposition", "attachment; filename=\"can0.ccap\"");
+      return "application/octet-stream";
+    }
+    OTA::sendHeader("Content-Disposition", "inline; filename=\"can0.log\"");
+    return "text/plain";
+  }
+  
+  size_t ComfoAir::captureStatus(char *buf, size_t len) {
+    CanCapture::Stats s = canCapture.stats();
+    int n = snprintf(buf, len,
+                     "{\"enabled\":%s,\"paused\":%s,\"recorded\":%u,\"frames\":%u,\"dropped\":%u,"
+                     "\"bytes_used\":%u,\"capacity\":%u,\"span_ms\":%u,\"first_seq\":%u,\"end_seq\":%u}",
+                     canCapture.enabled() ? "true" : "false", s.paused ? "true" : "false",
+                     s.recorded, s.frames, s.dropped, s.bytesUsed, s.capacity,
+                     (unsigned)(s.spanUs / 1000), canCapture.firstSeq(), canCapture.endSeq());
+    return n < 0 ? 0 : ((size_t)n < len ? n : len - 1);
+  }
+  
+  // POST /can/capture/control?action=pause|resume|clear|snapshot
+  // snapshot = pause, then download first_seq..end_seq page by page and resume
+  size_t ComfoAir::captureControl(char *buf, size_t len) {
+    char action[16];
+    if (!OTA::arg("action", action, sizeof(action))) return 0;
+    if (strcmp(action, "pause") == 0 || strcmp(action, "snapshot") == 0) {
+      canCapture.pause(true);
+    } else if (strcmp(action, "resume") == 0) {
+      canCapture.pause(false);
+    } else if (strcmp(action, "clear") == 0) {
+      canCapture.clear();
+    } else {
+      return 0;
+    }
+    Serial.printf("[CAN] Capture %s\n", action);
+    return captureStatus(buf, len);
+  }
+  
+  // ==========================================================================
+  // CAN GATEWAY
+  // ==========================================================================
+  void ComfoAir::setupGateway() {
+    if (!CAN_GATEWAY_ENABLED) return;
+    if (!canGateway.begin(CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT, CAN_GATEWAY_CANNELLONI_PEER)) {
+      Serial.printf("CAN gateway: cannot open tcp/%u / udp/%u - gateway off\n",
+                    CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT);
+      canGateway.end();
+      return;
+    }
+    canFanout.addSink("gw", [](void *ctx, const CAN_FRAME &frame) {
+      return static_cast<ComfoAir*>(ctx)->canGateway.forward(frame, millis());
+    }, this, CAN_RX_BUDGET);
+    OTA::addEndpoint("/can/gateway", [](void *ctx, char *buf, size_t len) -> size_t {
+      return static_cast<ComfoAir*>(ctx)->canGateway.toJson(buf, len);
+    }, this);
+    Serial.printf("CAN gateway: slcan tcp/%u, cannelloni udp/%u, PC -> bus %u frames/s\n",
+                  CAN_GATEWAY_SLCAN_PORT, CAN_GATEWAY_CANNELLONI_PORT, CAN_GATEWAY_TX_RATE);
+  }
+  
+  void ComfoAir::reportCanStats() {
+    #if !defined(REMOTE_CLIENT_MODE) || !REMOTE_CLIENT_MODE
+      const PdoCache::Stats &cache = pdoCache.stats();
+      Serial.printf("[CAN] Suppressed %u unchanged + %u deadband, %u heartbeats\n",
+                    cache.unchanged, cache.deadband, cache.heartbeats);
+      pdoCache.resetStats();
+      
+      CAN_RX_STATS rx = port.getRxStats();
+      Serial.printf("[CAN] RX ring high-water %u/%u, overflows %u, driver missed %u, overrun %u\n",
+                    rx.ringHighWater, rx.ringSize, rx.ringOverflows,
+                    rx.driverMissed, rx.driverOverrun);
+      const CanTxQueue::Stats &tx = txQueue.stats();
+      Serial.printf("[CAN] TX jobs %u queued, %u done, %u failed, %u retries, %u rejected, max depth %u\n",
+                    tx.enqueued, tx.completed, tx.failed, tx.retries, tx.rejected, tx.maxDepth);
+      uint32_t polls = 0, answered = 0, timeouts = 0, latencySum = 0, latencyMax = 0;
+      for (uint8_t i = 0; i < pdoPoller.count(); i++) {
+        PdoPoller::EntryStats poll = pdoPoller.stats(i, millis());
+        polls += poll.requests;
+        answered += poll.responses;
+        timeouts += poll.timeouts;
+        latencySum += poll.avgLatencyMs * poll.responses;
+        if (poll.maxLatencyMs > latencyMax) latencyMax = poll.maxLatencyMs;
+      }
+      Serial.printf("[CAN] RTR polls %u sent, %u answered (%.0f%%), %u timeouts, latency avg %u ms, max %u ms\n",
+                    polls, answered, polls ? 100.0f * answered / polls : 100.0f, timeouts,
+                    answered ? latencySum / answered : 0, latencyMax);
+      const RmiReassembler::Stats &rmi = rmiReassembler.stats();
+      Serial.printf("[CAN] RMI %u messages (%u multi-frame), pool %u/%u (max %u), dropped %u timeout %u no buffer %u oversize, %u dup %u out-of-order %u restart\n",
+                    rmi.messages, rmi.multiFrame, rmiReassembler.inUse(), RmiReassembler::POOL_SIZE,
+                    rmi.poolHighWater, rmi.timeouts, rmi.poolExhausted, rmi.oversize,
+                    rmi.duplicates, rmi.outOfOrder, rmi.restarts);
+      const RmiClient::Stats &client = rmiClient.stats();
+      Serial.printf("[CAN] RMI requests %u: %u ok, %u error, %u timeout, %u rejected, %u unmatched, max %u in flight, max latency %u ms\n",
+                    client.requests, client.ok, client.errors, client.timeouts, client.rejected,
+                    client.unmatched, client.maxInFlight, client.maxLatencyMs);
+      CanBusStatus bus = port.getBusStatus();
+      busStats.setBusStatus(bus);
+      Serial.printf("[CAN] Bus %s, load %u.%u%% (peak %u.%u%%), TEC %u REC %u, %u PDOIDs seen, %u decode failures\n",
+                    canBusStateName(bus.state), busStats.loadPermille() / 10, busStats.loadPermille() % 10,
+                    busStats.peakLoadPermille() / 10, busStats.peakLoadPermille() % 10,
+                    bus.txErrorCounter, bus.rxErrorCounter, busStats.pdoCount(),
+                    busStats.decodeFailureCount());
+      const CanHealth::Stats &health = canHealth.stats();
+      Serial.printf("[CAN] Health %s%s, %u error passive, %u bus-off, %u recovered (last %u ms, max %u ms), %u failed, backoff %u ms\n",
+                    canHealthStateName(canHealth.state()), canHealth.errorWarning() ? " (warning)" : "",
+                    health.errorPassive, health.busOffs, health.recoveries, health.lastRecoveryMs,
+                    health.maxRecoveryMs, health.recoveryFailures, canHealth.backoffMs());
+      Serial.printf("[CAN] Time passive %u s, bus-off %u ms, recovering %u ms, %u bus errors, %u TX failed\n",
+                    canHealth.timeInState(CanHealthState::ERROR_PASSIVE, millis()) / 1000,
+                    canHealth.timeInState(CanHealthState::BUS_OFF, millis()),
+                    canHealth.timeInState(CanHealthState::RECOVERING, millis()),
+                    health.busErrors, health.txFailed);
+      char nodes[160];
+      size_t used = 0;
+      nodes[0] = '\0';
+      for (uint8_t id = 0; id < NodeTable::MAX_NODES && used < sizeof(nodes); id++) {
+        const NodeTable::Node &node = nodeTable.node(id);
+        if (node.state == NodeState::UNSEEN) continue;
+        int n = snprintf(nodes + used, sizeof(nodes) - used, " 0x%02X%s %u.%u pdo/s", id,
+                         node.state == NodeState::DEAD ? " dead" : "", node.pdoRateX10 / 10, node.pdoRateX10 % 10);
+        if (n > 0) used += n;
+      }
+      Serial.printf("[CAN] Nodes %u alive:%s\n", nodeTable.aliveCount(), nodes);
+      if (nodeTable.collisions()) {
+        Serial.printf("[CAN] Node ID 0x%02X COLLISION: %u frames from another node with our ID, last %u s ago\n",
+                      LOCAL_NODE_ID, nodeTable.collisions(), (millis() - nodeTable.lastCollisionMs()) / 1000);
+      }
+      if (canCapture.enabled()) {
+        CanCapture::Stats capture = canCapture.stats();
+        Serial.printf("[CAN] Capture%s %u frames over %u s, %u/%u KB, %u dropped\n",
+                      capture.paused ? " (paused)" : "", capture.frames, (unsigned)(capture.spanUs / 1000000),
+                      capture.bytesUsed / 1024, capture.capacity / 1024, capture.dropped);
       }
+      if (rawMqtt) {
+        Serial.printf("[CAN] MQTT raw %u frames in %u messages (%.1f per message), %u KB\n",
+                      rawFrames, rawMessages, rawMessages ? (float)rawFrames / rawMessages : 0.0f, rawBytes / 1024);
+      }
+      if (CAN_GATEWAY_ENABLED) {
+        const CanGateway::Stats &gw = canGateway.stats();
+        Serial.printf("[CAN] Gateway slcan %s %u frames in %u writes, cannelloni %s %u frames in %u packets, PC -> bus %u sent %u rate limited %u rejected, %u bad input, %u blocked\n",
+                      canGateway.slcanOpen() ? "open" : (canGateway.slcanConnected() ? "connected" : "idle"),
+                      gw.slcanFrames, gw.slcanWrites, canGateway.hasPeer() ? "peer" : "no peer",
+                      gw.udpFrames, gw.udpPackets, gw.txFrames, gw.txRateLimited, gw.txRejected,
+                      gw.badInput, gw.blocked);
+      }
+      for (uint8_t i = 0; i < LatencyStats::STAGE_COUNT; i++) {
+        const LatencyHistogram &h = canLatency.stage((LatencyStage)i);
+        if (h.count == 0) continue;
+        Serial.printf("[CAN] Latency %-17s %u samples, avg %u us, p50 < %u us, p99 < %u us, max %u us\n",
+                      latencyStageName((LatencyStage)i), h.count, h.averageUs(),
+                      h.percentileUs(500), h.percentileUs(990), h.maxUs);
+      }
+      Serial.printf("[CAN] Filter: passed %u, rejected in software %u, hw filter would reject %u\n",
+                    rx.received, rx.swRejected, rx.hwWouldReject);
+      
+      for (uint8_t i = 0; i < canFanout.sinkCount(); i++) {
+        FrameFanout::SinkStats sink = canFanout.sinkStats(i);
+        Serial.printf("[CAN] Sink %-6s delivered %u, lag %u (max %u), lost %u\n",
+                      sink.name, sink.delivered, sink.lag, sink.maxLag, sink.lost);
+      }
+      canFanout.resetStats();
     #endif
   }
-}
\ No newline at end of file
+}
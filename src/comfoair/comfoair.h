@@ -1,6 +1,21 @@
 #ifndef COMFOAIRClass_H
 #define COMFOAIRClass_H
 #include "message.h"
+#include "can_port.h"
+#include "pdo_router.h"
+#include "pdo_cache.h"
+#include "frame_fanout.h"
+#include "can_tx_queue.h"
+#include "pdo_poller.h"
+#include "rmi_reassembler.h"
+#include "rmi_client.h"
+#include "bus_stats.h"
+#include "can_health.h"
+#include "latency_stats.h"
+#include "can_capture.h"
+#include "node_table.h"
+#include "can_gateway.h"
+#include "raw_frame_batch.h"
 
 // Forward declarations
 namespace comfoair {
@@ -14,7 +29,8 @@ namespace comfoair {
 namespace comfoair {
   class ComfoAir {
     public:
-      ComfoAir();
+      // All bus traffic goes through port (CAN0 on the device)
+      explicit ComfoAir(CanPort &port);
       void setup();
       void loop();
       void setSensorDataManager(SensorDataManager* manager);
@@ -24,7 +40,8 @@ namespace comfoair {
       void setErrorDataManager(ErrorDataManager* manager);  // ← NEW
       
       // Send CAN command
-      bool sendCommand(const char* command);
+      bool sendCommand(CommandId command);
+      bool sendCommand(const char* command);  // by table name, e.g. "boost_10_min"
       
       // Time synchronization methods
       void requestDeviceTime();
@@ -36,23 +53,89 @@ namespace comfoair {
       void requestBypassStatus();      // PDOID 66  - Bypass activation mode
       void requestOperatingMode();     // PDOID 49  - Operating mode
       
+      // RMI property access on the MVHR (node 1), answered via callback
+      RmiRequestId getProperty(uint8_t unit, uint8_t subunit, uint8_t property,
+                               RmiCallback callback, void *context);
+      RmiRequestId setProperty(uint8_t unit, uint8_t subunit, uint8_t property,
+                               const uint8_t *value, uint8_t length,
+                               RmiCallback callback, void *context);
+      void requestDeviceInfo();        // serial, firmware, model - logged
+      
     private:
-      CAN_FRAME canMessage;
+      CanPort &port;
       ComfoMessage comfoMessage;
-      DecodedMessage decodedMessage;
+      CanTxQueue txQueue;  // every frame we send, by priority
       SensorDataManager* sensorManager;
       FilterDataManager* filterManager;
       ControlManager* controlManager;
       TimeManager* timeManager;
       ErrorDataManager* errorManager;  // ← NEW
       
+      // PDOID -> handler table, filled by the set*Manager() calls
+      PdoRouter pdoRouter;
+      
+      // Received frames, read independently by each sink below
+      FrameFanout canFanout;
+      
+      // Last forwarded payload per PDOID - drops unchanged rebroadcasts.
+      // Separate caches so a lagging MQTT sink does not hide changes from
+      // the managers (and vice versa).
+      PdoCache pdoCache;
+      PdoCache mqttCache;
+      
+      // RTR polling of the slow-changing PDOs (filter days, target temp, ...)
+      PdoPoller pdoPoller;
+      
+      // Multi-frame RMI responses, collected in a fixed buffer pool
+      RmiReassembler rmiReassembler;
+      RmiClient rmiClient;
+      
+      // Per-PDOID rate / jitter, bus load, TWAI status (HTTP /can/stats, MQTT)
+      BusStats busStats;
+      
+      // Error-passive / bus-off recovery, pauses txQueue while bus-off
+      CanHealth canHealth;
+      
+      // Nodes seen on the bus, liveness, address collisions (HTTP /can/nodes)
+      NodeTable nodeTable;
+      
+      // Raw frame recorder in PSRAM, exported on HTTP /can/capture
+      CanCapture canCapture;
+      CanCaptureExport captureExport;
+      
+      // slcan / cannelloni for PC tools, CAN_GATEWAY_ENABLED (HTTP /can/gateway)
+      CanGateway canGateway;
+      
+      // Fan-out sinks
+      bool routeFrame(const CAN_FRAME &frame);    // decode -> managers
+      bool publishFrame(const CAN_FRAME &frame);  // decode -> MQTT
+      bool publishRawFrame(const CAN_FRAME &frame);  // raw batch -> MQTT
+      void flushRawFrames();
+      void buildRxFilter(CanIdFilter &filter);
+      void invalidatePdo(uint16_t pdoid);
+      bool pollPdo(uint16_t pdoid);
+      void onMqttCommand(CommandId command);
+      void onRmiMessage(const RmiMessage &message);
+      void reportCanStats();
+      void publishBusStats();
+      void setupCapture();
+      const char *beginCaptureExport();
+      size_t captureStatus(char *buf, size_t len);
+      size_t captureControl(char *buf, size_t len);
+      void setupGateway();
+      
       // ✅ Time-based deduplication (tracks SENT commands, not CAN state)
       uint8_t last_sent_fan_speed;  // Last speed we SENT via command
       unsigned long last_fan_speed_command_time;  // When we sent it
       uint8_t current_fan_speed;  // Current speed from CAN (for display)
       
-      // Handle device time response
-      void handleDeviceTimeResponse(uint32_t device_seconds);
+      // Raw mode of the headless bridge (CAN_MQTT_RAW_MS): frames batched
+      // to <prefix>/can/raw instead of one text message per value
+      RawFrameBatch rawBatch;
+      bool rawMqtt;
+      uint32_t rawMessages;
+      uint32_t rawFrames;
+      uint32_t rawBytes;
   };
 }
 
@@ -1,27 +1,141 @@
 #ifndef COMFOCOMMANDS_H
 #define COMFOCOMMANDS_H
-#include "../secrets.h"
-
-#define CMD_ventilation_level_0             { 0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00 }
-#define CMD_ventilation_level_1             { 0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01 }
-#define CMD_ventilation_level_2             { 0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02 }
-#define CMD_ventilation_level_3             { 0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03 }
-#define CMD_boost_10_min                    { 0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x58, 0x02, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00 }
-#define CMD_boost_20_min                    { 0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0xB0, 0x04, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00 }
-#define CMD_boost_30_min                    { 0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x08, 0x07, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00 }
-#define CMD_boost_60_min                    { 0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0E, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00 }
-#define CMD_boost_end                       { 0x85, 0x15, 0x01, 0x06 }
-#define CMD_auto                            { 0x85, 0x15, 0x08, 0x01 }
-#define CMD_manual                          { 0x84, 0x15, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01 }
-#define CMD_bypass_activate_1h              { 0x84, 0x15, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x01 }
-#define CMD_bypass_deactivate_1h            { 0x84, 0x15, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x02 }
-#define CMD_bypass_auto                     { 0x85, 0x15, 0x02, 0x01 }
-#define CMD_ventilation_supply_only         { 0x84, 0x15, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x01 }
-#define CMD_ventilation_supply_only_reset   { 0x85, 0x15, 0x06, 0x01 }
-#define CMD_ventilation_extract_only        { 0x84, 0x15, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x00 }
-#define CMD_ventilation_extract_only_reset  { 0x85, 0x15, 0x07, 0x01 }
-#define CMD_temp_profile_normal             { 0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00 }
-#define CMD_temp_profile_cool               { 0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x01 }
-#define CMD_temp_profile_warm               { 0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x02 }
-
-#endif
\ No newline at end of file
+
+#include <cstdint>
+#include <cstring>
+
+// ============================================================================
+// COMMAND TABLE - RMI payloads sent to the MVHR
+// ============================================================================
+// One line per command: id, MQTT topic name (<prefix>/commands/<name>) and
+// payload bytes. Everything below is constexpr, so the table lives in flash
+// and sending a command needs no heap.
+//
+// Topic names map to a CommandId through a perfect hash computed by the
+// compiler: one FNV-1a hash, one slot read and one strcmp per lookup.
+// ============================================================================
+
+#define COMFO_COMMANDS(X) \
+  X(VENTILATION_LEVEL_0,            ventilation_level_0,            0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00) \
+  X(VENTILATION_LEVEL_1,            ventilation_level_1,            0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01) \
+  X(VENTILATION_LEVEL_2,            ventilation_level_2,            0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x02) \
+  X(VENTILATION_LEVEL_3,            ventilation_level_3,            0x84, 0x15, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03) \
+  X(BOOST_10_MIN,                   boost_10_min,                   0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x58, 0x02, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00) \
+  X(BOOST_20_MIN,                   boost_20_min,                   0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0xB0, 0x04, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00) \
+  X(BOOST_30_MIN,                   boost_30_min,                   0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x08, 0x07, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00) \
+  X(BOOST_60_MIN,                   boost_60_min,                   0x84, 0x15, 0x01, 0x06, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0E, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00) \
+  X(BOOST_END,                      boost_end,                      0x85, 0x15, 0x01, 0x06) \
+  X(AUTO,                           auto,                           0x85, 0x15, 0x08, 0x01) \
+  X(MANUAL,                         manual,                         0x84, 0x15, 0x08, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x01) \
+  X(BYPASS_ACTIVATE_1H,             bypass_activate_1h,             0x84, 0x15, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x01) \
+  X(BYPASS_DEACTIVATE_1H,           bypass_deactivate_1h,           0x84, 0x15, 0x02, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x02) \
+  X(BYPASS_AUTO,                    bypass_auto,                    0x85, 0x15, 0x02, 0x01) \
+  X(VENTILATION_SUPPLY_ONLY,        ventilation_supply_only,        0x84, 0x15, 0x06, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x01) \
+  X(VENTILATION_SUPPLY_ONLY_RESET,  ventilation_supply_only_reset,  0x85, 0x15, 0x06, 0x01) \
+  X(VENTILATION_EXTRACT_ONLY,       ventilation_extract_only,       0x84, 0x15, 0x07, 0x01, 0x00, 0x00, 0x00, 0x00, 0x10, 0x0e, 0x00, 0x00, 0x00) \
+  X(VENTILATION_EXTRACT_ONLY_RESET, ventilation_extract_only_reset, 0x85, 0x15, 0x07, 0x01) \
+  X(TEMP_PROFILE_NORMAL,            temp_profile_normal,            0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x00) \
+  X(TEMP_PROFILE_COOL,              temp_profile_cool,              0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x01) \
+  X(TEMP_PROFILE_WARM,              temp_profile_warm,              0x84, 0x15, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0xff, 0xff, 0xff, 0xff, 0x02)
+
+namespace comfoair {
+
+  #define COMFO_COMMAND_ENUM(id, name, ...) id,
+  enum class CommandId : uint8_t {
+    COMFO_COMMANDS(COMFO_COMMAND_ENUM)
+    COUNT,
+    NONE = 0xFF
+  };
+  #undef COMFO_COMMAND_ENUM
+
+  #define COMFO_COMMAND_PAYLOAD(id, name, ...) constexpr uint8_t CMD_##name[] = { __VA_ARGS__ };
+  COMFO_COMMANDS(COMFO_COMMAND_PAYLOAD)
+  #undef COMFO_COMMAND_PAYLOAD
+
+  struct CommandDescriptor {
+    CommandId id;
+    const char *name;
+    const uint8_t *payload;
+    uint8_t length;
+  };
+
+  #define COMFO_COMMAND_ENTRY(id, name, ...) { CommandId::id, #name, CMD_##name, sizeof(CMD_##name) },
+  constexpr CommandDescriptor COMMANDS[] = {
+    COMFO_COMMANDS(COMFO_COMMAND_ENTRY)
+  };
+  #undef COMFO_COMMAND_ENTRY
+
+  constexpr uint8_t COMMAND_COUNT = sizeof(COMMANDS) / sizeof(COMMANDS[0]);
+  static_assert(COMMAND_COUNT == (uint8_t)CommandId::COUNT, "COMMANDS must cover every CommandId");
+
+  constexpr const CommandDescriptor &commandDescriptor(CommandId id) {
+    return COMMANDS[(uint8_t)id];
+  }
+
+  constexpr const char *commandName(CommandId id) {
+    return (uint8_t)id < COMMAND_COUNT ? COMMANDS[(uint8_t)id].name : "unknown";
+  }
+
+  // 0..3 for the ventilation level commands, 255 otherwise
+  constexpr uint8_t commandFanSpeed(CommandId id) {
+    return (uint8_t)id <= (uint8_t)CommandId::VENTILATION_LEVEL_3 ? (uint8_t)id : 255;
+  }
+
+  // ==========================================================================
+  // Perfect hash: topic name -> CommandId
+  // ==========================================================================
+  constexpr uint8_t COMMAND_HASH_SLOTS = 64;  // power of two, > COMMAND_COUNT
+
+  constexpr uint32_t commandHash(const char *name, uint32_t seed) {
+    uint32_t hash = 2166136261u ^ seed;
+    while (*name) {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619u;
+    }
+    return hash;
+  }
+
+  constexpr bool commandSeedIsPerfect(uint32_t seed) {
+    bool used[COMMAND_HASH_SLOTS] = {};
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+      uint8_t slot = commandHash(COMMANDS[i].name, seed) & (COMMAND_HASH_SLOTS - 1);
+      if (used[slot]) return false;
+      used[slot] = true;
+    }
+    return true;
+  }
+
+  constexpr uint32_t findCommandSeed() {
+    for (uint32_t seed = 0; seed < 4096; seed++) {
+      if (commandSeedIsPerfect(seed)) return seed;
+    }
+    return UINT32_MAX;
+  }
+
+  constexpr uint32_t COMMAND_HASH_SEED = findCommandSeed();
+  static_assert(COMMAND_HASH_SEED != UINT32_MAX, "no perfect hash seed - raise COMMAND_HASH_SLOTS");
+
+  struct CommandSlots {
+    CommandId slot[COMMAND_HASH_SLOTS];
+  };
+
+  constexpr CommandSlots buildCommandSlots() {
+    CommandSlots slots = {};
+    for (uint8_t i = 0; i < COMMAND_HASH_SLOTS; i++) slots.slot[i] = CommandId::NONE;
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+      slots.slot[commandHash(COMMANDS[i].name, COMMAND_HASH_SEED) & (COMMAND_HASH_SLOTS - 1)] = COMMANDS[i].id;
+    }
+    return slots;
+  }
+
+  constexpr CommandSlots COMMAND_SLOTS = buildCommandSlots();
+
+  // CommandId::NONE for names that are not in the table
+  inline CommandId findCommand(const char *name) {
+    CommandId id = COMMAND_SLOTS.slot[commandHash(name, COMMAND_HASH_SEED) & (COMMAND_HASH_SLOTS - 1)];
+    if (id == CommandId::NONE || strcmp(COMMANDS[(uint8_t)id].name, name) != 0) return CommandId::NONE;
+    return id;
+  }
+}
+
+#endif
@@ -1,5 +1,7 @@
 #include "control_manager.h"
 #include "comfoair.h"
+#include "commands.h"
+#include "pdo_router.h"
 #include "../ui/GUI.h"
 #include "../mqtt/mqtt.h"
 #include "../secrets.h"
@@ -29,7 +31,8 @@ ControlManager::ControlManager()
       pending_fan_speed(2),
       pending_temp_profile(0),
       fan_speed_command_pending(false),
-      temp_profile_command_pending(false) {
+      temp_profile_command_pending(false),
+      display_mark() {
 }
 
 void ControlManager::setup() {
@@ -59,6 +62,19 @@ void ControlManager::setMQTT(MQTT* mqtt_client) {
     Serial.println("ControlManager: MQTT linked for remote command sending");
 }
 
+void ControlManager::subscribePdos(PdoRouter &router) {
+    router.subscribe(PDO_FAN_SPEED, [](void *ctx, const PdoValue &value) {
+        ControlManager *self = static_cast<ControlManager*>(ctx);
+        self->display_mark.note(value);
+        self->updateFanSpeedFromCAN(value.raw);
+        self->display_mark.clear();  // display unchanged (same speed, boost)
+    }, this);
+    // Enum ordinal: 0 = auto, 1 = cold, 2 = warm
+    router.subscribe(PDO_TEMP_PROFILE, [](void *ctx, const PdoValue &value) {
+        static_cast<ControlManager*>(ctx)->updateTempProfileFromCAN(value.ordinal);
+    }, this);
+}
+
 bool ControlManager::isDemoMode() {
     if (last_can_feedback == 0) return true;
     return (millis() - last_can_feedback) > CAN_TIMEOUT;
@@ -123,6 +139,7 @@ void ControlManager::endBoost() {
 
 void ControlManager::updateDisplay() {
     GUI_update_fan_speed_display_from_cpp(current_fan_speed, boost_timer_active);
+    canLatency.displayQueued(display_mark);
     
     if (boost_timer_active) {
         int minutes = getRemainingBoostMinutes();
@@ -351,50 +368,45 @@ void ControlManager::updateTempProfileFromCAN(uint8_t profile) {
 // ============================================================================
 
 void ControlManager::sendFanSpeedCommand(uint8_t speed) {
-    const char* commands[] = {
-        "ventilation_level_0",
-        "ventilation_level_1",
-        "ventilation_level_2",
-        "ventilation_level_3"
-    };
-    
     if (speed > 3) return;
+    CommandId command = (CommandId)((uint8_t)CommandId::VENTILATION_LEVEL_0 + speed);
     
     #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
         if (mqtt) {
-            Serial.printf("ControlManager: Sending MQTT command: %s\n", commands[speed]);
+            Serial.printf("ControlManager: Sending MQTT command: %s\n", commandName(command));
             char topic[50];
-            snprintf(topic, sizeof(topic), MQTT_PREFIX "/commands/%s", commands[speed]);
+            snprintf(topic, sizeof(topic), MQTT_PREFIX "/commands/%s", commandName(command));
             mqtt->writeToTopic(topic, "");
         }
     #else
         if (comfoair) {
-            Serial.printf("ControlManager: Sending CAN command: %s\n", commands[speed]);
-            comfoair->sendCommand(commands[speed]);
+            Serial.printf("ControlManager: Sending CAN command: %s\n", commandName(command));
+            comfoair->sendCommand(command);
         }
     #endif
 }
 
 void ControlManager::sendTempProfileCommand(uint8_t profile) {
-    const char* commands[] = {
-        "temp_profile_normal",
-        "temp_profile_cool",
-        "temp_profile_warm"
+    static const CommandId commands[] = {
+        CommandId::TEMP_PROFILE_NORMAL,
+        CommandId::TEMP_PROFILE_COOL,
+        CommandId::TEMP_PROFILE_WARM
     };
     
     if (profile > 2) return;
+    CommandId command = commands[profile];
     
     #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
         if (mqtt) {
-            Serial.printf("ControlManager: Sending MQTT command: %s\n", commands[profile]);
+            Serial.printf("ControlManager: Sending MQTT command: %s\n", commandName(command));
             char topic[50];
-            snprintf(topic, sizeof(topic), MQTT_PREFIX "/commands/%s", commands[profile]);
+            snprintf(topic, sizeof(topic), MQTT_PREFIX "/commands/%s", commandName(command));
             mqtt->writeToTopic(topic, "");
         }
     #else
         if (comfoair) {
-            Serial.printf("ControlManager: Sending CAN command: %s\n", commands[profile]);
-            comfoair->sendCommand(commands[profile]);
+            Serial.printf("ControlManager: Sending CAN command: %s\n", commandName(command));
+            comfoair->sendCommand(command);
         }
     #endif
 }
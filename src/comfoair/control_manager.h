@@ -2,12 +2,14 @@
 #define CONTROL_MANAGER_H
 
 #include <Arduino.h>
+#include "latency_stats.h"
 
 namespace comfoair {
 
 // Forward declarations
 class ComfoAir;
 class MQTT;
+class PdoRouter;
 
 class ControlManager {
 public:
@@ -18,6 +20,9 @@ public:
     void setComfoAir(ComfoAir* comfo);
     void setMQTT(MQTT* mqtt_client);
     
+    // Subscribe to the CAN PDOs this manager consumes
+    void subscribePdos(PdoRouter &router);
+    
     // Button command triggers (called from GUI events)
     void increaseFanSpeed();
     void decreaseFanSpeed();
@@ -64,6 +69,9 @@ private:
     bool temp_profile_command_pending;
     static const unsigned long COMMAND_DEBOUNCE_MS = 2000; // Wait 2s before sending command
     
+    // Fan speed value being handled, for the decode -> pixel latency
+    LatencyMark display_mark;
+    
     // Internal helper functions
     void processPendingCommands();
     void updateBoostTimer();  // Ã¢Å“â€¦ NEW: Check and update boost timer every loop
@@ -1,4 +1,5 @@
 #include "error_data.h"
+#include "pdo_router.h"
 #include "../ui/GUI.h"
 #include "../board_config.h"  // For hasDisplay()
 
@@ -59,6 +60,31 @@ void ErrorDataManager::loop() {
     }
 }
 
+// One handler for all error PDOs: PDOID 321-329 map in order onto the setters.
+// Enum ordinal 0 is "clear"/"ok", anything else is ACTIVE/REPLACE/WARNING.
+static void onErrorPdo(void *ctx, const PdoValue &value) {
+    typedef void (ErrorDataManager::*Setter)(bool);
+    static const Setter SETTERS[] = {
+        &ErrorDataManager::updateErrorOverheating,     // 321
+        &ErrorDataManager::updateErrorTempSensorPODA,  // 322
+        &ErrorDataManager::updateErrorPreheatLocation, // 323
+        &ErrorDataManager::updateErrorExtPressureEHA,  // 324
+        &ErrorDataManager::updateErrorExtPressureSUP,  // 325
+        &ErrorDataManager::updateErrorTempControlPODA, // 326
+        &ErrorDataManager::updateErrorTempControlSUP,  // 327
+        &ErrorDataManager::updateAlarmFilter,          // 328
+        &ErrorDataManager::updateWarningSystem         // 329
+    };
+    ErrorDataManager *manager = static_cast<ErrorDataManager*>(ctx);
+    (manager->*SETTERS[value.pdoid - PDO_ERROR_OVERHEATING])(value.ordinal != 0);
+}
+
+void ErrorDataManager::subscribePdos(PdoRouter &router) {
+    for (uint16_t pdoid = PDO_ERROR_OVERHEATING; pdoid <= PDO_WARNING_SYSTEM; pdoid++) {
+        router.subscribe(pdoid, onErrorPdo, this);
+    }
+}
+
 void ErrorDataManager::updateErrorOverheating(bool active) {
     if (error_overheating != active) {
         error_overheating = active;
@@ -5,6 +5,8 @@
 
 namespace comfoair {
 
+class PdoRouter;
+
 class ErrorDataManager {
 public:
     ErrorDataManager();
@@ -12,6 +14,9 @@ public:
     void setup();
     void loop();
     
+    // Subscribe to the CAN PDOs this manager consumes (PDOID 321-329)
+    void subscribePdos(PdoRouter &router);
+    
     // Update individual error states from CAN
     void updateErrorOverheating(bool active);
     void updateErrorTempSensorPODA(bool active);
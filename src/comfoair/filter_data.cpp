@@ -1,4 +1,5 @@
 #include "filter_data.h"
+#include "pdo_router.h"
 #include "../ui/GUI.h"
 #include "../board_config.h"  // For hasDisplay()
 
@@ -35,6 +36,12 @@ void FilterDataManager::loop() {
     }
 }
 
+void FilterDataManager::subscribePdos(PdoRouter &router) {
+    router.subscribe(PDO_FILTER_DAYS, [](void *ctx, const PdoValue &value) {
+        static_cast<FilterDataManager*>(ctx)->updateFilterDays(value.raw);
+    }, this);
+}
+
 void FilterDataManager::updateFilterDays(int days) {
     // ✅ DEDUPLICATION: Ignore if same value received within 5 seconds
     // This prevents issues when MVHR sends multiple responses to RTR
@@ -6,6 +6,8 @@
 
 namespace comfoair {
 
+class PdoRouter;
+
 class FilterDataManager {
 public:
     FilterDataManager();
@@ -13,6 +15,9 @@ public:
     void setup();
     void loop();
     
+    // Subscribe to the CAN PDOs this manager consumes
+    void subscribePdos(PdoRouter &router);
+    
     // Update filter days from CAN
     void updateFilterDays(int days);
     
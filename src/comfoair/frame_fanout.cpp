@@ -0,0 +1,72 @@
+#include <string.h>
+#include "frame_fanout.h"
+
+namespace comfoair {
+
+  FrameFanout::FrameFanout() : head(0), count(0) {
+    memset(sinks, 0, sizeof(sinks));
+  }
+
+  int8_t FrameFanout::addSink(const char *name, FrameSink sink, void *context, uint8_t budget) {
+    if (count >= MAX_SINKS || sink == nullptr || budget == 0) return -1;
+
+    Sink &s = sinks[count];
+    s.name = name;
+    s.fn = sink;
+    s.context = context;
+    s.budget = budget;
+    s.cursor = head;
+    s.delivered = 0;
+    s.lost = 0;
+    s.maxLag = 0;
+    return count++;
+  }
+
+  void FrameFanout::publish(const CAN_FRAME &frame) {
+    slots[head & (CAN_FANOUT_SIZE - 1)] = frame;
+    head++;
+  }
+
+  void FrameFanout::poll() {
+    for (uint8_t i = 0; i < count; i++) {
+      Sink &s = sinks[i];
+
+      uint32_t lag = head - s.cursor;
+      if (lag > CAN_FANOUT_SIZE) {
+        // Lapped by the producer: drop this sink's overwritten backlog
+        s.lost += lag - CAN_FANOUT_SIZE;
+        s.cursor = head - CAN_FANOUT_SIZE;
+        lag = CAN_FANOUT_SIZE;
+      }
+      if (lag > s.maxLag) s.maxLag = lag;
+
+      for (uint8_t n = 0; n < s.budget && s.cursor != head; n++) {
+        if (!s.fn(s.context, slots[s.cursor & (CAN_FANOUT_SIZE - 1)])) break;
+        s.cursor++;
+        s.delivered++;
+      }
+    }
+  }
+
+  FrameFanout::SinkStats FrameFanout::sinkStats(uint8_t id) const {
+    SinkStats stats = {};
+    if (id >= count) return stats;
+
+    const Sink &s = sinks[id];
+    uint32_t lag = head - s.cursor;
+    stats.name = s.name;
+    stats.delivered = s.delivered;
+    stats.lost = s.lost + (lag > CAN_FANOUT_SIZE ? lag - CAN_FANOUT_SIZE : 0);
+    stats.lag = lag > CAN_FANOUT_SIZE ? CAN_FANOUT_SIZE : lag;
+    stats.maxLag = s.maxLag;
+    return stats;
+  }
+
+  void FrameFanout::resetStats() {
+    for (uint8_t i = 0; i < count; i++) {
+      sinks[i].delivered = 0;
+      sinks[i].lost = 0;
+      sinks[i].maxLag = 0;
+    }
+  }
+}
@@ -0,0 +1,79 @@
+#ifndef FRAME_FANOUT_H
+#define FRAME_FANOUT_H
+
+#include <cstdint>
+#include "can_frame.h"
+
+// ============================================================================
+// FRAME FANOUT - broadcast ring of received CAN frames
+// ============================================================================
+// Every received frame is published once; each sink (decode/routing, MQTT,
+// frame log, capture, gateways...) reads it through its own cursor. Sinks
+// get a const reference into the ring slot, frames are never copied.
+//
+// The producer never waits: a sink that falls more than CAN_FANOUT_SIZE
+// frames behind (e.g. MQTT during a reconnect) skips ahead to the oldest
+// frame still in the ring and only loses its own backlog.
+//
+// publish() and poll() must be called from the same task (ComfoAir::loop).
+// ============================================================================
+
+#ifndef CAN_FANOUT_SIZE
+  #define CAN_FANOUT_SIZE 128   // power of two
+#endif
+
+namespace comfoair {
+
+  // Return false if the sink cannot take the frame right now; it is offered
+  // again on the next poll().
+  typedef bool (*FrameSink)(void *context, const CAN_FRAME &frame);
+
+  class FrameFanout {
+    public:
+      static const uint8_t MAX_SINKS = 8;
+
+      struct SinkStats {
+        const char *name;
+        uint32_t delivered;     // frames handled by the sink
+        uint32_t lost;          // frames overwritten before the sink read them
+        uint32_t lag;           // frames waiting for this sink right now
+        uint32_t maxLag;        // worst lag seen since resetStats()
+      };
+
+      FrameFanout();
+
+      // budget = max frames handed to this sink per poll().
+      // Returns the sink id, or -1 if MAX_SINKS is reached.
+      // A new sink only sees frames published after it was added.
+      int8_t addSink(const char *name, FrameSink sink, void *context, uint8_t budget);
+
+      void publish(const CAN_FRAME &frame);
+      void poll();
+
+      uint8_t sinkCount() const { return count; }
+      SinkStats sinkStats(uint8_t id) const;
+      uint32_t published() const { return head; }
+      void resetStats();
+
+    private:
+      static_assert((CAN_FANOUT_SIZE & (CAN_FANOUT_SIZE - 1)) == 0, "CAN_FANOUT_SIZE must be a power of two");
+
+      struct Sink {
+        const char *name;
+        FrameSink fn;
+        void *context;
+        uint8_t budget;
+        uint32_t cursor;        // sequence number of the next frame to read
+        uint32_t delivered;
+        uint32_t lost;
+        uint32_t maxLag;
+      };
+
+      CAN_FRAME slots[CAN_FANOUT_SIZE];
+      uint32_t head;            // sequence number of the next frame to publish
+      Sink sinks[MAX_SINKS];
+      uint8_t count;
+  };
+}
+
+#endif
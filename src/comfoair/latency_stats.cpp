@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <string.h>
+#include "latency_stats.h"
+
+namespace comfoair {
+
+  LatencyStats canLatency;
+
+  const char *latencyStageName(LatencyStage stage) {
+    switch (stage) {
+      case LatencyStage::RX_TO_DECODE: return "rx_to_decode";
+      case LatencyStage::DECODE_TO_PUBLISH: return "decode_to_publish";
+      case LatencyStage::DECODE_TO_PIXEL: return "decode_to_pixel";
+      case LatencyStage::RX_TO_PUBLISH: return "rx_to_publish";
+      case LatencyStage::RX_TO_PIXEL: return "rx_to_pixel";
+      case LatencyStage::COUNT: break;
+    }
+    return "unknown";
+  }
+
+  uint8_t LatencyHistogram::bucket(uint32_t us) {
+    if (us == 0) return 0;
+    uint8_t b = 32 - __builtin_clz(us);
+    return b < BUCKETS ? b : BUCKETS - 1;
+  }
+
+  void LatencyHistogram::record(uint32_t us) {
+    count++;
+    sumUs += us;
+    if (us > maxUs) maxUs = us;
+    buckets[bucket(us)]++;
+  }
+
+  uint32_t LatencyHistogram::percentileUs(uint16_t permille) const {
+    if (count == 0) return 0;
+    uint64_t target = ((uint64_t)count * permille + 999) / 1000;
+    uint32_t seen = 0;
+    for (uint8_t b = 0; b < BUCKETS; b++) {
+      seen += buckets[b];
+      if (seen >= target) {
+        // Never above what was seen (also covers the open-ended last bucket)
+        return b < BUCKETS - 1 && (1UL << b) < maxUs ? (1UL << b) : maxUs;
+      }
+    }
+    return maxUs;
+  }
+
+  LatencyStats::LatencyStats() {
+    reset();
+  }
+
+  void LatencyStats::reset() {
+    memset(histograms, 0, sizeof(histograms));
+    memset(&displayPending, 0, sizeof(displayPending));
+  }
+
+  void LatencyStats::displayQueued(LatencyMark &mark) {
+    if (!mark.set) return;
+    // Keep the oldest: the refresh shows everything queued before it
+    if (!displayPending.set) displayPending = mark;
+    mark.clear();
+  }
+
+  void LatencyStats::displayFlushed(uint32_t nowUs) {
+    if (!displayPending.set) return;
+    record(LatencyStage::DECODE_TO_PIXEL, displayPending.decodeUs, nowUs);
+    record(LatencyStage::RX_TO_PIXEL, displayPending.rxUs, nowUs);
+    displayPending.clear();
+  }
+
+  size_t LatencyStats::toJson(char *buf, size_t len, bool withHistograms) const {
+    if (len < 3) {
+      if (len) buf[0] = '\0';
+      return 0;
+    }
+    size_t pos = 0;
+    buf[pos++] = '{';
+
+    char piece[320];
+    for (uint8_t s = 0; s < STAGE_COUNT; s++) {
+      const LatencyHistogram &h = histograms[s];
+      int n = snprintf(piece, sizeof(piece), "%s\"%s\":[%u,%u,%u,%u,%u",
+                       s ? "," : "", latencyStageName((LatencyStage)s), h.count,
+                       h.averageUs(), h.percentileUs(500), h.percentileUs(990), h.maxUs);
+      if (n > 0 && withHistograms) {
+        for (uint8_t b = 0; b < LatencyHistogram::BUCKETS && n < (int)sizeof(piece); b++) {
+          n += snprintf(piece + n, sizeof(piece) - n, ",%u", h.buckets[b]);
+        }
+      }
+      if (n > 0 && n < (int)sizeof(piece) - 1) piece[n++] = ']';
+      // Whole entries only, keep room for "}"
+      if (n < 0 || n >= (int)sizeof(piece) || pos + n + 2 > len) break;
+      memcpy(buf + pos, piece, n);
+      pos += n;
+    }
+
+    buf[pos++] = '}';
+    buf[pos] = '\0';
+    return pos;
+  }
+}
@@ -0,0 +1,103 @@
+#ifndef LATENCY_STATS_H
+#define LATENCY_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "pdo_table.h"
+
+// ============================================================================
+// LATENCY STATS - per-stage latency of received values, as histograms
+// ============================================================================
+// Every frame is stamped (esp_timer, us) by the RX task; PdoValue carries
+// that stamp and the time it was decoded. The stages record their own end
+// time against them:
+//   RX_TO_DECODE       RX task -> decoded in the route sink (ring wait,
+//                      loop() latency, cache, decode)
+//   DECODE_TO_PUBLISH  decoded in the MQTT sink -> writeToTopic() returned
+//   DECODE_TO_PIXEL    decoded -> label set and lv_refr_now() returned
+//                      (includes the managers' display batching)
+//   RX_TO_PUBLISH / RX_TO_PIXEL   end to end
+//
+// Display updates are often batched: a manager keeps a LatencyMark with the
+// oldest value it has not shown yet and hands it over with displayQueued()
+// when it sets its labels; displayFlushed() after the LVGL refresh closes
+// it. Stamps are 32-bit microseconds, differences survive the wrap.
+// ============================================================================
+
+namespace comfoair {
+
+  enum class LatencyStage : uint8_t {
+    RX_TO_DECODE,
+    DECODE_TO_PUBLISH,
+    DECODE_TO_PIXEL,
+    RX_TO_PUBLISH,
+    RX_TO_PIXEL,
+    COUNT
+  };
+
+  const char *latencyStageName(LatencyStage stage);
+
+  // log2 buckets: 0 = < 1 us, n = [2^(n-1), 2^n) us, last open ended (>= 8.4 s)
+  struct LatencyHistogram {
+    static const uint8_t BUCKETS = 25;
+
+    uint32_t count;
+    uint64_t sumUs;
+    uint32_t maxUs;
+    uint32_t buckets[BUCKETS];
+
+    void record(uint32_t us);
+    uint32_t averageUs() const { return count ? (uint32_t)(sumUs / count) : 0; }
+    // Upper bound of the bucket holding the given permille, 0 if empty
+    uint32_t percentileUs(uint16_t permille) const;
+
+    static uint8_t bucket(uint32_t us);
+  };
+
+  // Oldest value waiting for the display
+  struct LatencyMark {
+    uint32_t rxUs;
+    uint32_t decodeUs;
+    bool set;
+
+    void note(const PdoValue &value) {
+      if (set || value.decodeUs == 0) return;
+      rxUs = value.rxUs;
+      decodeUs = value.decodeUs;
+      set = true;
+    }
+    void clear() { set = false; }
+  };
+
+  class LatencyStats {
+    public:
+      static const uint8_t STAGE_COUNT = (uint8_t)LatencyStage::COUNT;
+
+      LatencyStats();
+
+      void record(LatencyStage stage, uint32_t fromUs, uint32_t toUs) {
+        histograms[(uint8_t)stage].record(toUs - fromUs);
+      }
+
+      // Labels set from the marked value; consumes the mark
+      void displayQueued(LatencyMark &mark);
+      // The LVGL refresh returned: pixels of all queued values are out
+      void displayFlushed(uint32_t nowUs);
+
+      const LatencyHistogram &stage(LatencyStage stage) const { return histograms[(uint8_t)stage]; }
+
+      // {"rx_to_decode":[count,avg,p50,p99,max,buckets...],...}, all in us
+      size_t toJson(char *buf, size_t len, bool histograms) const;
+
+      void reset();
+
+    private:
+      LatencyHistogram histograms[STAGE_COUNT];
+      LatencyMark displayPending;
+  };
+
+  // Shared by the CAN path, the managers and the main loop
+  extern LatencyStats canLatency;
+}
+
+#endif
@@ -0,0 +1,155 @@
+#include <chrono>
+#include "loopback_port.h"
+
+namespace comfoair {
+
+  static uint32_t steadyClockUs() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  LoopbackBus::LoopbackBus(Clock clock) :
+    clock(clock ? clock : steadyClockUs), portCount(0), delivered(0) {
+  }
+
+  bool LoopbackBus::attach(LoopbackPort *port) {
+    for (uint8_t i = 0; i < portCount; i++) {
+      if (ports[i] == port) return true;
+    }
+    if (portCount >= MAX_PORTS) return false;
+    ports[portCount++] = port;
+    return true;
+  }
+
+  uint8_t LoopbackBus::deliver(const LoopbackPort *from, const CAN_FRAME &frame) {
+    CAN_FRAME stamped = frame;
+    stamped.timestamp_us = nowUs();
+
+    uint8_t receivers = 0;
+    for (uint8_t i = 0; i < portCount; i++) {
+      if (ports[i] == from) continue;
+      // A full ring still ACKs on a real bus, the receiver just loses it
+      if (ports[i]->state.load(std::memory_order_relaxed) == CanBusState::RUNNING) {
+        ports[i]->inject(stamped);
+        receivers++;
+      }
+    }
+    if (receivers) delivered.fetch_add(1, std::memory_order_relaxed);
+    return receivers;
+  }
+
+  uint32_t LoopbackBus::nowUs() const {
+    return clock();
+  }
+
+  LoopbackPort::LoopbackPort(LoopbackBus &bus, const char *name) :
+    bus(bus),
+    portName(name),
+    started(false),
+    filterActive(false),
+    state(CanBusState::STOPPED),
+    errorPassive(false),
+    recoveryStuck(false),
+    lastResult(TxResult::PENDING),
+    txFailed(0),
+    events(0),
+    received(0),
+    swRejected(0) {
+  }
+
+  // No bit timing on an in-process bus, the bitrate is ignored
+  bool LoopbackPort::begin(uint32_t /*bitrate*/, const CanIdFilter *wanted) {
+    if (!bus.attach(this)) return false;
+    filterActive = wanted && !wanted->isEmpty();
+    if (filterActive) filter = *wanted;
+    state = CanBusState::RUNNING;
+    started = true;
+    return true;
+  }
+
+  bool LoopbackPort::read(CAN_FRAME &frame) {
+    return ring.pop(frame);
+  }
+
+  bool LoopbackPort::inject(const CAN_FRAME &frame) {
+    if (filterActive && !filter.matches(frame.id, frame.extended)) {
+      swRejected.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+    if (!ring.push(frame)) return false;
+    received.fetch_add(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool LoopbackPort::transmit(const CAN_FRAME &frame) {
+    // Like twai_transmit() outside the running state
+    if (state != CanBusState::RUNNING) return false;
+
+    if (bus.deliver(this, frame)) {
+      lastResult = TxResult::SUCCESS;
+    } else {
+      lastResult = TxResult::FAILED;    // no ACK
+      txFailed.fetch_add(1, std::memory_order_relaxed);
+      events.fetch_or(CAN_EVENT_TX_FAILED, std::memory_order_relaxed);
+    }
+    return true;
+  }
+
+  CanBusStatus LoopbackPort::getBusStatus() const {
+    CanBusStatus status = {};
+    status.state = state.load(std::memory_order_relaxed);
+    status.txErrorCounter = status.state == CanBusState::BUS_OFF ? 256 : (errorPassive ? 128 : 0);
+    status.txFailed = txFailed.load(std::memory_order_relaxed);
+    status.rxMissed = ring.overflows();
+    return status;
+  }
+
+  CAN_RX_STATS LoopbackPort::getRxStats() const {
+    CAN_RX_STATS stats = {};
+    stats.received = received.load(std::memory_order_relaxed);
+    stats.ringOverflows = ring.overflows();
+    stats.ringHighWater = ring.highWater();
+    stats.ringSize = ring.capacity();
+    stats.swRejected = swRejected.load(std::memory_order_relaxed);
+    return stats;
+  }
+
+  bool LoopbackPort::initiateRecovery() {
+    if (state != CanBusState::BUS_OFF) return false;
+    if (recoveryStuck) {
+      state = CanBusState::RECOVERING;
+      return true;
+    }
+    // 128 x 11 recessive bits take no time in here
+    state = CanBusState::STOPPED;
+    errorPassive = false;
+    events.fetch_or(CAN_EVENT_BUS_RECOVERED, std::memory_order_relaxed);
+    return true;
+  }
+
+  bool LoopbackPort::restart() {
+    if (state != CanBusState::STOPPED || !started) return false;
+    state = CanBusState::RUNNING;
+    return true;
+  }
+
+  void LoopbackPort::injectBusOff() {
+    state = CanBusState::BUS_OFF;
+    events.fetch_or(CAN_EVENT_BUS_OFF, std::memory_order_relaxed);
+  }
+
+  void LoopbackPort::injectErrorPassive(bool passive) {
+    errorPassive = passive;
+    events.fetch_or(passive ? CAN_EVENT_ERR_PASSIVE : CAN_EVENT_ERR_ACTIVE,
+                    std::memory_order_relaxed);
+  }
+
+  void LoopbackPort::injectStuckRecovery(bool stuck) {
+    recoveryStuck = stuck;
+    if (!stuck && state == CanBusState::RECOVERING) {
+      state = CanBusState::STOPPED;
+      errorPassive = false;
+      events.fetch_or(CAN_EVENT_BUS_RECOVERED, std::memory_order_relaxed);
+    }
+  }
+}
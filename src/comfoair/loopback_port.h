@@ -0,0 +1,109 @@
+#ifndef LOOPBACK_PORT_H
+#define LOOPBACK_PORT_H
+
+#include <atomic>
+#include <cstdint>
+#include "can_port.h"
+#include "spsc_ring.h"
+
+// ============================================================================
+// LOOPBACK PORT - in-process CAN bus, no hardware
+// ============================================================================
+// Ports attached to one LoopbackBus see each other's frames, like nodes on
+// a wire: transmit() stamps the frame with the bus clock and pushes it into
+// the RX ring of every other started port (no self reception). A frame
+// nobody else receives fails, as it would without an ACK. inject() hands a
+// frame to one port as if it came from the bus (simulators, trace replay).
+//
+// Bus-off is per port: injectBusOff() raises CAN_EVENT_BUS_OFF, transmit()
+// fails until initiateRecovery() (completes at once, or when
+// injectStuckRecovery(false) releases a stuck bus) and restart().
+//
+// Each RX ring is single producer: transmit() into a given port from one
+// thread at a time. Any number of threads may read their own port.
+// ============================================================================
+
+#ifndef LOOPBACK_RX_RING_SIZE
+  #define LOOPBACK_RX_RING_SIZE 256     // power of two
+#endif
+
+namespace comfoair {
+
+  class LoopbackPort;
+
+  class LoopbackBus {
+    public:
+      static const uint8_t MAX_PORTS = 4;
+      typedef uint32_t (*Clock)();          // microseconds
+
+      // nullptr = monotonic clock (std::chrono::steady_clock)
+      explicit LoopbackBus(Clock clock = nullptr);
+
+      bool attach(LoopbackPort *port);
+
+      // To every started port but from; returns the number of receivers
+      uint8_t deliver(const LoopbackPort *from, const CAN_FRAME &frame);
+
+      uint32_t nowUs() const;
+      uint32_t frames() const { return delivered.load(std::memory_order_relaxed); }
+
+    private:
+      Clock clock;
+      LoopbackPort *ports[MAX_PORTS];
+      uint8_t portCount;
+      std::atomic<uint32_t> delivered;
+  };
+
+  class LoopbackPort : public CanPort {
+    public:
+      explicit LoopbackPort(LoopbackBus &bus, const char *name = "loopback");
+
+      const char *name() const override { return portName; }
+      bool begin(uint32_t bitrate, const CanIdFilter *wanted = nullptr) override;
+
+      bool read(CAN_FRAME &frame) override;
+      uint32_t rxPending() const override { return ring.size(); }
+
+      bool transmit(const CAN_FRAME &frame) override;
+      TxResult txResult() override { return lastResult; }
+
+      CanBusStatus getBusStatus() const override;
+      CAN_RX_STATS getRxStats() const override;
+
+      uint16_t takeHealthEvents() override {
+        return events.exchange(0, std::memory_order_relaxed);
+      }
+      bool initiateRecovery() override;
+      bool restart() override;
+
+      // A frame from the bus, stamped by the caller; false if filtered or
+      // the ring is full
+      bool inject(const CAN_FRAME &frame);
+
+      // Fault injection
+      void injectBusOff();
+      void injectErrorPassive(bool passive);
+      // Recovery hangs in RECOVERING until called again with false
+      void injectStuckRecovery(bool stuck);
+
+    private:
+      friend class LoopbackBus;
+
+      LoopbackBus &bus;
+      const char *portName;
+      bool started;
+      CanIdFilter filter;
+      bool filterActive;
+      std::atomic<CanBusState> state;   // read by transmitting ports
+      bool errorPassive;
+      bool recoveryStuck;
+      TxResult lastResult;
+      std::atomic<uint32_t> txFailed;
+      std::atomic<uint16_t> events;
+      std::atomic<uint32_t> received;
+      std::atomic<uint32_t> swRejected;
+      SpscRing<CAN_FRAME, LOOPBACK_RX_RING_SIZE> ring;
+  };
+}
+
+#endif
@@ -1,13 +1,11 @@
 #include "message.h"
-#include "twai_wrapper.h"
 #include "CanAddress.h"
-#include "commands.h"
+#include "pdo_table.h"
 
 #include "../serial_logger.h"
 #define Serial LogSerial 
 
 #define min(a,b) ((a) < (b) ? (a): (b))
-#define DEBUG true
 void printFrame(CAN_FRAME *message)
 {/*
     Serial.print(message->id, HEX);
@@ -19,548 +17,191 @@ void printFrame(CAN_FRAME *message)
     }
     Serial.println();*/
 }
-CAN_FRAME message;
-#ifdef DEBUG
-uint8_t hextob(char ch)
-{
-    if (ch >= '0' && ch <= '9') return ch - '0';
-    if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-    if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-    return 0;
-}
-#endif
 namespace comfoair {
-  void ComfoMessage::test(const char * test, const char * name, const char * expectedValue) {
-    #ifdef DEBUG
-    Serial.print("Testing: ");
-    Serial.print(test);
-    Serial.print(" - ");
-    Serial.print(name);
-    Serial.print(" - ");
-    Serial.println(expectedValue);
-
-    message.id = 0;    
-    for (uint8_t i=0; i< 8; i++) { 
-      message.id <<=4; 
-      message.id += hextob(test[i]); 
-    } 
-    message.length = hextob(test[8]); 
-    for (uint8_t i=0; i<message.length; i++) { 
-      message.data.uint8[i] = (hextob(test[i*2+9]) << 4) + hextob(test[i*2+10]); 
-    } 
-    DecodedMessage decodeddd;  
-    this->decode(&message, &decodeddd); 
-    if (strcmp(decodeddd.name, name) != 0) {
-      Serial.print("[ERR] Received Name: ");
-      Serial.println(decodeddd.name);
-    }
-    if (strcmp(expectedValue, decodeddd.val) != 0) {
-      Serial.print("[ERR] Received Value: ");
-      Serial.println(decodeddd.val);
-    }
-    #endif
-  }
   ComfoMessage::ComfoMessage() {
     this->sequence = 0;
-    message.extended = true;
-    message.rtr = 0;
-    #ifdef DEBUG 
-    this->test("00040041107", "away_indicator", "true");
-    this->test("00040041101", "away_indicator", "false");
-    this->test("00104041102", "fan_speed", "2");
-    this->test("00104041100", "fan_speed", "0");
-    this->test("001D4041113", "exhaust_fan_duty", "19");
-    this->test("001D4041126", "exhaust_fan_duty", "38");
-    this->test("001D8041110", "supply_fan_duty", "16");
-    this->test("001DC0412C400", "exhaust_fan_flow", "196");
-    this->test("001DC04128200", "exhaust_fan_flow", "130");
-    this->test("001E00412C800", "supply_fan_flow", "200");
-    this->test("001E00412C900", "supply_fan_flow", "201");
-    this->test("001E40412ED07", "exhaust_fan_speed", "2029");
-    this->test("001E804127F07", "supply_fan_speed", "1919");
-    this->test("0020004123200", "power_consumption_current", "50");
-    this->test("0020004123200", "power_consumption_current", "50");
-    this->test("0035404126E03", "ah_actual", "8.78");
-    this->test("0035404126F03", "ah_actual", "8.79");
-    this->test("0035804125401", "ah_ytd", "340");
-    this->test("0035804125301", "ah_ytd", "339");
-    this->test("0035C04124415", "ah_total", "5444");
-    this->test("003500412DB00", "target_temp", "21.9");
-    this->test("004480412D100", "extract_air_temp", "20.9");
-    this->test("0044C04123700", "exhaust_air_temp", "5.5");
-    this->test("0045004120900", "outdoor_air_temp", "0.9");
-    this->test("004500412FFFF", "outdoor_air_temp", "-0.1");
-    this->test("004500412FFA1", "outdoor_air_temp", "-9.5");
-    this->test("004500412FEB3", "outdoor_air_temp", "-33.3");
-    this->test("004580412C700", "post_heater_temp_before", "19.9");
-    this->test("0048804112D", "extract_air_humidity", "45");
-    this->test("00488041129", "extract_air_humidity", "41");
-    this->test("0048C04115F", "exhaust_air_humidity", "95");
-    this->test("0048C04115E", "exhaust_air_humidity", "94");
-    this->test("00490041146", "outdoor_air_humidity", "70");
-    this->test("00490041143", "outdoor_air_humidity", "67");
-    this->test("00490041145", "outdoor_air_humidity", "69");
-    this->test("0049804111B", "supply_air_humidity", "27");
-    this->test("003740412C700", "post_heater_temp_after", "19.9");
-    #endif
+    this->reservedSequences = 0;
+    this->txQueue = nullptr;
   }
 
-  bool ComfoMessage::sendCommand(char const * command) {
-    // FIXED: Send command only ONCE (removed duplicate send and 1-second delay)
-    #define CMDIF(name) if (strcmp(command, #name) == 0) { \
-                          return this->send(new std::vector<uint8_t>( CMD_ ## name )); \
-                        } else 
-    CMDIF(ventilation_level_0)
-    CMDIF(ventilation_level_1)
-    CMDIF(ventilation_level_2)
-    CMDIF(ventilation_level_3)
-    CMDIF(boost_10_min)
-    CMDIF(boost_20_min)
-    CMDIF(boost_30_min)
-    CMDIF(boost_60_min)
-    CMDIF(boost_end)
-    CMDIF(auto)
-    CMDIF(manual)
-    CMDIF(bypass_activate_1h)
-    CMDIF(bypass_deactivate_1h)
-    CMDIF(bypass_auto)
-    CMDIF(ventilation_supply_only)
-    CMDIF(ventilation_supply_only_reset)
-    CMDIF(ventilation_extract_only)
-    CMDIF(ventilation_extract_only_reset)
-    CMDIF(temp_profile_normal)
-    CMDIF(temp_profile_cool)
-    CMDIF(temp_profile_warm)
-    return false;
+  bool ComfoMessage::sendCommand(CommandId command, TxCallback callback, void *context) {
+    if ((uint8_t)command >= COMMAND_COUNT) return false;
+    const CommandDescriptor &cmd = commandDescriptor(command);
+    return this->send(cmd.length, cmd.payload, callback, context);
   }
 
-  bool ComfoMessage::decode(CAN_FRAME *frame, DecodedMessage *message) {
-    // Clear the message structure to prevent garbage data
-    memset(message, 0, sizeof(DecodedMessage));
-    
+  // ==========================================================================
+  // Formatter for table-driven decoding
+  // ==========================================================================
+  // Fixed-point formatting without floats: raw -95 with 1 decimal -> "-9.5"
+  size_t ComfoMessage::format(const PdoValue &value, char *buf, size_t len) {
+    return pdoFormat(value, buf, len);
+  }
+
+  bool ComfoMessage::decode(const CAN_FRAME *frame, PdoValue *value) {
     // ====================================================================
     // SPECIAL CASE: Time response (CAN ID 0x10040001)
     // ====================================================================
     // Tested and confirmed: 2025-10-26
     // Time response comes on a special CAN ID, not via PDOID
     // Format: 4 bytes, little-endian, seconds since 2000-01-01
+    // Decoded with the device_time (PDOID 1) descriptor.
     // ====================================================================
-    if (frame->id == 0x10040001) {
-      if (frame->length >= 4) {
-        uint8_t *vals = &frame->data.uint8[0];
-        uint32_t device_seconds = vals[0] | (vals[1] << 8) | (vals[2] << 16) | (vals[3] << 24);
-        
-        snprintf(message->val, 15, "%u", device_seconds);
-        strncpy(message->name, "device_time", 39);
-        message->name[39] = '\0';
-        
-        Serial.printf("ComfoMessage: Time response decoded: %u seconds\n", device_seconds);
-        return true;
-      }
+    bool isTimeResponse = (frame->id == CAN_ID_TIME_RESPONSE);
+    // Short frames (empty RTR ACKs have length 0) are rejected here
+    if (!pdoDecodeFrame(frame->id, frame->data.uint8, frame->length, *value)) {
+      return false;
     }
-    // ====================================================================
-    
-    uint16_t PDOID = (frame->id & 0x01fff000) >> 14;
-    uint8_t *vals = &frame->data.uint8[0];
-    #define uint16 (vals[0] + (vals[1]<<8))
-    #define int16 (vals[1] < 0x80 ? (vals[0] + (vals[1] << 8)) : - ((vals[0] ^ 0xFF) + ((vals[1] ^ 0xFF) << 8) + 1))
-    #define uint32 (uint16 + ((vals[2] + (vals[3]<<8))<<16))
-    #define LAZYSWITCH(id, key, format, transformation) case id: \
-                                                  snprintf(message->val, 15, format, transformation); \
-                                                  strncpy(message->name, key, 39); \
-                                                  message->name[39] = '\0'; \
-                                                  return true;
-
-// For documentation on PDOID's see: https://github.com/michaelarnauts/comfoconnect/blob/master/PROTOCOL-PDO.md
-    switch (PDOID) {
-     LAZYSWITCH(1, "device_time", "%u", uint32)  // Device time in seconds since 2000-01-01
-      LAZYSWITCH(16, "away_indicator", "%s", vals[0] == 0x07 ? "true" : "false")
-      //LAZYSWITCH(49, "operating_mode", "%s", vals[0] == 1 ? "limited_manual": (vals[0] == 0xff ? "auto": "unlimited_manual"))  // 01 = limited_manual, FF = auto, 05 = unlimited_manual
-      // PDOID 49: Operating Mode
-      // Filter out empty RTR ACK frames (length=0)
-      case 49: {
-        if (frame->length < 1) {
-          return false;  // Ignore empty RTR ACK
-        }
-        const char* mode_str;
-        if (vals[0] == 1) {
-          mode_str = "limited_manual";
-        } else if (vals[0] == 0xff) {
-          mode_str = "auto";
-        } else {
-          mode_str = "unlimited_manual";
-        }
-        snprintf(message->val, 15, "%s", mode_str);
-        strncpy(message->name, "operating_mode", 39);
-        message->name[39] = '\0';
-        return true;
-      }
-      LAZYSWITCH(65, "fan_speed", "%d", vals[0])
-      //LAZYSWITCH(66, "bypass_activation_mode", "%s", vals[0] == 0 ? "auto": (vals[0] == 1 ? "activated": "deactivated")) // 0 auto, 1 activated, 2 deactivated
-      // PDOID 66: Bypass Activation Mode
-      // Filter out empty RTR ACK frames (length=0)
-      case 66: {
-        if (frame->length < 1) {
-          return false;  // Ignore empty RTR ACK
-        }
-        const char* mode_str;
-        if (vals[0] == 0) {
-          mode_str = "auto";
-        } else if (vals[0] == 1) {
-          mode_str = "activated";
-        } else {
-          mode_str = "deactivated";
-        }
-        snprintf(message->val, 15, "%s", mode_str);
-        strncpy(message->name, "bypass_activation_mode", 39);
-        message->name[39] = '\0';
-        return true;
-      }
-      LAZYSWITCH(67, "temp_profile", "%s", vals[0] == 0 ? "auto": (vals[0] == 1 ? "cold": "warm")) // 0 auto, 1 cold, 2 warm
-      LAZYSWITCH(81, "next_fan_change", "%d", uint32)
-      LAZYSWITCH(82, "next_bypass_change", "%d", uint32)
+    value->rxUs = frame->timestamp_us;
 
-      // Fans
-      LAZYSWITCH(117, "exhaust_fan_duty", "%d", vals[0]) // %
-      LAZYSWITCH(118, "supply_fan_duty", "%d", vals[0]) // %
-      LAZYSWITCH(119, "exhaust_fan_flow", "%d", uint16) // m3/h
-      LAZYSWITCH(120, "supply_fan_flow", "%d", uint16) // m3/h
-      LAZYSWITCH(121, "exhaust_fan_speed", "%d", uint16) // rpm
-      LAZYSWITCH(122, "supply_fan_speed", "%d", uint16) // rpm
-
-      // Power
-      LAZYSWITCH(128, "power_consumption_current", "%d", uint16) 
-      LAZYSWITCH(129, "power_consumption_ytd", "%d", uint16)  // kWh
-      LAZYSWITCH(130, "power_consumption_since_start", "%d", uint16)  // kWh
-
-   
-     // PDOID 192: Filter Days Remaining
-      // Filter out empty RTR ACK frames (length=0)
-      case 192: {
-        if (frame->length < 2) {
-          return false;  // Ignore empty RTR ACK
-        }
-        uint16_t raw_value = vals[0] + (vals[1] << 8);
-        snprintf(message->val, 15, "%d", raw_value);
-        strncpy(message->name, "remaining_days_filter_replacement", 39);
-        message->name[39] = '\0';
-        return true;
-      }
-      
-      
-      // Avoided heating section
-      LAZYSWITCH(213, "ah_actual", "%.2f", uint16/ 100.0)  // watts
-      LAZYSWITCH(214, "ah_ytd", "%d", uint16)  // kWh
-      LAZYSWITCH(215, "ah_total", "%d", uint16)  // kWh
-      // AVoided cooling section
-      LAZYSWITCH(216, "ac_actual", "%.2f", uint16/ 100.0)  // watts
-      LAZYSWITCH(217, "ac_ytd", "%d", uint16)  // wh
-      LAZYSWITCH(218, "ac_total", "%d", uint16)  // wh   
-      
-      //LAZYSWITCH(227, "bypass_state", "%d", vals[0])  // %
-      // PDOID 227: Bypass State (open percentage)
-      // Filter out empty RTR ACK frames (length=0)
-      case 227: {
-        if (frame->length < 1) {
-          return false;  // Ignore empty RTR ACK
-        }
-        snprintf(message->val, 15, "%d", vals[0]);
-        strncpy(message->name, "bypass_state", 39);
-        message->name[39] = '\0';
-        return true;
-      }
-      
-      // temps
-      LAZYSWITCH(209, "rmot", "%.1f", int16/ 10.0)  // C
-      //LAZYSWITCH(212, "target_temp", "%.1f", uint16/ 10.0)  // C
+    if (isTimeResponse) {
+      Serial.printf("ComfoMessage: Time response decoded: %u seconds\n", value->toUnsigned());
+    }
+    return true;
+  }
+  
+  bool ComfoMessage::queueFrames(TxPriority priority, CAN_FRAME *frames, uint8_t count,
+                                 TxCallback callback, void *context) {
+    for (uint8_t i = 0; i < count; i++) {
+      frames[i].timestamp_us = 0;
+      printFrame(&frames[i]);
+    }
 
-      
-      // PDOID 212: Target Temperature
-      // Filter out empty RTR ACK frames (length=0)
-      case 212: {
-        if (frame->length < 2) {
-          return false;  // Ignore empty RTR ACK
-        }
-        uint16_t raw_value = vals[0] + (vals[1] << 8);
-        float temp_c = raw_value / 10.0f;
-        snprintf(message->val, 15, "%.1f", temp_c);
-        strncpy(message->name, "target_temp", 39);
-        message->name[39] = '\0';
-        return true;
-      }
-      
+    if (!txQueue) {
+      Serial.println("ComfoMessage: no TX queue set - frame dropped");
+      return false;
+    }
+    return txQueue->enqueue(priority, frames, count, callback, context) != 0;
+  }
 
+  bool ComfoMessage::send(uint8_t length, const uint8_t *buf, TxCallback callback, void *context) {
+    return sendRmi(0x1, length, buf, TxPriority::COMMAND, false, callback, context) >= 0;
+  }
 
-      LAZYSWITCH(220, "pre_heater_temp_before", "%.1f", int16/10.0) // C
-      LAZYSWITCH(221, "post_heater_temp_after", "%.1f", int16/10.0)  // C
-      LAZYSWITCH(274, "extract_air_temp", "%.1f", int16 /10.0)  // C
-      LAZYSWITCH(275, "exhaust_air_temp", "%.1f", int16 /10.0)  // C
-      LAZYSWITCH(276, "outdoor_air_temp", "%.1f", int16 /10.0)  // C
-      LAZYSWITCH(277, "pre_heater_temp_after", "%.1f", int16 /10.0)  // C
-      LAZYSWITCH(278, "post_heater_temp_before", "%.1f", int16 /10.0)  // C
-      // Humidity
-      LAZYSWITCH(290, "extract_air_humidity", "%d", vals[0])  // %
-      LAZYSWITCH(291, "exhaust_air_humidity", "%d", vals[0])  // %   
-      LAZYSWITCH(292, "outdoor_air_humidity", "%d", vals[0])  // %   
-      LAZYSWITCH(293, "pre_heater_humidity_after", "%d", vals[0]) // %
-      LAZYSWITCH(294, "supply_air_humidity", "%d", vals[0])  // %   
-      
-      // ==============================================================================
-      // ERROR/ALARM MESSAGES
-      // Based on: https://github.com/michaelarnauts/aiocomfoconnect PROTOCOL-RMI.md
-      // ==============================================================================
-      
-      // Status indicators (may show problems)
-      LAZYSWITCH(37, "current_rmot", "%d", vals[0])  // Current RMOT (may indicate errors)
-      LAZYSWITCH(56, "frost_protection_unbalance", "%d", vals[0])  // Frost protection status
-      
-      // CRITICAL ERRORS
-      LAZYSWITCH(321, "error_overheating", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // DANGER! OVERHEATING! Two or more sensors detecting incorrect temperature. Ventilation stopped.
-      
-      // TEMPERATURE SENSOR ERRORS
-      LAZYSWITCH(322, "error_temp_sensor_p_oda", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Pre-conditioned outdoor air temperature sensor detecting incorrect temperature
-      
-      // PRE-HEATER ERRORS
-      LAZYSWITCH(323, "error_preheat_location", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Pre-heater present but not in correct position (right/left)
-      
-      // PRESSURE ERRORS
-      LAZYSWITCH(324, "error_ext_pressure_eha", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Exhaust air pressure too high. Check outlets, ducts, filters for pollution/obstructions. Check valve settings.
-      
-      LAZYSWITCH(325, "error_ext_pressure_sup", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Supply air pressure too high. Check outlets, ducts, filters for pollution/obstructions. Check valve settings.
-      
-      // TEMPERATURE CONTROL ERRORS
-      LAZYSWITCH(326, "error_tempcontrol_p_oda", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Failed to reach required temperature too often for outdoor air after pre-heater
-      
-      LAZYSWITCH(327, "error_tempcontrol_sup", "%s", vals[0] ? "ACTIVE" : "clear")  
-      // Failed to reach required temperature too often for supply air. Modulating bypass may have malfunction.
-      
-      // MAINTENANCE ALARMS
-      LAZYSWITCH(328, "alarm_filter", "%s", vals[0] ? "REPLACE" : "ok")  
-      // Filter replacement alarm
-      
-      // GENERAL WARNINGS
-      LAZYSWITCH(329, "warning_system", "%s", vals[0] ? "WARNING" : "ok")  
-      // General system warning
-      
-      // ==============================================================================
-      
-      default: 
-        return false;
+  // Next sequence number not held by an outstanding RMI request
+  int8_t ComfoMessage::nextSequence() {
+    for (uint8_t i = 0; i < 4; i++) {
+      this->sequence = (this->sequence + 1) & 0x3;
+      if (!(this->reservedSequences & (1 << this->sequence))) return this->sequence;
     }
+    return -1;
   }
-  
-  bool ComfoMessage::send(std::vector<uint8_t> *buf) {
-    return this->send(buf->size(), buf->data());
+
+  void ComfoMessage::releaseSequence(uint8_t seq) {
+    this->reservedSequences &= ~(1 << (seq & 0x3));
   }
 
-  bool ComfoMessage::send(uint8_t length, uint8_t *buf) {
-    this->sequence++;
-    this->sequence = this->sequence & 0x3;
-    message.extended = true;
-    message.rtr = false;  // âœ… Safety: Ensure RTR is always cleared for regular commands
+  int8_t ComfoMessage::sendRmi(uint8_t dstNode, uint8_t length, const uint8_t *buf, TxPriority priority,
+                               bool reserve, TxCallback callback, void *context) {
+    int8_t seq = nextSequence();
+    if (seq < 0) {
+      Serial.println("ComfoMessage: no free RMI sequence number");
+      return -1;
+    }
+
+    CAN_FRAME frames[CanTxQueue::MAX_FRAMES_PER_JOB];
+    uint8_t count = 0;
+
     if (length > 8) {
-      CanAddress addr = CanAddress(0x11, 0x1, 0, 1, 0, 1, this->sequence);
+      CanAddress addr = CanAddress(0x11, dstNode, 0, 1, 0, 1, seq);
       uint8_t dataGrams = length / 7;
       if (dataGrams * 7 == length)  {
         dataGrams--;
       }
-
-      for (uint8_t i = 0; i < dataGrams; i++) {
-        memset(message.data.byte, 0, 8);
-        message.data.uint8[0] = i;
-        message.length = min((i*7)+7, length) - i*7 + 1;
-        message.id = addr.canID();
-        memcpy(& message.data.uint8[1], &buf[i * 7], message.length - 1);
-        CAN0.sendFrame(message);
-        printFrame(&message);
+      if (dataGrams + 1 > CanTxQueue::MAX_FRAMES_PER_JOB) {
+        Serial.printf("ComfoMessage: %u byte command does not fit in one TX job\n", length);
+        return -1;
       }
 
-
-      // Send last packet
-      memset(message.data.uint8, 0, 8);
-      message.data.uint8[0] = dataGrams | 0x80;
-      message.length = length - dataGrams * 7 + 1;
-      memcpy(& message.data.uint8[1], &buf[dataGrams * 7], length - dataGrams * 7);
-      CAN0.sendFrame(message);
-      printFrame(&message);
-
+      // Segments 0..n-1 carry 7 bytes each, the last one has bit 7 set
+      for (uint8_t i = 0; i <= dataGrams; i++) {
+        CAN_FRAME &frame = frames[count++];
+        memset(&frame, 0, sizeof(frame));
+        frame.id = addr.canID();
+        frame.extended = true;
+        frame.rtr = false;
+        frame.data.uint8[0] = (i == dataGrams) ? (i | 0x80) : i;
+        frame.length = min((i*7)+7, length) - i*7 + 1;
+        memcpy(&frame.data.uint8[1], &buf[i * 7], frame.length - 1);
+      }
     } else {
-      CanAddress addr = CanAddress(0x11, 0x1, 0, 0, 0, 1, this->sequence);
-      message.id = addr.canID();
-      message.length = length;
-      memcpy(message.data.uint8, buf, length);
-      CAN0.sendFrame(message);
-      printFrame(&message);
-
+      CanAddress addr = CanAddress(0x11, dstNode, 0, 0, 0, 1, seq);
+      CAN_FRAME &frame = frames[count++];
+      memset(&frame, 0, sizeof(frame));
+      frame.id = addr.canID();
+      frame.extended = true;
+      frame.rtr = false;
+      frame.length = length;
+      memcpy(frame.data.uint8, buf, length);
     }
-    return true;
+
+    // All segments in one job, so they go out back-to-back or not at all
+    if (!queueFrames(priority, frames, count, callback, context)) return -1;
+    if (reserve) this->reservedSequences |= 1 << seq;
+    return seq;
   }
 
   // Time synchronization methods
   bool ComfoMessage::requestTime() {
-    Serial.println("ComfoMessage: Sending time request (RTR to 0x10080028)");
+    Serial.println("ComfoMessage: Queueing time request (RTR to 0x10080028)");
     
-    // ====================================================================
-    // FIX: Use LOCAL message variable to avoid polluting global state
-    // ====================================================================
-    // The global 'message' variable is used by send() for regular commands
-    // Using it for RTR would leave message.rtr = true, breaking all
-    // subsequent commands. Use a local variable instead.
-    // ====================================================================
     CAN_FRAME rtr_message;
+    memset(&rtr_message, 0, sizeof(rtr_message));
     rtr_message.id = 0x10080028;
     rtr_message.extended = true;
     rtr_message.rtr = true;  // Remote Transmission Request (no data)
     rtr_message.length = 0;
-    memset(rtr_message.data.byte, 0, 8);  // Ensure clean data buffer
     
-    // ====================================================================
-    // Send RTR frame ONCE (no loop, no delays)
-    // ====================================================================
-    // Previous code sent 3x with 100ms delays = 300ms blocking
-    // One RTR is sufficient, MVHR will respond if it's ready
-    // ====================================================================
-    bool success = CAN0.sendFrame(rtr_message);
-    
-    if (success) {
-      Serial.println("ComfoMessage:  Time request sent (1 RTR, non-blocking)");
-      Serial.println("ComfoMessage:    Response expected on 0x10040001 within 5s");
-    } else {
-      Serial.println("ComfoMessage:Time request failed (no CAN ACK)");
+    // Response expected on 0x10040001, routed to TimeManager
+    bool success = queueFrames(TxPriority::TIME_SYNC, &rtr_message, 1);
+    if (!success) {
+      Serial.println("ComfoMessage: Time request not queued (TX queue full)");
     }
-    
-    // Global 'message' variable is untouched - regular commands will work!
-    
     return success;
   }
 
   // ============================================================================
-  // âœ… NEW: Request Filter Days Remaining (PDOID 192)
+  // RTR for a PDO: the MVHR answers on the regular PDO CAN ID
   // ============================================================================
-  bool ComfoMessage::requestFilterDays() {
-    Serial.println("ComfoMessage: Requesting filter days (RTR for PDOID 192)");
-    
-    // PDOID 192 = remaining_days_filter_replacement
-    // Calculate CAN ID from PDOID: (PDOID << 14) | other_bits
-    // For PDOID 192: (192 << 14) = 0x00300000
-    // Full CAN ID: 0x00300041 (observed from protocol docs)
+  bool ComfoMessage::requestPdo(uint16_t pdoid) {
+    const PdoDescriptor *desc = findPdo(pdoid);
+    if (!desc || !desc->rtr) {
+      Serial.printf("ComfoMessage: PDOID %u is not marked rtr in pdo_spec.json\n", pdoid);
+      return false;
+    }
     
     CAN_FRAME rtr_message;
-    rtr_message.id = 0x00300041;  // PDOID 192 in extended format
+    memset(&rtr_message, 0, sizeof(rtr_message));
+    rtr_message.id = pdoCanId(pdoid, 0x01);  // addressed as the MVHR's own PDO
     rtr_message.extended = true;
     rtr_message.rtr = true;  // Remote Transmission Request (no data)
     rtr_message.length = 0;
-    memset(rtr_message.data.byte, 0, 8);
-    
-    bool success = CAN0.sendFrame(rtr_message);
-    
+
+    bool success = queueFrames(TxPriority::POLL, &rtr_message, 1);
     if (success) {
-      Serial.println("ComfoMessage: Filter days request sent (RTR to 0x00300041)");
-      Serial.println("ComfoMessage:    Response expected within 5s");
+      Serial.printf("ComfoMessage: RTR for PDOID %u queued (0x%08X)\n", pdoid, rtr_message.id);
     } else {
-      Serial.println("ComfoMessage: Filter days request failed (no CAN ACK)");
+      Serial.printf("ComfoMessage: RTR for PDOID %u not queued (TX queue full)\n", pdoid);
     }
-    
     return success;
   }
 
-  // ============================================================================
-  // ✅ NEW: Request Target Temperature (PDOID 212)
-  // ============================================================================
+  bool ComfoMessage::requestFilterDays() {
+    return requestPdo(PDO_FILTER_DAYS);
+  }
+
   bool ComfoMessage::requestTargetTemp() {
-    Serial.println("ComfoMessage: Requesting target temp (RTR for PDOID 212)");
-    
-    // PDOID 212 = target_temp
-    // Calculate CAN ID from PDOID: (PDOID << 14) | 0x41
-    // For PDOID 212: (212 << 14) = 0x00350000
-    // Full CAN ID: 0x00350041
-    
-    CAN_FRAME rtr_message;
-    rtr_message.id = 0x00350041;  // PDOID 212 in extended format
-    rtr_message.extended = true;
-    rtr_message.rtr = true;  // Remote Transmission Request (no data)
-    rtr_message.length = 0;
-    memset(rtr_message.data.byte, 0, 8);
-    
-    bool success = CAN0.sendFrame(rtr_message);
-    
-    if (success) {
-      Serial.println("ComfoMessage: Target temp request sent (RTR to 0x00350041)");
-      Serial.println("ComfoMessage:    Response expected within 5s");
-    } else {
-      Serial.println("ComfoMessage: Target temp request failed (no CAN ACK)");
-    }
-    
-    return success;
+    return requestPdo(PDO_TARGET_TEMP);
   }
 
-  // ============================================================================
-  // ✅ NEW: Request Bypass Status (PDOID 66)
-  // ============================================================================
   bool ComfoMessage::requestBypassStatus() {
-    Serial.println("ComfoMessage: Requesting bypass status (RTR for PDOID 66)");
-    
-    // PDOID 66 = bypass_activation_mode
-    // Calculate CAN ID from PDOID: (PDOID << 14) | 0x41
-    // For PDOID 66: (66 << 14) = 0x00108000
-    // Full CAN ID: 0x00108041
-    
-    CAN_FRAME rtr_message;
-    rtr_message.id = 0x00108041;  // PDOID 66 in extended format
-    rtr_message.extended = true;
-    rtr_message.rtr = true;  // Remote Transmission Request (no data)
-    rtr_message.length = 0;
-    memset(rtr_message.data.byte, 0, 8);
-    
-    bool success = CAN0.sendFrame(rtr_message);
-    
-    if (success) {
-      Serial.println("ComfoMessage: Bypass status request sent (RTR to 0x00108041)");
-      Serial.println("ComfoMessage:    Response expected within 5s");
-    } else {
-      Serial.println("ComfoMessage: Bypass status request failed (no CAN ACK)");
-    }
-    
-    return success;
+    return requestPdo(PDO_BYPASS_ACTIVATION_MODE);
   }
 
-  // ============================================================================
-  // ✅ NEW: Request Operating Mode (PDOID 49)
-  // ============================================================================
   bool ComfoMessage::requestOperatingMode() {
-    Serial.println("ComfoMessage: Requesting operating mode (RTR for PDOID 49)");
-    
-    // PDOID 49 = operating_mode
-    // Calculate CAN ID from PDOID: (PDOID << 14) | 0x41
-    // For PDOID 49: (49 << 14) = 0x000C4000
-    // Full CAN ID: 0x000C4041
-    
-    CAN_FRAME rtr_message;
-    rtr_message.id = 0x000C4041;  // PDOID 49 in extended format
-    rtr_message.extended = true;
-    rtr_message.rtr = true;  // Remote Transmission Request (no data)
-    rtr_message.length = 0;
-    memset(rtr_message.data.byte, 0, 8);
-    
-    bool success = CAN0.sendFrame(rtr_message);
-    
-    if (success) {
-      Serial.println("ComfoMessage: Operating mode request sent (RTR to 0x000C4041)");
-      Serial.println("ComfoMessage:    Response expected within 5s");
-    } else {
-      Serial.println("ComfoMessage: Operating mode request failed (no CAN ACK)");
-    }
-    
-    return success;
+    return requestPdo(PDO_OPERATING_MODE);
   }
 
-
   bool ComfoMessage::setTime(uint32_t secondsSince2000) {
     Serial.printf("ComfoMessage: Setting device time to %u seconds since 2000-01-01\n", secondsSince2000);
     
@@ -574,25 +215,27 @@ namespace comfoair {
     // NOTE: MVHR expects UTC time, not local time with timezone!
     // ====================================================================
     
-    message.id = 0x10040001;  // CONFIRMED WORKING
-    message.extended = true;
-    message.rtr = false;  // Not RTR - we're sending data
-    message.length = 4;
+    CAN_FRAME time_message;
+    memset(&time_message, 0, sizeof(time_message));
+    time_message.id = 0x10040001;  // CONFIRMED WORKING
+    time_message.extended = true;
+    time_message.rtr = false;  // Not RTR - we're sending data
+    time_message.length = 4;
     
     // Pack time as little-endian 4 bytes
-    message.data.uint8[0] = (secondsSince2000) & 0xFF;
-    message.data.uint8[1] = (secondsSince2000 >> 8) & 0xFF;
-    message.data.uint8[2] = (secondsSince2000 >> 16) & 0xFF;
-    message.data.uint8[3] = (secondsSince2000 >> 24) & 0xFF;
+    time_message.data.uint8[0] = (secondsSince2000) & 0xFF;
+    time_message.data.uint8[1] = (secondsSince2000 >> 8) & 0xFF;
+    time_message.data.uint8[2] = (secondsSince2000 >> 16) & 0xFF;
+    time_message.data.uint8[3] = (secondsSince2000 >> 24) & 0xFF;
     
-    bool success = CAN0.sendFrame(message);
+    bool success = queueFrames(TxPriority::TIME_SYNC, &time_message, 1);
     
     if (success) {
-      Serial.printf("ComfoMessage:  Time set command sent to 0x10040001: [%02X %02X %02X %02X]\n",
-                   message.data.uint8[0], message.data.uint8[1], 
-                   message.data.uint8[2], message.data.uint8[3]);
+      Serial.printf("ComfoMessage:  Time set command queued for 0x10040001: [%02X %02X %02X %02X]\n",
+                   time_message.data.uint8[0], time_message.data.uint8[1], 
+                   time_message.data.uint8[2], time_message.data.uint8[3]);
     } else {
-      Serial.println("ComfoMessage: Failed to send time set command");
+      Serial.println("ComfoMessage: Failed to queue time set command");
     }
     
     return success;
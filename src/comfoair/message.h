@@ -2,26 +2,32 @@
 #define COMFOMESSAGE_H
 
 #include <inttypes.h>
-#include <PubSubClient.h>
-#include <map>
-#include "twai_wrapper.h"  // Changed from esp32_can.h
-#include <vector>      
+#include <stddef.h>
+#include "can_frame.h"
+#include "pdo_table.h"
+#include "can_tx_queue.h"
+#include "commands.h"
 #include <cstdint> 
 
 namespace comfoair {
-  struct DecodedMessage {
-    char name[40];
-    char val[15];
-  };
-
   class ComfoMessage {
     public:
       ComfoMessage();
-      void test(const char * test, const char * name, const char * expectedValue);
-      bool send(uint8_t length, uint8_t * buf);
-      bool send(std::vector<uint8_t> *buf);
-      bool decode(CAN_FRAME *frame, DecodedMessage *message);
-      bool sendCommand(char const * command);
+      
+      // All transmissions go through this queue (nothing is sent without one)
+      void setTxQueue(CanTxQueue *queue) { txQueue = queue; }
+      
+      // Returns true once queued; the callback reports the bus outcome
+      bool send(uint8_t length, const uint8_t * buf, TxCallback callback = nullptr, void *context = nullptr);
+      
+      // RMI request to any node. Returns the sequence number used, -1 if not
+      // queued. With reserve, the number is not reused until releaseSequence().
+      int8_t sendRmi(uint8_t dstNode, uint8_t length, const uint8_t *buf, TxPriority priority,
+                     bool reserve, TxCallback callback = nullptr, void *context = nullptr);
+      void releaseSequence(uint8_t seq);
+      bool decode(const CAN_FRAME *frame, PdoValue *value);
+      static size_t format(const PdoValue &value, char *buf, size_t len);
+      bool sendCommand(CommandId command, TxCallback callback = nullptr, void *context = nullptr);
       
       // Time synchronization methods
       bool requestTime();
@@ -34,9 +40,16 @@ namespace comfoair {
       bool requestTargetTemp();        // PDOID 212 - Target temperature
       bool requestBypassStatus();      // PDOID 66  - Bypass activation mode
       bool requestOperatingMode();     // PDOID 49  - Operating mode
+      bool requestPdo(uint16_t pdoid);  // RTR for any PDO of the MVHR
 
     private:
       uint8_t sequence;
+      uint8_t reservedSequences;  // bit per RMI sequence number in use
+      CanTxQueue *txQueue;
+      
+      bool queueFrames(TxPriority priority, CAN_FRAME *frames, uint8_t count,
+                       TxCallback callback = nullptr, void *context = nullptr);
+      int8_t nextSequence();
       
       // Helper for date/time calculations
       uint32_t dateTimeToSeconds(uint16_t year, uint8_t month, uint8_t day,
@@ -0,0 +1,377 @@
+#include <math.h>
+#include <string.h>
+#include "mvhr_simulator.h"
+
+namespace comfoair {
+
+  static const uint32_t CAN_ID_TIME_REQUEST = 0x10080028;
+
+  // Fan level 0..3 (boost runs at 3)
+  static const uint16_t FLOW_M3H[] = { 0, 100, 150, 225 };
+  static const uint8_t DUTY_PERCENT[] = { 0, 25, 40, 65 };
+  static const uint16_t FAN_RPM[] = { 0, 1050, 1500, 2250 };
+  static const uint16_t POWER_W[] = { 2, 14, 31, 72 };
+  static const uint16_t TARGET_TEMP[] = { 210, 190, 235 };   // profile normal / cool / warm, 0.1 C
+
+  // Broadcast period on the realistic schedule
+  static uint16_t periodMs(uint16_t pdoid) {
+    if (pdoid >= 117 && pdoid <= 122) return 2000;                   // fans
+    if (pdoid == 128) return 5000;                                   // power now
+    if (pdoid >= 321 && pdoid <= 329) return 30000;                  // alarms
+    if (pdoid == 129 || pdoid == 130 || pdoid == 192 || pdoid == 214 ||
+        pdoid == 215 || pdoid == 217 || pdoid == 218) return 60000;  // counters
+    if (pdoid == 1) return 60000;
+    return 10000;                                                    // temps, humidity, modes
+  }
+
+  MvhrSimulator::MvhrSimulator(CanPort &port) :
+    port(port),
+    rmi([](void *ctx, const RmiMessage &message) {
+      static_cast<MvhrSimulator*>(ctx)->onRmi(message);
+    }, this),
+    fanLevel(2),
+    opMode(0xFF),
+    bypass(0),
+    profile(0),
+    alarms(0),
+    boostEndUs(0),
+    levelBeforeBoost(2),
+    timeBase(MVHR_SIM_START_TIME),
+    loadPercent(0),
+    lastPollUs(0),
+    uptimeUs(0),
+    busFreeUs(0),
+    loadFreeUs(0),
+    roundRobin(0),
+    started(false),
+    scheduleCount(0),
+    outboxHead(0),
+    outboxCount(0) {
+    // Staggered, so they do not all go out in the first millisecond
+    for (const PdoDescriptor &desc : PDO_DESCRIPTORS) {
+      Schedule &entry = schedule[scheduleCount];
+      entry.pdoid = desc.pdoid;
+      entry.periodMs = periodMs(desc.pdoid);
+      entry.dueUs = (uint64_t)scheduleCount * 37000;
+      scheduleCount++;
+    }
+    resetStats();
+  }
+
+  bool MvhrSimulator::begin() {
+    // Hears everything, like the real unit
+    started = port.begin(MVHR_SIM_BITRATE);
+    return started;
+  }
+
+  void MvhrSimulator::resetStats() {
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  void MvhrSimulator::setLoad(uint16_t percent) {
+    loadPercent = percent;
+    loadFreeUs = uptimeUs;
+  }
+
+  void MvhrSimulator::setAlarm(uint16_t pdoid, bool active) {
+    if (pdoid < 321 || pdoid > 329) return;
+    uint16_t bit = 1 << (pdoid - 321);
+    alarms = active ? (alarms | bit) : (alarms & ~bit);
+    queuePdo(pdoid);
+  }
+
+  void MvhrSimulator::setFanSpeed(uint8_t level) {
+    fanLevel = level > 3 ? 3 : level;
+    boostEndUs = 0;
+    fanChanged();
+  }
+
+  uint32_t MvhrSimulator::deviceTime() const {
+    return timeBase + (uint32_t)(uptimeUs / 1000000);
+  }
+
+  int32_t MvhrSimulator::value(uint16_t pdoid) const {
+    float t = uptimeUs / 1e6f;
+    float outdoor = 8.0f + 4.0f * sinf(t * 6.2832f / 600.0f);     // 10 min cycle
+    float extract = 21.5f + 0.3f * sinf(t * 6.2832f / 240.0f);
+    float recovered = extract - (extract - outdoor) * 0.12f;      // ~88 % efficiency
+    uint8_t level = fanLevel > 3 ? 3 : fanLevel;
+    int32_t wobble = (int32_t)(uptimeUs / 1000000 % 7) - 3;
+
+    switch (pdoid) {
+      case 1:   return (int32_t)deviceTime();
+      case 16:  return 0;
+      case 37:  return (int32_t)outdoor;
+      case 49:  return opMode;
+      case 56:  return 0;
+      case 65:  return level;
+      case 66:  return bypass;
+      case 67:  return profile;
+      case 81:  return boostEndUs > uptimeUs ? (int32_t)((boostEndUs - uptimeUs) / 1000000) : 0;
+      case 82:  return 0;
+      case 117:
+      case 118: return DUTY_PERCENT[level];
+      case 119:
+      case 120: return FLOW_M3H[level];
+      case 121: return level ? FAN_RPM[level] + wobble * 5 : 0;
+      case 122: return level ? FAN_RPM[level] + 40 + wobble * 5 : 0;
+      case 128: return POWER_W[level];
+      case 129: return 120;
+      case 130: return 830;
+      case 192: return 143;
+      case 209: return (int32_t)(outdoor * 10);
+      case 212: return TARGET_TEMP[profile < 3 ? profile : 0];
+      case 213: return outdoor < extract ? (int32_t)((extract - outdoor) * FLOW_M3H[level] * 0.3f * 100) : 0;
+      case 214: return 410;
+      case 215: return 2950;
+      case 216: return 0;
+      case 217: return 35;
+      case 218: return 260;
+      case 227: return bypass == 1 ? 100 : 0;
+      case 220:
+      case 276:
+      case 277: return (int32_t)(outdoor * 10);
+      case 221:
+      case 278: return (int32_t)(recovered * 10);
+      case 274: return (int32_t)(extract * 10);
+      case 275: return (int32_t)((outdoor + (extract - recovered)) * 10);
+      case 290: return 48 + wobble;
+      case 291: return 62 + wobble;
+      case 292: return 75;
+      case 293: return 70;
+      case 294: return 44 + wobble;
+      default:
+        if (pdoid >= 321 && pdoid <= 329) return (alarms >> (pdoid - 321)) & 1;
+        return 0;
+    }
+  }
+
+  CAN_FRAME MvhrSimulator::pdoFrame(uint16_t pdoid) const {
+    CAN_FRAME frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.id = pdoCanId(pdoid, NODE);
+    frame.extended = true;
+
+    const PdoDescriptor *desc = findPdo(pdoid);
+    if (!desc) return frame;
+    uint32_t raw = (uint32_t)value(pdoid);
+    frame.length = pdoTypeSize(desc->type);
+    for (uint8_t i = 0; i < frame.length; i++) {
+      frame.data.uint8[i] = (raw >> (8 * i)) & 0xFF;
+    }
+    return frame;
+  }
+
+  // ==========================================================================
+  // Receive side
+  // ==========================================================================
+  void MvhrSimulator::receive(const CAN_FRAME &frame) {
+    if (!frame.extended) return;
+
+    if (frame.rtr) {
+      if (frame.id == CAN_ID_TIME_REQUEST) {
+        totals.timeRequests++;
+        CAN_FRAME answer;
+        memset(&answer, 0, sizeof(answer));
+        answer.id = CAN_ID_TIME_RESPONSE;
+        answer.extended = true;
+        answer.length = 4;
+        uint32_t now = deviceTime();
+        memcpy(answer.data.uint8, &now, 4);
+        queueAnswer(answer);
+      } else if (isPdoCanId(frame.id)) {
+        uint16_t pdoid = pdoidFromCanId(frame.id);
+        if (findPdo(pdoid)) {
+          totals.rtrAnswered++;
+          queuePdo(pdoid);
+        } else {
+          totals.rtrUnknown++;
+        }
+      }
+      return;
+    }
+
+    if (frame.id == CAN_ID_TIME_RESPONSE && frame.length >= 4) {
+      // setTime() from the display
+      uint32_t seconds = frame.data.uint8[0] | (frame.data.uint8[1] << 8) |
+                         (frame.data.uint8[2] << 16) | ((uint32_t)frame.data.uint8[3] << 24);
+      timeBase = seconds - (uint32_t)(uptimeUs / 1000000);
+      totals.timeSets++;
+      return;
+    }
+
+    if (isRmiCanId(frame.id) && rmiDstNode(frame.id) == NODE) {
+      rmi.accept(frame, (uint32_t)(uptimeUs / 1000));
+    }
+  }
+
+  void MvhrSimulator::onRmi(const RmiMessage &message) {
+    if (!message.isRequest) return;
+
+    for (const CommandDescriptor &command : COMMANDS) {
+      if (command.length == message.length && memcmp(command.payload, message.data, message.length) == 0) {
+        totals.commands++;
+        answerRmi(message, false);
+        applyCommand(command.id, message.data);
+        return;
+      }
+    }
+    // Property reads and everything else we do not model
+    totals.unknownRequests++;
+    answerRmi(message, true);
+  }
+
+  void MvhrSimulator::applyCommand(CommandId id, const uint8_t *payload) {
+    switch (id) {
+      case CommandId::VENTILATION_LEVEL_0:
+      case CommandId::VENTILATION_LEVEL_1:
+      case CommandId::VENTILATION_LEVEL_2:
+      case CommandId::VENTILATION_LEVEL_3:
+        fanLevel = commandFanSpeed(id);
+        boostEndUs = 0;
+        fanChanged();
+        return;
+      case CommandId::BOOST_10_MIN:
+      case CommandId::BOOST_20_MIN:
+      case CommandId::BOOST_30_MIN:
+      case CommandId::BOOST_60_MIN: {
+        // Duration in seconds at bytes 8..11
+        uint32_t seconds = payload[8] | (payload[9] << 8) | (payload[10] << 16) | ((uint32_t)payload[11] << 24);
+        if (!boostEndUs) levelBeforeBoost = fanLevel;
+        fanLevel = 3;
+        boostEndUs = uptimeUs + (uint64_t)seconds * 1000000;
+        fanChanged();
+        return;
+      }
+      case CommandId::BOOST_END:
+        if (boostEndUs) fanLevel = levelBeforeBoost;
+        boostEndUs = 0;
+        fanChanged();
+        return;
+      case CommandId::AUTO:
+        opMode = 0xFF;
+        queuePdo(PDO_OPERATING_MODE);
+        return;
+      case CommandId::MANUAL:
+        opMode = 0x01;
+        queuePdo(PDO_OPERATING_MODE);
+        return;
+      case CommandId::BYPASS_ACTIVATE_1H:   bypass = 1; queuePdo(PDO_BYPASS_ACTIVATION_MODE); return;
+      case CommandId::BYPASS_DEACTIVATE_1H: bypass = 2; queuePdo(PDO_BYPASS_ACTIVATION_MODE); return;
+      case CommandId::BYPASS_AUTO:          bypass = 0; queuePdo(PDO_BYPASS_ACTIVATION_MODE); return;
+      case CommandId::TEMP_PROFILE_NORMAL:
+      case CommandId::TEMP_PROFILE_COOL:
+      case CommandId::TEMP_PROFILE_WARM:
+        profile = (uint8_t)id - (uint8_t)CommandId::TEMP_PROFILE_NORMAL;
+        queuePdo(PDO_TEMP_PROFILE);
+        queuePdo(PDO_TARGET_TEMP);
+        return;
+      default:
+        // Supply / extract only: accepted, not modelled
+        return;
+    }
+  }
+
+  // fan_speed, next_fan_change and the fan duty / flow / rpm values
+  void MvhrSimulator::fanChanged() {
+    queuePdo(PDO_FAN_SPEED);
+    queuePdo(81);
+    for (uint16_t pdoid = 117; pdoid <= 122; pdoid++) queuePdo(pdoid);
+  }
+
+  void MvhrSimulator::answerRmi(const RmiMessage &request, bool error) {
+    CAN_FRAME answer;
+    memset(&answer, 0, sizeof(answer));
+    answer.id = rmiResponseId(request.srcNode) | ((uint32_t)(request.seq & 0x3) << 17) |
+                (error ? (1UL << 15) : 0) | NODE;
+    answer.extended = true;
+    answer.length = 0;
+    queueAnswer(answer);
+  }
+
+  // ==========================================================================
+  // Transmit side
+  // ==========================================================================
+  bool MvhrSimulator::queueAnswer(const CAN_FRAME &frame) {
+    if (outboxCount >= OUTBOX_SIZE) {
+      totals.outboxFull++;
+      return false;
+    }
+    outbox[(outboxHead + outboxCount) % OUTBOX_SIZE] = frame;
+    outboxCount++;
+    return true;
+  }
+
+  void MvhrSimulator::queuePdo(uint16_t pdoid) {
+    queueAnswer(pdoFrame(pdoid));
+  }
+
+  uint32_t MvhrSimulator::frameUs(const CAN_FRAME &frame) const {
+    uint32_t us = canFrameBits(frame.length, frame.extended) * 1000000UL / MVHR_SIM_BITRATE;
+    // Beyond 100 % the wire itself gets faster
+    return loadPercent > 100 ? us * 100 / loadPercent : us;
+  }
+
+  bool MvhrSimulator::send(const CAN_FRAME &frame) {
+    if (!port.transmit(frame)) {
+      totals.txBusy++;
+      return false;
+    }
+    uint32_t us = frameUs(frame);
+    busFreeUs += us;
+    totals.busyUs += us;
+    return true;
+  }
+
+  bool MvhrSimulator::nextBroadcast(CAN_FRAME &frame) {
+    if (loadPercent) {
+      if (uptimeUs < loadFreeUs) return false;
+      if (loadFreeUs + MVHR_SIM_CATCHUP_US < uptimeUs) loadFreeUs = uptimeUs - MVHR_SIM_CATCHUP_US;
+      frame = pdoFrame(schedule[roundRobin].pdoid);
+      roundRobin = (roundRobin + 1) % scheduleCount;
+      loadFreeUs += (uint64_t)canFrameBits(frame.length, true) * 1000000UL * 100 / MVHR_SIM_BITRATE / loadPercent;
+      return true;
+    }
+
+    for (uint8_t i = 0; i < scheduleCount; i++) {
+      Schedule &entry = schedule[i];
+      if (entry.dueUs > uptimeUs) continue;
+      entry.dueUs += (uint64_t)entry.periodMs * 1000;
+      if (entry.dueUs <= uptimeUs) entry.dueUs = uptimeUs + (uint64_t)entry.periodMs * 1000;
+      frame = pdoFrame(entry.pdoid);
+      return true;
+    }
+    return false;
+  }
+
+  void MvhrSimulator::poll(uint32_t nowUs) {
+    if (!started) return;
+    uptimeUs += (uint32_t)(nowUs - lastPollUs);
+    lastPollUs = nowUs;
+
+    CAN_FRAME frame;
+    while (port.read(frame)) receive(frame);
+    rmi.poll((uint32_t)(uptimeUs / 1000));
+
+    if (boostEndUs && uptimeUs >= boostEndUs) {
+      fanLevel = levelBeforeBoost;
+      boostEndUs = 0;
+      fanChanged();
+    }
+
+    // The wire was idle: catch up a little, not the whole gap
+    if (busFreeUs + MVHR_SIM_CATCHUP_US < uptimeUs) busFreeUs = uptimeUs - MVHR_SIM_CATCHUP_US;
+
+    while (busFreeUs <= uptimeUs) {
+      if (outboxCount) {
+        if (!send(outbox[outboxHead])) return;
+        outboxHead = (outboxHead + 1) % OUTBOX_SIZE;
+        outboxCount--;
+        continue;
+      }
+      if (!nextBroadcast(frame)) return;
+      if (send(frame)) totals.broadcasts++;
+      else return;
+    }
+  }
+}
@@ -0,0 +1,143 @@
+#ifndef MVHR_SIMULATOR_H
+#define MVHR_SIMULATOR_H
+
+#include <cstdint>
+#include "can_port.h"
+#include "commands.h"
+#include "pdo_table.h"
+#include "rmi_reassembler.h"
+
+// ============================================================================
+// MVHR SIMULATOR - the ComfoAir Q side of the bus, for load and regression
+// ============================================================================
+// Plays node 1 on a CanPort (usually a LoopbackPort next to the one given
+// to ComfoAir):
+//   - broadcasts every PDO in pdo_table.h with plausible values derived
+//     from its state (fans follow the level, temperatures drift slowly)
+//   - answers PDO RTRs (49 / 66 / 192 / 212 and any other it broadcasts)
+//     and the 0x10080028 time request on 0x10040001; a data frame on
+//     0x10040001 sets its clock
+//   - takes the RMI commands of commands.h (single and multi frame),
+//     changes fan_speed / operating_mode / bypass / temp_profile, answers
+//     and broadcasts the changed PDOs; other requests get an error answer
+//
+// Transmission is paced like a real wire at MVHR_SIM_BITRATE (frame bits
+// without stuffing, so 100% is the most frames the bus could ever carry):
+//   setLoad(0)      realistic schedule, a few frames per second
+//   setLoad(1..100) broadcasts fill that share of the bus, round robin
+//   setLoad(>100)   beyond the wire, for host throughput runs
+// Answers always go first. poll() must be called at least every ms or so;
+// a late call catches up at most MVHR_SIM_CATCHUP_US of bus time.
+// ============================================================================
+
+#ifndef MVHR_SIM_BITRATE
+  #define MVHR_SIM_BITRATE 50000
+#endif
+#ifndef MVHR_SIM_CATCHUP_US
+  #define MVHR_SIM_CATCHUP_US 2000
+#endif
+#ifndef MVHR_SIM_START_TIME
+  #define MVHR_SIM_START_TIME 820000000UL   // seconds since 2000-01-01 (2025-12)
+#endif
+
+namespace comfoair {
+
+  // Bits on the wire without stuffing: SOF..IFS
+  constexpr uint32_t canFrameBits(uint8_t length, bool extended) {
+    return (extended ? 67 : 47) + 8 * (length > 8 ? 8 : length);
+  }
+
+  class MvhrSimulator {
+    public:
+      static const uint8_t NODE = 1;
+      static const uint8_t OUTBOX_SIZE = 16;
+
+      struct Stats {
+        uint32_t broadcasts;
+        uint32_t rtrAnswered;
+        uint32_t rtrUnknown;      // RTR for a PDOID we do not broadcast
+        uint32_t timeRequests;
+        uint32_t timeSets;
+        uint32_t commands;
+        uint32_t unknownRequests; // RMI requests answered with an error
+        uint32_t outboxFull;      // answers dropped
+        uint32_t txBusy;          // transmit() refused a frame
+        uint64_t busyUs;          // wire time of everything sent
+      };
+
+      explicit MvhrSimulator(CanPort &port);
+
+      bool begin();
+      void poll(uint32_t nowUs);
+
+      // Percent of MVHR_SIM_BITRATE for broadcasts, 0 = realistic schedule
+      void setLoad(uint16_t percent);
+      uint16_t load() const { return loadPercent; }
+
+      void setAlarm(uint16_t pdoid, bool active);   // 321..329
+      void setFanSpeed(uint8_t level);
+
+      uint8_t fanSpeed() const { return fanLevel; }
+      uint8_t tempProfile() const { return profile; }
+      uint8_t operatingMode() const { return opMode; }
+      uint8_t bypassMode() const { return bypass; }
+      uint32_t deviceTime() const;          // seconds since 2000-01-01
+
+      // Raw wire value of a broadcast PDO as of the last poll()
+      int32_t value(uint16_t pdoid) const;
+
+      const Stats &stats() const { return totals; }
+      void resetStats();
+
+    private:
+      struct Schedule {
+        uint16_t pdoid;
+        uint16_t periodMs;
+        uint64_t dueUs;
+      };
+
+      void receive(const CAN_FRAME &frame);
+      void onRmi(const RmiMessage &message);
+      void applyCommand(CommandId id, const uint8_t *payload);
+      void fanChanged();
+      void answerRmi(const RmiMessage &request, bool error);
+
+      CAN_FRAME pdoFrame(uint16_t pdoid) const;
+      bool queueAnswer(const CAN_FRAME &frame);
+      void queuePdo(uint16_t pdoid);
+      uint32_t frameUs(const CAN_FRAME &frame) const;
+      bool send(const CAN_FRAME &frame);
+      bool nextBroadcast(CAN_FRAME &frame);
+
+      CanPort &port;
+      RmiReassembler rmi;
+
+      uint8_t fanLevel;
+      uint8_t opMode;
+      uint8_t bypass;
+      uint8_t profile;
+      uint16_t alarms;            // bit n = PDOID 321 + n
+      uint64_t boostEndUs;        // 0 = no boost running
+      uint8_t levelBeforeBoost;
+      uint32_t timeBase;          // device time at uptime 0
+
+      uint16_t loadPercent;
+      uint32_t lastPollUs;
+      uint64_t uptimeUs;          // poll() clock, does not wrap
+      uint64_t busFreeUs;         // the wire is busy until then
+      uint64_t loadFreeUs;        // next broadcast slot in load mode
+      uint8_t roundRobin;
+      bool started;
+
+      Schedule schedule[PDO_DESCRIPTOR_COUNT];
+      uint8_t scheduleCount;
+
+      CAN_FRAME outbox[OUTBOX_SIZE];
+      uint8_t outboxHead;
+      uint8_t outboxCount;
+
+      Stats totals;
+  };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <string.h>
+#include "node_table.h"
+
+namespace comfoair {
+
+  const char *nodeStateName(NodeState state) {
+    switch (state) {
+      case NodeState::UNSEEN: return "unseen";
+      case NodeState::ALIVE:  return "alive";
+      case NodeState::DEAD:   return "dead";
+    }
+    return "?";
+  }
+
+  NodeTable::NodeTable(uint8_t localNode) :
+    ignoredNodes(0), local(localNode & CAN_NODE_MASK), collisionFrames(0), collisionMs(0),
+    windowStartMs(0), windowStarted(false), listener(nullptr), listenerContext(nullptr) {
+    memset(nodes, 0, sizeof(nodes));
+  }
+
+  void NodeTable::setListener(NodeListener listener, void *context) {
+    this->listener = listener;
+    this->listenerContext = context;
+  }
+
+  void NodeTable::setState(uint8_t id, NodeState state, uint32_t nowMs) {
+    NodeState from = nodes[id].state;
+    if (from == state) return;
+    nodes[id].state = state;
+    if (listener) listener(listenerContext, id, from, state, nowMs);
+  }
+
+  bool NodeTable::record(const CAN_FRAME &frame, uint32_t nowMs) {
+    if (!frame.extended) return true;     // not ComfoNet
+    uint8_t id = canIdSourceNode(frame.id);
+    if (isIgnored(id)) {
+      nodes[id].dropped++;
+      return false;
+    }
+    if (frame.rtr) return true;
+
+    if (id == local) {
+      collisionFrames++;
+      collisionMs = nowMs;
+    }
+
+    Node &n = nodes[id];
+    if (n.state == NodeState::UNSEEN) n.firstSeenMs = nowMs;
+    n.lastSeenMs = nowMs;
+    n.frames++;
+    switch (canIdKind(frame.id)) {
+      case CanIdKind::PDO:
+        n.pdoFrames++;
+        if (n.windowPdo < UINT16_MAX) n.windowPdo++;
+        break;
+      case CanIdKind::RMI:
+        n.rmiFrames++;
+        break;
+      case CanIdKind::NODE:
+        if (isNodeHeartbeatId(frame.id)) n.heartbeats++;
+        break;
+      case CanIdKind::OTHER:
+        break;
+    }
+    if (n.state != NodeState::ALIVE) setState(id, NodeState::ALIVE, nowMs);
+    return true;
+  }
+
+  void NodeTable::poll(uint32_t nowMs) {
+    for (uint8_t id = 0; id < MAX_NODES; id++) {
+      if (nodes[id].state == NodeState::ALIVE && nowMs - nodes[id].lastSeenMs >= NODE_TIMEOUT_MS) {
+        setState(id, NodeState::DEAD, nowMs);
+      }
+    }
+
+    if (!windowStarted) {
+      windowStartMs = nowMs;
+      windowStarted = true;
+      return;
+    }
+    uint32_t elapsed = nowMs - windowStartMs;
+    if (elapsed < NODE_RATE_WINDOW_MS) return;
+    for (uint8_t id = 0; id < MAX_NODES; id++) {
+      Node &n = nodes[id];
+      uint32_t rate = (uint32_t)n.windowPdo * 10000 / elapsed;
+      n.pdoRateX10 = rate > UINT16_MAX ? UINT16_MAX : rate;
+      n.windowPdo = 0;
+    }
+    windowStartMs = nowMs;
+  }
+
+  uint8_t NodeTable::aliveCount() const {
+    uint8_t count = 0;
+    for (uint8_t id = 0; id < MAX_NODES; id++) {
+      if (nodes[id].state == NodeState::ALIVE) count++;
+    }
+    return count;
+  }
+
+  size_t NodeTable::toJson(char *buf, size_t len, uint32_t nowMs) const {
+    if (len == 0) return 0;
+    size_t pos = 0;
+
+    // Appends only if the whole piece fits
+    auto append = [&](const char *piece, int n) {
+      if (n < 0 || pos + n + 3 >= len) return false;  // keep room for "]}"
+      memcpy(buf + pos, piece, n);
+      pos += n;
+      return true;
+    };
+
+    char piece[128];
+    int n = snprintf(piece, sizeof(piece), "{\"local\":%u,\"collisions\":%u,\"nodes\":[",
+                     local, collisionFrames);
+    if (!append(piece, n)) {
+      buf[0] = '\0';
+      return 0;
+    }
+
+    bool first = true;
+    for (uint8_t id = 0; id < MAX_NODES; id++) {
+      const Node &node = nodes[id];
+      if (node.state == NodeState::UNSEEN && node.dropped == 0) continue;
+      uint32_t age = node.state == NodeState::UNSEEN ? UINT32_MAX : nowMs - node.lastSeenMs;
+      n = snprintf(piece, sizeof(piece), "%s[%u,\"%s\",%u,%u,%u,%u,%u,%u,%u]", first ? "" : ",",
+                   id, nodeStateName(node.state), node.frames, node.pdoFrames, node.rmiFrames,
+                   node.heartbeats, node.dropped, node.pdoRateX10, age);
+      if (!append(piece, n)) break;
+      first = false;
+    }
+
+    buf[pos++] = ']';
+    buf[pos++] = '}';
+    buf[pos] = '\0';
+    return pos;
+  }
+}
@@ -0,0 +1,99 @@
+#ifndef NODE_TABLE_H
+#define NODE_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+#include "CanAddress.h"
+
+// ============================================================================
+// NODE TABLE - ComfoNet nodes seen on the bus and their liveness
+// ============================================================================
+// record() runs for every received frame before the fan-out: the source
+// node comes from the CAN ID (CanAddress), the table is indexed by it
+// (6-bit node IDs, 64 slots, no search).
+//   - per node: first / last seen, frames by kind (PDO, RMI, heartbeat) and
+//     the PDO rate over the last NODE_RATE_WINDOW_MS
+//   - a node silent for NODE_TIMEOUT_MS is dead; state changes go to the
+//     listener (alive <-> dead)
+//   - frames carrying our own node ID are an address collision: another
+//     device uses it (the controller does not receive what we send)
+//   - frames from ignored nodes are counted and dropped right here
+// RTR frames are not attributed: they carry the ID of the node that is
+// asked, not of the one asking.
+// ============================================================================
+
+#ifndef NODE_TIMEOUT_MS
+  #define NODE_TIMEOUT_MS 10000
+#endif
+#define NODE_RATE_WINDOW_MS 10000
+
+namespace comfoair {
+
+  enum class NodeState : uint8_t {
+    UNSEEN,
+    ALIVE,
+    DEAD
+  };
+
+  const char *nodeStateName(NodeState state);
+
+  typedef void (*NodeListener)(void *context, uint8_t node, NodeState from, NodeState to, uint32_t nowMs);
+
+  class NodeTable {
+    public:
+      static const uint8_t MAX_NODES = CAN_NODE_MASK + 1;
+
+      struct Node {
+        NodeState state;
+        uint32_t firstSeenMs;
+        uint32_t lastSeenMs;
+        uint32_t frames;
+        uint32_t pdoFrames;
+        uint32_t rmiFrames;
+        uint32_t heartbeats;
+        uint32_t dropped;         // ignored node
+        uint16_t pdoRateX10;      // PDO frames/s x 10 over the last window
+        uint16_t windowPdo;
+      };
+
+      explicit NodeTable(uint8_t localNode);
+
+      void setListener(NodeListener listener, void *context);
+
+      // Bit n set = drop frames from node n
+      void setIgnored(uint64_t nodeMask) { ignoredNodes = nodeMask; }
+      bool isIgnored(uint8_t node) const { return (ignoredNodes >> (node & CAN_NODE_MASK)) & 1; }
+
+      // Every received frame; false if it comes from an ignored node
+      bool record(const CAN_FRAME &frame, uint32_t nowMs);
+
+      // Timeouts and rate windows; call about once a second
+      void poll(uint32_t nowMs);
+
+      const Node &node(uint8_t id) const { return nodes[id & CAN_NODE_MASK]; }
+      uint8_t aliveCount() const;
+      uint8_t localNode() const { return local; }
+      uint32_t collisions() const { return collisionFrames; }
+      uint32_t lastCollisionMs() const { return collisionMs; }
+
+      // {"local":17,"collisions":0,"nodes":[[node,"state",frames,pdo,rmi,
+      //   heartbeats,dropped,pdo rate x10,age ms],...]}
+      size_t toJson(char *buf, size_t len, uint32_t nowMs) const;
+
+    private:
+      void setState(uint8_t id, NodeState state, uint32_t nowMs);
+
+      Node nodes[MAX_NODES];
+      uint64_t ignoredNodes;
+      uint8_t local;
+      uint32_t collisionFrames;
+      uint32_t collisionMs;
+      uint32_t windowStartMs;
+      bool windowStarted;
+      NodeListener listener;
+      void *listenerContext;
+  };
+}
+
+#endif
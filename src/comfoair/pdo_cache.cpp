@@ -0,0 +1,115 @@
+#include <string.h>
+#include "pdo_cache.h"
+
+namespace comfoair {
+
+  // Fan speeds jitter by a few rpm on every broadcast
+  static const struct { uint16_t pdoid; uint16_t deadband; } DEFAULT_DEADBANDS[] = {
+    { 121, 10 },  // exhaust_fan_speed (rpm)
+    { 122, 10 },  // supply_fan_speed (rpm)
+  };
+
+  PdoCache::PdoCache(uint32_t defaultHeartbeatMs) {
+    memset(entries, 0, sizeof(entries));
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+      entries[i].heartbeatMs = defaultHeartbeatMs;
+    }
+    for (const auto &d : DEFAULT_DEADBANDS) {
+      setDeadband(d.pdoid, d.deadband);
+    }
+    resetStats();
+  }
+
+  PdoCache::Entry *PdoCache::entryFor(uint16_t pdoid) {
+    if (pdoid >= PDO_TABLE_SIZE || PDO_INDEX.slot[pdoid] == 0) return nullptr;
+    return &entries[PDO_INDEX.slot[pdoid] - 1];
+  }
+
+  const PdoCache::Entry *PdoCache::entryFor(uint16_t pdoid) const {
+    if (pdoid >= PDO_TABLE_SIZE || PDO_INDEX.slot[pdoid] == 0) return nullptr;
+    return &entries[PDO_INDEX.slot[pdoid] - 1];
+  }
+
+  bool PdoCache::accept(uint16_t pdoid, const uint8_t *data, uint8_t length, uint32_t nowMs) {
+    Entry *entry = entryFor(pdoid);
+    if (!entry) return true;
+
+    const PdoDescriptor &desc = PDO_DESCRIPTORS[PDO_INDEX.slot[pdoid] - 1];
+    if (length < desc.minLength || length > sizeof(entry->data)) return true;
+
+    totals.frames++;
+
+    if (entry->length != 0) {
+      bool same = (entry->length == length && memcmp(entry->data, data, length) == 0);
+
+      if (!same && entry->deadband != 0 && desc.enumMap == nullptr) {
+        int32_t delta = pdoExtractRaw(desc.type, data) - pdoExtractRaw(desc.type, entry->data);
+        if (delta < 0) delta = -delta;
+        if (delta < entry->deadband) {
+          // Keep the last forwarded bytes so slow drift still crosses the band
+          if (entry->heartbeatMs == 0 || nowMs - entry->lastForwardMs < entry->heartbeatMs) {
+            entry->suppressed++;
+            totals.deadband++;
+            return false;
+          }
+          same = true;
+        }
+      }
+
+      if (same) {
+        if (entry->heartbeatMs == 0 || nowMs - entry->lastForwardMs < entry->heartbeatMs) {
+          entry->suppressed++;
+          totals.unchanged++;
+          return false;
+        }
+        totals.heartbeats++;
+      } else {
+        totals.forwarded++;
+      }
+    } else {
+      totals.forwarded++;
+    }
+
+    memcpy(entry->data, data, length);
+    entry->length = length;
+    entry->lastForwardMs = nowMs;
+    return true;
+  }
+
+  void PdoCache::invalidate(uint16_t pdoid) {
+    Entry *entry = entryFor(pdoid);
+    if (entry) entry->length = 0;
+  }
+
+  void PdoCache::clear() {
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+      entries[i].length = 0;
+    }
+  }
+
+  bool PdoCache::setDeadband(uint16_t pdoid, uint16_t rawUnits) {
+    Entry *entry = entryFor(pdoid);
+    if (!entry) return false;
+    entry->deadband = rawUnits;
+    return true;
+  }
+
+  bool PdoCache::setHeartbeat(uint16_t pdoid, uint32_t heartbeatMs) {
+    Entry *entry = entryFor(pdoid);
+    if (!entry) return false;
+    entry->heartbeatMs = heartbeatMs;
+    return true;
+  }
+
+  uint32_t PdoCache::suppressedCount(uint16_t pdoid) const {
+    const Entry *entry = entryFor(pdoid);
+    return entry ? entry->suppressed : 0;
+  }
+
+  void PdoCache::resetStats() {
+    memset(&totals, 0, sizeof(totals));
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+      entries[i].suppressed = 0;
+    }
+  }
+}
@@ -0,0 +1,78 @@
+#ifndef PDO_CACHE_H
+#define PDO_CACHE_H
+
+#include <cstdint>
+#include "pdo_table.h"
+
+// ============================================================================
+// PDO CHANGE CACHE - skip rebroadcasts with identical payloads
+// ============================================================================
+// The MVHR rebroadcasts most PDOs every few seconds with the same payload.
+// accept() compares the raw CAN bytes against the last forwarded frame of
+// that PDOID and drops repeats before they are decoded, published to MQTT
+// or pushed into the display managers.
+//
+// Per channel:
+//   deadband  - numeric PDOs whose raw value moved less than this (in raw
+//               units, e.g. 0.1 C for temperatures) are treated as unchanged
+//   heartbeat - an unchanged value is still forwarded once this many ms
+//               passed since the last forward, so MQTT consumers keep
+//               seeing liveness (0 = never republish)
+//
+// Time is passed in by the caller, so the cache has no Arduino dependency.
+// ============================================================================
+
+#ifndef PDO_CACHE_HEARTBEAT_MS
+  #define PDO_CACHE_HEARTBEAT_MS 60000
+#endif
+
+namespace comfoair {
+
+  class PdoCache {
+    public:
+      struct Stats {
+        uint32_t frames;          // PDO frames offered to accept()
+        uint32_t forwarded;       // new or changed values
+        uint32_t heartbeats;      // unchanged values forwarded by the heartbeat
+        uint32_t unchanged;       // dropped: identical payload
+        uint32_t deadband;        // dropped: change smaller than the deadband
+      };
+
+      explicit PdoCache(uint32_t defaultHeartbeatMs = PDO_CACHE_HEARTBEAT_MS);
+
+      // Returns true if the frame should be decoded and published.
+      // PDOIDs without a descriptor are always passed through (decode()
+      // rejects them) and are not counted.
+      bool accept(uint16_t pdoid, const uint8_t *data, uint8_t length, uint32_t nowMs);
+
+      // Forget the cached value, the next frame of this PDOID is forwarded.
+      // Used after an RTR request so the answer is always delivered.
+      void invalidate(uint16_t pdoid);
+      void clear();
+
+      bool setDeadband(uint16_t pdoid, uint16_t rawUnits);
+      bool setHeartbeat(uint16_t pdoid, uint32_t heartbeatMs);
+
+      const Stats &stats() const { return totals; }
+      uint32_t suppressedCount(uint16_t pdoid) const;
+      void resetStats();
+
+    private:
+      struct Entry {
+        uint8_t data[8];
+        uint8_t length;           // 0 = nothing cached yet
+        uint16_t deadband;
+        uint32_t heartbeatMs;
+        uint32_t lastForwardMs;
+        uint32_t suppressed;
+      };
+
+      Entry *entryFor(uint16_t pdoid);
+      const Entry *entryFor(uint16_t pdoid) const;
+
+      Entry entries[PDO_DESCRIPTOR_COUNT];  // indexed like PDO_DESCRIPTORS
+      Stats totals;
+  };
+}
+
+#endif
@@ -0,0 +1,128 @@
+#include <string.h>
+#include "pdo_poller.h"
+
+namespace comfoair {
+
+  PdoPoller::PdoPoller(PdoRequestFn request, void *context)
+    : request(request), context(context), entryCount(0), nextIndex(0), started(false),
+      gated(false), gateStartMs(0), gateMs(0) {
+    memset(entries, 0, sizeof(entries));
+  }
+
+  bool PdoPoller::add(uint16_t pdoid, uint32_t refreshMs) {
+    if (entryCount >= MAX_ENTRIES || find(pdoid)) return false;
+    Entry &entry = entries[entryCount++];
+    memset(&entry, 0, sizeof(entry));
+    entry.pdoid = pdoid;
+    entry.refreshMs = refreshMs;
+    return true;
+  }
+
+  bool PdoPoller::isPolled(uint16_t pdoid) const {
+    for (uint8_t i = 0; i < entryCount; i++) {
+      if (entries[i].pdoid == pdoid) return true;
+    }
+    return false;
+  }
+
+  PdoPoller::Entry *PdoPoller::find(uint16_t pdoid) {
+    for (uint8_t i = 0; i < entryCount; i++) {
+      if (entries[i].pdoid == pdoid) return &entries[i];
+    }
+    return nullptr;
+  }
+
+  void PdoPoller::start(uint32_t nowMs, uint32_t initialDelayMs) {
+    started = true;
+    holdGate(nowMs, initialDelayMs);
+  }
+
+  void PdoPoller::holdGate(uint32_t nowMs, uint32_t durationMs) {
+    gated = true;
+    gateStartMs = nowMs;
+    gateMs = durationMs;
+  }
+
+  void PdoPoller::onPdoReceived(uint16_t pdoid, uint32_t nowMs) {
+    Entry *entry = find(pdoid);
+    if (!entry) return;
+
+    entry->hasValue = true;
+    entry->lastValueMs = nowMs;
+    if (entry->outstanding) {
+      uint32_t latency = nowMs - entry->sentMs;
+      entry->outstanding = false;
+      entry->attempts = 0;
+      entry->responses++;
+      entry->lastLatencyMs = latency;
+      entry->sumLatencyMs += latency;
+      if (latency > entry->maxLatencyMs) entry->maxLatencyMs = latency;
+    }
+  }
+
+  // Elapsed-time tests only (now - start < duration): correct across the
+  // millis() wrap, and a flag instead of a deadline means "none"
+  bool PdoPoller::isDue(Entry &entry, uint32_t nowMs) {
+    if (entry.heldOff) {
+      if (nowMs - entry.holdoffStartMs < PDO_POLL_HOLDOFF_MS) return false;
+      entry.heldOff = false;
+    }
+    return !entry.hasValue || nowMs - entry.lastValueMs >= entry.refreshMs;
+  }
+
+  void PdoPoller::poll(uint32_t nowMs) {
+    if (!started || entryCount == 0) return;
+
+    // Outstanding request: wait for the answer or time out
+    for (uint8_t i = 0; i < entryCount; i++) {
+      Entry &entry = entries[i];
+      if (!entry.outstanding) continue;
+      if (nowMs - entry.sentMs < PDO_POLL_TIMEOUT_MS) return;
+
+      entry.outstanding = false;
+      entry.timeouts++;
+      if (++entry.attempts >= PDO_POLL_MAX_ATTEMPTS) {
+        entry.attempts = 0;
+        entry.heldOff = true;
+        entry.holdoffStartMs = nowMs;
+      }
+    }
+
+    if (gated) {
+      if (nowMs - gateStartMs < gateMs) return;
+      gated = false;
+    }
+
+    for (uint8_t n = 0; n < entryCount; n++) {
+      uint8_t i = (nextIndex + n) % entryCount;
+      Entry &entry = entries[i];
+      if (!isDue(entry, nowMs)) continue;
+
+      // Spacing applies whether or not the request could be queued
+      holdGate(nowMs, PDO_POLL_SPACING_MS);
+      if (request(context, entry.pdoid)) {
+        entry.outstanding = true;
+        entry.sentMs = nowMs;
+        entry.requests++;
+        nextIndex = (i + 1) % entryCount;
+      }
+      return;
+    }
+  }
+
+  PdoPoller::EntryStats PdoPoller::stats(uint8_t index, uint32_t nowMs) const {
+    EntryStats s = {};
+    if (index >= entryCount) return s;
+
+    const Entry &entry = entries[index];
+    s.pdoid = entry.pdoid;
+    s.requests = entry.requests;
+    s.responses = entry.responses;
+    s.timeouts = entry.timeouts;
+    s.lastLatencyMs = entry.lastLatencyMs;
+    s.avgLatencyMs = entry.responses ? entry.sumLatencyMs / entry.responses : 0;
+    s.maxLatencyMs = entry.maxLatencyMs;
+    s.ageMs = entry.hasValue ? nowMs - entry.lastValueMs : UINT32_MAX;
+    return s;
+  }
+}
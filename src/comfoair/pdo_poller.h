@@ -0,0 +1,98 @@
+#ifndef PDO_POLLER_H
+#define PDO_POLLER_H
+
+#include <cstdint>
+
+// ============================================================================
+// PDO POLLER - timer-driven RTR requests for slow-changing PDOs
+// ============================================================================
+// Replaces the delay(2000) chains: poll() is called every loop and sends at
+// most one RTR per PDO_POLL_SPACING_MS, one request outstanding at a time.
+//   - a PDO is only requested when it has no value yet or its last value
+//     (RTR answer or regular broadcast) is older than its refresh period
+//   - answers are matched to the outstanding request by PDOID
+//   - no answer within PDO_POLL_TIMEOUT_MS counts as a timeout and the
+//     request is retried; after PDO_POLL_MAX_ATTEMPTS the PDO is left
+//     alone for PDO_POLL_HOLDOFF_MS
+// Time is passed in by the caller, so the poller has no Arduino dependency.
+// ============================================================================
+
+#ifndef PDO_POLL_SPACING_MS
+  #define PDO_POLL_SPACING_MS 2000
+#endif
+#define PDO_POLL_TIMEOUT_MS 5000
+#define PDO_POLL_MAX_ATTEMPTS 3
+#define PDO_POLL_HOLDOFF_MS 60000
+
+namespace comfoair {
+
+  // Send an RTR for pdoid; false if it could not be queued
+  typedef bool (*PdoRequestFn)(void *context, uint16_t pdoid);
+
+  class PdoPoller {
+    public:
+      static const uint8_t MAX_ENTRIES = 8;
+
+      struct EntryStats {
+        uint16_t pdoid;
+        uint32_t requests;
+        uint32_t responses;
+        uint32_t timeouts;
+        uint32_t lastLatencyMs;
+        uint32_t avgLatencyMs;
+        uint32_t maxLatencyMs;
+        uint32_t ageMs;           // since the last value, UINT32_MAX = never seen
+      };
+
+      PdoPoller(PdoRequestFn request, void *context);
+
+      bool add(uint16_t pdoid, uint32_t refreshMs);
+      bool isPolled(uint16_t pdoid) const;
+
+      // No request goes out before nowMs + initialDelayMs
+      void start(uint32_t nowMs, uint32_t initialDelayMs);
+
+      // Call for every received frame of a PDO (answer or broadcast)
+      void onPdoReceived(uint16_t pdoid, uint32_t nowMs);
+
+      void poll(uint32_t nowMs);
+
+      uint8_t count() const { return entryCount; }
+      EntryStats stats(uint8_t index, uint32_t nowMs) const;
+
+    private:
+      struct Entry {
+        uint16_t pdoid;
+        uint32_t refreshMs;
+        bool hasValue;
+        bool outstanding;
+        uint8_t attempts;
+        uint32_t lastValueMs;
+        uint32_t sentMs;
+        bool heldOff;
+        uint32_t holdoffStartMs;
+        uint32_t requests;
+        uint32_t responses;
+        uint32_t timeouts;
+        uint32_t lastLatencyMs;
+        uint32_t sumLatencyMs;
+        uint32_t maxLatencyMs;
+      };
+
+      Entry *find(uint16_t pdoid);
+      bool isDue(Entry &entry, uint32_t nowMs);
+      void holdGate(uint32_t nowMs, uint32_t durationMs);
+
+      PdoRequestFn request;
+      void *context;
+      Entry entries[MAX_ENTRIES];
+      uint8_t entryCount;
+      uint8_t nextIndex;          // round robin start
+      bool started;
+      bool gated;                 // start delay, then request spacing
+      uint32_t gateStartMs;
+      uint32_t gateMs;
+  };
+}
+
+#endif
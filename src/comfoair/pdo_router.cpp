@@ -0,0 +1,46 @@
+#include <string.h>
+#include "pdo_router.h"
+
+namespace comfoair {
+
+  PdoRouter::PdoRouter() : count(0) {
+    memset(head, 0, sizeof(head));
+  }
+
+  bool PdoRouter::subscribe(uint16_t pdoid, PdoHandler handler, void *context) {
+    if (pdoid >= PDO_TABLE_SIZE || handler == nullptr || count >= MAX_ROUTES) {
+      return false;
+    }
+
+    routes[count].handler = handler;
+    routes[count].context = context;
+    routes[count].next = 0;
+    count++;
+
+    // Append to the end of this PDOID's chain to keep subscription order
+    if (head[pdoid] == 0) {
+      head[pdoid] = count;
+    } else {
+      uint8_t r = head[pdoid];
+      while (routes[r - 1].next != 0) {
+        r = routes[r - 1].next;
+      }
+      routes[r - 1].next = count;
+    }
+    return true;
+  }
+
+  bool PdoRouter::dispatch(const PdoValue &value) const {
+    if (value.pdoid >= PDO_TABLE_SIZE) return false;
+
+    uint8_t r = head[value.pdoid];
+    if (r == 0) return false;
+
+    do {
+      const Route &route = routes[r - 1];
+      route.handler(route.context, value);
+      r = route.next;
+    } while (r != 0);
+    return true;
+  }
+}
@@ -0,0 +1,52 @@
+#ifndef PDO_ROUTER_H
+#define PDO_ROUTER_H
+
+#include <cstdint>
+#include "pdo_table.h"
+
+// ============================================================================
+// PDO ROUTER - PDOID-indexed handler dispatch
+// ============================================================================
+// Managers subscribe a handler to the PDOIDs they care about. dispatch() is
+// one array lookup: PDOIDs without a subscriber return immediately, the rest
+// walk a short linked list of routes (normally a single entry).
+// Handlers are plain function pointers + context, so there is no heap use.
+// ============================================================================
+
+namespace comfoair {
+
+  typedef void (*PdoHandler)(void *context, const PdoValue &value);
+
+  class PdoRouter {
+    public:
+      static const uint8_t MAX_ROUTES = 32;
+
+      PdoRouter();
+
+      // Handlers for the same PDOID are called in subscription order.
+      // Returns false if the PDOID is out of range or the route table is full.
+      bool subscribe(uint16_t pdoid, PdoHandler handler, void *context);
+
+      // Returns false if nobody subscribed to value.pdoid
+      bool dispatch(const PdoValue &value) const;
+
+      bool isHandled(uint16_t pdoid) const {
+        return pdoid < PDO_TABLE_SIZE && head[pdoid] != 0;
+      }
+
+      uint8_t routeCount() const { return count; }
+
+    private:
+      struct Route {
+        PdoHandler handler;
+        void *context;
+        uint8_t next;         // 1-based index of the next route, 0 = end
+      };
+
+      uint8_t head[PDO_TABLE_SIZE];  // 1-based index of the first route, 0 = unhandled
+      Route routes[MAX_ROUTES];
+      uint8_t count;
+  };
+}
+
+#endif
@@ -0,0 +1,270 @@
+#ifndef PDO_TABLE_H
+#define PDO_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include "CanAddress.h"   // pdoidFromCanId()
+
+// ============================================================================
+// PDO DESCRIPTOR TABLE
+// ============================================================================
+// One constexpr entry per PDOID we decode. ComfoMessage::decode() looks the
+// PDOID up in PDO_INDEX (a direct-indexed array) and runs one generic typed
+// extractor, so adding a PDO from the comfoconnect list is a one-line change
+// in pdo_spec.json - no new code path. The descriptors, the MQTT topics
+// (pdo_topics_gen.h) and docs/haconfig/mqtt.yaml are generated from it by
+// tools/gen_pdo_tables.py before every PlatformIO build.
+//
+// For documentation on PDOID's see:
+// https://github.com/michaelarnauts/comfoconnect/blob/master/PROTOCOL-PDO.md
+// ============================================================================
+
+namespace comfoair {
+
+  enum class PdoType : uint8_t {
+    U8,
+    U16,
+    I16,
+    U32
+  };
+
+  constexpr uint8_t pdoTypeSize(PdoType type) {
+    return type == PdoType::U8 ? 1 : (type == PdoType::U32 ? 4 : 2);
+  }
+
+  // Little-endian wire value; U32 is stored bit-for-bit in the int32_t
+  constexpr int32_t pdoExtractRaw(PdoType type, const uint8_t *vals) {
+    return type == PdoType::U8  ? vals[0]
+         : type == PdoType::U16 ? vals[0] | (vals[1] << 8)
+         : type == PdoType::I16 ? (int16_t)(vals[0] | (vals[1] << 8))
+         : (int32_t)(vals[0] | (vals[1] << 8) | (vals[2] << 16) | ((uint32_t)vals[3] << 24));
+  }
+
+  // Enum mapping: raw byte -> label. Values not listed map to 'fallback'.
+  struct PdoEnumEntry {
+    uint8_t raw;
+    const char *label;
+  };
+
+  struct PdoEnumMap {
+    const PdoEnumEntry *entries;
+    uint8_t count;
+    const char *fallback;
+  };
+
+  // Manager that consumes a PDO (remote client mode subscribes these)
+  enum class PdoRoute : uint8_t {
+    NONE,
+    SENSOR_DATA,
+    FILTER_DATA,
+    CONTROL,
+    TIME,
+    ERROR_DATA
+  };
+
+  struct PdoDescriptor {
+    uint16_t pdoid;
+    const char *name;
+    PdoType type;
+    uint8_t decimals;         // value = raw / 10^decimals
+    const PdoEnumMap *enumMap; // nullptr for plain numbers
+    uint8_t minLength;        // shorter frames (e.g. empty RTR ACKs) are ignored
+    bool rtr;                 // answers RTRs, polled by PdoPoller
+    PdoRoute route;
+  };
+}
+
+// PdoId symbols, enum maps, PDO_DESCRIPTORS and PDO_POLLED, generated from
+// pdo_spec.json by tools/gen_pdo_tables.py
+#include "pdo_table_gen.h"
+
+namespace comfoair {
+
+  constexpr uint16_t PDO_DESCRIPTOR_COUNT = sizeof(PDO_DESCRIPTORS) / sizeof(PDO_DESCRIPTORS[0]);
+
+  // One slot per 11-bit PDOID (CAN ID [24:14]), so every documented PDO -
+  // ComfoCool sits at 784+ - can be described. PDO_INDEX is 2 KB of flash;
+  // the PDOID-indexed arrays of PdoRouter and BusStats 2 KB of RAM each.
+  constexpr uint16_t PDO_TABLE_SIZE = 2048;
+  static_assert(pdoidFromCanId(0xFFFFFFFF) == PDO_TABLE_SIZE - 1, "one slot per PDOID");
+
+  // --------------------------------------------------------------------------
+  // Direct-indexed lookup: PDO_INDEX[pdoid] = descriptor position + 1 (0 = none)
+  // --------------------------------------------------------------------------
+  struct PdoIndex {
+    uint8_t slot[PDO_TABLE_SIZE];
+  };
+
+  constexpr PdoIndex buildPdoIndex() {
+    PdoIndex index = {};
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+      index.slot[PDO_DESCRIPTORS[i].pdoid] = i + 1;
+    }
+    return index;
+  }
+
+  inline constexpr PdoIndex PDO_INDEX = buildPdoIndex();
+
+  static_assert(PDO_DESCRIPTOR_COUNT < 255, "PDO_INDEX uses uint8_t slots");
+
+  constexpr const PdoDescriptor *findPdo(uint16_t pdoid) {
+    return (pdoid < PDO_TABLE_SIZE && PDO_INDEX.slot[pdoid] != 0)
+      ? &PDO_DESCRIPTORS[PDO_INDEX.slot[pdoid] - 1]
+      : nullptr;
+  }
+
+  // CAN ID on which the MVHR answers a device time request (not a PDO).
+  // It is decoded with the descriptor of PDOID 1 (device_time).
+  constexpr uint32_t CAN_ID_TIME_RESPONSE = 0x10040001;
+
+  // Frames that carry a value: PDO data frames and the time response. Not
+  // RTRs (poll requests, their data bytes are junk) and not foreign IDs,
+  // which pdoidFromCanId() would still turn into some PDOID.
+  constexpr bool isPdoValueFrame(uint32_t canId, bool rtr) {
+    return !rtr && (isPdoCanId(canId) || canId == CAN_ID_TIME_RESPONSE);
+  }
+
+  constexpr uint8_t PDO_NO_ORDINAL = 0xFF;
+
+  // Typed result of ComfoMessage::decode(). Consumers read the numbers
+  // directly; text is only rendered at the edges (MQTT, logs) via format().
+  struct PdoValue {
+    uint16_t pdoid;             // channel id (time response is reported as PDOID 1)
+    int32_t raw;                // wire value, U32 stored bit-for-bit
+    uint8_t decimals;           // fixed-point scale: value = raw / 10^decimals
+    uint8_t ordinal;            // enum ordinal (fallback = entry count), PDO_NO_ORDINAL otherwise
+    const PdoDescriptor *desc;
+    uint32_t rxUs;              // CAN_FRAME::timestamp_us of the source frame
+    uint32_t decodeUs;          // stamped by the decoding stage, 0 = not stamped
+
+    const char *name() const { return desc->name; }
+    uint32_t toUnsigned() const { return (uint32_t)raw; }
+    float toFloat() const {
+      static const float SCALE[] = { 1.0f, 10.0f, 100.0f, 1000.0f };
+      return raw / SCALE[decimals];
+    }
+  };
+
+  // Entry index of raw in the enum map, map->count if it is the fallback
+  constexpr uint8_t pdoEnumOrdinal(const PdoEnumMap *map, int32_t raw) {
+    for (uint8_t i = 0; i < map->count; i++) {
+      if (map->entries[i].raw == raw) return i;
+    }
+    return map->count;
+  }
+
+  // Table-driven decode of one PDO payload. False for PDOIDs not in the
+  // table and payloads shorter than the type (empty RTR answers).
+  inline bool pdoDecode(uint16_t pdoid, const uint8_t *data, uint8_t length, PdoValue &value) {
+    const PdoDescriptor *desc = findPdo(pdoid);
+    if (!desc || length < desc->minLength) {
+      return false;
+    }
+    value.pdoid = pdoid;
+    value.raw = pdoExtractRaw(desc->type, data);
+    value.decimals = desc->decimals;
+    value.ordinal = desc->enumMap ? pdoEnumOrdinal(desc->enumMap, value.raw) : PDO_NO_ORDINAL;
+    value.desc = desc;
+    value.rxUs = 0;
+    value.decodeUs = 0;
+    return true;
+  }
+
+  // Decode a received frame by CAN ID: PDOs, and the time response as
+  // device_time (PDOID 1). This is ComfoMessage::decode() without the driver.
+  inline bool pdoDecodeFrame(uint32_t canId, const uint8_t *data, uint8_t length, PdoValue &value) {
+    if (!isPdoValueFrame(canId, false)) return false;
+    uint16_t pdoid = canId == CAN_ID_TIME_RESPONSE ? (uint16_t)PDO_DEVICE_TIME : pdoidFromCanId(canId);
+    return pdoDecode(pdoid, data, length, value);
+  }
+
+  // Buffer for pdoFormat(): the longest enum label or "-2147483.648"
+  constexpr size_t PDO_TEXT_SIZE = 24;
+
+  // Text form published to MQTT: enum label, or the scaled number
+  inline size_t pdoFormat(const PdoValue &value, char *buf, size_t len) {
+    const PdoDescriptor *desc = value.desc;
+    int n;
+    if (desc->enumMap) {
+      const PdoEnumMap *map = desc->enumMap;
+      n = snprintf(buf, len, "%s", value.ordinal < map->count ? map->entries[value.ordinal].label : map->fallback);
+    } else if (desc->type == PdoType::U32) {
+      n = snprintf(buf, len, "%u", (unsigned)value.toUnsigned());
+    } else if (value.decimals == 0) {
+      n = snprintf(buf, len, "%d", (int)value.raw);
+    } else {
+      int width = value.decimals == 1 ? 1 : (value.decimals == 2 ? 2 : 3);
+      uint32_t div = width == 1 ? 10 : (width == 2 ? 100 : 1000);
+      uint32_t mag = value.raw < 0 ? -value.raw : value.raw;
+      n = snprintf(buf, len, "%s%u.%0*u", value.raw < 0 ? "-" : "", (unsigned)(mag / div), width,
+                   (unsigned)(mag % div));
+    }
+    return n < 0 ? 0 : (size_t)n;
+  }
+
+  // True if the len bytes at text are exactly label
+  inline bool pdoLabelIs(const char *label, const char *text, size_t len) {
+    return strlen(label) == len && memcmp(label, text, len) == 0;
+  }
+
+  // Inverse of pdoFormat(): a published payload (not 0-terminated) back to
+  // a value, for remote clients fed from MQTT. Enum PDOs accept their labels
+  // and the fallback only; numbers are rounded down to the descriptor's
+  // decimals.
+  inline bool pdoParse(uint16_t pdoid, const char *text, size_t len, PdoValue &value) {
+    const PdoDescriptor *desc = findPdo(pdoid);
+    if (!desc || len == 0) return false;
+    value.pdoid = pdoid;
+    value.decimals = desc->decimals;
+    value.ordinal = PDO_NO_ORDINAL;
+    value.desc = desc;
+    value.rxUs = 0;
+    value.decodeUs = 0;
+
+    if (desc->enumMap) {
+      const PdoEnumMap *map = desc->enumMap;
+      for (uint8_t i = 0; i < map->count; i++) {
+        if (pdoLabelIs(map->entries[i].label, text, len)) {
+          value.raw = map->entries[i].raw;
+          value.ordinal = i;
+          return true;
+        }
+      }
+      if (!pdoLabelIs(map->fallback, text, len)) return false;
+      // First raw byte that is not listed
+      int32_t raw = 0;
+      while (pdoEnumOrdinal(map, raw) != map->count) raw++;
+      value.raw = raw;
+      value.ordinal = map->count;
+      return true;
+    }
+
+    size_t i = 0;
+    bool negative = text[0] == '-';
+    if (negative) i++;
+    uint32_t mag = 0;
+    uint8_t digits = 0;
+    uint8_t fraction = 0;
+    bool point = false;
+    for (; i < len; i++) {
+      if (text[i] == '.' && !point) {
+        point = true;
+      } else if (text[i] >= '0' && text[i] <= '9') {
+        if (point && fraction == desc->decimals) continue;
+        mag = mag * 10 + (text[i] - '0');
+        digits++;
+        if (point) fraction++;
+      } else {
+        return false;
+      }
+    }
+    if (digits == 0) return false;
+    for (; fraction < desc->decimals; fraction++) mag *= 10;
+    value.raw = negative ? -(int32_t)mag : (int32_t)mag;
+    return true;
+  }
+}
+
+#endif
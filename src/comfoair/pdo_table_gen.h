@@ -0,0 +1,199 @@
+#ifndef PDO_TABLE_GEN_H
+#define PDO_TABLE_GEN_H
+
+// GENERATED by tools/gen_pdo_tables.py from pdo_spec.json - do not edit
+// Included by pdo_table.h after the descriptor types.
+
+namespace comfoair {
+
+  // PDOIDs as symbols, one per descriptor
+  enum PdoId : uint16_t {
+    PDO_DEVICE_TIME                   = 1,
+    PDO_AWAY_INDICATOR                = 16,
+    PDO_CURRENT_RMOT                  = 37,
+    PDO_OPERATING_MODE                = 49,
+    PDO_FROST_PROTECTION_UNBALANCE    = 56,
+    PDO_FAN_SPEED                     = 65,
+    PDO_BYPASS_ACTIVATION_MODE        = 66,
+    PDO_TEMP_PROFILE                  = 67,
+    PDO_NEXT_FAN_CHANGE               = 81,
+    PDO_NEXT_BYPASS_CHANGE            = 82,
+    PDO_NEXT_SUPPLY_FAN_CHANGE        = 86,
+    PDO_NEXT_EXHAUST_FAN_CHANGE       = 87,
+    PDO_EXHAUST_FAN_DUTY              = 117,
+    PDO_SUPPLY_FAN_DUTY               = 118,
+    PDO_EXHAUST_FAN_FLOW              = 119,
+    PDO_SUPPLY_FAN_FLOW               = 120,
+    PDO_EXHAUST_FAN_SPEED             = 121,
+    PDO_SUPPLY_FAN_SPEED              = 122,
+    PDO_POWER_CONSUMPTION_CURRENT     = 128,
+    PDO_POWER_CONSUMPTION_YTD         = 129,
+    PDO_POWER_CONSUMPTION_SINCE_START = 130,
+    PDO_PREHEATER_ENERGY_YTD          = 144,
+    PDO_PREHEATER_ENERGY_SINCE_START  = 145,
+    PDO_PREHEATER_POWER_CURRENT       = 146,
+    PDO_RF_PAIRING                    = 176,
+    PDO_FILTER_DAYS                   = 192,
+    PDO_RMOT                          = 209,
+    PDO_HEATING_SEASON                = 210,
+    PDO_COOLING_SEASON                = 211,
+    PDO_TARGET_TEMP                   = 212,
+    PDO_AH_ACTUAL                     = 213,
+    PDO_AH_YTD                        = 214,
+    PDO_AH_TOTAL                      = 215,
+    PDO_AC_ACTUAL                     = 216,
+    PDO_AC_YTD                        = 217,
+    PDO_AC_TOTAL                      = 218,
+    PDO_PRE_HEATER_TEMP_BEFORE        = 220,
+    PDO_POST_HEATER_TEMP_AFTER        = 221,
+    PDO_COMFORT_CONTROL_MODE          = 225,
+    PDO_BYPASS_STATE                  = 227,
+    PDO_EXTRACT_AIR_TEMP              = 274,
+    PDO_EXHAUST_AIR_TEMP              = 275,
+    PDO_OUTDOOR_AIR_TEMP              = 276,
+    PDO_PRE_HEATER_TEMP_AFTER         = 277,
+    PDO_POST_HEATER_TEMP_BEFORE       = 278,
+    PDO_EXTRACT_AIR_HUMIDITY          = 290,
+    PDO_EXHAUST_AIR_HUMIDITY          = 291,
+    PDO_OUTDOOR_AIR_HUMIDITY          = 292,
+    PDO_PRE_HEATER_HUMIDITY_AFTER     = 293,
+    PDO_SUPPLY_AIR_HUMIDITY           = 294,
+    PDO_ERROR_OVERHEATING             = 321,
+    PDO_ERROR_TEMP_SENSOR_P_ODA       = 322,
+    PDO_ERROR_PREHEAT_LOCATION        = 323,
+    PDO_ERROR_EXT_PRESSURE_EHA        = 324,
+    PDO_ERROR_EXT_PRESSURE_SUP        = 325,
+    PDO_ERROR_TEMPCONTROL_P_ODA       = 326,
+    PDO_ERROR_TEMPCONTROL_SUP         = 327,
+    PDO_ALARM_FILTER                  = 328,
+    PDO_WARNING_SYSTEM                = 329,
+    PDO_ANALOG_INPUT_1                = 369,
+    PDO_ANALOG_INPUT_2                = 370,
+    PDO_ANALOG_INPUT_3                = 371,
+    PDO_ANALOG_INPUT_4                = 372,
+    PDO_COMFOFOND_OUTDOOR_AIR_TEMP    = 416,
+    PDO_COMFOFOND_GROUND_TEMP         = 417,
+    PDO_COMFOFOND_GHE_STATE           = 418,
+    PDO_COMFOFOND_GHE_PRESENT         = 419,
+    PDO_COMFOCOOL_STATE               = 784,
+    PDO_COMFOCOOL_COMPRESSOR_STATE    = 785,
+    PDO_COMFOCOOL_CONDENSER_TEMP      = 802
+  };
+
+  // --------------------------------------------------------------------------
+  // Enum mappings
+  // --------------------------------------------------------------------------
+  inline constexpr PdoEnumEntry ENUM_AWAY_ENTRIES[] = { {0x07, "true"} };
+  inline constexpr PdoEnumMap ENUM_AWAY = { ENUM_AWAY_ENTRIES, 1, "false" };
+
+  // 01 = limited_manual, FF = auto, 05 = unlimited_manual
+  inline constexpr PdoEnumEntry ENUM_OPERATING_MODE_ENTRIES[] = { {0x01, "limited_manual"}, {0xFF, "auto"} };
+  inline constexpr PdoEnumMap ENUM_OPERATING_MODE = { ENUM_OPERATING_MODE_ENTRIES, 2, "unlimited_manual" };
+
+  // 0 auto, 1 activated, 2 deactivated
+  inline constexpr PdoEnumEntry ENUM_BYPASS_MODE_ENTRIES[] = { {0x00, "auto"}, {0x01, "activated"} };
+  inline constexpr PdoEnumMap ENUM_BYPASS_MODE = { ENUM_BYPASS_MODE_ENTRIES, 2, "deactivated" };
+
+  // 0 auto, 1 cold, 2 warm
+  inline constexpr PdoEnumEntry ENUM_TEMP_PROFILE_ENTRIES[] = { {0x00, "auto"}, {0x01, "cold"} };
+  inline constexpr PdoEnumMap ENUM_TEMP_PROFILE = { ENUM_TEMP_PROFILE_ENTRIES, 2, "warm" };
+
+  inline constexpr PdoEnumEntry ENUM_SEASON_ENTRIES[] = { {0x00, "inactive"} };
+  inline constexpr PdoEnumMap ENUM_SEASON = { ENUM_SEASON_ENTRIES, 1, "active" };
+
+  inline constexpr PdoEnumEntry ENUM_ERROR_ENTRIES[] = { {0x00, "clear"} };
+  inline constexpr PdoEnumMap ENUM_ERROR = { ENUM_ERROR_ENTRIES, 1, "ACTIVE" };
+
+  inline constexpr PdoEnumEntry ENUM_FILTER_ALARM_ENTRIES[] = { {0x00, "ok"} };
+  inline constexpr PdoEnumMap ENUM_FILTER_ALARM = { ENUM_FILTER_ALARM_ENTRIES, 1, "REPLACE" };
+
+  inline constexpr PdoEnumEntry ENUM_WARNING_ENTRIES[] = { {0x00, "ok"} };
+  inline constexpr PdoEnumMap ENUM_WARNING = { ENUM_WARNING_ENTRIES, 1, "WARNING" };
+
+  // --------------------------------------------------------------------------
+  // Descriptors (order is irrelevant, PDO_INDEX is built from the pdoid field)
+  // --------------------------------------------------------------------------
+  #define PDO(id, name, type, decimals, enumMap, rtr, route) \
+    PdoDescriptor{ id, name, PdoType::type, decimals, enumMap, pdoTypeSize(PdoType::type), rtr, PdoRoute::route }
+
+  inline constexpr PdoDescriptor PDO_DESCRIPTORS[] = {
+    PDO(1,   "device_time",                       U32, 0, nullptr,              false, TIME),  // s, seconds since 2000-01-01
+    PDO(16,  "away_indicator",                    U8,  0, &ENUM_AWAY,           false, NONE),
+    PDO(37,  "current_rmot",                      U8,  0, nullptr,              false, NONE),
+    PDO(49,  "operating_mode",                    U8,  0, &ENUM_OPERATING_MODE, true,  NONE),
+    PDO(56,  "frost_protection_unbalance",        U8,  0, nullptr,              false, NONE),
+    PDO(65,  "fan_speed",                         U8,  0, nullptr,              false, CONTROL),
+    PDO(66,  "bypass_activation_mode",            U8,  0, &ENUM_BYPASS_MODE,    true,  NONE),
+    PDO(67,  "temp_profile",                      U8,  0, &ENUM_TEMP_PROFILE,   false, CONTROL),
+    PDO(81,  "next_fan_change",                   U32, 0, nullptr,              false, NONE),  // s
+    PDO(82,  "next_bypass_change",                U32, 0, nullptr,              false, NONE),  // s
+    PDO(86,  "next_supply_fan_change",            U32, 0, nullptr,              false, NONE),  // s
+    PDO(87,  "next_exhaust_fan_change",           U32, 0, nullptr,              false, NONE),  // s
+    PDO(117, "exhaust_fan_duty",                  U8,  0, nullptr,              false, NONE),  // %
+    PDO(118, "supply_fan_duty",                   U8,  0, nullptr,              false, NONE),  // %
+    PDO(119, "exhaust_fan_flow",                  U16, 0, nullptr,              false, NONE),  // m3/h
+    PDO(120, "supply_fan_flow",                   U16, 0, nullptr,              false, NONE),  // m3/h
+    PDO(121, "exhaust_fan_speed",                 U16, 0, nullptr,              false, NONE),  // rpm
+    PDO(122, "supply_fan_speed",                  U16, 0, nullptr,              false, NONE),  // rpm
+    PDO(128, "power_consumption_current",         U16, 0, nullptr,              false, NONE),  // W
+    PDO(129, "power_consumption_ytd",             U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(130, "power_consumption_since_start",     U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(144, "preheater_energy_ytd",              U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(145, "preheater_energy_since_start",      U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(146, "preheater_power_current",           U16, 0, nullptr,              false, NONE),  // W
+    PDO(176, "rf_pairing",                        U8,  0, nullptr,              false, NONE),
+    PDO(192, "remaining_days_filter_replacement", U16, 0, nullptr,              true,  FILTER_DATA),  // days
+    PDO(209, "rmot",                              I16, 1, nullptr,              false, NONE),  // C
+    PDO(210, "heating_season",                    U8,  0, &ENUM_SEASON,         false, NONE),
+    PDO(211, "cooling_season",                    U8,  0, &ENUM_SEASON,         false, NONE),
+    PDO(212, "target_temp",                       U16, 1, nullptr,              true,  NONE),  // C
+    PDO(213, "ah_actual",                         U16, 2, nullptr,              false, NONE),  // W
+    PDO(214, "ah_ytd",                            U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(215, "ah_total",                          U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(216, "ac_actual",                         U16, 2, nullptr,              false, NONE),  // W
+    PDO(217, "ac_ytd",                            U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(218, "ac_total",                          U16, 0, nullptr,              false, NONE),  // kWh
+    PDO(220, "pre_heater_temp_before",            I16, 1, nullptr,              false, NONE),  // C
+    PDO(221, "post_heater_temp_after",            I16, 1, nullptr,              false, NONE),  // C
+    PDO(225, "comfort_control_mode",              U8,  0, nullptr,              false, NONE),
+    PDO(227, "bypass_state",                      U8,  0, nullptr,              false, NONE),  // %
+    PDO(274, "extract_air_temp",                  I16, 1, nullptr,              false, SENSOR_DATA),  // C
+    PDO(275, "exhaust_air_temp",                  I16, 1, nullptr,              false, NONE),  // C
+    PDO(276, "outdoor_air_temp",                  I16, 1, nullptr,              false, SENSOR_DATA),  // C
+    PDO(277, "pre_heater_temp_after",             I16, 1, nullptr,              false, NONE),  // C
+    PDO(278, "post_heater_temp_before",           I16, 1, nullptr,              false, NONE),  // C
+    PDO(290, "extract_air_humidity",              U8,  0, nullptr,              false, SENSOR_DATA),  // %
+    PDO(291, "exhaust_air_humidity",              U8,  0, nullptr,              false, NONE),  // %
+    PDO(292, "outdoor_air_humidity",              U8,  0, nullptr,              false, SENSOR_DATA),  // %
+    PDO(293, "pre_heater_humidity_after",         U8,  0, nullptr,              false, NONE),  // %
+    PDO(294, "supply_air_humidity",               U8,  0, nullptr,              false, NONE),  // %
+    PDO(321, "error_overheating",                 U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // two or more sensors detecting incorrect temperature, ventilation stopped
+    PDO(322, "error_temp_sensor_p_oda",           U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // pre-conditioned outdoor air temp sensor incorrect
+    PDO(323, "error_preheat_location",            U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // pre-heater present but not in correct position
+    PDO(324, "error_ext_pressure_eha",            U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // exhaust air pressure too high
+    PDO(325, "error_ext_pressure_sup",            U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // supply air pressure too high
+    PDO(326, "error_tempcontrol_p_oda",           U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // outdoor air after pre-heater missed target too often
+    PDO(327, "error_tempcontrol_sup",             U8,  0, &ENUM_ERROR,          false, ERROR_DATA),  // supply air missed target too often
+    PDO(328, "alarm_filter",                      U8,  0, &ENUM_FILTER_ALARM,   false, ERROR_DATA),
+    PDO(329, "warning_system",                    U8,  0, &ENUM_WARNING,        false, ERROR_DATA),
+    PDO(369, "analog_input_1",                    U8,  1, nullptr,              false, NONE),  // V, 0-10 V inputs of the option box
+    PDO(370, "analog_input_2",                    U8,  1, nullptr,              false, NONE),  // V
+    PDO(371, "analog_input_3",                    U8,  1, nullptr,              false, NONE),  // V
+    PDO(372, "analog_input_4",                    U8,  1, nullptr,              false, NONE),  // V
+    PDO(416, "comfofond_outdoor_air_temp",        I16, 1, nullptr,              false, NONE),  // C, ComfoFond ground heat exchanger
+    PDO(417, "comfofond_ground_temp",             I16, 1, nullptr,              false, NONE),  // C
+    PDO(418, "comfofond_ghe_state",               U8,  0, nullptr,              false, NONE),  // %
+    PDO(419, "comfofond_ghe_present",             U8,  0, nullptr,              false, NONE),
+    PDO(784, "comfocool_state",                   U8,  0, nullptr,              false, NONE),  // ComfoCool cooling unit
+    PDO(785, "comfocool_compressor_state",        U8,  0, nullptr,              false, NONE),
+    PDO(802, "comfocool_condenser_temp",          I16, 1, nullptr,              false, NONE),  // C
+  };
+
+  #undef PDO
+
+  // PDOs marked rtr: requested by PdoPoller when missing or stale
+  inline constexpr uint16_t PDO_POLLED[] = { PDO_OPERATING_MODE, PDO_BYPASS_ACTIVATION_MODE, PDO_FILTER_DAYS, PDO_TARGET_TEMP };
+  constexpr uint8_t PDO_POLLED_COUNT = 4;
+}
+
+#endif
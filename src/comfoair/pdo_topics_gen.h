@@ -0,0 +1,97 @@
+#ifndef PDO_TOPICS_GEN_H
+#define PDO_TOPICS_GEN_H
+
+#include "pdo_table.h"
+
+// GENERATED by tools/gen_pdo_tables.py from pdo_spec.json - do not edit
+// Needs MQTT_PREFIX, include after secrets.h.
+
+#ifndef MQTT_PREFIX
+  #error "pdo_topics_gen.h needs MQTT_PREFIX (secrets.h)"
+#endif
+
+namespace comfoair {
+
+  // MQTT state topic per descriptor, same order as PDO_DESCRIPTORS
+  inline constexpr const char *PDO_TOPICS[] = {
+    MQTT_PREFIX "/device_time",
+    MQTT_PREFIX "/away_indicator",
+    MQTT_PREFIX "/current_rmot",
+    MQTT_PREFIX "/operating_mode",
+    MQTT_PREFIX "/frost_protection_unbalance",
+    MQTT_PREFIX "/fan_speed",
+    MQTT_PREFIX "/bypass_activation_mode",
+    MQTT_PREFIX "/temp_profile",
+    MQTT_PREFIX "/next_fan_change",
+    MQTT_PREFIX "/next_bypass_change",
+    MQTT_PREFIX "/next_supply_fan_change",
+    MQTT_PREFIX "/next_exhaust_fan_change",
+    MQTT_PREFIX "/exhaust_fan_duty",
+    MQTT_PREFIX "/supply_fan_duty",
+    MQTT_PREFIX "/exhaust_fan_flow",
+    MQTT_PREFIX "/supply_fan_flow",
+    MQTT_PREFIX "/exhaust_fan_speed",
+    MQTT_PREFIX "/supply_fan_speed",
+    MQTT_PREFIX "/power_consumption_current",
+    MQTT_PREFIX "/power_consumption_ytd",
+    MQTT_PREFIX "/power_consumption_since_start",
+    MQTT_PREFIX "/preheater_energy_ytd",
+    MQTT_PREFIX "/preheater_energy_since_start",
+    MQTT_PREFIX "/preheater_power_current",
+    MQTT_PREFIX "/rf_pairing",
+    MQTT_PREFIX "/remaining_days_filter_replacement",
+    MQTT_PREFIX "/rmot",
+    MQTT_PREFIX "/heating_season",
+    MQTT_PREFIX "/cooling_season",
+    MQTT_PREFIX "/target_temp",
+    MQTT_PREFIX "/ah_actual",
+    MQTT_PREFIX "/ah_ytd",
+    MQTT_PREFIX "/ah_total",
+    MQTT_PREFIX "/ac_actual",
+    MQTT_PREFIX "/ac_ytd",
+    MQTT_PREFIX "/ac_total",
+    MQTT_PREFIX "/pre_heater_temp_before",
+    MQTT_PREFIX "/post_heater_temp_after",
+    MQTT_PREFIX "/comfort_control_mode",
+    MQTT_PREFIX "/bypass_state",
+    MQTT_PREFIX "/extract_air_temp",
+    MQTT_PREFIX "/exhaust_air_temp",
+    MQTT_PREFIX "/outdoor_air_temp",
+    MQTT_PREFIX "/pre_heater_temp_after",
+    MQTT_PREFIX "/post_heater_temp_before",
+    MQTT_PREFIX "/extract_air_humidity",
+    MQTT_PREFIX "/exhaust_air_humidity",
+    MQTT_PREFIX "/outdoor_air_humidity",
+    MQTT_PREFIX "/pre_heater_humidity_after",
+    MQTT_PREFIX "/supply_air_humidity",
+    MQTT_PREFIX "/error_overheating",
+    MQTT_PREFIX "/error_temp_sensor_p_oda",
+    MQTT_PREFIX "/error_preheat_location",
+    MQTT_PREFIX "/error_ext_pressure_eha",
+    MQTT_PREFIX "/error_ext_pressure_sup",
+    MQTT_PREFIX "/error_tempcontrol_p_oda",
+    MQTT_PREFIX "/error_tempcontrol_sup",
+    MQTT_PREFIX "/alarm_filter",
+    MQTT_PREFIX "/warning_system",
+    MQTT_PREFIX "/analog_input_1",
+    MQTT_PREFIX "/analog_input_2",
+    MQTT_PREFIX "/analog_input_3",
+    MQTT_PREFIX "/analog_input_4",
+    MQTT_PREFIX "/comfofond_outdoor_air_temp",
+    MQTT_PREFIX "/comfofond_ground_temp",
+    MQTT_PREFIX "/comfofond_ghe_state",
+    MQTT_PREFIX "/comfofond_ghe_present",
+    MQTT_PREFIX "/comfocool_state",
+    MQTT_PREFIX "/comfocool_compressor_state",
+    MQTT_PREFIX "/comfocool_condenser_temp",
+  };
+
+  static_assert(sizeof(PDO_TOPICS) / sizeof(PDO_TOPICS[0]) == PDO_DESCRIPTOR_COUNT,
+                "PDO_TOPICS out of step with PDO_DESCRIPTORS");
+
+  inline const char *pdoTopic(const PdoDescriptor *desc) {
+    return PDO_TOPICS[desc - PDO_DESCRIPTORS];
+  }
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include <string.h>
+#include "raw_frame_batch.h"
+
+namespace comfoair {
+
+  RawFrameBatch::RawFrameBatch() : used(HEADER_SIZE), count(0), seq(0), baseUs(0) {
+  }
+
+  bool RawFrameBatch::append(const CAN_FRAME &frame) {
+    uint8_t dlc = frame.length > 8 ? 8 : frame.length;
+    uint8_t dataBytes = frame.rtr ? 0 : dlc;
+    if ((size_t)used + 7 + dataBytes > sizeof(buf)) return false;
+
+    if (count == 0) baseUs = frame.timestamp_us;
+    uint32_t offsetMs = (frame.timestamp_us - baseUs) / 1000;
+    if (offsetMs > 0xFFFF) return false;
+
+    uint32_t id = frame.extended ? (frame.id & 0x1FFFFFFF) | ID_EXTENDED : frame.id & 0x7FF;
+    if (frame.rtr) id |= ID_RTR;
+    uint8_t *p = buf + used;
+    p[0] = offsetMs;
+    p[1] = offsetMs >> 8;
+    for (uint8_t i = 0; i < 4; i++) p[2 + i] = id >> (8 * i);
+    p[6] = dlc;
+    memcpy(p + 7, frame.data.uint8, dataBytes);
+    used += 7 + dataBytes;
+    count++;
+    return true;
+  }
+
+  const uint8_t *RawFrameBatch::finish(size_t &length) {
+    buf[0] = VERSION;
+    buf[1] = seq;
+    buf[2] = count;
+    buf[3] = count >> 8;
+    for (uint8_t i = 0; i < 4; i++) buf[4 + i] = baseUs >> (8 * i);
+    length = used;
+    return buf;
+  }
+
+  void RawFrameBatch::reset() {
+    used = HEADER_SIZE;
+    count = 0;
+    seq++;
+  }
+
+  int RawFrameBatch::decode(const uint8_t *payload, size_t length, FrameFn fn, void *context) {
+    if (length < HEADER_SIZE || payload[0] != VERSION) return -1;
+    uint16_t frames = payload[2] | (payload[3] << 8);
+    uint32_t base = 0;
+    for (uint8_t i = 0; i < 4; i++) base |= (uint32_t)payload[4 + i] << (8 * i);
+
+    // Whole payload first: a truncated or corrupt batch dispatches nothing
+    size_t pos = HEADER_SIZE;
+    for (uint16_t n = 0; n < frames; n++) {
+      if (pos + 7 > length) return -1;
+      const uint8_t *p = payload + pos;
+      uint8_t dlc = p[6];
+      if (dlc > 8) return -1;
+      uint8_t dataBytes = (p[5] & (ID_RTR >> 24)) ? 0 : dlc;
+      pos += 7 + dataBytes;
+    }
+    if (pos != length) return -1;
+
+    pos = HEADER_SIZE;
+    for (uint16_t n = 0; n < frames; n++) {
+      const uint8_t *p = payload + pos;
+      uint32_t id = 0;
+      for (uint8_t i = 0; i < 4; i++) id |= (uint32_t)p[2 + i] << (8 * i);
+      uint8_t dlc = p[6];
+      uint8_t dataBytes = (id & ID_RTR) ? 0 : dlc;
+
+      CAN_FRAME frame;
+      memset(&frame, 0, sizeof(frame));
+      frame.extended = (id & ID_EXTENDED) != 0;
+      frame.rtr = (id & ID_RTR) != 0;
+      frame.id = id & (frame.extended ? 0x1FFFFFFF : 0x7FF);
+      frame.length = dlc;
+      memcpy(frame.data.uint8, p + 7, dataBytes);
+      frame.timestamp_us = base + (uint32_t)(p[0] | (p[1] << 8)) * 1000;
+      fn(context, frame);
+      pos += 7 + dataBytes;
+    }
+    return frames;
+  }
+}
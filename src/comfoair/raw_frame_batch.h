@@ -0,0 +1,67 @@
+#ifndef RAW_FRAME_BATCH_H
+#define RAW_FRAME_BATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+
+// ============================================================================
+// RAW FRAME BATCH - received frames packed into one binary MQTT message
+// ============================================================================
+// The headless bridge in raw mode (CAN_MQTT_RAW_MS) appends every frame
+// here instead of decoding and publishing one text value per PDO; the
+// batch goes out on <prefix>/can/raw every CAN_MQTT_RAW_MS or when full.
+// Decoding happens on the consumer (remote panel, host tools) with its
+// own tables.
+//
+// Layout (little endian):
+//   header  u8 version (1), u8 seq (+1 per batch, a gap = lost batches),
+//           u16 frame count, u32 base: timestamp_us of the first frame
+//   record  u16 ms since base, u32 id (bit 31 extended, bit 30 rtr),
+//           u8 dlc, u8[dlc] data (none for RTR frames)
+// A ComfoNet PDO frame takes 8-11 bytes.
+// ============================================================================
+
+#ifndef RAW_FRAME_BATCH_SIZE
+  #define RAW_FRAME_BATCH_SIZE 1536   // payload bytes, below MQTT_BUFFER_SIZE
+#endif
+
+namespace comfoair {
+
+  class RawFrameBatch {
+    public:
+      static const uint8_t VERSION = 1;
+      static const uint8_t HEADER_SIZE = 8;
+      static const uint8_t MAX_RECORD = 2 + 4 + 1 + 8;
+      static const uint32_t ID_EXTENDED = 0x80000000;
+      static const uint32_t ID_RTR = 0x40000000;
+
+      typedef void (*FrameFn)(void *context, const CAN_FRAME &frame);
+
+      RawFrameBatch();
+
+      // false if the frame does not fit (bytes or time span): publish first
+      bool append(const CAN_FRAME &frame);
+
+      bool empty() const { return count == 0; }
+      uint16_t frameCount() const { return count; }
+
+      // Header written, the payload to publish
+      const uint8_t *finish(size_t &length);
+      // After a publish: empty, next sequence number
+      void reset();
+
+      // Frames of a payload to fn, timestamp_us rebuilt from base + offset;
+      // the frame count, -1 (and no fn call) if malformed
+      static int decode(const uint8_t *payload, size_t length, FrameFn fn, void *context);
+
+    private:
+      uint8_t buf[RAW_FRAME_BATCH_SIZE];
+      uint16_t used;
+      uint16_t count;
+      uint8_t seq;
+      uint32_t baseUs;
+  };
+}
+
+#endif
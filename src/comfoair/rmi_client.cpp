@@ -0,0 +1,143 @@
+#include <string.h>
+#include "rmi_client.h"
+
+namespace comfoair {
+
+  RmiClient::RmiClient(const RmiTransport &transport, uint8_t localNode)
+    : transport(transport), localNode(localNode), nextSeq(0), nextId(1) {
+    memset(requests, 0, sizeof(requests));
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  RmiRequestId RmiClient::get(uint8_t node, uint8_t unit, uint8_t subunit, uint8_t property,
+                              RmiCallback callback, void *context, uint32_t timeoutMs) {
+    const uint8_t payload[] = { 0x01, unit, subunit, 0x10, property };
+    return enqueue(node, payload, sizeof(payload), callback, context, timeoutMs);
+  }
+
+  RmiRequestId RmiClient::set(uint8_t node, uint8_t unit, uint8_t subunit, uint8_t property,
+                              const uint8_t *value, uint8_t length,
+                              RmiCallback callback, void *context, uint32_t timeoutMs) {
+    if (length > MAX_VALUE_SIZE) {
+      totals.rejected++;
+      return 0;
+    }
+    uint8_t payload[4 + MAX_VALUE_SIZE] = { 0x03, unit, subunit, property };
+    memcpy(&payload[4], value, length);
+    return enqueue(node, payload, 4 + length, callback, context, timeoutMs);
+  }
+
+  RmiRequestId RmiClient::enqueue(uint8_t node, const uint8_t *payload, uint8_t length,
+                                  RmiCallback callback, void *context, uint32_t timeoutMs) {
+    for (Request &request : requests) {
+      if (request.id != 0) continue;
+
+      request.id = nextId++;
+      if (nextId == 0) nextId = 1;
+      request.sent = false;
+      request.node = node;
+      memcpy(request.payload, payload, length);
+      request.length = length;
+      request.seq = nextSeq++;
+      request.timeoutMs = timeoutMs;
+      request.callback = callback;
+      request.context = context;
+      totals.requests++;
+      return request.id;
+    }
+    totals.rejected++;
+    return 0;
+  }
+
+  void RmiClient::complete(Request &request, RmiStatus status, const uint8_t *data,
+                           uint16_t length, uint32_t nowMs) {
+    if (status == RmiStatus::OK) totals.ok++;
+    else if (status == RmiStatus::ERROR) totals.errors++;
+    else totals.timeouts++;
+
+    // get: 0x01 unit subunit 0x10 property, set: 0x03 unit subunit property
+    bool isGet = request.payload[0] == 0x01;
+    RmiResult result = {};
+    result.id = request.id;
+    result.status = status;
+    result.node = request.node;
+    result.unit = request.payload[1];
+    result.subunit = request.payload[2];
+    result.property = isGet ? request.payload[4] : request.payload[3];
+    result.data = data;
+    result.length = length;
+    result.latencyMs = nowMs - request.sentMs;
+    if (status != RmiStatus::TIMEOUT && result.latencyMs > totals.maxLatencyMs) {
+      totals.maxLatencyMs = result.latencyMs;
+    }
+
+    RmiCallback callback = request.callback;
+    void *context = request.context;
+    transport.release(transport.context, request.sequence);
+    request.id = 0;
+
+    // Last, the callback may queue a follow-up request
+    if (callback) callback(context, result);
+  }
+
+  bool RmiClient::onMessage(const RmiMessage &message, uint32_t nowMs) {
+    if (message.isRequest || message.dstNode != localNode) return false;
+
+    for (Request &request : requests) {
+      if (request.id != 0 && request.sent && request.node == message.srcNode &&
+          request.sequence == message.seq) {
+        complete(request, message.error ? RmiStatus::ERROR : RmiStatus::OK,
+                 message.data, message.length, nowMs);
+        return true;
+      }
+    }
+    totals.unmatched++;
+    return false;
+  }
+
+  void RmiClient::poll(uint32_t nowMs) {
+    for (Request &request : requests) {
+      if (request.id != 0 && request.sent && nowMs - request.sentMs >= request.timeoutMs) {
+        complete(request, RmiStatus::TIMEOUT, nullptr, 0, nowMs);
+      }
+    }
+
+    // Oldest queued request first, up to MAX_IN_FLIGHT outstanding
+    uint8_t outstanding = inFlight();
+    while (outstanding < MAX_IN_FLIGHT) {
+      Request *next = nullptr;
+      for (Request &request : requests) {
+        if (request.id != 0 && !request.sent &&
+            (!next || (int32_t)(request.seq - next->seq) < 0)) {
+          next = &request;
+        }
+      }
+      if (!next) return;
+
+      int8_t sequence = transport.send(transport.context, next->node, next->payload, next->length);
+      if (sequence < 0) return;
+
+      next->sent = true;
+      next->sequence = sequence;
+      next->sentMs = nowMs;
+      outstanding++;
+      if (outstanding > totals.maxInFlight) totals.maxInFlight = outstanding;
+    }
+  }
+
+  uint8_t RmiClient::pending() const {
+    uint8_t n = 0;
+    for (const Request &request : requests) {
+      if (request.id != 0) n++;
+    }
+    return n;
+  }
+
+  uint8_t RmiClient::inFlight() const {
+    uint8_t n = 0;
+    for (const Request &request : requests) {
+      if (request.id != 0 && request.sent) n++;
+    }
+    return n;
+  }
+}
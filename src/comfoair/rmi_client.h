@@ -0,0 +1,158 @@
+#ifndef RMI_CLIENT_H
+#define RMI_CLIENT_H
+
+#include <cstdint>
+#include "rmi_reassembler.h"
+
+// ============================================================================
+// RMI CLIENT - asynchronous property get/set on any ComfoNet node
+// ============================================================================
+// get()/set() queue a request and return at once; poll() sends queued
+// requests while fewer than MAX_IN_FLIGHT are outstanding, so a burst of
+// reads is pipelined instead of sent one by one with sleeps in between.
+//
+// Each request in flight holds one RMI sequence number (2 bits on the bus).
+// The transport reserves it until release(), so other senders (commands)
+// never reuse it; one sequence number is always left for them. Responses are
+// matched by node and sequence number, requests without a response within
+// their timeout complete with RmiStatus::TIMEOUT.
+//
+// Request payloads (ComfoConnect RMI):
+//   get: 0x01 unit subunit 0x10 property
+//   set: 0x03 unit subunit property value...
+// ============================================================================
+
+#ifndef RMI_REQUEST_TIMEOUT_MS
+  #define RMI_REQUEST_TIMEOUT_MS 1000
+#endif
+
+namespace comfoair {
+
+  // RMI units (ComfoConnect numbering)
+  enum RmiUnit : uint8_t {
+    RMI_UNIT_NODE = 0x01,
+    RMI_UNIT_COMFOBUS = 0x02,
+    RMI_UNIT_ERROR = 0x03,
+    RMI_UNIT_SCHEDULE = 0x15,
+    RMI_UNIT_VALVE = 0x16,
+    RMI_UNIT_FAN = 0x17,
+    RMI_UNIT_POWERSENSOR = 0x18,
+    RMI_UNIT_PREHEATER = 0x19,
+    RMI_UNIT_HMI = 0x1A,
+    RMI_UNIT_RFCOMMUNICATION = 0x1B,
+    RMI_UNIT_FILTER = 0x1C,
+    RMI_UNIT_TEMPHUMCONTROL = 0x1D,
+    RMI_UNIT_VENTILATIONCONFIG = 0x1E,
+    RMI_UNIT_NODECONFIGURATION = 0x20,
+    RMI_UNIT_TEMPERATURESENSOR = 0x21,
+    RMI_UNIT_HUMIDITYSENSOR = 0x22,
+    RMI_UNIT_PRESSURESENSOR = 0x23
+  };
+
+  // Properties of RMI_UNIT_NODE, subunit 1
+  enum RmiNodeProperty : uint8_t {
+    RMI_NODE_SERIAL_NUMBER = 0x04,     // string
+    RMI_NODE_FIRMWARE_VERSION = 0x06,  // uint32
+    RMI_NODE_MODEL = 0x08,             // string
+    RMI_NODE_ARTICLE = 0x0B,           // string
+    RMI_NODE_COUNTRY = 0x0D,           // string
+    RMI_NODE_NAME = 0x14               // string
+  };
+
+  enum class RmiStatus : uint8_t {
+    OK,
+    ERROR,      // node answered with the error flag, data[0] = error code
+    TIMEOUT
+  };
+
+  typedef uint16_t RmiRequestId;  // 0 = not queued
+
+  struct RmiResult {
+    RmiRequestId id;
+    RmiStatus status;
+    uint8_t node;
+    uint8_t unit;
+    uint8_t subunit;
+    uint8_t property;
+    const uint8_t *data;    // valid only during the callback
+    uint16_t length;
+    uint32_t latencyMs;
+  };
+
+  typedef void (*RmiCallback)(void *context, const RmiResult &result);
+
+  struct RmiTransport {
+    // Queue payload as one RMI request; returns the reserved sequence
+    // number, or -1 if it could not be queued (retried on the next poll)
+    int8_t (*send)(void *context, uint8_t node, const uint8_t *payload, uint8_t length);
+    void (*release)(void *context, uint8_t sequence);
+    void *context;
+  };
+
+  class RmiClient {
+    public:
+      static const uint8_t MAX_REQUESTS = 8;
+      static const uint8_t MAX_IN_FLIGHT = 3;
+      static const uint8_t MAX_VALUE_SIZE = 8;
+
+      struct Stats {
+        uint32_t requests;
+        uint32_t ok;
+        uint32_t errors;
+        uint32_t timeouts;
+        uint32_t rejected;      // request table full
+        uint32_t unmatched;     // responses nobody waited for
+        uint32_t maxLatencyMs;
+        uint8_t maxInFlight;
+      };
+
+      RmiClient(const RmiTransport &transport, uint8_t localNode);
+
+      RmiRequestId get(uint8_t node, uint8_t unit, uint8_t subunit, uint8_t property,
+                       RmiCallback callback, void *context,
+                       uint32_t timeoutMs = RMI_REQUEST_TIMEOUT_MS);
+      RmiRequestId set(uint8_t node, uint8_t unit, uint8_t subunit, uint8_t property,
+                       const uint8_t *value, uint8_t length,
+                       RmiCallback callback, void *context,
+                       uint32_t timeoutMs = RMI_REQUEST_TIMEOUT_MS);
+
+      // true if the message answered one of our requests
+      bool onMessage(const RmiMessage &message, uint32_t nowMs);
+
+      // Send queued requests, time out unanswered ones
+      void poll(uint32_t nowMs);
+
+      uint8_t pending() const;      // queued + in flight
+      uint8_t inFlight() const;
+      const Stats &stats() const { return totals; }
+
+    private:
+      struct Request {
+        RmiRequestId id;            // 0 = free slot
+        bool sent;
+        uint8_t sequence;
+        uint8_t node;
+        uint8_t payload[5 + MAX_VALUE_SIZE];
+        uint8_t length;
+        uint32_t seq;               // queue order
+        uint32_t sentMs;
+        uint32_t timeoutMs;
+        RmiCallback callback;
+        void *context;
+      };
+
+      RmiRequestId enqueue(uint8_t node, const uint8_t *payload, uint8_t length,
+                           RmiCallback callback, void *context, uint32_t timeoutMs);
+      void complete(Request &request, RmiStatus status, const uint8_t *data,
+                    uint16_t length, uint32_t nowMs);
+
+      RmiTransport transport;
+      uint8_t localNode;
+      Request requests[MAX_REQUESTS];
+      uint32_t nextSeq;
+      RmiRequestId nextId;
+      Stats totals;
+  };
+}
+
+#endif
@@ -0,0 +1,138 @@
+#include <string.h>
+#include "rmi_reassembler.h"
+
+namespace comfoair {
+
+  RmiReassembler::RmiReassembler(RmiHandler handler, void *context)
+    : handler(handler), context(context) {
+    memset(pool, 0, sizeof(pool));
+    memset(&totals, 0, sizeof(totals));
+  }
+
+  RmiReassembler::Slot *RmiReassembler::find(uint8_t src, uint8_t dst, uint8_t seq) {
+    for (Slot &slot : pool) {
+      if (slot.active && slot.srcNode == src && slot.dstNode == dst && slot.seq == seq) return &slot;
+    }
+    return nullptr;
+  }
+
+  RmiReassembler::Slot *RmiReassembler::allocate(const CAN_FRAME &frame, uint32_t nowMs) {
+    for (Slot &slot : pool) {
+      if (slot.active) continue;
+
+      slot.active = true;
+      slot.srcNode = rmiSrcNode(frame.id);
+      slot.dstNode = rmiDstNode(frame.id);
+      slot.seq = rmiSeq(frame.id);
+      slot.error = rmiError(frame.id);
+      slot.isRequest = rmiIsRequest(frame.id);
+      slot.lastIndex = 0xFF;
+      slot.highestIndex = 0;
+      slot.length = 0;
+      slot.received = 0;
+      slot.lastMs = nowMs;
+
+      uint8_t used = inUse();
+      if (used > totals.poolHighWater) totals.poolHighWater = used;
+      return &slot;
+    }
+    totals.poolExhausted++;
+    return nullptr;
+  }
+
+  void RmiReassembler::deliver(Slot &slot) {
+    RmiMessage message = { slot.srcNode, slot.dstNode, slot.seq, slot.error, slot.isRequest,
+                           slot.data, slot.length };
+    totals.messages++;
+    totals.multiFrame++;
+    if (handler) handler(context, message);
+    slot.active = false;
+  }
+
+  bool RmiReassembler::accept(const CAN_FRAME &frame, uint32_t nowMs) {
+    if (!frame.extended || frame.rtr || !isRmiCanId(frame.id)) return false;
+
+    if (!rmiMultiMsg(frame.id)) {
+      RmiMessage message = { rmiSrcNode(frame.id), rmiDstNode(frame.id), rmiSeq(frame.id),
+                             rmiError(frame.id), rmiIsRequest(frame.id),
+                             frame.data.uint8, frame.length };
+      totals.messages++;
+      if (handler) handler(context, message);
+      return true;
+    }
+
+    if (frame.length < 1) {
+      totals.oversize++;
+      return true;
+    }
+    uint8_t index = frame.data.uint8[0] & 0x7F;
+    bool last = frame.data.uint8[0] & 0x80;
+    uint8_t len = frame.length - 1;
+    const uint8_t *payload = &frame.data.uint8[1];
+
+    Slot *slot = find(rmiSrcNode(frame.id), rmiDstNode(frame.id), rmiSeq(frame.id));
+    if (index >= MAX_SEGMENTS || (!last && len != 7)) {
+      totals.oversize++;
+      if (slot) slot->active = false;
+      return true;
+    }
+
+    uint32_t bit = 1UL << index;
+    if (slot && (slot->received & bit)) {
+      if (memcmp(&slot->data[index * 7], payload, len) == 0) {
+        totals.duplicates++;
+        return true;
+      }
+      // Same key, different data: a new transfer (sequence numbers wrap
+      // every 4 messages) or a corrupted one - start over either way
+      totals.restarts++;
+      slot->active = false;
+      slot = nullptr;
+      if (index != 0) return true;
+    }
+
+    if (!slot) {
+      slot = allocate(frame, nowMs);
+      if (!slot) return true;
+      if (index != 0) totals.outOfOrder++;
+    } else if (index != slot->highestIndex + 1) {
+      totals.outOfOrder++;
+    }
+
+    memcpy(&slot->data[index * 7], payload, len);
+    slot->received |= bit;
+    if (index > slot->highestIndex) slot->highestIndex = index;
+    slot->lastMs = nowMs;
+    if (last) {
+      slot->lastIndex = index;
+      slot->length = index * 7 + len;
+    }
+
+    if (slot->lastIndex != 0xFF) {
+      uint32_t all = (slot->lastIndex == 31) ? 0xFFFFFFFFUL : ((1UL << (slot->lastIndex + 1)) - 1);
+      if ((slot->received & all) == all) deliver(*slot);
+    }
+    return true;
+  }
+
+  void RmiReassembler::poll(uint32_t nowMs) {
+    for (Slot &slot : pool) {
+      if (slot.active && nowMs - slot.lastMs >= RMI_REASSEMBLY_TIMEOUT_MS) {
+        slot.active = false;
+        totals.timeouts++;
+      }
+    }
+  }
+
+  uint8_t RmiReassembler::inUse() const {
+    uint8_t n = 0;
+    for (const Slot &slot : pool) {
+      if (slot.active) n++;
+    }
+    return n;
+  }
+
+  void RmiReassembler::resetStats() {
+    memset(&totals, 0, sizeof(totals));
+  }
+}
@@ -0,0 +1,118 @@
+#ifndef RMI_REASSEMBLER_H
+#define RMI_REASSEMBLER_H
+
+#include <cstdint>
+#include "can_frame.h"
+#include "CanAddress.h"
+
+// ============================================================================
+// RMI REASSEMBLER - multi-frame RMI messages from the bus
+// ============================================================================
+// RMI frames use 0x1F << 24 IDs (see CanAddress). Payloads longer than 8
+// bytes are split into segments: byte 0 is the segment index, bit 7 marks
+// the last one, bytes 1..7 carry data. This is the inverse of
+// ComfoMessage::send().
+//
+// Transfers are keyed by source node, destination node and sequence number
+// and collected in a fixed pool of buffers (no heap):
+//   - segments are placed by index, so out-of-order arrival still completes;
+//     out-of-order and duplicated segments are counted
+//   - a repeated index 0 with different data restarts the transfer
+//   - transfers without progress for RMI_REASSEMBLY_TIMEOUT_MS are dropped
+//   - complete messages go to the handler straight from the pool buffer,
+//     which is released when the handler returns
+// Single-frame RMI messages are handed over directly from the CAN frame.
+// ============================================================================
+
+#ifndef RMI_POOL_SIZE
+  #define RMI_POOL_SIZE 4
+#endif
+#ifndef RMI_REASSEMBLY_TIMEOUT_MS
+  #define RMI_REASSEMBLY_TIMEOUT_MS 1000
+#endif
+
+namespace comfoair {
+
+  // RMI CAN ID fields (CanAddress layout)
+  constexpr bool isRmiCanId(uint32_t canId) { return canIdKind(canId) == CanIdKind::RMI; }
+  constexpr uint8_t rmiSrcNode(uint32_t canId) { return CanAddress::fromCanId(canId).srcNode(); }
+  constexpr uint8_t rmiDstNode(uint32_t canId) { return CanAddress::fromCanId(canId).dstNode(); }
+  constexpr bool rmiMultiMsg(uint32_t canId) { return CanAddress::fromCanId(canId).multiMsg(); }
+  constexpr bool rmiError(uint32_t canId) { return CanAddress::fromCanId(canId).error(); }
+  constexpr bool rmiIsRequest(uint32_t canId) { return CanAddress::fromCanId(canId).request(); }
+  constexpr uint8_t rmiSeq(uint32_t canId) { return CanAddress::fromCanId(canId).seq(); }
+
+  // Responses addressed to node: counter, multimsg, error and sequence vary
+  constexpr uint32_t rmiResponseId(uint8_t dstNode) { return CanAddress(0, dstNode, 0, false, false, false, 0).canID(); }
+  constexpr uint32_t RMI_RESPONSE_DONT_CARE = (0x3UL << 17) | (1UL << 15) | (1UL << 14) | (0x3UL << 12) | 0x3F;
+
+  struct RmiMessage {
+    uint8_t srcNode;
+    uint8_t dstNode;
+    uint8_t seq;
+    bool error;
+    bool isRequest;
+    const uint8_t *data;    // valid only during the handler call
+    uint16_t length;
+  };
+
+  typedef void (*RmiHandler)(void *context, const RmiMessage &message);
+
+  class RmiReassembler {
+    public:
+      static const uint8_t POOL_SIZE = RMI_POOL_SIZE;
+      static const uint8_t MAX_SEGMENTS = 32;  // one bit each in the received map
+      static const uint16_t BUFFER_SIZE = MAX_SEGMENTS * 7;
+
+      struct Stats {
+        uint32_t messages;      // delivered, single + multi frame
+        uint32_t multiFrame;
+        uint32_t duplicates;    // identical segment seen twice, ignored
+        uint32_t outOfOrder;    // segment index other than highest so far + 1
+        uint32_t restarts;      // index 0 with new data replaced a transfer
+        uint32_t timeouts;      // incomplete transfers dropped
+        uint32_t oversize;      // index beyond MAX_SEGMENTS / malformed
+        uint32_t poolExhausted; // no free buffer for a new transfer
+        uint8_t poolHighWater;
+      };
+
+      RmiReassembler(RmiHandler handler, void *context);
+
+      // false if the frame is not an RMI frame (nothing consumed)
+      bool accept(const CAN_FRAME &frame, uint32_t nowMs);
+
+      // Drop stale transfers
+      void poll(uint32_t nowMs);
+
+      uint8_t inUse() const;
+      const Stats &stats() const { return totals; }
+      void resetStats();
+
+    private:
+      struct Slot {
+        bool active;
+        uint8_t srcNode;
+        uint8_t dstNode;
+        uint8_t seq;
+        bool error;
+        bool isRequest;
+        uint8_t lastIndex;      // 0xFF until the end segment arrived
+        uint8_t highestIndex;
+        uint16_t length;        // known once the end segment arrived
+        uint32_t received;      // bit per segment index
+        uint32_t lastMs;
+        uint8_t data[BUFFER_SIZE];
+      };
+
+      Slot *find(uint8_t src, uint8_t dst, uint8_t seq);
+      Slot *allocate(const CAN_FRAME &frame, uint32_t nowMs);
+      void deliver(Slot &slot);
+
+      RmiHandler handler;
+      void *context;
+      Slot pool[POOL_SIZE];
+      Stats totals;
+  };
+}
+
+#endif
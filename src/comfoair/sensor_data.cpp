@@ -1,4 +1,5 @@
 #include "sensor_data.h"
+#include "pdo_router.h"
 #include "../ui/GUI.h"
 #include "../board_config.h"  // For hasDisplay()
 
@@ -8,7 +9,8 @@ SensorDataManager::SensorDataManager()
     : last_display_update(0), 
       can_data_ever_received(false),
       display_update_pending(false),
-      last_can_update(0) {
+      last_can_update(0),
+      display_mark() {
     // Initialize with dummy data
     current_data.inside_temp = 23.0f;
     current_data.outside_temp = 20.5f;
@@ -40,6 +42,7 @@ void SensorDataManager::loop() {
         // This reduces from 100+/sec to 0.5/sec while still feeling responsive
         if (display_update_pending && (now - last_display_update >= 2000)) {
             updateDisplay();
+            canLatency.displayQueued(display_mark);
             display_update_pending = false;
             last_display_update = now;
             
@@ -55,6 +58,25 @@ void SensorDataManager::loop() {
     }
 }
 
+void SensorDataManager::subscribePdos(PdoRouter &router) {
+    router.subscribe(PDO_EXTRACT_AIR_TEMP, [](void *ctx, const PdoValue &value) {
+        static_cast<SensorDataManager*>(ctx)->display_mark.note(value);
+        static_cast<SensorDataManager*>(ctx)->updateInsideTemp(value.toFloat());
+    }, this);
+    router.subscribe(PDO_OUTDOOR_AIR_TEMP, [](void *ctx, const PdoValue &value) {
+        static_cast<SensorDataManager*>(ctx)->display_mark.note(value);
+        static_cast<SensorDataManager*>(ctx)->updateOutsideTemp(value.toFloat());
+    }, this);
+    router.subscribe(PDO_EXTRACT_AIR_HUMIDITY, [](void *ctx, const PdoValue &value) {
+        static_cast<SensorDataManager*>(ctx)->display_mark.note(value);
+        static_cast<SensorDataManager*>(ctx)->updateInsideHumidity(value.toFloat());
+    }, this);
+    router.subscribe(PDO_OUTDOOR_AIR_HUMIDITY, [](void *ctx, const PdoValue &value) {
+        static_cast<SensorDataManager*>(ctx)->display_mark.note(value);
+        static_cast<SensorDataManager*>(ctx)->updateOutsideHumidity(value.toFloat());
+    }, this);
+}
+
 void SensorDataManager::updateInsideTemp(float temp) {
     current_data.inside_temp = temp;
     current_data.valid = true;
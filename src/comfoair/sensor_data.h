@@ -2,9 +2,12 @@
 #define SENSOR_DATA_H
 
 #include <Arduino.h>
+#include "latency_stats.h"
 
 namespace comfoair {
 
+class PdoRouter;
+
 // Sensor data structure
 struct SensorData {
     float inside_temp;      // Extract air temp (°C)
@@ -22,6 +25,9 @@ public:
     void setup();
     void loop();
     
+    // Subscribe to the CAN PDOs this manager consumes
+    void subscribePdos(PdoRouter &router);
+    
     // Update sensor values from CAN
     void updateInsideTemp(float temp);
     void updateOutsideTemp(float temp);
@@ -53,6 +59,9 @@ private:
     // Timing
     unsigned long last_display_update;
     
+    // Oldest value not shown yet, for the decode -> pixel latency
+    LatencyMark display_mark;
+    
     // OPTIMIZED: Update display every 10 seconds for sensor data (low priority)
     static const unsigned long DISPLAY_UPDATE_INTERVAL = 10000; // 10 seconds
 };
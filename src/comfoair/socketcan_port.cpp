@@ -0,0 +1,221 @@
+#if defined(__linux__)
+
+#include <errno.h>
+#include <fcntl.h>
+#include <net/if.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/can.h>
+#include <linux/can/error.h>
+#include <linux/can/raw.h>
+#include <linux/sockios.h>
+#include "socketcan_port.h"
+
+namespace comfoair {
+
+  SocketCanPort::SocketCanPort(const char *interface) :
+    interfaceName(interface),
+    fd(-1),
+    filterActive(false),
+    state(CanBusState::STOPPED),
+    lastResult(TxResult::PENDING),
+    events(0),
+    txErrorCounter(0),
+    rxErrorCounter(0),
+    txFailed(0),
+    rxOverrun(0),
+    busErrors(0),
+    received(0),
+    swRejected(0) {
+  }
+
+  SocketCanPort::~SocketCanPort() {
+    end();
+  }
+
+  uint32_t SocketCanPort::monotonicUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000);
+  }
+
+  // The bitrate is set with ip link (see socketcan_port.h), not here
+  bool SocketCanPort::begin(uint32_t /*bitrate*/, const CanIdFilter *wanted) {
+    end();
+
+    fd = socket(PF_CAN, SOCK_RAW, CAN_RAW);
+    if (fd < 0) {
+      fprintf(stderr, "SocketCAN: socket() failed: %s\n", strerror(errno));
+      return false;
+    }
+
+    struct ifreq ifr = {};
+    strncpy(ifr.ifr_name, interfaceName, IFNAMSIZ - 1);
+    if (ioctl(fd, SIOCGIFINDEX, &ifr) < 0) {
+      fprintf(stderr, "SocketCAN: no interface %s: %s\n", interfaceName, strerror(errno));
+      end();
+      return false;
+    }
+
+    can_err_mask_t errMask = CAN_ERR_BUSOFF | CAN_ERR_CRTL | CAN_ERR_RESTARTED |
+                             CAN_ERR_PROT | CAN_ERR_TX_TIMEOUT | CAN_ERR_ACK;
+    setsockopt(fd, SOL_CAN_RAW, CAN_RAW_ERR_FILTER, &errMask, sizeof(errMask));
+
+    struct sockaddr_can addr = {};
+    addr.can_family = AF_CAN;
+    addr.can_ifindex = ifr.ifr_ifindex;
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+      fprintf(stderr, "SocketCAN: bind %s failed: %s\n", interfaceName, strerror(errno));
+      end();
+      return false;
+    }
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    filterActive = wanted && !wanted->isEmpty();
+    if (filterActive) filter = *wanted;
+    state = CanBusState::RUNNING;
+    return true;
+  }
+
+  void SocketCanPort::end() {
+    if (fd >= 0) close(fd);
+    fd = -1;
+    state = CanBusState::STOPPED;
+  }
+
+  bool SocketCanPort::read(CAN_FRAME &frame) {
+    if (fd < 0) return false;
+
+    struct can_frame raw;
+    while (::read(fd, &raw, sizeof(raw)) == (ssize_t)sizeof(raw)) {
+      if (raw.can_id & CAN_ERR_FLAG) {
+        handleErrorFrame(raw.can_id & CAN_ERR_MASK, raw.data, raw.can_dlc);
+        continue;
+      }
+
+      frame.extended = (raw.can_id & CAN_EFF_FLAG) != 0;
+      frame.id = raw.can_id & (frame.extended ? CAN_EFF_MASK : CAN_SFF_MASK);
+      if (filterActive && !filter.matches(frame.id, frame.extended)) {
+        swRejected++;
+        continue;
+      }
+
+      frame.rtr = (raw.can_id & CAN_RTR_FLAG) != 0;
+      frame.length = raw.can_dlc > 8 ? 8 : raw.can_dlc;
+      memset(frame.data.uint8, 0, sizeof(frame.data.uint8));
+      memcpy(frame.data.uint8, raw.data, frame.length);
+      frame.timestamp_us = monotonicUs();
+      received++;
+      return true;
+    }
+    return false;
+  }
+
+  uint32_t SocketCanPort::rxPending() const {
+    int bytes = 0;
+    if (fd < 0 || ioctl(fd, FIONREAD, &bytes) < 0) return 0;
+    // Size of the next datagram only; enough for "anything waiting?"
+    return bytes > 0 ? 1 : 0;
+  }
+
+  bool SocketCanPort::transmit(const CAN_FRAME &frame) {
+    if (fd < 0 || state != CanBusState::RUNNING) return false;
+
+    struct can_frame raw = {};
+    raw.can_id = frame.extended ? ((frame.id & CAN_EFF_MASK) | CAN_EFF_FLAG) : (frame.id & CAN_SFF_MASK);
+    if (frame.rtr) raw.can_id |= CAN_RTR_FLAG;
+    raw.can_dlc = frame.length > 8 ? 8 : frame.length;
+    memcpy(raw.data, frame.data.uint8, raw.can_dlc);
+
+    ssize_t n = write(fd, &raw, sizeof(raw));
+    if (n == (ssize_t)sizeof(raw)) {
+      lastResult = TxResult::SUCCESS;
+      return true;
+    }
+    // ENOBUFS / EAGAIN: interface queue full, CanTxQueue tries again
+    if (errno == ENOBUFS || errno == EAGAIN) return false;
+    lastResult = TxResult::FAILED;
+    txFailed++;
+    events |= CAN_EVENT_TX_FAILED;
+    return true;
+  }
+
+  void SocketCanPort::handleErrorFrame(uint32_t canId, const uint8_t *data, uint8_t length) {
+    if (canId & CAN_ERR_BUSOFF) {
+      state = CanBusState::BUS_OFF;
+      events |= CAN_EVENT_BUS_OFF;
+    }
+    if (canId & CAN_ERR_RESTARTED) {
+      // The kernel restarted the controller (restart-ms)
+      state = CanBusState::STOPPED;
+      events |= CAN_EVENT_BUS_RECOVERED;
+    }
+    if ((canId & CAN_ERR_CRTL) && length > 1) {
+      uint8_t ctrl = data[1];
+      if (ctrl & CAN_ERR_CRTL_RX_OVERFLOW) rxOverrun++;
+      if (ctrl & (CAN_ERR_CRTL_TX_PASSIVE | CAN_ERR_CRTL_RX_PASSIVE)) events |= CAN_EVENT_ERR_PASSIVE;
+      if (ctrl & (CAN_ERR_CRTL_TX_WARNING | CAN_ERR_CRTL_RX_WARNING)) events |= CAN_EVENT_ABOVE_ERR_WARN;
+#ifdef CAN_ERR_CRTL_ACTIVE
+      if (ctrl & CAN_ERR_CRTL_ACTIVE) events |= CAN_EVENT_ERR_ACTIVE | CAN_EVENT_BELOW_ERR_WARN;
+#endif
+    }
+    if (canId & CAN_ERR_PROT) {
+      busErrors++;
+      events |= CAN_EVENT_BUS_ERROR;
+    }
+    if (canId & (CAN_ERR_TX_TIMEOUT | CAN_ERR_ACK)) {
+      lastResult = TxResult::FAILED;
+      txFailed++;
+      events |= CAN_EVENT_TX_FAILED;
+    }
+#ifdef CAN_ERR_CNT
+    if ((canId & CAN_ERR_CNT) && length > 7) {
+      txErrorCounter = data[6];
+      rxErrorCounter = data[7];
+    }
+#endif
+  }
+
+  CanBusStatus SocketCanPort::getBusStatus() const {
+    CanBusStatus status = {};
+    status.state = state;
+    status.txErrorCounter = txErrorCounter;
+    status.rxErrorCounter = rxErrorCounter;
+    status.txFailed = txFailed;
+    status.rxOverrun = rxOverrun;
+    status.busErrors = busErrors;
+    return status;
+  }
+
+  CAN_RX_STATS SocketCanPort::getRxStats() const {
+    CAN_RX_STATS stats = {};
+    stats.received = received;
+    stats.driverOverrun = rxOverrun;
+    stats.swRejected = swRejected;
+    return stats;
+  }
+
+  uint16_t SocketCanPort::takeHealthEvents() {
+    uint16_t taken = events;
+    events = 0;
+    return taken;
+  }
+
+  bool SocketCanPort::initiateRecovery() {
+    if (state != CanBusState::BUS_OFF) return false;
+    state = CanBusState::RECOVERING;
+    return true;
+  }
+
+  bool SocketCanPort::restart() {
+    if (fd < 0 || state != CanBusState::STOPPED) return false;
+    state = CanBusState::RUNNING;
+    return true;
+  }
+}
+
+#endif // __linux__
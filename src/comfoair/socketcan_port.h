@@ -0,0 +1,74 @@
+#ifndef SOCKETCAN_PORT_H
+#define SOCKETCAN_PORT_H
+
+#if defined(__linux__)
+
+#include <cstdint>
+#include "can_port.h"
+
+// ============================================================================
+// SOCKETCAN PORT - Linux raw CAN socket (can0, vcan0, ...)
+// ============================================================================
+// For host builds: the same decode / routing / TX queue code as on the
+// device, against a virtual bus or a USB adapter:
+//   sudo ip link add dev vcan0 type vcan && sudo ip link set up vcan0
+//
+// The bitrate is set on the interface, not here:
+//   sudo ip link set can0 type can bitrate 50000 restart-ms 100
+//
+// Frames are stamped with CLOCK_MONOTONIC (us) when read. The wanted
+// filter is applied in software. Error frames are mapped to CanHealthEvent
+// bits; bus-off recovery is the kernel's (restart-ms), initiateRecovery()
+// only waits for CAN_ERR_RESTARTED. txResult() is SUCCESS once the kernel
+// took the frame - a raw socket reports no ACK per frame.
+// ============================================================================
+
+namespace comfoair {
+
+  class SocketCanPort : public CanPort {
+    public:
+      explicit SocketCanPort(const char *interface);
+      ~SocketCanPort();
+
+      const char *name() const override { return interfaceName; }
+      bool begin(uint32_t bitrate, const CanIdFilter *wanted = nullptr) override;
+      void end();
+
+      bool read(CAN_FRAME &frame) override;
+      uint32_t rxPending() const override;
+
+      bool transmit(const CAN_FRAME &frame) override;
+      TxResult txResult() override { return lastResult; }
+
+      CanBusStatus getBusStatus() const override;
+      CAN_RX_STATS getRxStats() const override;
+
+      uint16_t takeHealthEvents() override;
+      bool initiateRecovery() override;
+      bool restart() override;
+
+      static uint32_t monotonicUs();
+
+    private:
+      void handleErrorFrame(uint32_t canId, const uint8_t *data, uint8_t length);
+
+      const char *interfaceName;
+      int fd;
+      CanIdFilter filter;
+      bool filterActive;
+      CanBusState state;
+      TxResult lastResult;
+      uint16_t events;
+      uint32_t txErrorCounter;
+      uint32_t rxErrorCounter;
+      uint32_t txFailed;
+      uint32_t rxOverrun;
+      uint32_t busErrors;
+      uint32_t received;
+      uint32_t swRejected;
+  };
+}
+
+#endif // __linux__
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <cstdint>
+
+// ============================================================================
+// SPSC RING - lock-free single-producer / single-consumer queue
+// ============================================================================
+// Fixed capacity, no heap. One task may push(), one other task may pop().
+// head is only written by the producer, tail only by the consumer, so the
+// acquire/release pair on each index is all the synchronisation needed.
+// A full ring drops the new element and counts it in overflows().
+// ============================================================================
+
+namespace comfoair {
+
+  template <typename T, uint32_t N>
+  class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+    public:
+      SpscRing() : head(0), tail(0), overflowCount(0), highWaterMark(0) {}
+
+      // Producer side
+      bool push(const T &item) {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        uint32_t used = h - tail.load(std::memory_order_acquire);
+        if (used >= N) {
+          overflowCount.fetch_add(1, std::memory_order_relaxed);
+          return false;
+        }
+        slots[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+
+        if (used + 1 > highWaterMark.load(std::memory_order_relaxed)) {
+          highWaterMark.store(used + 1, std::memory_order_relaxed);
+        }
+        return true;
+      }
+
+      // Consumer side
+      bool pop(T &item) {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (t == head.load(std::memory_order_acquire)) return false;
+        item = slots[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+      }
+
+      uint32_t size() const {
+        return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire);
+      }
+      bool empty() const { return size() == 0; }
+      static constexpr uint32_t capacity() { return N; }
+
+      uint32_t overflows() const { return overflowCount.load(std::memory_order_relaxed); }
+      uint32_t highWater() const { return highWaterMark.load(std::memory_order_relaxed); }
+
+    private:
+      T slots[N];
+      std::atomic<uint32_t> head;            // next slot to write (producer)
+      std::atomic<uint32_t> tail;            // next slot to read (consumer)
+      std::atomic<uint32_t> overflowCount;   // written by producer only
+      std::atomic<uint32_t> highWaterMark;   // written by producer only
+  };
+}
+
+#endif
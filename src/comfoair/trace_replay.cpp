@@ -0,0 +1,279 @@
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace_replay.h"
+#include "loopback_port.h"
+
+namespace comfoair {
+
+  // Spacing of frames from logs without timestamps
+  static const uint32_t UNTIMED_SPACING_US = 1000;
+
+  static const char *skipSpace(const char *p) {
+    while (*p == ' ' || *p == '\t') p++;
+    return p;
+  }
+
+  static const char *skipToken(const char *p) {
+    while (*p && *p != ' ' && *p != '\t') p++;
+    return p;
+  }
+
+  static int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+  }
+
+  static bool hexByte(const char *p, uint8_t &value) {
+    int hi = hexDigit(p[0]);
+    int lo = hi < 0 ? -1 : hexDigit(p[1]);
+    if (lo < 0) return false;
+    value = (hi << 4) | lo;
+    return true;
+  }
+
+  // "sec.frac" -> microseconds; p is advanced past it
+  static bool parseTime(const char *&p, uint64_t &timeUs) {
+    if (!isdigit((unsigned char)*p)) return false;
+    uint64_t sec = 0;
+    while (isdigit((unsigned char)*p)) sec = sec * 10 + (*p++ - '0');
+    uint32_t frac = 0;
+    uint32_t scale = 1000000;
+    if (*p == '.') {
+      p++;
+      while (isdigit((unsigned char)*p)) {
+        if (scale > 1) {
+          scale /= 10;
+          frac += (*p - '0') * scale;
+        }
+        p++;
+      }
+    }
+    timeUs = sec * 1000000 + frac;
+    return true;
+  }
+
+  // Hex id, extended if longer than 3 digits; p is advanced past it
+  static bool parseId(const char *&p, CAN_FRAME &frame) {
+    const char *start = p;
+    uint32_t id = 0;
+    int digit;
+    while ((digit = hexDigit(*p)) >= 0 && p - start < 8) {
+      id = (id << 4) | digit;
+      p++;
+    }
+    if (p == start) return false;
+    frame.id = id;
+    frame.extended = (p - start > 3) || id > 0x7FF;
+    return true;
+  }
+
+  void TraceParser::reset() {
+    ascDecimal = false;
+    untimedUs = 0;
+  }
+
+  bool TraceParser::parse(const char *line, CAN_FRAME &frame, uint64_t &timeUs) {
+    memset(&frame, 0, sizeof(frame));
+    const char *p = skipSpace(line);
+
+    // ASC header: "base hex  timestamps absolute"
+    if (strncmp(p, "base ", 5) == 0) {
+      ascDecimal = strncmp(skipSpace(p + 5), "dec", 3) == 0;
+      return false;
+    }
+
+    if (*p == '(') {
+      p++;
+      if (!parseTime(p, timeUs) || *p != ')') return false;
+      p = skipSpace(skipToken(skipSpace(p + 1)));   // interface
+      return strchr(p, '#') ? parseCandumpCompact(p, frame) : parseCandump(p, frame);
+    }
+
+    if (isdigit((unsigned char)*p)) {
+      if (!parseTime(p, timeUs)) return false;
+      return parseAsc(skipSpace(p), frame);
+    }
+
+    // candump without -t: "can0  10040001   [2]  01 02"
+    if (!isalpha((unsigned char)*p)) return false;
+    p = skipSpace(skipToken(p));
+    if (!parseCandump(p, frame)) return false;
+    timeUs = untimedUs;
+    untimedUs += UNTIMED_SPACING_US;
+    return true;
+  }
+
+  // 10040001#0102, 123#R, 123#R8 (CAN FD "##" is not ours)
+  bool TraceParser::parseCandumpCompact(const char *p, CAN_FRAME &frame) {
+    if (!parseId(p, frame) || *p++ != '#') return false;
+    if (*p == 'R' || *p == 'r') {
+      frame.rtr = 1;
+      int dlc = hexDigit(p[1]);
+      frame.length = (dlc >= 0 && dlc <= 8) ? dlc : 0;
+      return true;
+    }
+    uint8_t length = 0;
+    while (length < 8) {
+      if (*p == '.') p++;
+      if (!hexByte(p, frame.data.uint8[length])) break;
+      length++;
+      p += 2;
+    }
+    frame.length = length;
+    return *p == '\0' || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+  }
+
+  // 10040001   [2]  01 02   /   123   [2]  remote request
+  bool TraceParser::parseCandump(const char *p, CAN_FRAME &frame) {
+    if (!parseId(p, frame)) return false;
+    p = skipSpace(p);
+    if (*p++ != '[' || !isdigit((unsigned char)*p)) return false;
+    uint8_t dlc = *p++ - '0';
+    if (*p++ != ']' || dlc > 8) return false;
+    frame.length = dlc;
+    p = skipSpace(p);
+    if (strncmp(p, "remote", 6) == 0) {
+      frame.rtr = 1;
+      return true;
+    }
+    for (uint8_t i = 0; i < dlc; i++) {
+      if (!hexByte(p, frame.data.uint8[i])) return false;
+      p = skipSpace(p + 2);
+    }
+    return true;
+  }
+
+  // 1  10040001x       Rx   d 2 01 02   (time already taken)
+  bool TraceParser::parseAsc(const char *p, CAN_FRAME &frame) {
+    if (!isdigit((unsigned char)*p)) return false;              // channel
+    p = skipSpace(skipToken(p));
+
+    char *end;
+    unsigned long id = strtoul(p, &end, ascDecimal ? 10 : 16);
+    if (end == p) return false;
+    frame.id = id;
+    frame.extended = (*end == 'x' || *end == 'X');
+    if (frame.extended) end++;
+    if (*end != ' ' && *end != '\t') return false;              // ErrorFrame, ...
+    p = skipSpace(end);
+
+    if (strncmp(p, "Rx", 2) != 0 && strncmp(p, "Tx", 2) != 0) return false;
+    p = skipSpace(p + 2);
+    char kind = *p;
+    if (kind != 'd' && kind != 'r') return false;
+    p = skipSpace(p + 1);
+    frame.rtr = kind == 'r';
+
+    uint8_t dlc = 0;
+    if (isdigit((unsigned char)*p)) {
+      dlc = *p - '0';
+      p = skipSpace(p + 1);
+    }
+    if (dlc > 8) return false;
+    frame.length = dlc;
+    if (frame.rtr) return true;
+    for (uint8_t i = 0; i < dlc; i++) {
+      if (ascDecimal) {
+        unsigned long b = strtoul(p, &end, 10);
+        if (end == p || b > 0xFF) return false;
+        frame.data.uint8[i] = b;
+        p = skipSpace(end);
+      } else {
+        if (!hexByte(p, frame.data.uint8[i])) return false;
+        p = skipSpace(p + 2);
+      }
+    }
+    return true;
+  }
+
+  bool TraceText::readLine(void *context, char *line, size_t len) {
+    TraceText *text = static_cast<TraceText*>(context);
+    if (text->pos >= text->length || len == 0) return false;
+    size_t n = 0;
+    while (text->pos < text->length) {
+      char c = text->data[text->pos++];
+      if (c == '\n') break;
+      if (c != '\r' && n + 1 < len) line[n++] = c;
+    }
+    line[n] = '\0';
+    return true;
+  }
+
+  bool traceToLoopback(void *context, const CAN_FRAME &frame) {
+    LoopbackPort *port = static_cast<LoopbackPort*>(context);
+    if (port->rxPending() >= LOOPBACK_RX_RING_SIZE) return false;
+    port->inject(frame);
+    return true;
+  }
+
+  TraceReplay::TraceReplay(TraceLineSource source, void *sourceContext, FrameSink sink, void *sinkContext) :
+    source(source), sourceContext(sourceContext), sink(sink), sinkContext(sinkContext),
+    hasPending(false), haveFirst(false), speedFactor(1), lastPollUs(0),
+    started(false), finished(false), totals() {}
+
+  void TraceReplay::start(uint32_t nowUs, uint16_t speed) {
+    parser.reset();
+    speedFactor = speed;
+    lastPollUs = nowUs;
+    hasPending = false;
+    haveFirst = false;
+    started = true;
+    finished = false;
+    totals = Stats();
+  }
+
+  bool TraceReplay::fetch() {
+    char line[TraceParser::MAX_LINE];
+    while (source(sourceContext, line, sizeof(line))) {
+      totals.lines++;
+      if (!parser.parse(line, pending, pendingUs)) {
+        totals.skipped++;
+        continue;
+      }
+      totals.frames++;
+      if (!haveFirst) {
+        firstUs = pendingUs;
+        haveFirst = true;
+      }
+      // Logs merged from several files can step back; keep the order
+      if (pendingUs < firstUs + totals.traceUs) pendingUs = firstUs + totals.traceUs;
+      totals.traceUs = pendingUs - firstUs;
+      hasPending = true;
+      return true;
+    }
+    return false;
+  }
+
+  uint32_t TraceReplay::poll(uint32_t nowUs, uint32_t maxFrames) {
+    if (!started || finished) return 0;
+    totals.elapsedUs += nowUs - lastPollUs;
+    lastPollUs = nowUs;
+
+    uint32_t count = 0;
+    while (count < maxFrames) {
+      if (!hasPending && !fetch()) {
+        finished = true;
+        break;
+      }
+      uint64_t dueUs = speedFactor ? (pendingUs - firstUs) / speedFactor : 0;
+      if (dueUs > totals.elapsedUs) break;
+
+      pending.timestamp_us = nowUs;
+      if (!sink(sinkContext, pending)) {
+        totals.retries++;
+        break;
+      }
+      uint64_t lateUs = totals.elapsedUs - dueUs;
+      if (speedFactor && lateUs > totals.maxLateUs) {
+        totals.maxLateUs = lateUs > UINT32_MAX ? UINT32_MAX : (uint32_t)lateUs;
+      }
+      totals.delivered++;
+      hasPending = false;
+      count++;
+    }
+    return count;
+  }
+}
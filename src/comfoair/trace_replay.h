@@ -0,0 +1,113 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <cstddef>
+#include <cstdint>
+#include "can_frame.h"
+#include "frame_fanout.h"
+
+// ============================================================================
+// TRACE REPLAY - recorded bus logs back into the receive path
+// ============================================================================
+// TraceParser reads one log line at a time:
+//   candump -L      (1700000000.123456) can0 10040001#0102  /  123#R
+//   candump -ta     (1700000000.123456)  can0  10040001   [2]  01 02
+//   candump         can0  10040001   [2]  01 02  (no time: 1 ms apart)
+//   Vector ASC      0.123456 1  10040001x       Rx   d 2 01 02
+// An id with more than 3 hex digits (candump) or an 'x' suffix (ASC) is
+// extended. Comments, headers and anything else are skipped.
+//
+// TraceReplay pulls lines from a TraceLineSource and hands the frames to a
+// FrameSink (usually LoopbackPort::inject) when they are due:
+//   speed 1   real time, gaps as recorded
+//   speed N   N x faster
+//   speed 0   as fast as the sink takes them
+// A frame the sink refuses (ring full) is offered again on the next poll().
+// Frames are stamped with the poll() clock, like the RX task does.
+// ============================================================================
+
+namespace comfoair {
+
+  // Next line without the newline into line; false at the end of the trace
+  typedef bool (*TraceLineSource)(void *context, char *line, size_t len);
+
+  class TraceParser {
+    public:
+      static const uint8_t MAX_LINE = 128;
+
+      TraceParser() { reset(); }
+      void reset();
+
+      // false for lines that carry no frame
+      bool parse(const char *line, CAN_FRAME &frame, uint64_t &timeUs);
+
+    private:
+      bool parseCandumpCompact(const char *p, CAN_FRAME &frame);
+      bool parseCandump(const char *p, CAN_FRAME &frame);
+      bool parseAsc(const char *p, CAN_FRAME &frame);
+
+      bool ascDecimal;          // "base dec" header seen
+      uint64_t untimedUs;       // next time for lines without one
+  };
+
+  // Lines of a trace held in memory (PSRAM upload on the device)
+  struct TraceText {
+    const char *data;
+    size_t length;
+    size_t pos;
+
+    static bool readLine(void *context, char *line, size_t len);
+  };
+
+  // FrameSink into a LoopbackPort (context): waits while its RX ring is
+  // full; frames its filter rejects are dropped, as on the wire
+  bool traceToLoopback(void *context, const CAN_FRAME &frame);
+
+  class TraceReplay {
+    public:
+      struct Stats {
+        uint32_t lines;
+        uint32_t frames;          // parsed
+        uint32_t delivered;       // taken by the sink
+        uint32_t skipped;         // lines without a frame
+        uint32_t retries;         // sink refused, offered again
+        uint64_t traceUs;         // trace time covered so far
+        uint64_t elapsedUs;       // replay clock since start()
+        uint32_t maxLateUs;       // worst delivery after the due time
+      };
+
+      TraceReplay(TraceLineSource source, void *sourceContext, FrameSink sink, void *sinkContext);
+
+      void start(uint32_t nowUs, uint16_t speed);
+      // Delivers due frames, at most maxFrames; returns how many
+      uint32_t poll(uint32_t nowUs, uint32_t maxFrames = UINT32_MAX);
+
+      bool running() const { return started && !finished; }
+      bool done() const { return finished; }
+      uint16_t speed() const { return speedFactor; }
+      const Stats &stats() const { return totals; }
+
+    private:
+      bool fetch();               // next frame into pending
+
+      TraceLineSource source;
+      void *sourceContext;
+      FrameSink sink;
+      void *sinkContext;
+      TraceParser parser;
+
+      CAN_FRAME pending;
+      uint64_t pendingUs;         // trace time of pending
+      bool hasPending;
+      uint64_t firstUs;           // trace time of the first frame
+      bool haveFirst;
+
+      uint16_t speedFactor;
+      uint32_t lastPollUs;
+      bool started;
+      bool finished;
+      Stats totals;
+  };
+}
+
+#endif
@@ -6,3 +6,203 @@
 
 // Global instance
 TWAIWrapper CAN0;
+
+
+// ============================================================================
+// RX TASK
+// ============================================================================
+// Blocks on the driver alerts, so it wakes as soon as a frame arrives
+// (TWAI_ALERT_RX_DATA) or a transmission completes (TX_SUCCESS / TX_FAILED).
+// Received frames are stamped with esp_timer_get_time() (the clock behind
+// micros()) and handed to loop() via the SPSC ring; TX results are counted
+// for CanTxQueue and error state alerts recorded for CanHealth.
+// ============================================================================
+
+bool TWAIWrapper::startRxTask() {
+    if (!initialized) return false;
+    if (rx_task) return true;
+    
+    BaseType_t ok = xTaskCreatePinnedToCore(rxTaskEntry, "can_rx", CAN_RX_TASK_STACK, this,
+                                            CAN_RX_TASK_PRIORITY, &rx_task, CAN_RX_TASK_CORE);
+    if (ok != pdPASS) {
+        rx_task = nullptr;
+        Serial.println("❌ TWAI: Failed to start RX task - falling back to polling");
+        return false;
+    }
+    
+    Serial.printf("✅ TWAI RX task started (core %d, ring %d frames)\n",
+                  CAN_RX_TASK_CORE, CAN_RX_RING_SIZE);
+    return true;
+}
+
+void TWAIWrapper::rxTaskEntry(void *arg) {
+    static_cast<TWAIWrapper*>(arg)->rxTaskLoop();
+}
+
+void TWAIWrapper::rxTaskLoop() {
+    twai_message_t rx_msg;
+    CAN_FRAME frame;
+    
+    for (;;) {
+        uint32_t alerts = 0;
+        twai_read_alerts(&alerts, pdMS_TO_TICKS(CAN_RX_ALERT_POLL_MS));
+        
+        // Several RX_DATA alerts may be coalesced into one - drain the queue
+        while (twai_receive(&rx_msg, 0) == ESP_OK) {
+            toFrame(rx_msg, frame);
+            if (acceptFrame(frame) && rx_ring.push(frame)) {
+                rx_received.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        processAlerts(alerts);
+    }
+}
+
+// Software post-filter: drops what the hardware filter could not express
+bool TWAIWrapper::acceptFrame(const CAN_FRAME &frame) {
+    if (!rx_filter_active) return true;
+    
+    if (!CAN_HW_FILTER_ENABLED &&
+        !comfoair::CanIdFilter::hardwareAccepts(hw_filter, frame.id, frame.extended)) {
+        rx_hw_would_reject.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (!rx_filter.matches(frame.id, frame.extended)) {
+        rx_sw_rejected.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+void TWAIWrapper::handleAlerts() {
+    uint32_t alerts;
+    if (twai_read_alerts(&alerts, 0) == ESP_OK) {
+        processAlerts(alerts);
+    }
+}
+
+// Only counts and records here (RX task context): recovery is up to
+// CanHealth on the loop() task, see takeHealthEvents()
+void TWAIWrapper::processAlerts(uint32_t alerts) {
+    if (alerts & TWAI_ALERT_TX_SUCCESS) {
+        tx_success.fetch_add(1, std::memory_order_release);
+    }
+    if (alerts & TWAI_ALERT_TX_FAILED) {
+        tx_failed.fetch_add(1, std::memory_order_release);
+    }
+    
+    const uint32_t health = TWAI_ALERT_ERR_ACTIVE | TWAI_ALERT_ERR_PASS | TWAI_ALERT_BUS_OFF |
+                            TWAI_ALERT_BUS_RECOVERED | TWAI_ALERT_ABOVE_ERR_WARN |
+                            TWAI_ALERT_BELOW_ERR_WARN | TWAI_ALERT_BUS_ERROR | TWAI_ALERT_TX_FAILED;
+    if (alerts & health) {
+        health_alerts.fetch_or(alerts & health, std::memory_order_relaxed);
+    }
+}
+
+uint16_t TWAIWrapper::takeHealthEvents() {
+    if (!rx_task) handleAlerts();  // no RX task reading alerts for us
+    
+    uint32_t alerts = health_alerts.exchange(0, std::memory_order_relaxed);
+    uint16_t events = 0;
+    if (alerts & TWAI_ALERT_ERR_ACTIVE)      events |= comfoair::CAN_EVENT_ERR_ACTIVE;
+    if (alerts & TWAI_ALERT_ERR_PASS)        events |= comfoair::CAN_EVENT_ERR_PASSIVE;
+    if (alerts & TWAI_ALERT_BUS_OFF)         events |= comfoair::CAN_EVENT_BUS_OFF;
+    if (alerts & TWAI_ALERT_BUS_RECOVERED)   events |= comfoair::CAN_EVENT_BUS_RECOVERED;
+    if (alerts & TWAI_ALERT_ABOVE_ERR_WARN)  events |= comfoair::CAN_EVENT_ABOVE_ERR_WARN;
+    if (alerts & TWAI_ALERT_BELOW_ERR_WARN)  events |= comfoair::CAN_EVENT_BELOW_ERR_WARN;
+    if (alerts & TWAI_ALERT_BUS_ERROR)       events |= comfoair::CAN_EVENT_BUS_ERROR;
+    if (alerts & TWAI_ALERT_TX_FAILED)       events |= comfoair::CAN_EVENT_TX_FAILED;
+    return events;
+}
+
+// ============================================================================
+// NON-BLOCKING TX (used by CanTxQueue)
+// ============================================================================
+// Single shot: the controller does not retransmit on its own, a lost
+// arbitration or missing ACK raises TX_FAILED and CanTxQueue retries with
+// backoff. Only one frame is in flight, so the next TX_SUCCESS / TX_FAILED
+// alert belongs to it. A frame abandoned after a timeout keeps transmit()
+// busy until its own alert is counted (see abortTransmit()).
+// ============================================================================
+
+bool TWAIWrapper::transmit(const CAN_FRAME &frame) {
+    if (!initialized) return false;
+    if (tx_abandoned) {
+        if (txResult() == comfoair::TxResult::PENDING) return false;
+        tx_abandoned = false;
+    }
+    
+    twai_message_t tx_msg = {};
+    tx_msg.identifier = frame.id;
+    tx_msg.extd = frame.extended;
+    tx_msg.rtr = frame.rtr;
+    tx_msg.ss = 1;
+    tx_msg.data_length_code = frame.length;
+    memcpy(tx_msg.data, frame.data.byte, frame.length);
+    
+    tx_success_seen = tx_success.load(std::memory_order_acquire);
+    tx_failed_seen = tx_failed.load(std::memory_order_acquire);
+    return twai_transmit(&tx_msg, 0) == ESP_OK;
+}
+
+comfoair::TxResult TWAIWrapper::txResult() {
+    if (!rx_task) handleAlerts();  // no RX task reading alerts for us
+    
+    if (tx_failed.load(std::memory_order_acquire) != tx_failed_seen) {
+        return comfoair::TxResult::FAILED;
+    }
+    if (tx_success.load(std::memory_order_acquire) != tx_success_seen) {
+        return comfoair::TxResult::SUCCESS;
+    }
+    return comfoair::TxResult::PENDING;
+}
+
+// The timed-out frame either still waits in the driver TX queue (dropped
+// here, no alert will come) or sits in the controller (one attempt left,
+// its TX_SUCCESS / TX_FAILED is still to come)
+void TWAIWrapper::abortTransmit() {
+    if (!initialized) return;
+    twai_clear_transmit_queue();
+    twai_status_info_t status;
+    tx_abandoned = twai_get_status_info(&status) == ESP_OK && status.msgs_to_tx > 0;
+}
+
+CAN_RX_STATS TWAIWrapper::getRxStats() const {
+    CAN_RX_STATS stats = {};
+    stats.received = rx_received.load(std::memory_order_relaxed);
+    stats.ringOverflows = rx_ring.overflows();
+    stats.ringHighWater = rx_ring.highWater();
+    stats.ringSize = rx_ring.capacity();
+    stats.swRejected = rx_sw_rejected.load(std::memory_order_relaxed);
+    stats.hwWouldReject = rx_hw_would_reject.load(std::memory_order_relaxed);
+    
+    twai_status_info_t status;
+    if (initialized && twai_get_status_info(&status) == ESP_OK) {
+        stats.driverPending = status.msgs_to_rx;
+        stats.driverMissed = status.rx_missed_count;
+        stats.driverOverrun = status.rx_overrun_count;
+    }
+    return stats;
+}
+
+comfoair::CanBusStatus TWAIWrapper::getBusStatus() const {
+    comfoair::CanBusStatus bus = {};
+    bus.state = comfoair::CanBusState::STOPPED;
+    
+    twai_status_info_t status;
+    if (initialized && twai_get_status_info(&status) == ESP_OK) {
+        switch (status.state) {
+            case TWAI_STATE_RUNNING:    bus.state = comfoair::CanBusState::RUNNING; break;
+            case TWAI_STATE_BUS_OFF:    bus.state = comfoair::CanBusState::BUS_OFF; break;
+            case TWAI_STATE_RECOVERING: bus.state = comfoair::CanBusState::RECOVERING; break;
+            default:                    bus.state = comfoair::CanBusState::STOPPED; break;
+        }
+        bus.txErrorCounter = status.tx_error_counter;
+        bus.rxErrorCounter = status.rx_error_counter;
+        bus.txFailed = status.tx_failed_count;
+        bus.rxMissed = status.rx_missed_count;
+        bus.rxOverrun = status.rx_overrun_count;
+        bus.arbLost = status.arb_lost_count;
+        bus.busErrors = status.bus_error_count;
+    }
+    return bus;
+}
@@ -10,38 +10,102 @@
 #define TWAI_WRAPPER_H
 
 #include <Arduino.h>
+#include <atomic>
 #include "driver/twai.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 #include "../board_config.h"  // Centralized board detection and pin config
+#include "spsc_ring.h"
+#include "can_port.h"
 
-// CAN_FRAME structure compatible with old esp32_can library
-typedef struct {
-    uint32_t id;          // CAN ID
-    uint8_t extended;     // Extended frame (1) or standard (0)
-    uint8_t rtr;          // RTR frame
-    uint8_t length;       // Data length
-    union {
-        uint8_t byte[8];
-        uint8_t uint8[8];
-        uint32_t uint32[2];
-    } data;
-} CAN_FRAME;
+// Driver RX queue (ISR -> driver) and our ring (RX task -> loop()).
+// Size both from the overflow / high-water counters in getRxStats().
+#ifndef CAN_RX_QUEUE_LEN
+  #define CAN_RX_QUEUE_LEN 32
+#endif
+#ifndef CAN_RX_RING_SIZE
+  #define CAN_RX_RING_SIZE 64     // power of two
+#endif
 
-class TWAIWrapper {
+// RX task runs on core 0 next to WiFi; Arduino loop() + LVGL own core 1
+#ifndef CAN_RX_TASK_CORE
+  #define CAN_RX_TASK_CORE 0
+#endif
+#ifndef CAN_RX_TASK_PRIORITY
+  #define CAN_RX_TASK_PRIORITY 10
+#endif
+// Install the acceptance filter computed from the wanted-frame set in
+// hardware. When false the driver accepts all frames and the filter is only
+// emulated, to measure how many frames it would have rejected.
+#ifndef CAN_HW_FILTER_ENABLED
+  #define CAN_HW_FILTER_ENABLED true
+#endif
+#define CAN_RX_TASK_STACK 3072
+#define CAN_RX_ALERT_POLL_MS 100  // max alert wait while the bus is idle
+
+
+class TWAIWrapper : public comfoair::CanPort {
 private:
     bool initialized;
     gpio_num_t tx_pin;
     gpio_num_t rx_pin;
     
+    // RX task (producer) -> read() (consumer)
+    TaskHandle_t rx_task;
+    comfoair::SpscRing<CAN_FRAME, CAN_RX_RING_SIZE> rx_ring;
+    std::atomic<uint32_t> rx_received;
+    
+    // Wanted-frame set (software post-filter) and the matching hardware filter
+    comfoair::CanIdFilter rx_filter;
+    comfoair::CanHwFilter hw_filter;
+    bool rx_filter_active;
+    std::atomic<uint32_t> rx_sw_rejected;
+    std::atomic<uint32_t> rx_hw_would_reject;
+    
+    bool acceptFrame(const CAN_FRAME &frame);
+    
+    static void rxTaskEntry(void *arg);
+    void rxTaskLoop();
+    void handleAlerts();
+    void processAlerts(uint32_t alerts);
+    
+    // TX results reported by the alerts (see transmit())
+    std::atomic<uint32_t> tx_success;
+    std::atomic<uint32_t> tx_failed;
+    uint32_t tx_success_seen;
+    uint32_t tx_failed_seen;
+    bool tx_abandoned;          // timed-out frame still in the controller
+    
+    // Error state alerts for CanHealth, collected until takeHealthEvents()
+    std::atomic<uint32_t> health_alerts;
+    
+    static void toFrame(const twai_message_t &rx_msg, CAN_FRAME &frame) {
+        frame.id = rx_msg.identifier;
+        frame.extended = rx_msg.extd;
+        frame.rtr = rx_msg.rtr;
+        frame.length = rx_msg.data_length_code;
+        memcpy(frame.data.byte, rx_msg.data, rx_msg.data_length_code);
+        frame.timestamp_us = (uint32_t)esp_timer_get_time();
+    }
+    
 public:
-    TWAIWrapper() : initialized(false), tx_pin(GPIO_NUM_NC), rx_pin(GPIO_NUM_NC) {}
+    TWAIWrapper() : initialized(false), tx_pin(GPIO_NUM_NC), rx_pin(GPIO_NUM_NC),
+                    rx_task(nullptr), rx_received(0), rx_filter_active(false),
+                    rx_sw_rejected(0), rx_hw_would_reject(0),
+                    tx_success(0), tx_failed(0), tx_success_seen(0), tx_failed_seen(0),
+                    tx_abandoned(false), health_alerts(0) {}
     
     // Get detected board type (for debugging/logging)
     BoardType getBoardType() const {
         return g_board_type;
     }
     
-    // Initialize TWAI driver using centralized board config
-    bool begin(uint32_t baudrate) {
+    const char *name() const override { return "twai"; }
+    
+    // Initialize TWAI driver using centralized board config and start the
+    // RX task. wanted = frames we consume (nullptr = accept everything)
+    bool begin(uint32_t baudrate, const comfoair::CanIdFilter *wanted = nullptr) override {
         // Get pins from centralized board config
         tx_pin = getCAN_TX();
         rx_pin = getCAN_RX();
@@ -72,8 +136,23 @@ public:
             t_config = TWAI_TIMING_CONFIG_50KBITS();
         }
         
-        // Accept all messages
+        // Accept all messages, unless we were told what we consume
         twai_filter_config_t f_config = TWAI_FILTER_CONFIG_ACCEPT_ALL();
+        rx_filter_active = (wanted != nullptr && !wanted->isEmpty());
+        if (rx_filter_active) {
+            rx_filter = *wanted;
+            hw_filter = rx_filter.computeHardware();
+            Serial.printf("🚌 CAN filter: %s, code=0x%08X mask=0x%08X (%u ID patterns)%s\n",
+                          hw_filter.singleFilter ? "single" : "dual",
+                          hw_filter.acceptanceCode, hw_filter.acceptanceMask,
+                          hw_filter.acceptedPatterns,
+                          CAN_HW_FILTER_ENABLED ? "" : " - emulated only");
+            if (CAN_HW_FILTER_ENABLED) {
+                f_config.acceptance_code = hw_filter.acceptanceCode;
+                f_config.acceptance_mask = hw_filter.acceptanceMask;
+                f_config.single_filter = hw_filter.singleFilter;
+            }
+        }
         
         // Configure TWAI with detected pins
         twai_general_config_t g_config = {
@@ -83,7 +162,7 @@ public:
             .clkout_io = (gpio_num_t)TWAI_IO_UNUSED,
             .bus_off_io = (gpio_num_t)TWAI_IO_UNUSED,
             .tx_queue_len = 32,
-            .rx_queue_len = 32,
+            .rx_queue_len = CAN_RX_QUEUE_LEN,
             .alerts_enabled = TWAI_ALERT_ALL,
             .clkout_divider = 0
         };
@@ -102,6 +181,7 @@ public:
         
         initialized = true;
         Serial.println("✅ TWAI Driver started successfully");
+        startRxTask();
         return true;
     }
     
@@ -115,42 +195,58 @@ public:
         // Filter already configured in begin()
     }
     
+    // Start the pinned RX task (done by begin()). From then on read() only
+    // pops the ring, so frame timing no longer depends on how often loop()
+    // gets to run. Without it read() polls the driver.
+    bool startRxTask();
+    
     // Read a CAN frame (convert TWAI message to CAN_FRAME)
-    // IMPROVED: Direct queue polling instead of relying solely on alerts
-    bool read(CAN_FRAME &frame) {
+    bool read(CAN_FRAME &frame) override {
         if (!initialized) return false;
         
-        // Try direct receive first (non-blocking, 0 timeout)
-        // This polls the receive queue directly regardless of alert state
-        twai_message_t rx_msg;
-        if (twai_receive(&rx_msg, 0) == ESP_OK) {
-            // Convert TWAI message to CAN_FRAME
-            frame.id = rx_msg.identifier;
-            frame.extended = rx_msg.extd;
-            frame.rtr = rx_msg.rtr;
-            frame.length = rx_msg.data_length_code;
-            memcpy(frame.data.byte, rx_msg.data, rx_msg.data_length_code);
-            return true;
+        if (rx_task) {
+            return rx_ring.pop(frame);
         }
         
-        // Check for alerts (bus errors, etc.) even if no data received
-        uint32_t alerts;
-        if (twai_read_alerts(&alerts, 0) == ESP_OK) {
-            // Handle critical alerts
-            if (alerts & TWAI_ALERT_BUS_OFF) {
-                Serial.println("E (Alert) TWAI: Alert 4096");
-                twai_initiate_recovery();
-            }
-            
-            if (alerts & TWAI_ALERT_TX_FAILED) {
-                Serial.println("E (Alert) TWAI: Alert 1024");
-            }
+        // No RX task: poll the driver queue directly (non-blocking, 0 timeout)
+        twai_message_t rx_msg;
+        while (twai_receive(&rx_msg, 0) == ESP_OK) {
+            toFrame(rx_msg, frame);
+            if (acceptFrame(frame)) return true;
         }
         
+        // Check for alerts (bus errors, etc.) even if no data received
+        handleAlerts();
         return false;
     }
     
-    // Send a CAN frame (convert CAN_FRAME to TWAI message)
+    // Frames received but not read() yet
+    uint32_t rxPending() const override {
+        return rx_ring.size();
+    }
+    
+    CAN_RX_STATS getRxStats() const override;
+    comfoair::CanBusStatus getBusStatus() const override;
+    
+    // Alerts since the last call as CanHealthEvent bits
+    uint16_t takeHealthEvents() override;
+    
+    // Driver side of CanHealth: bus-off recovery, then start again
+    bool initiateRecovery() override {
+        return initialized && twai_initiate_recovery() == ESP_OK;
+    }
+    bool restart() override {
+        tx_abandoned = false;  // twai_start() empties the TX side
+        return initialized && twai_start() == ESP_OK;
+    }
+    
+    // Queue one frame without waiting; txResult() reports its outcome
+    bool transmit(const CAN_FRAME &frame) override;
+    comfoair::TxResult txResult() override;
+    void abortTransmit() override;
+    
+    // Send a CAN frame (convert CAN_FRAME to TWAI message), blocking.
+    // Used by the self tests - runtime traffic goes through CanTxQueue.
     bool sendFrame(CAN_FRAME &frame) {
         if (!initialized) return false;
         
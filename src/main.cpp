@@ -17,6 +17,18 @@
 // Your app modules
 #include "wifi/wifi.h"
 #include "comfoair/comfoair.h"
+#include "comfoair/pdo_topics_gen.h"
+#include "comfoair/twai_wrapper.h"
+#if defined(MVHR_SIMULATOR) && MVHR_SIMULATOR
+  #include "esp_timer.h"
+  #include "comfoair/loopback_port.h"
+  #include "comfoair/mvhr_simulator.h"
+#endif
+#if defined(TRACE_REPLAY) && TRACE_REPLAY
+  #include "esp_timer.h"
+  #include "comfoair/loopback_port.h"
+  #include "comfoair/trace_replay.h"
+#endif
 #include "comfoair/sensor_data.h"
 #include "comfoair/filter_data.h"
 #include "comfoair/control_manager.h"
@@ -74,6 +86,131 @@ comfoair::ControlManager *controlMgr = nullptr;
 comfoair::ErrorDataManager *errorData = nullptr;
 comfoair::ScreenManager *screenMgr = nullptr;
 
+#if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
+  // Bridge state topics -> managers, see the MQTT data subscriptions in setup()
+  static comfoair::PdoRouter remotePdoRouter;
+  
+  // Raw frame batches from a bridge in raw mode (CAN_MQTT_RAW_MS), decoded
+  // here with our own tables; unchanged rebroadcasts are dropped as on the bus
+  static comfoair::PdoCache remoteRawCache;
+  
+  static void dispatchRawFrame(void *context, const CAN_FRAME &frame) {
+    if (frame.rtr || comfoair::canIdKind(frame.id) != comfoair::CanIdKind::PDO) return;
+    uint16_t pdoid = comfoair::pdoidFromCanId(frame.id);
+    if (!remotePdoRouter.isHandled(pdoid)) return;
+    if (!remoteRawCache.accept(pdoid, frame.data.uint8, frame.length, millis())) return;
+    comfoair::PdoValue value;
+    if (comfoair::pdoDecode(pdoid, frame.data.uint8, frame.length, value)) {
+      remotePdoRouter.dispatch(value);
+    }
+  }
+#endif
+
+#if defined(MVHR_SIMULATOR) && MVHR_SIMULATOR
+// ============================================================================
+// MVHR SIMULATOR BUILD (env:esp32s3_sim) - no CAN transceiver needed
+// ============================================================================
+// ComfoAir runs on a loopback bus against an in-process ComfoAir Q that is
+// polled from its own task; the [CAN] stats show the loop's frames/s and
+// ring overflows at MVHR_SIMULATOR_LOAD percent of 50 kbit/s.
+// ============================================================================
+#ifndef MVHR_SIMULATOR_LOAD
+  #define MVHR_SIMULATOR_LOAD 0   // 0 = realistic broadcast schedule
+#endif
+
+static uint32_t simulatorClockUs() { return (uint32_t)esp_timer_get_time(); }
+static comfoair::LoopbackBus simulatorBus(simulatorClockUs);
+static comfoair::LoopbackPort simulatorDisplayPort(simulatorBus, "loopback (simulator)");
+static comfoair::LoopbackPort simulatorMvhrPort(simulatorBus, "mvhr");
+static comfoair::MvhrSimulator simulator(simulatorMvhrPort);
+
+static void simulatorTask(void *arg) {
+  for (;;) {
+    simulator.poll(simulatorClockUs());
+    vTaskDelay(1);
+  }
+}
+#endif
+
+#if defined(TRACE_REPLAY) && TRACE_REPLAY
+// ============================================================================
+// TRACE REPLAY BUILD (env:esp32s3_replay) - no CAN transceiver needed
+// ============================================================================
+// ComfoAir runs on a loopback bus fed from a recorded candump / ASC log
+// (e.g. a /can/capture download) uploaded into PSRAM:
+//   curl -F trace=@can0.log "http://comfoesp32.local/can/replay?speed=10"
+// speed 1 = real time, N = N x, 0 = as fast as loop() drains the ring.
+// Progress on /can/replay/status, throughput in the [CAN] stats.
+// ============================================================================
+#ifndef TRACE_REPLAY_BUFFER_SIZE
+  #define TRACE_REPLAY_BUFFER_SIZE (2 * 1024 * 1024)
+#endif
+
+static uint32_t replayClockUs() { return (uint32_t)esp_timer_get_time(); }
+static comfoair::LoopbackBus replayBus(replayClockUs);
+static comfoair::LoopbackPort replayDisplayPort(replayBus, "loopback (trace replay)");
+static comfoair::LoopbackPort replayTracePort(replayBus, "trace");  // ACKs what we send
+static char *replayBuffer = nullptr;
+static comfoair::TraceText replayText = { nullptr, 0, 0 };
+static comfoair::TraceReplay traceReplay(comfoair::TraceText::readLine, &replayText,
+                                         comfoair::traceToLoopback, &replayDisplayPort);
+static bool replayTruncated = false;
+
+// Upload and replay both run in loop(), never at the same time
+static void replayUpload(void *context, size_t offset, const uint8_t *data, size_t len) {
+  if (!data) {
+    replayText.length = 0;  // a running replay ends at its next poll
+    replayTruncated = false;
+    return;
+  }
+  if (offset + len > TRACE_REPLAY_BUFFER_SIZE) {
+    replayTruncated = true;
+    len = offset < TRACE_REPLAY_BUFFER_SIZE ? TRACE_REPLAY_BUFFER_SIZE - offset : 0;
+  }
+  memcpy(replayBuffer + offset, data, len);
+  replayText.length = offset + len;
+}
+
+static size_t replayStatus(void *context, char *buf, size_t len) {
+  const comfoair::TraceReplay::Stats &stats = traceReplay.stats();
+  int n = snprintf(buf, len,
+                   "{\"running\":%s,\"done\":%s,\"speed\":%u,\"bytes\":%u,\"truncated\":%s,"
+                   "\"lines\":%u,\"frames\":%u,\"skipped\":%u,\"delivered\":%u,\"retries\":%u,"
+                   "\"trace_ms\":%u,\"elapsed_ms\":%u,\"max_late_us\":%u,\"frames_per_s\":%u}",
+                   traceReplay.running() ? "true" : "false", traceReplay.done() ? "true" : "false",
+                   traceReplay.speed(), (unsigned)replayText.length, replayTruncated ? "true" : "false",
+                   stats.lines, stats.frames, stats.skipped, stats.delivered, stats.retries,
+                   (unsigned)(stats.traceUs / 1000), (unsigned)(stats.elapsedUs / 1000), stats.maxLateUs,
+                   stats.elapsedUs ? (unsigned)(stats.delivered * 1000000ULL / stats.elapsedUs) : 0);
+  return n < 0 ? 0 : ((size_t)n < len ? n : len - 1);
+}
+
+// POST /can/replay?speed=N, the trace as a multipart file
+static size_t replayStart(void *context, char *buf, size_t len) {
+  if (replayText.length == 0) return 0;
+  char arg[8];
+  uint16_t speed = comfoair::OTA::arg("speed", arg, sizeof(arg)) ? strtoul(arg, nullptr, 10) : 1;
+  replayText.pos = 0;
+  traceReplay.start(replayClockUs(), speed);
+  Serial.printf("Trace replay: %u bytes at speed %u%s\n", (unsigned)replayText.length, speed,
+                replayTruncated ? " (truncated)" : "");
+  return replayStatus(context, buf, len);
+}
+
+static void setupTraceReplay() {
+  replayBuffer = (char *)heap_caps_malloc(TRACE_REPLAY_BUFFER_SIZE, MALLOC_CAP_SPIRAM);
+  if (!replayBuffer) {
+    Serial.println("❌ Trace replay: no PSRAM for the trace buffer");
+    return;
+  }
+  replayText.data = replayBuffer;
+  replayTracePort.begin(50000);
+  comfoair::OTA::addUpload("/can/replay", replayUpload, replayStart, nullptr);
+  comfoair::OTA::addEndpoint("/can/replay/status", replayStatus, nullptr);
+  Serial.printf("Trace replay ready, upload up to %u KB to /can/replay\n", TRACE_REPLAY_BUFFER_SIZE / 1024);
+}
+#endif
+
 // Track current IO expander GPIO output state
 // V3: maps to TCA9554 output register 0x01 (default 0x0E = backlight+LCD+touch on)
 // V4: maps to CH32V003 output register 0x03 (default 0xFF = all high)
@@ -671,7 +808,18 @@ void setup() {
   Serial.println("════════════════════════════════════════");
   
   // Create subsystem instances
-  comfo = new comfoair::ComfoAir();
+  #if defined(MVHR_SIMULATOR) && MVHR_SIMULATOR
+    comfo = new comfoair::ComfoAir(simulatorDisplayPort);
+    simulator.setLoad(MVHR_SIMULATOR_LOAD);
+    simulator.begin();
+    xTaskCreatePinnedToCore(simulatorTask, "mvhr_sim", 4096, nullptr, 5, nullptr, 0);
+    Serial.printf("MVHR simulator running, load %u%%\n", MVHR_SIMULATOR_LOAD);
+  #elif defined(TRACE_REPLAY) && TRACE_REPLAY
+    comfo = new comfoair::ComfoAir(replayDisplayPort);
+    setupTraceReplay();
+  #else
+    comfo = new comfoair::ComfoAir(CAN0);
+  #endif
   wifi = new comfoair::WiFi();
   ota = new comfoair::OTA();
   timeMgr = new comfoair::TimeManager();
@@ -726,6 +874,11 @@ void setup() {
       sensorData->setup();
       filterData->setup();
       errorData->setup();
+      // Subscribe the display managers to their CAN PDOs
+      comfo->setSensorDataManager(sensorData);
+      comfo->setFilterDataManager(filterData);
+      comfo->setErrorDataManager(errorData);
+      comfo->setControlManager(controlMgr);
       Serial.println("✅ Display-dependent managers initialized");
     } else {
       Serial.println("⚠️  Display-dependent managers skipped (headless mode)");
@@ -775,79 +928,36 @@ void setup() {
       #if defined(REMOTE_CLIENT_MODE) && REMOTE_CLIENT_MODE
         Serial.println("Setting up MQTT subscriptions for sensor data...");
         
-        // Subscribe to sensor data from bridge
-        mqtt->subscribeTo(MQTT_PREFIX "/extract_air_temp", [](char const * _1, uint8_t const * _2, int _3) {
-          if (sensorData) {
-            float temp = atof((char*)_2);
-            sensorData->updateInsideTemp(temp);
-            Serial.printf("MQTT: Inside temp = %.1f°C\n", temp);
-          }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/outdoor_air_temp", [](char const * _1, uint8_t const * _2, int _3) {
-          if (sensorData) {
-            float temp = atof((char*)_2);
-            sensorData->updateOutsideTemp(temp);
-            Serial.printf("MQTT: Outside temp = %.1f°C\n", temp);
-          }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/extract_air_humidity", [](char const * _1, uint8_t const * _2, int _3) {
-          if (sensorData) {
-            float humidity = atof((char*)_2);
-            sensorData->updateInsideHumidity(humidity);
-            Serial.printf("MQTT: Inside humidity = %.1f%%\n", humidity);
-          }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/outdoor_air_humidity", [](char const * _1, uint8_t const * _2, int _3) {
-          if (sensorData) {
-            float humidity = atof((char*)_2);
-            sensorData->updateOutsideHumidity(humidity);
-            Serial.printf("MQTT: Outside humidity = %.1f%%\n", humidity);
+        // The managers subscribe to their PDOs as on the bus; every routed
+        // PDO in pdo_spec.json is read back from the bridge's state topic
+        // and dispatched to them (NTP only, so no device time)
+        sensorData->subscribePdos(remotePdoRouter);
+        filterData->subscribePdos(remotePdoRouter);
+        controlMgr->subscribePdos(remotePdoRouter);
+        errorData->subscribePdos(remotePdoRouter);
+        for (uint16_t i = 0; i < comfoair::PDO_DESCRIPTOR_COUNT; i++) {
+          const comfoair::PdoDescriptor *desc = &comfoair::PDO_DESCRIPTORS[i];
+          if (desc->route == comfoair::PdoRoute::NONE || desc->route == comfoair::PdoRoute::TIME ||
+              !remotePdoRouter.isHandled(desc->pdoid)) {
+            continue;
           }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/remaining_days_filter_replacement", [](char const * _1, uint8_t const * _2, int _3) {
-          if (filterData) {
-            int days = atoi((char*)_2);
-            filterData->updateFilterDays(days);
-            Serial.printf("MQTT: Filter days = %d\n", days);
-          }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/fan_speed", [](char const * _1, uint8_t const * _2, int _3) {
-          if (controlMgr) {
-            int speed = atoi((char*)_2);
-            controlMgr->updateFanSpeedFromCAN(speed);
-            Serial.printf("MQTT: Fan speed = %d\n", speed);
-          }
-        });
-        
-        mqtt->subscribeTo(MQTT_PREFIX "/temp_profile", [](char const * _1, uint8_t const * _2, int _3) {
-          if (controlMgr) {
-            uint8_t profile = 0;
-            if (strcmp((char*)_2, "cold") == 0) profile = 1;
-            else if (strcmp((char*)_2, "warm") == 0) profile = 2;
-            controlMgr->updateTempProfileFromCAN(profile);
-            Serial.printf("MQTT: Temp profile = %s (%d)\n", (char*)_2, profile);
-          }
-        });
-
-        // Subscribe to error/alarm messages
-        mqtt->subscribeTo(MQTT_PREFIX "/error_overheating", [](char const * _1, uint8_t const * _2, int _3) {
-          if (errorData) {
-            bool active = (strcmp((char*)_2, "ACTIVE") == 0);
-            errorData->updateErrorOverheating(active);
-          }
-        });
+          mqtt->subscribeTo(comfoair::pdoTopic(desc), [](void *ctx, const char *_1, const uint8_t *_2, unsigned int _3) {
+            const comfoair::PdoDescriptor *desc = static_cast<const comfoair::PdoDescriptor*>(ctx);
+            comfoair::PdoValue value;
+            if (!comfoair::pdoParse(desc->pdoid, (const char*)_2, _3, value)) {
+              Serial.printf("MQTT: %s = '%.*s' not understood\n", desc->name, (int)_3, (const char*)_2);
+              return;
+            }
+            Serial.printf("MQTT: %s = %.*s\n", desc->name, (int)_3, (const char*)_2);
+            remotePdoRouter.dispatch(value);
+          }, const_cast<comfoair::PdoDescriptor*>(desc));
+        }
         
-        mqtt->subscribeTo(MQTT_PREFIX "/alarm_filter", [](char const * _1, uint8_t const * _2, int _3) {
-          if (errorData) {
-            bool active = (strcmp((char*)_2, "REPLACE") == 0 || strcmp((char*)_2, "ACTIVE") == 0);
-            errorData->updateAlarmFilter(active);
+        mqtt->subscribeTo(MQTT_PREFIX "/can/raw", [](void *ctx, const char *_1, const uint8_t *_2, unsigned int _3) {
+          if (comfoair::RawFrameBatch::decode(_2, _3, dispatchRawFrame, nullptr) < 0) {
+            Serial.printf("MQTT: raw frame batch of %u bytes not understood\n", _3);
           }
-        });
+        }, nullptr);
         
         Serial.println("MQTT sensor data subscriptions complete");
       #endif
@@ -902,7 +1012,6 @@ void setup() {
 
 void loop() {
   static unsigned long last_touch_read = 0;
-  static unsigned long last_can_process = 0;
   
   // ============================================================================
   // CONDITIONAL DISPLAY UPDATES (only on Touch LCD board — V3 or V4)
@@ -913,6 +1022,7 @@ void loop() {
     
     // ✅ PRIORITY 2: Process display refreshes (instant for button presses)
     GUI_process_display_refresh();
+    comfoair::canLatency.displayFlushed(micros());  // CAN values shown by this refresh
     
     // ✅ PRIORITY 3: Touch polling every 5ms (CRITICAL for responsiveness)
     unsigned long now = millis();
@@ -931,12 +1041,12 @@ void loop() {
   // CAN PROCESSING (only in non-remote client mode)
   // ============================================================================
   #if !defined(REMOTE_CLIENT_MODE) || !REMOTE_CLIENT_MODE
-    // ✅ PRIORITY 4: CAN processing throttled to 10ms (prevent flooding)
-    unsigned long now = millis();
-    if (now - last_can_process >= 10) {
-      if (comfo) comfo->loop();
-      last_can_process = now;
-    }
+    // ✅ PRIORITY 4: CAN processing - frames are received by the CAN RX task,
+    // comfo->loop() drains the ring with a per-call budget (no 10ms throttle)
+    #if defined(TRACE_REPLAY) && TRACE_REPLAY
+      traceReplay.poll(replayClockUs());
+    #endif
+    if (comfo) comfo->loop();
   #endif
   
   // ✅ PRIORITY 5: Manager loops (these handle batched updates)
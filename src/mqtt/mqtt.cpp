@@ -1,76 +1,92 @@
 #include <PubSubClient.h>
 #include <WiFi.h>
-#include <map>
 #include "../secrets.h"
 #include "mqtt.h"
 
 namespace comfoair {
 
 WiFiClient wifiClient;
-  MQTT::MQTT() {
+  MQTT::MQTT() : attempted(false), lastAttemptMs(0) {
     this->client = PubSubClient(wifiClient);
   }
 
-  void MQTT::subscribeTo(const char* topic, MQTT_CALLBACK_SIGNATURE) {
-    this->callbackMap[topic] = callback;
+  bool MQTT::subscribeTo(const char* topic, MqttHandler handler, void *context) {
+    if (!this->router.add(topic, handler, context)) {
+      Serial.printf("MQTT: no room to subscribe to %s\n", topic);
+      return false;
+    }
     if (this->client.connected()) {
-      this->subscribeToTopics();
+      this->client.subscribe(topic);
     }
+    return true;
   }
 
   void MQTT::setup() {
     this->client.setServer(MQTT_HOST, MQTT_PORT);
+    this->client.setBufferSize(MQTT_BUFFER_SIZE);  // room for the CAN stats snapshot
+    // Bounds a reconnect attempt: TCP connect (WiFiClient, 3 s) + CONNACK wait
+    this->client.setSocketTimeout(MQTT_CONNECT_TIMEOUT_S);
     this->client.setCallback([this](char* topic, unsigned char* payload, unsigned int length){
       Serial.println("-------new message from broker-----");
       Serial.print("channel:");
       Serial.println(topic);
       Serial.print("data:");  
-      Serial.write(payload, length);
+      bool text = true;
+      for (unsigned int i = 0; i < length && text; i++) text = payload[i] >= 0x20 || payload[i] == '\t';
+      if (text) Serial.write(payload, length);
+      else Serial.printf("<%u bytes binary>", length);  // raw frame batches
       Serial.println();
-      callbackMap[topic](topic, payload, length);
+      if (!router.dispatch(topic, payload, length)) {
+        Serial.println("MQTT: no handler for this topic");
+      }
     });
   }
 
   void MQTT::loop() {
-    this->ensureConnected();
-    client.loop();
+    if (this->ensureConnected()) client.loop();
+  }
+
+  bool MQTT::writeToTopic(const char* topic,const char* payload) {
+    return this->ensureConnected() && this->client.publish(topic, payload);
   }
 
-  void MQTT::writeToTopic(const char* topic,const char* payload) {
-    this->ensureConnected();
-    this->client.publish(topic, payload);
+  bool MQTT::writeToTopic(const char* topic, const uint8_t* payload, unsigned int length) {
+    return this->ensureConnected() && this->client.publish(topic, payload, length);
   }
 
 // PRIVATE STUFF
 
-  void MQTT::ensureConnected() {
-    // Loop until we're reconnected
-    while (!this->client.connected()) {
-        Serial.print("Attempting MQTT connection...");
-        // Create a random client ID
-        // Attempt to connect
-        String clientId = "ESP32Client-";
-        clientId += String(random(0xffff), HEX);
-        if (client.connect(clientId.c_str(), MQTT_USER, MQTT_PASS)) {
-            Serial.println("connected");
-            subscribeToTopics();
-        } else {
-            Serial.print("failed, rc=");
-            Serial.print(client.state());
-            Serial.println(" try again in 5 seconds");
-            // Wait 5 seconds before retrying
-            delay(5000);
-        }
+  // One connection attempt per MQTT_RECONNECT_MS, never waits in between:
+  // loop() and the CAN fan-out keep running while the broker is away, only
+  // the MQTT sinks fall behind
+  bool MQTT::ensureConnected() {
+    if (this->client.connected()) return true;
+    unsigned long now = millis();
+    if (this->attempted && now - this->lastAttemptMs < MQTT_RECONNECT_MS) return false;
+    this->attempted = true;
+    this->lastAttemptMs = now;
+
+    Serial.print("Attempting MQTT connection...");
+    // Random client ID
+    String clientId = "ESP32Client-";
+    clientId += String(random(0xffff), HEX);
+    if (client.connect(clientId.c_str(), MQTT_USER, MQTT_PASS)) {
+        Serial.println("connected");
+        subscribeToTopics();
+        return true;
     }
+    Serial.print("failed, rc=");
+    Serial.print(client.state());
+    Serial.printf(" try again in %u ms\n", MQTT_RECONNECT_MS);
+    return false;
   }
 
   void MQTT::subscribeToTopics() {
-    std::map<std::string, std::function<void(char*, uint8_t*, unsigned int)>>::iterator it;
-    for (it=callbackMap.begin(); it!=callbackMap.end(); ++it) {
-      std::string s = it->first;
+    for (uint8_t i = 0; i < router.routeCount(); i++) {
+      const char *topic = router.route(i).topic;
       Serial.print("Subscribing to: ");
-      Serial.println(s.c_str());
-      client.subscribe(s.c_str());
+      Serial.println(topic);
+      client.subscribe(topic);
     }
   }
 
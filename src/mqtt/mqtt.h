@@ -3,22 +3,43 @@
 
 #include <inttypes.h>
 #include <PubSubClient.h>
-#include <map>
+#include "topic_router.h"
+
+// PubSubClient packet buffer (topic + payload), default is 256
+#ifndef MQTT_BUFFER_SIZE
+  #define MQTT_BUFFER_SIZE 2048
+#endif
+
+// Broker reconnect attempts while disconnected, at most one per interval
+#ifndef MQTT_RECONNECT_MS
+  #define MQTT_RECONNECT_MS 5000
+#endif
+// Longest wait for the broker's CONNACK / a packet, PubSubClient default 15
+#ifndef MQTT_CONNECT_TIMEOUT_S
+  #define MQTT_CONNECT_TIMEOUT_S 2
+#endif
 
 namespace comfoair {
   class MQTT {
     public:
       MQTT();
-      void subscribeTo(const char* topic, MQTT_CALLBACK_SIGNATURE);
+      // false if the topic router is full (MQTT_MAX_ROUTES / MQTT_TOPIC_POOL_SIZE)
+      bool subscribeTo(const char* topic, MqttHandler handler, void *context);
       void setup();
       void loop();
-      void writeToTopic(const char* topic,const char* payload);
+      // false if not connected (nothing is queued) or the publish failed
+      bool writeToTopic(const char* topic,const char* payload);
+      bool writeToTopic(const char* topic, const uint8_t* payload, unsigned int length);  // binary
+      bool isConnected() { return this->client.connected(); }
+      const TopicRouter &routes() const { return this->router; }
 
     private:
       PubSubClient client;
-      std::map<std::string, std::function<void(char*, uint8_t*, unsigned int)>> callbackMap;
+      TopicRouter router;
+      bool attempted;
+      unsigned long lastAttemptMs;
       void subscribeToTopics();
-      void ensureConnected();
+      bool ensureConnected();  // non-blocking, see mqtt.cpp
   };
 }
 
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+#include "topic_router.h"
+
+namespace comfoair {
+
+  TopicRouter::TopicRouter() : count(0), poolUsed(0), missCount(0) {
+  }
+
+  uint32_t TopicRouter::hash(const char *topic) {
+    uint32_t h = 2166136261u;
+    while (*topic) {
+      h ^= (uint8_t)*topic++;
+      h *= 16777619u;
+    }
+    return h;
+  }
+
+  // First route with this topic, nullptr if none; equal hashes are adjacent
+  TopicRouter::Route *TopicRouter::find(const char *topic, uint32_t h) {
+    uint8_t lo = 0, hi = count;
+    while (lo < hi) {
+      uint8_t mid = (lo + hi) / 2;
+      if (routes[mid].hash < h) lo = mid + 1;
+      else hi = mid;
+    }
+    for (; lo < count && routes[lo].hash == h; lo++) {
+      if (strcmp(routes[lo].topic, topic) == 0) return &routes[lo];
+    }
+    return nullptr;
+  }
+
+  bool TopicRouter::add(const char *topic, MqttHandler handler, void *context) {
+    if (handler == nullptr) return false;
+    uint32_t h = hash(topic);
+    Route *existing = find(topic, h);
+    if (existing) {
+      existing->handler = handler;
+      existing->context = context;
+      return true;
+    }
+
+    size_t size = strlen(topic) + 1;
+    if (count >= MAX_ROUTES || poolUsed + size > sizeof(pool)) return false;
+    char *copy = pool + poolUsed;
+    memcpy(copy, topic, size);
+    poolUsed += size;
+
+    // Insertion sort, after routes with the same hash
+    uint8_t i = count;
+    while (i > 0 && routes[i - 1].hash > h) {
+      routes[i] = routes[i - 1];
+      i--;
+    }
+    routes[i] = { h, copy, handler, context, 0 };
+    count++;
+    return true;
+  }
+
+  bool TopicRouter::dispatch(const char *topic, const uint8_t *payload, unsigned int length) {
+    Route *route = find(topic, hash(topic));
+    if (route == nullptr) {
+      missCount++;
+      return false;
+    }
+    route->hits++;
+    route->handler(route->context, topic, payload, length);
+    return true;
+  }
+
+  size_t TopicRouter::toJson(char *buf, size_t len) const {
+    if (len == 0) return 0;
+    size_t pos = 0;
+
+    // Appends only if the whole piece fits
+    auto append = [&](const char *piece, int n) {
+      if (n < 0 || pos + n + 3 >= len) return false;  // keep room for "]}"
+      memcpy(buf + pos, piece, n);
+      pos += n;
+      return true;
+    };
+
+    char piece[128];
+    int n = snprintf(piece, sizeof(piece), "{\"routes\":%u,\"misses\":%u,\"hits\":[", count, missCount);
+    if (!append(piece, n)) {
+      buf[0] = '\0';
+      return 0;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+      n = snprintf(piece, sizeof(piece), "%s[\"%s\",%u]", i ? "," : "", routes[i].topic, routes[i].hits);
+      if (!append(piece, n)) break;
+    }
+
+    memcpy(buf + pos, "]}", 3);
+    return pos + 2;
+  }
+}
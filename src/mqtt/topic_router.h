@@ -0,0 +1,71 @@
+#ifndef TOPIC_ROUTER_H
+#define TOPIC_ROUTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ============================================================================
+// TOPIC ROUTER - MQTT topic -> handler dispatch, no heap
+// ============================================================================
+// Routes live in a fixed array sorted by the FNV-1a hash of their topic;
+// dispatch() hashes the inbound topic, binary searches and confirms with
+// one strcmp(). Topics are copied into a fixed pool on add(), so callers
+// may pass a stack buffer. Unknown topics return false and are counted,
+// every route counts its hits.
+// Handlers are plain function pointers + context, as in PdoRouter.
+// ============================================================================
+
+#ifndef MQTT_MAX_ROUTES
+  #define MQTT_MAX_ROUTES 64          // commands + routed PDO topics of a remote panel
+#endif
+
+#ifndef MQTT_TOPIC_POOL_SIZE
+  #define MQTT_TOPIC_POOL_SIZE 2048   // bytes for all subscribed topics
+#endif
+
+namespace comfoair {
+
+  typedef void (*MqttHandler)(void *context, const char *topic, const uint8_t *payload, unsigned int length);
+
+  class TopicRouter {
+    public:
+      static const uint8_t MAX_ROUTES = MQTT_MAX_ROUTES;
+
+      struct Route {
+        uint32_t hash;
+        const char *topic;      // in the pool
+        MqttHandler handler;
+        void *context;
+        uint32_t hits;
+      };
+
+      TopicRouter();
+
+      // Adding a topic again replaces its handler. Returns false if the
+      // route table or the topic pool is full.
+      bool add(const char *topic, MqttHandler handler, void *context);
+
+      // Returns false if nobody subscribed to topic
+      bool dispatch(const char *topic, const uint8_t *payload, unsigned int length);
+
+      uint8_t routeCount() const { return count; }
+      const Route &route(uint8_t index) const { return routes[index]; }
+      uint32_t misses() const { return missCount; }
+
+      // {"routes":n,"misses":n,"hits":[["topic",hits],...]}
+      size_t toJson(char *buf, size_t len) const;
+
+      static uint32_t hash(const char *topic);
+
+    private:
+      Route *find(const char *topic, uint32_t h);
+
+      Route routes[MAX_ROUTES];
+      uint8_t count;
+      char pool[MQTT_TOPIC_POOL_SIZE];
+      uint16_t poolUsed;
+      uint32_t missCount;
+  };
+}
+
+#endif
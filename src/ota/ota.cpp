@@ -121,6 +121,78 @@ const char* serverIndex =
 "});"
 "</script>";
   WebServer server(80);
+  
+  #ifndef OTA_ENDPOINT_BUFFER_SIZE
+    #define OTA_ENDPOINT_BUFFER_SIZE 8192
+  #endif
+  static char endpointBuffer[OTA_ENDPOINT_BUFFER_SIZE];
+
+  void OTA::addEndpoint(const char* uri, OtaRenderFn render, void *context) {
+    server.on(uri, HTTP_GET, [render, context]() {
+      size_t len = render(context, endpointBuffer, sizeof(endpointBuffer));
+      server.sendHeader("Connection", "close");
+      server.send_P(200, "application/json", endpointBuffer, len);
+    });
+  }
+
+  void OTA::addAction(const char* uri, OtaRenderFn render, void *context) {
+    server.on(uri, HTTP_POST, [render, context]() {
+      size_t len = render(context, endpointBuffer, sizeof(endpointBuffer));
+      server.sendHeader("Connection", "close");
+      if (len == 0) {
+        server.send(400, "text/plain", "Bad request");
+        return;
+      }
+      server.send_P(200, "application/json", endpointBuffer, len);
+    });
+  }
+
+  void OTA::addStreamEndpoint(const char* uri, OtaStreamBeginFn begin, OtaRenderFn next, void *context) {
+    server.on(uri, HTTP_GET, [begin, next, context]() {
+      server.sendHeader("Connection", "close");
+      const char *contentType = begin(context);
+      if (!contentType) {
+        server.send(400, "text/plain", "Bad request");
+        return;
+      }
+      server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+      server.send(200, contentType, "");
+      size_t len;
+      while ((len = next(context, endpointBuffer, sizeof(endpointBuffer))) > 0) {
+        server.sendContent(endpointBuffer, len);
+      }
+      server.sendContent("");  // last chunk
+    });
+  }
+
+  void OTA::addUpload(const char* uri, OtaUploadFn write, OtaRenderFn done, void *context) {
+    server.on(uri, HTTP_POST, [done, context]() {
+      size_t len = done(context, endpointBuffer, sizeof(endpointBuffer));
+      server.sendHeader("Connection", "close");
+      if (len == 0) {
+        server.send(400, "text/plain", "Bad request");
+        return;
+      }
+      server.send_P(200, "application/json", endpointBuffer, len);
+    }, [write, context]() {
+      HTTPUpload& upload = server.upload();
+      if (upload.status == UPLOAD_FILE_START) {
+        write(context, 0, nullptr, 0);
+      } else if (upload.status == UPLOAD_FILE_WRITE) {
+        write(context, upload.totalSize, upload.buf, upload.currentSize);
+      }
+    });
+  }
+
+  bool OTA::arg(const char* name, char *buf, size_t len) {
+    if (!server.hasArg(name) || len == 0) return false;
+    strlcpy(buf, server.arg(name).c_str(), len);
+    return true;
+  }
+
+  void OTA::sendHeader(const char* name, const char* value) {
+    server.sendHeader(name, value);
+  }
 
   void OTA::setup() {
     /*use mdns for host name resolution*/
@@ -4,6 +4,14 @@
 #include <Arduino.h>
 
 namespace comfoair {
+  // Renders an endpoint body into buf, returns its length
+  typedef size_t (*OtaRenderFn)(void *context, char *buf, size_t len);
+  // Starts a streamed response: reads the query (OTA::arg), may add headers
+  // (OTA::sendHeader), returns the content type or nullptr for a 400
+  typedef const char *(*OtaStreamBeginFn)(void *context);
+  // Receives an uploaded file in chunks; offset 0 with len 0 starts it
+  typedef void (*OtaUploadFn)(void *context, size_t offset, const uint8_t *data, size_t len);
+
   class OTA {
     public:
       void setup();
@@ -12,6 +20,26 @@ namespace comfoair {
       // Serial logging buffer
       static void addLog(const char* message);
       
+      // Read-only JSON endpoint, e.g. /can/stats. Can be added before or
+      // after setup(); bodies share one OTA_ENDPOINT_BUFFER_SIZE buffer.
+      static void addEndpoint(const char* uri, OtaRenderFn render, void *context);
+      
+      // POST endpoint with a JSON reply, e.g. /can/capture/control?action=pause.
+      // A render returning 0 answers 400.
+      static void addAction(const char* uri, OtaRenderFn render, void *context);
+      
+      // Chunked GET endpoint for large bodies, e.g. /can/capture: begin()
+      // once, then next() fills the shared buffer until it returns 0.
+      static void addStreamEndpoint(const char* uri, OtaStreamBeginFn begin, OtaRenderFn next, void *context);
+      
+      // POST file upload (multipart form), e.g. /can/replay: write() per
+      // chunk, then done() renders the JSON reply (0 answers 400)
+      static void addUpload(const char* uri, OtaUploadFn write, OtaRenderFn done, void *context);
+      
+      // For the callbacks above, on the request being handled
+      static bool arg(const char* name, char *buf, size_t len);  // false if absent
+      static void sendHeader(const char* name, const char* value);
+      
     private:
       static const int LOG_BUFFER_SIZE = 300;  // Keep last 500 messages
       static const int LOG_MESSAGE_MAX_LEN = 256;  // Max length per message
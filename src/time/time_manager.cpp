@@ -1,5 +1,6 @@
 #include "time_manager.h"
 #include "../comfoair/comfoair.h"
+#include "../comfoair/pdo_router.h"
 #include "../ui/GUI.h"
 #include "../secrets.h"
 #include <WiFi.h>
@@ -26,6 +27,12 @@ void TimeManager::setComfoAir(ComfoAir* comfo_ptr) {
     Serial.println("TimeManager: ComfoAir instance linked");
 }
 
+void TimeManager::subscribePdos(PdoRouter &router) {
+    router.subscribe(PDO_DEVICE_TIME, [](void *ctx, const PdoValue &value) {
+        static_cast<TimeManager*>(ctx)->onDeviceTimeReceived(value.toUnsigned());
+    }, this);
+}
+
 void TimeManager::setup() {
     Serial.println("TimeManager: Starting NTP sync...");
     syncTime();
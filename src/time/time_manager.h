@@ -8,6 +8,7 @@ namespace comfoair {
 
 // Forward declaration
 class ComfoAir;
+class PdoRouter;
 
 class TimeManager {
 public:
@@ -17,6 +18,9 @@ public:
     void updateDisplay();
     void setComfoAir(ComfoAir* comfo_ptr);
     
+    // Subscribe to the device time PDO / time response
+    void subscribePdos(PdoRouter &router);
+    
     // Callback for when device time is received from CAN bus
     void onDeviceTimeReceived(uint32_t device_seconds);
 
@@ -0,0 +1,118 @@
+#ifndef COMMAND_LOOKUP_BENCH_H
+#define COMMAND_LOOKUP_BENCH_H
+
+// ============================================================================
+// COMMAND LOOKUP BENCHMARK (No external dependencies)
+// ============================================================================
+// Measures CPU cycles and heap per command for turning an MQTT topic name
+// into a payload:
+//   - legacy: strcmp() chain + new std::vector (pre-CommandId code path)
+//   - table:  findCommand() perfect hash + constexpr payload
+// Also checks that every table name maps back to its own CommandId.
+// No CAN bus needed, nothing is sent.
+//
+// USAGE IN main.cpp:
+//   #include "../test/command_lookup_bench.h"
+//
+//   void setup() {
+//       // ... your setup ...
+//       CommandLookupBench::runAll();
+//   }
+// ============================================================================
+
+#include <Arduino.h>
+#include <vector>
+#include "comfoair/commands.h"
+
+namespace CommandLookupBench {
+
+using namespace comfoair;
+
+static const uint32_t ITERATIONS = 200;
+
+static volatile uint32_t payload_bytes = 0;
+
+// Same comparisons, in the same order, as the old ComfoMessage::sendCommand()
+static std::vector<uint8_t> *legacyLookup(const char *command) {
+    #define LEGACY_CMDIF(name) if (strcmp(command, #name) == 0) { \
+                                 return new std::vector<uint8_t>(CMD_##name, CMD_##name + sizeof(CMD_##name)); \
+                               } else
+    LEGACY_CMDIF(ventilation_level_0)
+    LEGACY_CMDIF(ventilation_level_1)
+    LEGACY_CMDIF(ventilation_level_2)
+    LEGACY_CMDIF(ventilation_level_3)
+    LEGACY_CMDIF(boost_10_min)
+    LEGACY_CMDIF(boost_20_min)
+    LEGACY_CMDIF(boost_30_min)
+    LEGACY_CMDIF(boost_60_min)
+    LEGACY_CMDIF(boost_end)
+    LEGACY_CMDIF(auto)
+    LEGACY_CMDIF(manual)
+    LEGACY_CMDIF(bypass_activate_1h)
+    LEGACY_CMDIF(bypass_deactivate_1h)
+    LEGACY_CMDIF(bypass_auto)
+    LEGACY_CMDIF(ventilation_supply_only)
+    LEGACY_CMDIF(ventilation_supply_only_reset)
+    LEGACY_CMDIF(ventilation_extract_only)
+    LEGACY_CMDIF(ventilation_extract_only_reset)
+    LEGACY_CMDIF(temp_profile_normal)
+    LEGACY_CMDIF(temp_profile_cool)
+    LEGACY_CMDIF(temp_profile_warm)
+    #undef LEGACY_CMDIF
+    return nullptr;
+}
+
+static bool testRoundTrip() {
+    bool ok = true;
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+        if (findCommand(COMMANDS[i].name) != COMMANDS[i].id) {
+            Serial.printf("  ERROR: '%s' does not map back to id %u\n", COMMANDS[i].name, i);
+            ok = false;
+        }
+    }
+    if (findCommand("boost") != CommandId::NONE || findCommand("") != CommandId::NONE) {
+        Serial.println("  ERROR: unknown name matched a command");
+        ok = false;
+    }
+    return ok;
+}
+
+void runAll() {
+    Serial.println("\n=== COMMAND LOOKUP BENCHMARK ===");
+    Serial.printf("  Round trip:      %s (%u commands, seed %u, %u slots)\n",
+                  testRoundTrip() ? "OK" : "FAILED", COMMAND_COUNT,
+                  COMMAND_HASH_SEED, COMMAND_HASH_SLOTS);
+
+    // The old path leaked every vector; free them here, after measuring
+    std::vector<uint8_t> *last[COMMAND_COUNT];
+    uint32_t heap_before = ESP.getFreeHeap();
+    uint32_t start = ESP.getCycleCount();
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+        last[i] = legacyLookup(COMMANDS[i].name);
+        payload_bytes += last[i]->size();
+    }
+    uint32_t legacy_cycles = ESP.getCycleCount() - start;
+    uint32_t legacy_heap = heap_before - ESP.getFreeHeap();
+    for (uint8_t i = 0; i < COMMAND_COUNT; i++) delete last[i];
+
+    heap_before = ESP.getFreeHeap();
+    start = ESP.getCycleCount();
+    for (uint32_t it = 0; it < ITERATIONS; it++) {
+        for (uint8_t i = 0; i < COMMAND_COUNT; i++) {
+            payload_bytes += commandDescriptor(findCommand(COMMANDS[i].name)).length;
+        }
+    }
+    uint32_t table_cycles = ESP.getCycleCount() - start;
+    uint32_t table_heap = heap_before - ESP.getFreeHeap();
+
+    Serial.printf("  strcmp + vector: %u cycles/command, %u heap bytes per %u commands\n",
+                  legacy_cycles / COMMAND_COUNT, legacy_heap, COMMAND_COUNT);
+    Serial.printf("  perfect hash:    %u cycles/command, %u heap bytes per %u commands\n",
+                  table_cycles / (ITERATIONS * COMMAND_COUNT), table_heap,
+                  ITERATIONS * COMMAND_COUNT);
+    Serial.println("=== BENCHMARK COMPLETE ===\n");
+}
+
+} // namespace CommandLookupBench
+
+#endif
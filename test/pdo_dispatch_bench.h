@@ -0,0 +1,139 @@
+#ifndef PDO_DISPATCH_BENCH_H
+#define PDO_DISPATCH_BENCH_H
+
+// ============================================================================
+// PDO DISPATCH BENCHMARK (No external dependencies)
+// ============================================================================
+// Measures CPU cycles per CAN frame for routing a decoded PDO to its manager:
+//   - legacy: strcmp() chain on the decoded name (pre-PdoRouter code path)
+//   - router: PdoRouter::dispatch() (one table lookup)
+// The frame mix mirrors what a ComfoAir Q broadcasts: mostly temperatures,
+// fan data and power values that nobody on the display subscribes to.
+// No CAN bus or managers needed, handlers only count calls.
+//
+// USAGE IN main.cpp:
+//   #include "../test/pdo_dispatch_bench.h"
+//
+//   void setup() {
+//       // ... your setup ...
+//       PdoDispatchBench::runAll();
+//   }
+// ============================================================================
+
+#include <Arduino.h>
+#include "comfoair/message.h"
+#include "comfoair/pdo_router.h"
+
+namespace PdoDispatchBench {
+
+using namespace comfoair;
+
+static const uint32_t ITERATIONS = 2000;
+
+// PDOIDs seen on the bus in one broadcast cycle (routed and unrouted)
+static const uint16_t FRAME_MIX[] = {
+    65, 117, 118, 119, 120, 121, 122, 128, 129, 130, 209, 213, 216, 220, 221,
+    274, 275, 276, 277, 278, 290, 291, 292, 293, 294, 321, 325, 328, 329, 67
+};
+static const uint8_t FRAME_MIX_COUNT = sizeof(FRAME_MIX) / sizeof(FRAME_MIX[0]);
+
+static volatile uint32_t sink_calls = 0;
+
+static void countingHandler(void *context, const PdoValue &value) {
+    sink_calls++;
+}
+
+// Same comparisons, in the same order, as the old ComfoAir::loop() routing
+static void legacyRoute(const PdoValue &value) {
+    const char *name = value.name();
+    if (strcmp(name, "device_time") == 0) { countingHandler(nullptr, value); }
+
+    if (strcmp(name, "extract_air_temp") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "outdoor_air_temp") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "extract_air_humidity") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "outdoor_air_humidity") == 0) countingHandler(nullptr, value);
+
+    if (strcmp(name, "remaining_days_filter_replacement") == 0) countingHandler(nullptr, value);
+
+    if (strcmp(name, "fan_speed") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "temp_profile") == 0) countingHandler(nullptr, value);
+
+    if (strcmp(name, "error_overheating") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_temp_sensor_p_oda") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_preheat_location") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_ext_pressure_eha") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_ext_pressure_sup") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_tempcontrol_p_oda") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "error_tempcontrol_sup") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "alarm_filter") == 0) countingHandler(nullptr, value);
+    else if (strcmp(name, "warning_system") == 0) countingHandler(nullptr, value);
+}
+
+// Subscribe the same PDOIDs the managers subscribe to
+static void buildRouter(PdoRouter &router) {
+    static const uint16_t ROUTED[] = {
+        PDO_DEVICE_TIME, PDO_EXTRACT_AIR_TEMP, PDO_OUTDOOR_AIR_TEMP,
+        PDO_EXTRACT_AIR_HUMIDITY, PDO_OUTDOOR_AIR_HUMIDITY, PDO_FILTER_DAYS,
+        PDO_FAN_SPEED, PDO_FAN_SPEED, PDO_TEMP_PROFILE
+    };
+    for (uint16_t pdoid : ROUTED) {
+        router.subscribe(pdoid, countingHandler, nullptr);
+    }
+    for (uint16_t pdoid = PDO_ERROR_OVERHEATING; pdoid <= PDO_WARNING_SYSTEM; pdoid++) {
+        router.subscribe(pdoid, countingHandler, nullptr);
+    }
+}
+
+// Decode the frame mix once so both paths route identical values
+static uint8_t buildValues(PdoValue *values) {
+    ComfoMessage decoder;
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < FRAME_MIX_COUNT; i++) {
+        CAN_FRAME frame = {};
+        frame.id = ((uint32_t)FRAME_MIX[i] << 14) | 0x40 | 0x01;
+        frame.extended = true;
+        frame.length = 4;
+        frame.data.uint8[0] = 0x12;
+        if (decoder.decode(&frame, &values[n])) n++;
+    }
+    return n;
+}
+
+void runAll() {
+    Serial.println("\n=== PDO DISPATCH BENCHMARK ===");
+
+    PdoValue values[FRAME_MIX_COUNT];
+    uint8_t n = buildValues(values);
+
+    PdoRouter *router = new PdoRouter();  // ~1 KB, keep it off the stack
+    buildRouter(*router);
+
+    uint32_t start = ESP.getCycleCount();
+    for (uint32_t it = 0; it < ITERATIONS; it++) {
+        for (uint8_t i = 0; i < n; i++) legacyRoute(values[i]);
+    }
+    uint32_t legacy_cycles = ESP.getCycleCount() - start;
+    uint32_t legacy_calls = sink_calls;
+
+    sink_calls = 0;
+    start = ESP.getCycleCount();
+    for (uint32_t it = 0; it < ITERATIONS; it++) {
+        for (uint8_t i = 0; i < n; i++) router->dispatch(values[i]);
+    }
+    uint32_t router_cycles = ESP.getCycleCount() - start;
+    uint32_t router_calls = sink_calls;
+
+    delete router;
+
+    uint32_t frames = ITERATIONS * n;
+    Serial.printf("  Frames routed:   %u (%u PDOIDs in mix)\n", frames, n);
+    Serial.printf("  strcmp chain:    %u cycles/frame\n", legacy_cycles / frames);
+    Serial.printf("  PdoRouter:       %u cycles/frame\n", router_cycles / frames);
+    // fan_speed has two routes (ComfoAir + ControlManager), the old chain one
+    Serial.printf("  Handler calls:   legacy=%u router=%u\n", legacy_calls, router_calls);
+    Serial.println("=== BENCHMARK COMPLETE ===\n");
+}
+
+} // namespace PdoDispatchBench
+
+#endif
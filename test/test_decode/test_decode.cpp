@@ -0,0 +1,302 @@
+// ============================================================================
+// PDO DECODE TESTS - host unit tests for the decode table (env:native_test)
+// ============================================================================
+// The vectors ComfoMessage used to check on every boot, plus signed
+// temperatures, enum fallbacks, U32 values, the time response and frames
+// that must not decode (RTR ACKs, short payloads, unknown PDOIDs). Ends
+// with a decode / format microbenchmark in ns per frame.
+//
+//   pio test -e native_test -v
+// ============================================================================
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <unity.h>
+#include "comfoair/can_frame.h"
+#include "comfoair/pdo_table.h"
+
+using namespace comfoair;
+
+// "IIIIIIIILDD..": 8 hex digits CAN id, 1 digit length, the payload
+static CAN_FRAME frameFromHex(const char *hex) {
+    auto nibble = [](char c) -> uint8_t {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        return 0;
+    };
+    CAN_FRAME frame = {};
+    frame.extended = 1;
+    for (uint8_t i = 0; i < 8; i++) frame.id = (frame.id << 4) | nibble(hex[i]);
+    frame.length = nibble(hex[8]);
+    for (uint8_t i = 0; i < frame.length; i++) {
+        frame.data.uint8[i] = (nibble(hex[9 + i * 2]) << 4) | nibble(hex[10 + i * 2]);
+    }
+    return frame;
+}
+
+struct DecodeVector {
+    const char *frame;
+    const char *name;
+    const char *value;
+};
+
+static const DecodeVector VECTORS[] = {
+    // Former ComfoMessage boot-time self-tests
+    { "00040041107",   "away_indicator",            "true" },
+    { "00040041101",   "away_indicator",            "false" },
+    { "00104041102",   "fan_speed",                 "2" },
+    { "00104041100",   "fan_speed",                 "0" },
+    { "001D4041113",   "exhaust_fan_duty",          "19" },
+    { "001D4041126",   "exhaust_fan_duty",          "38" },
+    { "001D8041110",   "supply_fan_duty",           "16" },
+    { "001DC0412C400", "exhaust_fan_flow",          "196" },
+    { "001DC04128200", "exhaust_fan_flow",          "130" },
+    { "001E00412C800", "supply_fan_flow",           "200" },
+    { "001E00412C900", "supply_fan_flow",           "201" },
+    { "001E40412ED07", "exhaust_fan_speed",         "2029" },
+    { "001E804127F07", "supply_fan_speed",          "1919" },
+    { "0020004123200", "power_consumption_current", "50" },
+    { "0035404126E03", "ah_actual",                 "8.78" },
+    { "0035404126F03", "ah_actual",                 "8.79" },
+    { "0035804125401", "ah_ytd",                    "340" },
+    { "0035804125301", "ah_ytd",                    "339" },
+    { "0035C04124415", "ah_total",                  "5444" },
+    { "003500412DB00", "target_temp",               "21.9" },
+    { "004480412D100", "extract_air_temp",          "20.9" },
+    { "0044C04123700", "exhaust_air_temp",          "5.5" },
+    { "0045004120900", "outdoor_air_temp",          "0.9" },
+    { "004500412FFFF", "outdoor_air_temp",          "-0.1" },
+    { "004500412A1FF", "outdoor_air_temp",          "-9.5" },
+    { "004500412B3FE", "outdoor_air_temp",          "-33.3" },
+    { "004580412C700", "post_heater_temp_before",   "19.9" },
+    { "0048804112D",   "extract_air_humidity",      "45" },
+    { "00488041129",   "extract_air_humidity",      "41" },
+    { "0048C04115F",   "exhaust_air_humidity",      "95" },
+    { "0048C04115E",   "exhaust_air_humidity",      "94" },
+    { "00490041146",   "outdoor_air_humidity",      "70" },
+    { "00490041143",   "outdoor_air_humidity",      "67" },
+    { "00490041145",   "outdoor_air_humidity",      "69" },
+    { "0049804111B",   "supply_air_humidity",       "27" },
+    { "003740412C700", "post_heater_temp_after",    "19.9" },
+
+    // Signed temperatures: sign extension and range ends
+    { "00344041285FF", "rmot",                      "-12.3" },
+    { "0034404120000", "rmot",                      "0.0" },
+    { "004480412FF7F", "extract_air_temp",          "3276.7" },
+    { "0044804120080", "extract_air_temp",          "-3276.8" },
+    { "004500412F6FF", "outdoor_air_temp",          "-1.0" },
+
+    // Enums, including the fallback label
+    { "000C40411FF",   "operating_mode",            "auto" },
+    { "000C4041101",   "operating_mode",            "limited_manual" },
+    { "000C4041105",   "operating_mode",            "unlimited_manual" },
+    { "0010C041102",   "temp_profile",              "warm" },
+    { "00520041100",   "alarm_filter",              "ok" },
+    { "00520041101",   "alarm_filter",              "REPLACE" },
+
+    // U32, printed unsigned; extra payload bytes are ignored
+    { "0014404144C020000", "next_fan_change",       "588" },
+    { "00144041400000080", "next_fan_change",       "2147483648" },
+    { "001040418020100000000FF", "fan_speed",       "2" },
+
+    // Time response on its own CAN ID, decoded as device_time
+    { "1004000144C020000", "device_time",           "588" },
+    { "100400014309FE030", "device_time",           "820027184" },
+};
+
+static const char *const NOT_DECODED[] = {
+    "0010404100",       // RTR ACK: fan_speed with an empty payload
+    "0045004100",       // RTR ACK: outdoor_air_temp
+    "100400010",        // empty time response
+    "00450041109",      // I16 with one byte
+    "001440413010203",  // U32 with three bytes
+    "0032004110A",      // PDOID 200, not in the table
+    "01FFC04110A",      // PDOID 2047, top of the range, not in the table
+    "0010400110A",      // fan_speed's PDOID, but not a PDO ID (bits 6-13)
+    "0210404110A",      // fan_speed's PDOID, but not a PDO ID (bit 25)
+};
+
+void setUp() {}
+void tearDown() {}
+
+static void test_vectors() {
+    char message[96];
+    for (const DecodeVector &v : VECTORS) {
+        CAN_FRAME frame = frameFromHex(v.frame);
+        PdoValue value;
+        snprintf(message, sizeof(message), "frame %s", v.frame);
+        TEST_ASSERT_TRUE_MESSAGE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value), message);
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(v.name, value.name(), message);
+        char text[PDO_TEXT_SIZE];
+        pdoFormat(value, text, sizeof(text));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(v.value, text, message);
+    }
+}
+
+static void test_not_decoded() {
+    for (const char *hex : NOT_DECODED) {
+        CAN_FRAME frame = frameFromHex(hex);
+        PdoValue value;
+        TEST_ASSERT_FALSE_MESSAGE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value), hex);
+    }
+}
+
+// What the ComfoAir sinks let through to the change cache and decode
+static void test_value_frames() {
+    TEST_ASSERT_TRUE(isPdoValueFrame(pdoCanId(PDO_FAN_SPEED, 0x01), false));
+    TEST_ASSERT_TRUE(isPdoValueFrame(CAN_ID_TIME_RESPONSE, false));
+    TEST_ASSERT_FALSE(isPdoValueFrame(pdoCanId(PDO_FAN_SPEED, 0x01), true));     // poll request
+    TEST_ASSERT_FALSE(isPdoValueFrame(CAN_ID_TIME_RESPONSE, true));
+    TEST_ASSERT_FALSE(isPdoValueFrame(0x10080028, true));                        // time request
+    TEST_ASSERT_FALSE(isPdoValueFrame(nodeHeartbeatId(0x01), false));
+    TEST_ASSERT_FALSE(isPdoValueFrame(0x1F015057, false));                       // RMI
+    TEST_ASSERT_FALSE(isPdoValueFrame(0x02104041, false));                       // foreign, PDOID 65 in its bits
+
+    // A poll request as the TWAI driver hands it over: ID of the value,
+    // junk in the data bytes - would pass the cache and decode as fan_speed
+    CAN_FRAME frame = frameFromHex("001040411FF");
+    frame.rtr = 1;
+    PdoValue value;
+    TEST_ASSERT_TRUE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value));
+    TEST_ASSERT_FALSE(isPdoValueFrame(frame.id, frame.rtr));
+}
+
+static void test_typed_value() {
+    CAN_FRAME frame = frameFromHex("004500412A1FF");
+    PdoValue value;
+    TEST_ASSERT_TRUE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value));
+    TEST_ASSERT_EQUAL_UINT16(PDO_OUTDOOR_AIR_TEMP, value.pdoid);
+    TEST_ASSERT_EQUAL_INT32(-95, value.raw);
+    TEST_ASSERT_EQUAL_UINT8(1, value.decimals);
+    TEST_ASSERT_EQUAL_UINT8(PDO_NO_ORDINAL, value.ordinal);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, -9.5f, value.toFloat());
+
+    frame = frameFromHex("000C4041105");
+    TEST_ASSERT_TRUE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value));
+    TEST_ASSERT_EQUAL_UINT8(ENUM_OPERATING_MODE.count, value.ordinal);   // fallback
+
+    frame = frameFromHex("100400014309FE030");
+    TEST_ASSERT_TRUE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value));
+    TEST_ASSERT_EQUAL_UINT16(PDO_DEVICE_TIME, value.pdoid);
+    TEST_ASSERT_EQUAL_UINT32(820027184u, value.toUnsigned());
+}
+
+// Every descriptor decodes a full payload and every text fits PDO_TEXT_SIZE
+static void test_every_descriptor() {
+    static const uint8_t PAYLOAD[8] = { 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF };
+    for (uint16_t i = 0; i < PDO_DESCRIPTOR_COUNT; i++) {
+        const PdoDescriptor &desc = PDO_DESCRIPTORS[i];
+        PdoValue value;
+        TEST_ASSERT_TRUE_MESSAGE(pdoDecode(desc.pdoid, PAYLOAD, desc.minLength, value), desc.name);
+        TEST_ASSERT_EQUAL_PTR(&desc, findPdo(desc.pdoid));
+        char text[PDO_TEXT_SIZE];
+        TEST_ASSERT_LESS_THAN_MESSAGE(sizeof(text), pdoFormat(value, text, sizeof(text)), desc.name);
+        if (!desc.enumMap) continue;
+        for (uint8_t e = 0; e < desc.enumMap->count; e++) {
+            TEST_ASSERT_LESS_THAN_MESSAGE(PDO_TEXT_SIZE, strlen(desc.enumMap->entries[e].label), desc.name);
+        }
+        TEST_ASSERT_LESS_THAN_MESSAGE(PDO_TEXT_SIZE, strlen(desc.enumMap->fallback), desc.name);
+    }
+}
+
+// pdoParse() reads back what pdoFormat() published (remote client mode)
+static void test_parse_roundtrip() {
+    char message[96];
+    for (const DecodeVector &v : VECTORS) {
+        CAN_FRAME frame = frameFromHex(v.frame);
+        PdoValue decoded, parsed;
+        TEST_ASSERT_TRUE(pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, decoded));
+        snprintf(message, sizeof(message), "frame %s", v.frame);
+        TEST_ASSERT_TRUE_MESSAGE(pdoParse(decoded.pdoid, v.value, strlen(v.value), parsed), message);
+        TEST_ASSERT_EQUAL_UINT8_MESSAGE(decoded.ordinal, parsed.ordinal, message);
+        if (!decoded.desc->enumMap) TEST_ASSERT_EQUAL_INT32_MESSAGE(decoded.raw, parsed.raw, message);
+        char text[PDO_TEXT_SIZE];
+        pdoFormat(parsed, text, sizeof(text));
+        TEST_ASSERT_EQUAL_STRING_MESSAGE(v.value, text, message);
+    }
+
+    PdoValue value;
+    TEST_ASSERT_TRUE(pdoParse(PDO_ALARM_FILTER, "REPLACE", 7, value));     // fallback
+    TEST_ASSERT_EQUAL_UINT8(ENUM_FILTER_ALARM.count, value.ordinal);
+    TEST_ASSERT_FALSE(pdoParse(PDO_ALARM_FILTER, "ACTIVE", 6, value));     // another enum's label
+    TEST_ASSERT_FALSE(pdoParse(PDO_ERROR_OVERHEATING, "None", 4, value));  // HA's empty state
+    TEST_ASSERT_FALSE(pdoParse(PDO_OPERATING_MODE, "manual", 6, value));
+    TEST_ASSERT_FALSE(pdoParse(PDO_ALARM_FILTER, "o", 1, value));          // label prefix
+    TEST_ASSERT_FALSE(pdoParse(PDO_ALARM_FILTER, "ok\0", 3, value));       // embedded NUL
+    TEST_ASSERT_FALSE(pdoParse(PDO_ALARM_FILTER, "okay", 4, value));
+    TEST_ASSERT_TRUE(pdoParse(PDO_TARGET_TEMP, "21", 2, value));
+    TEST_ASSERT_EQUAL_INT32(210, value.raw);
+    TEST_ASSERT_TRUE(pdoParse(PDO_AH_ACTUAL, "8.789", 5, value));
+    TEST_ASSERT_EQUAL_INT32(878, value.raw);
+    TEST_ASSERT_TRUE(pdoParse(PDO_FAN_SPEED, "2xyz", 1, value));          // not 0-terminated
+    TEST_ASSERT_EQUAL_INT32(2, value.raw);
+    TEST_ASSERT_FALSE(pdoParse(PDO_FAN_SPEED, "", 0, value));
+    TEST_ASSERT_FALSE(pdoParse(PDO_FAN_SPEED, "-", 1, value));
+    TEST_ASSERT_FALSE(pdoParse(PDO_OUTDOOR_AIR_TEMP, "nan", 3, value));
+    TEST_ASSERT_FALSE(pdoParse(200, "1", 1, value));
+}
+
+// Generated from pdo_spec.json: polled PDOs answer RTRs
+static void test_generated_tables() {
+    for (uint16_t pdoid : PDO_POLLED) {
+        const PdoDescriptor *desc = findPdo(pdoid);
+        TEST_ASSERT_NOT_NULL(desc);
+        TEST_ASSERT_TRUE_MESSAGE(desc->rtr, desc->name);
+    }
+    TEST_ASSERT_TRUE(findPdo(PDO_FILTER_DAYS)->route == PdoRoute::FILTER_DATA);
+    TEST_ASSERT_TRUE(findPdo(PDO_DEVICE_TIME)->route == PdoRoute::TIME);
+}
+
+static uint64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void bench_decode() {
+    const uint32_t COUNT = sizeof(VECTORS) / sizeof(VECTORS[0]);
+    const uint32_t ROUNDS = 20000;
+    CAN_FRAME frames[COUNT];
+    for (uint32_t i = 0; i < COUNT; i++) frames[i] = frameFromHex(VECTORS[i].frame);
+
+    volatile int32_t sink = 0;
+    PdoValue value;
+    uint64_t t0 = nowNs();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (const CAN_FRAME &frame : frames) {
+            if (pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value)) sink = sink + value.raw;
+        }
+    }
+    uint64_t decodeNs = nowNs() - t0;
+
+    char text[PDO_TEXT_SIZE];
+    t0 = nowNs();
+    for (uint32_t r = 0; r < ROUNDS; r++) {
+        for (const CAN_FRAME &frame : frames) {
+            if (pdoDecodeFrame(frame.id, frame.data.uint8, frame.length, value)) {
+                sink = sink + pdoFormat(value, text, sizeof(text));
+            }
+        }
+    }
+    uint64_t formatNs = nowNs() - t0;
+
+    char message[96];
+    snprintf(message, sizeof(message), "decode %.1f ns/frame, decode + format %.1f ns/frame",
+             (double)decodeNs / (COUNT * ROUNDS), (double)formatNs / (COUNT * ROUNDS));
+    TEST_MESSAGE(message);
+    (void)sink;
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_vectors);
+    RUN_TEST(test_not_decoded);
+    RUN_TEST(test_value_frames);
+    RUN_TEST(test_typed_value);
+    RUN_TEST(test_every_descriptor);
+    RUN_TEST(test_parse_roundtrip);
+    RUN_TEST(test_generated_tables);
+    RUN_TEST(bench_decode);
+    return UNITY_END();
+}
@@ -0,0 +1,175 @@
+// ============================================================================
+// CAN HEALTH TESTS - bus faults on a LoopbackPort (env:native_test)
+// ============================================================================
+// CanHealth and CanTxQueue plugged into a LoopbackPort through
+// canHealthDriver() / canTxDriver(), as ComfoAir does with the TWAI port; a
+// second port on the bus ACKs and receives what we send. Faults come from
+// the port's inject*() hooks:
+//   - error passive and back
+//   - bus-off: TX paused, recovery after the backoff, restart, queued
+//     frames go out afterwards
+//   - repeated bus-off: backoff doubles, resets once the bus is stable
+//   - stuck bus: recovery times out and is retried, a late completion
+//     still restarts
+//   - lost alert: sync() catches the bus-off
+// Scripted millisecond clock, one step = one ComfoAir::loop() iteration.
+//
+//   pio test -e native_test -v
+// ============================================================================
+
+#include <unity.h>
+#include "comfoair/can_health.h"
+#include "comfoair/can_tx_queue.h"
+#include "comfoair/loopback_port.h"
+
+using namespace comfoair;
+
+static uint32_t nowMs;
+
+static uint32_t busClockUs() { return nowMs * 1000; }
+
+struct Rig {
+    LoopbackBus bus;
+    LoopbackPort port;
+    LoopbackPort peer;
+    CanHealth health;
+    CanTxQueue tx;
+
+    Rig() :
+        bus(busClockUs),
+        port(bus, "bridge"),
+        peer(bus, "peer"),
+        health(canHealthDriver(port)),
+        tx(canTxDriver(port)) {
+        port.begin(50000);
+        peer.begin(50000);
+        health.resetStats(nowMs);
+    }
+
+    // Same order as ComfoAir::loop()
+    void run(uint32_t ms, uint32_t stepMs = 1) {
+        for (uint32_t end = nowMs + ms; nowMs < end; nowMs += stepMs) {
+            health.onEvents(port.takeHealthEvents(), nowMs);
+            health.poll(nowMs);
+            tx.pause(!health.txAllowed());
+            tx.poll(nowMs);
+        }
+    }
+
+    void queueFrame() {
+        CAN_FRAME frame = {};
+        frame.id = 0x1F015057;
+        frame.extended = true;
+        frame.length = 1;
+        tx.enqueue(TxPriority::COMMAND, &frame, 1);
+    }
+
+    uint32_t peerFrames() {
+        uint32_t n = 0;
+        CAN_FRAME frame;
+        while (peer.read(frame)) n++;
+        return n;
+    }
+};
+
+void setUp() { nowMs = 1000; }
+void tearDown() {}
+
+void test_error_passive() {
+    Rig rig;
+    rig.port.injectErrorPassive(true);
+    rig.run(500);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::ERROR_PASSIVE);
+    TEST_ASSERT_TRUE(rig.health.txAllowed());
+
+    rig.port.injectErrorPassive(false);
+    rig.run(100);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::ERROR_ACTIVE);
+    uint32_t passive = rig.health.timeInState(CanHealthState::ERROR_PASSIVE, nowMs);
+    TEST_ASSERT_TRUE(passive >= 499 && passive <= 501);
+    TEST_ASSERT_EQUAL_UINT32(1, rig.health.stats().errorPassive);
+}
+
+void test_bus_off_recovery() {
+    Rig rig;
+    rig.port.injectBusOff();
+    rig.run(1);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::BUS_OFF);
+    TEST_ASSERT_TRUE(!rig.health.txAllowed() && rig.tx.isPaused());
+
+    // Held in the queue, nothing reaches the bus before the backoff
+    rig.queueFrame();
+    rig.run(CAN_RECOVERY_BACKOFF_MS - 10);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::BUS_OFF);
+    TEST_ASSERT_EQUAL_UINT8(1, rig.tx.depth());
+    TEST_ASSERT_EQUAL_UINT32(0, rig.peerFrames());
+
+    // Backoff over: recovery, BUS_RECOVERED, restart, the frame goes out
+    rig.run(20);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::RESTARTED);
+    TEST_ASSERT_TRUE(rig.port.getBusStatus().state == CanBusState::RUNNING);
+    TEST_ASSERT_TRUE(rig.tx.idle());
+    TEST_ASSERT_EQUAL_UINT32(1, rig.peerFrames());
+    TEST_ASSERT_EQUAL_UINT32(1, rig.health.stats().recoveries);
+    TEST_ASSERT_TRUE(rig.health.stats().lastRecoveryMs >= CAN_RECOVERY_BACKOFF_MS);
+
+    rig.run(CAN_RESTART_STABLE_MS, 10);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::ERROR_ACTIVE);
+}
+
+void test_backoff() {
+    Rig rig;
+    uint32_t expected = CAN_RECOVERY_BACKOFF_MS;
+    for (int i = 0; i < 4; i++) {
+        rig.port.injectBusOff();
+        rig.run(1);
+        TEST_ASSERT_EQUAL_UINT32(expected, rig.health.backoffMs());
+        rig.run(rig.health.backoffMs() + 100);
+        TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::RESTARTED);
+        expected *= 2;
+    }
+    TEST_ASSERT_EQUAL_UINT32(4, rig.health.stats().busOffs);
+    TEST_ASSERT_EQUAL_UINT32(4, rig.health.stats().recoveries);
+
+    rig.run(CAN_RESTART_STABLE_MS, 10);
+    TEST_ASSERT_EQUAL_UINT32(CAN_RECOVERY_BACKOFF_MS, rig.health.backoffMs());
+}
+
+void test_stuck_bus() {
+    Rig rig;
+    rig.port.injectStuckRecovery(true);
+    rig.port.injectBusOff();
+    rig.run(CAN_RECOVERY_BACKOFF_MS + CAN_RECOVERY_TIMEOUT_MS + 10);
+    TEST_ASSERT_TRUE(rig.health.stats().recoveryFailures >= 1);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::BUS_OFF);
+    TEST_ASSERT_FALSE(rig.health.txAllowed());
+
+    // Completes late, while we wait for the next attempt
+    rig.port.injectStuckRecovery(false);
+    rig.run(1);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::RESTARTED);
+    TEST_ASSERT_TRUE(rig.port.getBusStatus().state == CanBusState::RUNNING);
+}
+
+void test_lost_alert() {
+    Rig rig;
+    rig.port.injectBusOff();
+    rig.port.takeHealthEvents();            // the alert never reaches us
+    rig.run(50);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::ERROR_ACTIVE);
+
+    rig.health.sync(rig.port.getBusStatus(), nowMs);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::BUS_OFF);
+    rig.run(CAN_RECOVERY_BACKOFF_MS + 100);
+    TEST_ASSERT_TRUE(rig.health.state() == CanHealthState::RESTARTED);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_error_passive);
+    RUN_TEST(test_bus_off_recovery);
+    RUN_TEST(test_backoff);
+    RUN_TEST(test_stuck_bus);
+    RUN_TEST(test_lost_alert);
+    return UNITY_END();
+}
@@ -0,0 +1,145 @@
+// ============================================================================
+// NODE TABLE TESTS - CanAddress codec and bus node liveness (env:native_test)
+// ============================================================================
+// Encode / decode of the three ComfoNet ID kinds, then the NodeTable on a
+// scripted clock: discovery, PDO rate, timeout, collisions with our own ID,
+// ignored nodes and RTR frames that must not be attributed.
+//
+//   pio test -e native_test -v
+// ============================================================================
+
+#include <string.h>
+#include <unity.h>
+#include "comfoair/CanAddress.h"
+#include "comfoair/node_table.h"
+#include "comfoair/pdo_table.h"
+#include "comfoair/rmi_reassembler.h"
+
+using namespace comfoair;
+
+static const uint8_t LOCAL = 0x11;
+
+static CAN_FRAME frameWithId(uint32_t id, bool rtr = false) {
+    CAN_FRAME frame = {};
+    frame.id = id;
+    frame.extended = 1;
+    frame.rtr = rtr;
+    frame.length = rtr ? 0 : 2;
+    return frame;
+}
+
+struct Transition {
+    uint8_t node;
+    NodeState from;
+    NodeState to;
+};
+
+static Transition transitions[8];
+static uint8_t transitionCount;
+
+static void onNodeChange(void *context, uint8_t node, NodeState from, NodeState to, uint32_t nowMs) {
+    if (transitionCount < 8) transitions[transitionCount++] = { node, from, to };
+}
+
+void setUp() { transitionCount = 0; }
+void tearDown() {}
+
+static void test_codec() {
+    // RMI request as ComfoMessage::sendRmi() builds it, and back
+    CanAddress addr(LOCAL, 0x01, 0, true, false, true, 3);
+    uint32_t id = addr.canID();
+    TEST_ASSERT_EQUAL_UINT32(0x1F074051u, id);
+    CanAddress back = CanAddress::fromCanId(id);
+    TEST_ASSERT_EQUAL_UINT8(LOCAL, back.srcNode());
+    TEST_ASSERT_EQUAL_UINT8(0x01, back.dstNode());
+    TEST_ASSERT_TRUE(back.multiMsg());
+    TEST_ASSERT_TRUE(back.request());
+    TEST_ASSERT_FALSE(back.error());
+    TEST_ASSERT_EQUAL_UINT8(3, back.seq());
+    TEST_ASSERT_EQUAL_UINT32(id, back.canID());
+    TEST_ASSERT_TRUE(canIdKind(id) == CanIdKind::RMI);
+    TEST_ASSERT_EQUAL_UINT8(LOCAL, rmiSrcNode(id));
+
+    // PDO 276 from the MVHR
+    TEST_ASSERT_EQUAL_UINT32(0x00450041u, pdoCanId(276, 0x01));
+    TEST_ASSERT_EQUAL_UINT16(276, pdoidFromCanId(0x00450041));
+    TEST_ASSERT_EQUAL_UINT8(0x01, canIdSourceNode(0x00450041));
+    TEST_ASSERT_TRUE(canIdKind(0x00450041) == CanIdKind::PDO);
+
+    // Node frames
+    TEST_ASSERT_TRUE(isNodeHeartbeatId(nodeHeartbeatId(0x01)));
+    TEST_ASSERT_FALSE(isNodeHeartbeatId(0x10040001));           // time response
+    TEST_ASSERT_TRUE(canIdKind(0x10040001) == CanIdKind::NODE);
+    TEST_ASSERT_TRUE(canIdKind(0x123) == CanIdKind::OTHER);
+}
+
+static void test_liveness() {
+    NodeTable table(LOCAL);
+    table.setListener(onNodeChange, nullptr);
+    table.poll(0);
+
+    // MVHR: 5 PDOs/s and a heartbeat per second for 10 s; node 0x05 speaks once
+    for (uint32_t t = 0; t < 10000; t += 200) {
+        table.record(frameWithId(pdoCanId(PDO_OUTDOOR_AIR_TEMP, 0x01)), t);
+        if (t % 1000 == 0) table.record(frameWithId(nodeHeartbeatId(0x01)), t);
+    }
+    table.record(frameWithId(nodeHeartbeatId(0x05)), 500);
+    table.poll(10000);
+
+    TEST_ASSERT_EQUAL_UINT8(2, transitionCount);
+    TEST_ASSERT_EQUAL_UINT8(0x01, transitions[0].node);
+    TEST_ASSERT_TRUE(transitions[0].to == NodeState::ALIVE);
+
+    const NodeTable::Node &mvhr = table.node(0x01);
+    TEST_ASSERT_EQUAL_UINT32(60, mvhr.frames);
+    TEST_ASSERT_EQUAL_UINT32(50, mvhr.pdoFrames);
+    TEST_ASSERT_EQUAL_UINT32(10, mvhr.heartbeats);
+    TEST_ASSERT_EQUAL_UINT16(50, mvhr.pdoRateX10);              // 5.0 frames/s
+
+    // 0x05 last seen at 500 ms: dead at 10.5 s, the MVHR stays alive
+    table.poll(10500);
+    TEST_ASSERT_EQUAL_UINT8(3, transitionCount);
+    TEST_ASSERT_EQUAL_UINT8(0x05, transitions[2].node);
+    TEST_ASSERT_TRUE(transitions[2].from == NodeState::ALIVE);
+    TEST_ASSERT_TRUE(transitions[2].to == NodeState::DEAD);
+    TEST_ASSERT_TRUE(mvhr.state == NodeState::ALIVE);
+    TEST_ASSERT_EQUAL_UINT8(1, table.aliveCount());
+
+    // Back on the bus
+    table.record(frameWithId(nodeHeartbeatId(0x05)), 12000);
+    TEST_ASSERT_TRUE(table.node(0x05).state == NodeState::ALIVE);
+    TEST_ASSERT_EQUAL_UINT8(4, transitionCount);
+}
+
+static void test_collision_ignore_rtr() {
+    NodeTable table(LOCAL);
+    table.setIgnored(1ULL << 0x22);
+
+    // An RTR carries the ID of the node asked: not a frame from it
+    TEST_ASSERT_TRUE(table.record(frameWithId(pdoCanId(PDO_FILTER_DAYS, 0x01), true), 10));
+    TEST_ASSERT_TRUE(table.node(0x01).state == NodeState::UNSEEN);
+
+    // Another device using our node ID
+    TEST_ASSERT_TRUE(table.record(frameWithId(nodeHeartbeatId(LOCAL)), 20));
+    TEST_ASSERT_EQUAL_UINT32(1, table.collisions());
+    TEST_ASSERT_EQUAL_UINT32(20, table.lastCollisionMs());
+
+    // Ignored node: dropped and counted, never alive
+    TEST_ASSERT_FALSE(table.record(frameWithId(pdoCanId(PDO_FAN_SPEED, 0x22)), 30));
+    TEST_ASSERT_EQUAL_UINT32(1, table.node(0x22).dropped);
+    TEST_ASSERT_TRUE(table.node(0x22).state == NodeState::UNSEEN);
+
+    char json[256];
+    size_t n = table.toJson(json, sizeof(json), 40);
+    TEST_ASSERT_EQUAL_UINT32(strlen(json), n);
+    TEST_ASSERT_NOT_NULL(strstr(json, "\"collisions\":1"));
+    TEST_ASSERT_NOT_NULL(strstr(json, "[34,\"unseen\",0,0,0,0,1,0,4294967295]"));
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_codec);
+    RUN_TEST(test_liveness);
+    RUN_TEST(test_collision_ignore_rtr);
+    return UNITY_END();
+}
@@ -0,0 +1,123 @@
+// ============================================================================
+// PDO POLLER TESTS - RTR scheduling across the millis() wrap (env:native_test)
+// ============================================================================
+// The poller only compares elapsed times, so it must behave the same at
+// boot, past 2^31 ms (24.8 days) and across the 2^32 wrap (49.7 days):
+// start delay, request spacing, timeout holdoff and a gate that went stale
+// while every PDO had a fresh value.
+//
+//   pio test -e native_test -v
+// ============================================================================
+
+#include <unity.h>
+#include "comfoair/pdo_poller.h"
+
+using namespace comfoair;
+
+static const uint16_t PDO_A = 192;
+static const uint16_t PDO_B = 209;
+static const uint32_t REFRESH_MS = 600000;
+
+static uint32_t requests;
+static uint16_t lastPdoid;
+
+static bool onRequest(void *context, uint16_t pdoid) {
+    requests++;
+    lastPdoid = pdoid;
+    return true;
+}
+
+void setUp() {
+    requests = 0;
+    lastPdoid = 0;
+}
+
+void tearDown() {}
+
+// Same schedule from any start time: delay, first RTR, spacing to the next
+static void checkStartAt(uint32_t t0) {
+    PdoPoller poller(onRequest, nullptr);
+    poller.add(PDO_A, REFRESH_MS);
+    poller.add(PDO_B, REFRESH_MS);
+    poller.start(t0, 8000);
+
+    poller.poll(t0);
+    poller.poll(t0 + 7999);
+    TEST_ASSERT_EQUAL_UINT32(0, requests);
+    poller.poll(t0 + 8000);
+    TEST_ASSERT_EQUAL_UINT32(1, requests);
+    TEST_ASSERT_EQUAL_UINT16(PDO_A, lastPdoid);
+
+    poller.onPdoReceived(PDO_A, t0 + 8100);
+    poller.poll(t0 + 8000 + PDO_POLL_SPACING_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, requests);
+    poller.poll(t0 + 8000 + PDO_POLL_SPACING_MS);
+    TEST_ASSERT_EQUAL_UINT32(2, requests);
+    TEST_ASSERT_EQUAL_UINT16(PDO_B, lastPdoid);
+}
+
+void test_start_at_boot() {
+    checkStartAt(0);
+}
+
+void test_start_past_2_31() {
+    checkStartAt(0x80000010);
+}
+
+void test_start_across_wrap() {
+    checkStartAt(0xFFFFF000);
+}
+
+// Three unanswered requests, held off PDO_POLL_HOLDOFF_MS, then retried
+void test_holdoff_across_wrap() {
+    uint32_t t = 0xFFFF0000;
+    PdoPoller poller(onRequest, nullptr);
+    poller.add(PDO_A, REFRESH_MS);
+    poller.start(t, 0);
+
+    for (uint8_t attempt = 0; attempt < PDO_POLL_MAX_ATTEMPTS; attempt++) {
+        poller.poll(t);
+        TEST_ASSERT_EQUAL_UINT32(attempt + 1, requests);
+        t += PDO_POLL_TIMEOUT_MS;
+    }
+    poller.poll(t);                             // third timeout -> holdoff
+    TEST_ASSERT_EQUAL_UINT32(PDO_POLL_MAX_ATTEMPTS, requests);
+    TEST_ASSERT_EQUAL_UINT32(PDO_POLL_MAX_ATTEMPTS, poller.stats(0, t).timeouts);
+
+    uint32_t heldAt = t;
+    poller.poll(heldAt + PDO_POLL_HOLDOFF_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(PDO_POLL_MAX_ATTEMPTS, requests);
+    poller.poll(heldAt + PDO_POLL_HOLDOFF_MS);  // past the wrap by now
+    TEST_ASSERT_EQUAL_UINT32(PDO_POLL_MAX_ATTEMPTS + 1, requests);
+}
+
+// Last RTR long ago (values kept arriving by broadcast): neither the old
+// spacing gate nor an expired holdoff may block the next refresh
+void test_stale_gate() {
+    PdoPoller poller(onRequest, nullptr);
+    poller.add(PDO_A, REFRESH_MS);
+    poller.start(0, 0);
+    poller.poll(0);
+    TEST_ASSERT_EQUAL_UINT32(1, requests);
+    poller.onPdoReceived(PDO_A, 10);
+
+    uint32_t t = 10;
+    for (; t < 0x80000100u - REFRESH_MS; t += REFRESH_MS / 2) {
+        poller.onPdoReceived(PDO_A, t);         // broadcast keeps it fresh
+        poller.poll(t);
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, requests);
+
+    poller.poll(t + REFRESH_MS);                // > 2^31 ms after the last RTR
+    TEST_ASSERT_EQUAL_UINT32(2, requests);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_start_at_boot);
+    RUN_TEST(test_start_past_2_31);
+    RUN_TEST(test_start_across_wrap);
+    RUN_TEST(test_holdoff_across_wrap);
+    RUN_TEST(test_stale_gate);
+    return UNITY_END();
+}
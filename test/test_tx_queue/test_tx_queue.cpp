@@ -0,0 +1,149 @@
+// ============================================================================
+// CAN TX QUEUE TESTS - TX result timeout (env:native_test)
+// ============================================================================
+// A scripted driver stands in for the TWAI port: submit() / result() /
+// abort() are counted, results are set by the test. A frame that gets no
+// result within TX_RESULT_TIMEOUT_MS must be aborted in the driver before
+// it is retried, so it cannot reach the bus twice; a driver that stays
+// busy afterwards delays the retry instead of losing it.
+//
+//   pio test -e native_test -v
+// ============================================================================
+
+#include <unity.h>
+#include "comfoair/can_tx_queue.h"
+
+using namespace comfoair;
+
+struct ScriptedDriver {
+    bool busy;
+    TxResult result;
+    uint32_t submits;
+    uint32_t aborts;
+};
+
+static ScriptedDriver drv;
+
+static CanTxDriver scriptedDriver() {
+    return CanTxDriver{
+        [](void *, const CAN_FRAME &) {
+            if (drv.busy) return false;
+            drv.submits++;
+            drv.result = TxResult::PENDING;
+            return true;
+        },
+        [](void *) { return drv.result; },
+        [](void *) { drv.aborts++; },
+        nullptr
+    };
+}
+
+static TxJobId doneJob;
+static bool doneSuccess;
+
+static void onDone(void *context, TxJobId job, bool success) {
+    doneJob = job;
+    doneSuccess = success;
+}
+
+static TxJobId queueCommand(CanTxQueue &queue) {
+    CAN_FRAME frame = {};
+    frame.id = 0x1F015057;
+    frame.extended = true;
+    frame.length = 1;
+    return queue.enqueue(TxPriority::COMMAND, &frame, 1, onDone, nullptr);
+}
+
+void setUp() {
+    drv = ScriptedDriver{ false, TxResult::PENDING, 0, 0 };
+    doneJob = 0;
+    doneSuccess = false;
+}
+
+void tearDown() {}
+
+void test_result_in_time() {
+    CanTxQueue queue(scriptedDriver());
+    TxJobId job = queueCommand(queue);
+    queue.poll(0);
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS - 1);
+    drv.result = TxResult::SUCCESS;
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS - 1);
+    TEST_ASSERT_EQUAL_UINT32(1, drv.submits);
+    TEST_ASSERT_EQUAL_UINT32(0, drv.aborts);
+    TEST_ASSERT_EQUAL_UINT16(job, doneJob);
+    TEST_ASSERT_TRUE(doneSuccess);
+}
+
+void test_timeout_aborts_before_retry() {
+    CanTxQueue queue(scriptedDriver());
+    queueCommand(queue);
+    queue.poll(0);
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS);       // no result: abort
+    TEST_ASSERT_EQUAL_UINT32(1, drv.aborts);
+    TEST_ASSERT_EQUAL_UINT32(1, drv.submits);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().retries);
+
+    // Retried after the backoff, and not aborted again once it succeeds
+    uint32_t t = CanTxQueue::TX_RESULT_TIMEOUT_MS + CanTxQueue::RETRY_BACKOFF_MS;
+    queue.poll(t);
+    TEST_ASSERT_EQUAL_UINT32(2, drv.submits);
+    drv.result = TxResult::SUCCESS;
+    queue.poll(t + 1);
+    TEST_ASSERT_EQUAL_UINT32(1, drv.aborts);
+    TEST_ASSERT_TRUE(doneSuccess);
+    TEST_ASSERT_TRUE(queue.idle());
+}
+
+// The aborted frame is still in the controller: the port stays busy until
+// its outcome is in, the retry waits rather than counting as a failure
+void test_busy_after_abort() {
+    CanTxQueue queue(scriptedDriver());
+    queueCommand(queue);
+    queue.poll(0);
+    drv.busy = true;
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS);
+    for (uint32_t t = 200; t < 1000; t += 10) queue.poll(t);
+    TEST_ASSERT_EQUAL_UINT32(1, drv.submits);
+    TEST_ASSERT_EQUAL_UINT32(1, queue.stats().retries);
+    TEST_ASSERT_EQUAL_UINT16(0, doneJob);
+
+    drv.busy = false;
+    queue.poll(1000);
+    TEST_ASSERT_EQUAL_UINT32(2, drv.submits);
+    drv.result = TxResult::SUCCESS;
+    queue.poll(1001);
+    TEST_ASSERT_TRUE(doneSuccess);
+}
+
+void test_timeouts_until_failed() {
+    CanTxQueue queue(scriptedDriver());
+    TxJobId job = queueCommand(queue);
+    for (uint32_t t = 0; t < 5000 && !doneJob; t++) queue.poll(t);
+    TEST_ASSERT_EQUAL_UINT16(job, doneJob);
+    TEST_ASSERT_FALSE(doneSuccess);
+    TEST_ASSERT_EQUAL_UINT32(CanTxQueue::MAX_RETRIES + 1, drv.submits);
+    TEST_ASSERT_EQUAL_UINT32(CanTxQueue::MAX_RETRIES + 1, drv.aborts);
+}
+
+// A driver without the hook (nullptr) still times out and retries
+void test_no_abort_hook() {
+    CanTxDriver driver = scriptedDriver();
+    driver.abort = nullptr;
+    CanTxQueue queue(driver);
+    queueCommand(queue);
+    queue.poll(0);
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS);
+    queue.poll(CanTxQueue::TX_RESULT_TIMEOUT_MS + CanTxQueue::RETRY_BACKOFF_MS);
+    TEST_ASSERT_EQUAL_UINT32(2, drv.submits);
+}
+
+int main(int argc, char **argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_result_in_time);
+    RUN_TEST(test_timeout_aborts_before_retry);
+    RUN_TEST(test_busy_after_abort);
+    RUN_TEST(test_timeouts_until_failed);
+    RUN_TEST(test_no_abort_hook);
+    return UNITY_END();
+}
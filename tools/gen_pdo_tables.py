@@ -0,0 +1,269 @@
+"""
+PDO table generator - src/comfoair/pdo_spec.json -> C++ tables + HA config
+
+    python3 tools/gen_pdo_tables.py [--check]
+
+Writes
+    src/comfoair/pdo_table_gen.h    PdoId symbols, enum maps, PDO_DESCRIPTORS,
+                                    PDO_POLLED (included by pdo_table.h)
+    src/comfoair/pdo_topics_gen.h   MQTT state topic per descriptor
+    docs/haconfig/mqtt.yaml         Home Assistant MQTT sensors
+
+Runs as a PlatformIO pre: script (extra_scripts in platformio.ini) before
+every build. Files are only rewritten when their content changes, so an
+unchanged spec does not trigger a rebuild. The outputs are committed too:
+--check exits with 1 if they are stale (for CI). Standard library only.
+"""
+
+import json
+import os
+import sys
+
+TYPES = ("U8", "U16", "I16", "U32")
+ROUTES = {
+    None: "NONE",
+    "sensor_data": "SENSOR_DATA",
+    "filter_data": "FILTER_DATA",
+    "control": "CONTROL",
+    "time": "TIME",
+    "error_data": "ERROR_DATA",
+}
+TYPE_SIZE = {"U8": 1, "U16": 2, "I16": 2, "U32": 4}
+TEXT_SIZE = 24          # PDO_TEXT_SIZE in pdo_table.h
+TABLE_SIZE = 2048       # PDO_TABLE_SIZE in pdo_table.h (11-bit PDOIDs)
+STATE_TOPIC_PREFIX = "comfoair"   # MQTT_PREFIX of secrets_template.h
+
+BANNER = "// GENERATED by tools/gen_pdo_tables.py from pdo_spec.json - do not edit\n"
+
+
+def project_dir():
+    try:
+        Import("env")  # noqa: F821 - defined when run by PlatformIO (SCons)
+        return env.subst("$PROJECT_DIR")  # noqa: F821
+    except NameError:
+        return os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+
+class SpecError(Exception):
+    pass
+
+
+def load_spec(path):
+    with open(path, encoding="utf-8") as f:
+        spec = json.load(f)
+    enums = spec["enums"]
+    sections = spec.get("ha_sections", [])
+    seen_ids, seen_names = set(), set()
+    for pdo in spec["pdos"]:
+        where = "PDO %s" % pdo.get("id")
+        if not 0 <= pdo["id"] < TABLE_SIZE:
+            raise SpecError("%s: id beyond PDO_TABLE_SIZE" % where)
+        if pdo["id"] in seen_ids or pdo["name"] in seen_names:
+            raise SpecError("%s: duplicate id or name %s" % (where, pdo["name"]))
+        seen_ids.add(pdo["id"])
+        seen_names.add(pdo["name"])
+        if pdo["type"] not in TYPES:
+            raise SpecError("%s: type %s" % (where, pdo["type"]))
+        if not 0 <= pdo.get("decimals", 0) <= 3:
+            raise SpecError("%s: decimals must be 0..3" % where)
+        if "enum" in pdo and (pdo["enum"] not in enums or pdo["type"] != "U8"):
+            raise SpecError("%s: enum %s needs a U8 and an entry in enums" % (where, pdo["enum"]))
+        if pdo.get("route") not in ROUTES:
+            raise SpecError("%s: route %s" % (where, pdo.get("route")))
+        if "ha" in pdo and pdo["ha"]["section"] not in sections:
+            raise SpecError("%s: HA section %s not in ha_sections" % (where, pdo["ha"]["section"]))
+    for key, enum in enums.items():
+        for label in [e[1] for e in enum["entries"]] + [enum["fallback"]]:
+            if len(label) >= TEXT_SIZE:
+                raise SpecError("enum %s: label %s longer than PDO_TEXT_SIZE" % (key, label))
+    if len(spec["pdos"]) >= 255:
+        raise SpecError("PDO_INDEX uses uint8_t slots")
+    return spec
+
+
+def symbol(pdo):
+    return "PDO_" + pdo.get("symbol", pdo["name"].upper())
+
+
+def c_string(text):
+    return '"' + text.replace("\\", "\\\\").replace('"', '\\"') + '"'
+
+
+def gen_table(spec):
+    pdos = spec["pdos"]
+    out = [
+        "#ifndef PDO_TABLE_GEN_H",
+        "#define PDO_TABLE_GEN_H",
+        "",
+        BANNER.rstrip(),
+        "// Included by pdo_table.h after the descriptor types.",
+        "",
+        "namespace comfoair {",
+        "",
+        "  // PDOIDs as symbols, one per descriptor",
+        "  enum PdoId : uint16_t {",
+    ]
+    width = max(len(symbol(p)) for p in pdos)
+    for i, pdo in enumerate(pdos):
+        comma = "," if i + 1 < len(pdos) else ""
+        out.append("    %s = %d%s" % (symbol(pdo).ljust(width), pdo["id"], comma))
+    out += [
+        "  };",
+        "",
+        "  // --------------------------------------------------------------------------",
+        "  // Enum mappings",
+        "  // --------------------------------------------------------------------------",
+    ]
+    for key, enum in spec["enums"].items():
+        entries = ", ".join("{0x%02X, %s}" % (raw, c_string(label)) for raw, label in enum["entries"])
+        if "note" in enum:
+            out.append("  // " + enum["note"])
+        out.append("  inline constexpr PdoEnumEntry ENUM_%s_ENTRIES[] = { %s };" % (key, entries))
+        out.append("  inline constexpr PdoEnumMap ENUM_%s = { ENUM_%s_ENTRIES, %d, %s };"
+                   % (key, key, len(enum["entries"]), c_string(enum["fallback"])))
+        out.append("")
+    out += [
+        "  // --------------------------------------------------------------------------",
+        "  // Descriptors (order is irrelevant, PDO_INDEX is built from the pdoid field)",
+        "  // --------------------------------------------------------------------------",
+        "  #define PDO(id, name, type, decimals, enumMap, rtr, route) \\",
+        "    PdoDescriptor{ id, name, PdoType::type, decimals, enumMap, pdoTypeSize(PdoType::type), rtr, PdoRoute::route }",
+        "",
+        "  inline constexpr PdoDescriptor PDO_DESCRIPTORS[] = {",
+    ]
+    name_width = max(len(p["name"]) for p in pdos) + 3
+    for pdo in pdos:
+        enum = "&ENUM_%s" % pdo["enum"] if "enum" in pdo else "nullptr"
+        line = "    PDO(%s %s %s %d, %s %s %s)," % (
+            (str(pdo["id"]) + ",").ljust(4),
+            (c_string(pdo["name"]) + ",").ljust(name_width),
+            (pdo["type"] + ",").ljust(4),
+            pdo.get("decimals", 0),
+            (enum + ",").ljust(21),
+            ("true," if pdo.get("rtr") else "false,").ljust(6),
+            ROUTES[pdo.get("route")])
+        unit = pdo.get("unit", "").replace("\u00b0", "").replace("\u00b3", "3")
+        comment = [c for c in (unit, pdo.get("note")) if c]
+        if comment:
+            line += "  // " + ", ".join(comment)
+        out.append(line)
+    polled = [p for p in pdos if p.get("rtr")]
+    out += [
+        "  };",
+        "",
+        "  #undef PDO",
+        "",
+        "  // PDOs marked rtr: requested by PdoPoller when missing or stale",
+        "  inline constexpr uint16_t PDO_POLLED[] = { %s };" % ", ".join(symbol(p) for p in polled),
+        "  constexpr uint8_t PDO_POLLED_COUNT = %d;" % len(polled),
+        "}",
+        "",
+        "#endif",
+        "",
+    ]
+    return "\n".join(out)
+
+
+def gen_topics(spec):
+    out = [
+        "#ifndef PDO_TOPICS_GEN_H",
+        "#define PDO_TOPICS_GEN_H",
+        "",
+        '#include "pdo_table.h"',
+        "",
+        BANNER.rstrip(),
+        "// Needs MQTT_PREFIX, include after secrets.h.",
+        "",
+        "#ifndef MQTT_PREFIX",
+        '  #error "pdo_topics_gen.h needs MQTT_PREFIX (secrets.h)"',
+        "#endif",
+        "",
+        "namespace comfoair {",
+        "",
+        "  // MQTT state topic per descriptor, same order as PDO_DESCRIPTORS",
+        "  inline constexpr const char *PDO_TOPICS[] = {",
+    ]
+    for pdo in spec["pdos"]:
+        out.append('    MQTT_PREFIX "/%s",' % pdo["name"])
+    out += [
+        "  };",
+        "",
+        "  static_assert(sizeof(PDO_TOPICS) / sizeof(PDO_TOPICS[0]) == PDO_DESCRIPTOR_COUNT,",
+        '                "PDO_TOPICS out of step with PDO_DESCRIPTORS");',
+        "",
+        "  inline const char *pdoTopic(const PdoDescriptor *desc) {",
+        "    return PDO_TOPICS[desc - PDO_DESCRIPTORS];",
+        "  }",
+        "}",
+        "",
+        "#endif",
+        "",
+    ]
+    return "\n".join(out)
+
+
+def yaml_unit(unit):
+    return unit if unit.isalnum() and unit.isascii() else '"%s"' % unit
+
+
+def gen_yaml(spec):
+    out = [
+        "# " + BANNER[3:].rstrip().replace("pdo_spec.json", "src/comfoair/pdo_spec.json"),
+        "sensor:",
+    ]
+    for section in spec["ha_sections"]:
+        pdos = [p for p in spec["pdos"] if "ha" in p and p["ha"]["section"] == section]
+        if not pdos:
+            continue
+        out.append("# " + section)
+        for pdo in pdos:
+            ha = pdo["ha"]
+            out.append('-   name: "%s"' % ha["name"])
+            out.append('    state_topic: "%s/%s"' % (STATE_TOPIC_PREFIX, pdo["name"]))
+            if "unit" in pdo and "enum" not in pdo:
+                out.append("    unit_of_measurement: %s" % yaml_unit(pdo["unit"]))
+            if "icon" in ha:
+                out.append("    icon: %s" % ha["icon"])
+            out.append("")
+    return "\n".join(out)
+
+
+def write_if_changed(path, text, check):
+    try:
+        with open(path, encoding="utf-8") as f:
+            if f.read() == text:
+                return False
+    except FileNotFoundError:
+        pass
+    if check:
+        print("gen_pdo_tables: %s is out of date" % os.path.relpath(path))
+        return True
+    with open(path, "w", encoding="utf-8", newline="\n") as f:
+        f.write(text)
+    print("gen_pdo_tables: wrote %s" % os.path.relpath(path))
+    return True
+
+
+def main(check=False):
+    root = project_dir()
+    spec = load_spec(os.path.join(root, "src", "comfoair", "pdo_spec.json"))
+    outputs = [
+        (os.path.join(root, "src", "comfoair", "pdo_table_gen.h"), gen_table(spec)),
+        (os.path.join(root, "src", "comfoair", "pdo_topics_gen.h"), gen_topics(spec)),
+        (os.path.join(root, "docs", "haconfig", "mqtt.yaml"), gen_yaml(spec)),
+    ]
+    stale = False
+    for path, text in outputs:
+        stale |= write_if_changed(path, text, check)
+    return 1 if check and stale else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main("--check" in sys.argv[1:]))
+else:
+    # PlatformIO pre: script - a broken spec stops the build
+    try:
+        main()
+    except (SpecError, KeyError, ValueError) as e:
+        sys.stderr.write("gen_pdo_tables: %s\n" % e)
+        env.Exit(1)  # noqa: F821